@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include <functional>
+#include <atomic>
+
+/**
+ * @brief 性能测试程序共用的一些小工具
+ * @details 性能测试程序都是独立的可执行文件，不依赖第三方的benchmark框架，
+ * 参数统一使用 --name=value 的形式传入。
+ */
+namespace bench {
+
+inline uint64_t now_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * @brief 读取 --name=value 形式的整数参数
+ */
+inline long arg_int(int argc, char** argv, const char* name, long default_value) {
+  const size_t name_len = strlen(name);
+  for (int i = 1; i < argc; i++) {
+    const char* arg = argv[i];
+    if (strncmp(arg, "--", 2) == 0 && strncmp(arg + 2, name, name_len) == 0 && arg[2 + name_len] == '=') {
+      return strtol(arg + 3 + name_len, nullptr, 10);
+    }
+  }
+  return default_value;
+}
+
+/**
+ * @brief 1,2,4,...直到max_threads的线程数序列，最后一个总是max_threads
+ */
+inline std::vector<int> thread_counts(int max_threads) {
+  std::vector<int> counts;
+  for (int n = 1; n < max_threads; n *= 2) {
+    counts.push_back(n);
+  }
+  counts.push_back(max_threads);
+  return counts;
+}
+
+inline int default_max_threads() {
+  const int n = static_cast<int>(std::thread::hardware_concurrency());
+  return n > 0 ? n : 1;
+}
+
+/**
+ * @brief 启动thread_num个线程同时执行func(thread_index)
+ * @return 从所有线程开始执行到全部结束的耗时，单位秒
+ */
+inline double run_threads(int thread_num, const std::function<void(int)>& func) {
+  std::vector<std::thread> threads;
+  threads.reserve(thread_num);
+
+  std::atomic<int> ready{0};
+  std::atomic<bool> go{false};
+  for (int i = 0; i < thread_num; i++) {
+    threads.emplace_back([&, i]() {
+      ready.fetch_add(1);
+      while (!go.load(std::memory_order_acquire)) {
+        std::this_thread::yield();
+      }
+      func(i);
+    });
+  }
+
+  while (ready.load() < thread_num) {
+    std::this_thread::yield();
+  }
+  const uint64_t begin = now_ns();
+  go.store(true, std::memory_order_release);
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  return (now_ns() - begin) / 1e9;
+}
+
+/**
+ * @brief 简单的xorshift随机数，避免在测试循环里使用重量级的随机数引擎
+ */
+class FastRandom {
+public:
+  explicit FastRandom(uint64_t seed) : state_(seed * 0x9E3779B97F4A7C15ULL + 1) {}
+
+  uint64_t next() {
+    state_ ^= state_ << 13;
+    state_ ^= state_ >> 7;
+    state_ ^= state_ << 17;
+    return state_;
+  }
+
+private:
+  uint64_t state_;
+};
+
+} // namespace bench
@@ -0,0 +1,129 @@
+/**
+ * @file bitmap_bench.cpp
+ * @brief Bitmap 查找的耗时
+ * @details 两种场景：
+ * - alloc: 位图几乎全是1，随机清掉一位，然后从头找第一个0(页面分配)；
+ * - scan: 1‰的位是1，用 next_one_bit 从头到尾遍历所有的1(BufferPoolIterator)。
+ * 比较原来逐字节、逐位查找的实现(legacy)，按64位字查找(word)，AVX2 跳过全0/全1的字(avx2)，
+ * 以及开启摘要(summary)。
+ *
+ * 参数：
+ *   --ops=N  alloc 场景每种实现的查找次数，默认2000
+ */
+#include <cstdio>
+#include <vector>
+
+#include "bench_util.h"
+#include "common/bitmap/bitmap.h"
+
+namespace legacy {
+
+// 原来的实现
+int find_first(char byte, int start, bool one) {
+  for (int i = start; i < 8; i++) {
+    if (((byte & (1 << i)) != 0) == one) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+int next_bit(const char* bitmap, int size, int start, bool one) {
+  int ret           = -1;
+  int start_in_byte = start % 8;
+  for (int iter = start / 8, end = (size + 7) / 8; iter < end; iter++) {
+    char byte = bitmap[iter];
+    if (byte != (one ? 0 : -1)) {
+      int index_in_byte = find_first(byte, start_in_byte, one);
+      if (index_in_byte >= 0) {
+        ret = iter * 8 + index_in_byte;
+        break;
+      }
+    }
+    start_in_byte = 0;
+  }
+  return ret >= size ? -1 : ret;
+}
+
+}  // namespace legacy
+
+enum class Mode { LEGACY, WORD, AVX2, SUMMARY };
+
+static const char* mode_name(Mode mode) {
+  switch (mode) {
+    case Mode::LEGACY: return "legacy";
+    case Mode::WORD: return "word";
+    case Mode::AVX2: return "avx2";
+    default: return "summary";
+  }
+}
+
+static int next_bit(Mode mode, const Bitmap& bitmap, int start, bool one) {
+  if (mode == Mode::LEGACY) {
+    return legacy::next_bit(bitmap.data(), bitmap.size(), start, one);
+  }
+  return one ? bitmap.next_one_bit(start) : bitmap.next_zero_bit(start);
+}
+
+static void prepare(Mode mode, Bitmap& bitmap) {
+  Bitmap::set_avx2_enabled(mode != Mode::WORD);
+  if (mode == Mode::SUMMARY) {
+    bitmap.enable_summary();
+  }
+}
+
+/// 每次查找的耗时(ns)
+static double run_alloc(Mode mode, int size, long ops) {
+  std::vector<char> data((size + 7) / 8, 0);
+  Bitmap            bitmap(data.data(), size);
+  bitmap.set_range(0, size);
+  prepare(mode, bitmap);
+
+  bench::FastRandom random(1);
+  long              found = 0;
+  const uint64_t    begin = bench::now_ns();
+  for (long i = 0; i < ops; i++) {
+    bitmap.clear(random.next() % size);
+    const int bit = next_bit(mode, bitmap, 0, false);
+    bitmap.set(bit);
+    found += bit;
+  }
+  const double ns = static_cast<double>(bench::now_ns() - begin) / ops;
+  return found > 0 ? ns : -1;
+}
+
+/// 遍历整个位图的耗时(us)
+static double run_scan(Mode mode, int size) {
+  std::vector<char> data((size + 7) / 8, 0);
+  Bitmap            bitmap(data.data(), size);
+  bench::FastRandom random(2);
+  for (int i = 0; i < size / 1000; i++) {
+    bitmap.set(random.next() % size);
+  }
+  prepare(mode, bitmap);
+
+  const int      rounds = 10;
+  long           found  = 0;
+  const uint64_t begin  = bench::now_ns();
+  for (int round = 0; round < rounds; round++) {
+    for (int bit = next_bit(mode, bitmap, 0, true); bit >= 0; bit = next_bit(mode, bitmap, bit + 1, true)) {
+      found++;
+    }
+  }
+  const double us = static_cast<double>(bench::now_ns() - begin) / rounds / 1000;
+  return found > 0 ? us : -1;
+}
+
+int main(int argc, char** argv) {
+  const long ops = bench::arg_int(argc, argv, "ops", 2000);
+  printf("bitmap benchmark. ops=%ld\n\n", ops);
+
+  printf("%10s %8s %16s %16s\n", "bits", "mode", "alloc_ns/op", "scan_us");
+  for (int size : {65216, 1 << 20, 1 << 24}) {
+    for (Mode mode : {Mode::LEGACY, Mode::WORD, Mode::AVX2, Mode::SUMMARY}) {
+      printf("%10d %8s %16.0f %16.1f\n", size, mode_name(mode), run_alloc(mode, size, ops), run_scan(mode, size));
+    }
+  }
+  Bitmap::set_avx2_enabled(true);
+  return 0;
+}
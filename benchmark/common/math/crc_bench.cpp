@@ -0,0 +1,69 @@
+/**
+ * @file crc_bench.cpp
+ * @brief 校验和的吞吐，单位 GB/s
+ * @details 比较 crc32 (查表) 和 crc32c 的每种实现(参考 Crc32cKernel)在不同数据大小下的吞吐，
+ * CPU不支持的实现不测。日志记录一般是几十到几百字节，页面是 8KB。
+ *
+ * 参数：
+ *   --bytes=N    每种大小总共计算的字节数，默认1GB
+ */
+#include <cstdio>
+#include <vector>
+
+#include "bench_util.h"
+#include "common/math/crc.h"
+
+template <typename Func>
+static double run(Func&& func, const std::vector<char>& data, size_t size, long total_bytes) {
+  const long rounds = std::max(1L, total_bytes / static_cast<long>(size));
+  uint32_t   sum    = 0;
+
+  const uint64_t begin = bench::now_ns();
+  for (long i = 0; i < rounds; i++) {
+    // 每轮换一个起始位置，避免总是对齐
+    sum += func(data.data() + (i & 7), size);
+  }
+  const uint64_t elapsed = bench::now_ns() - begin;
+
+  // 防止编译器把计算优化掉
+  if (sum == 0x12345678) {
+    printf(" ");
+  }
+  return static_cast<double>(rounds) * size / elapsed;
+}
+
+int main(int argc, char** argv) {
+  const long total_bytes = bench::arg_int(argc, argv, "bytes", 1L << 30);
+
+  std::vector<char> data(1 << 20);
+  for (size_t i = 0; i < data.size(); i++) {
+    data[i] = static_cast<char>(i * 131 + 17);
+  }
+
+  std::vector<Crc32cKernel> kernels;
+  for (Crc32cKernel kernel : {Crc32cKernel::SLICE8, Crc32cKernel::SSE42, Crc32cKernel::PCLMUL}) {
+    if (crc32c_kernel_supported(kernel)) {
+      kernels.push_back(kernel);
+    }
+  }
+
+  printf("crc benchmark. bytes=%ld, crc32c kernel=%s\n\n", total_bytes, crc32c_kernel_name(crc32c_kernel()));
+  printf("%10s %10s", "size", "crc32");
+  for (Crc32cKernel kernel : kernels) {
+    printf(" %10s", crc32c_kernel_name(kernel));
+  }
+  printf("   (GB/s)\n");
+
+  for (size_t size : {24, 64, 256, 1024, 8192, 65536}) {
+    const double legacy = run([](const char* p, size_t n) { return crc32(p, static_cast<uint32_t>(n)); },
+        data, size, total_bytes);
+    printf("%10zu %10.2f", size, legacy);
+    for (Crc32cKernel kernel : kernels) {
+      const double castagnoli =
+          run([kernel](const char* p, size_t n) { return crc32c(kernel, p, n); }, data, size, total_bytes);
+      printf(" %10.2f", castagnoli);
+    }
+    printf("\n");
+  }
+  return 0;
+}
@@ -0,0 +1,139 @@
+/**
+ * @file mem_pool_bench.cpp
+ * @brief 内存池分配/释放的延迟
+ * @details 每个线程循环地分配 --batch 个对象再全部释放，统计一次分配加一次释放的平均耗时。
+ * 对照组 locked 是原来的实现方式：一把 shared_mutex 加上 std::list 空闲列表和 std::set 使用集合。
+ * magazine 是带线程缓存的 MemPoolItem(dynamic)，lock-free 是不带线程缓存的 MemPoolSimple。
+ *
+ * 参数：
+ *   --items=N    对象个数，默认65536
+ *   --ops=N      每个线程的分配次数，默认2000000
+ *   --batch=N    每次连续分配多少个再释放，默认8
+ *   --threads=N  最大线程数，默认CPU核数
+ */
+#include <cstdio>
+#include <list>
+#include <mutex>
+#include <set>
+#include <shared_mutex>
+#include <vector>
+
+#include "bench_util.h"
+#include "common/mem/mem_pool.h"
+
+struct BenchItem {
+  char data[64];
+
+  void reinit() {}
+  void reset() {}
+};
+
+/**
+ * @brief 原来的 MemPoolSimple 的分配方式
+ */
+class LockedPool {
+public:
+  explicit LockedPool(int item_num) : items_(item_num) {
+    for (BenchItem& item : items_) {
+      frees_.push_back(&item);
+    }
+  }
+
+  BenchItem* alloc() {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    if (frees_.empty()) {
+      return nullptr;
+    }
+    BenchItem* item = frees_.front();
+    frees_.pop_front();
+    used_.insert(item);
+    return item;
+  }
+
+  void free(BenchItem* item) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    auto iter = used_.find(item);
+    if (iter == used_.end()) {
+      return;
+    }
+    used_.erase(iter);
+    frees_.push_back(item);
+  }
+
+private:
+  std::shared_mutex      mutex_;
+  std::vector<BenchItem> items_;
+  std::list<BenchItem*>  frees_;
+  std::set<BenchItem*>   used_;
+};
+
+/**
+ * @brief 把 MemPoolItem 包装成和 MemPoolSimple 一样的接口
+ */
+class ItemPool {
+public:
+  explicit ItemPool(int item_num) : pool_("MemPoolItemBench") {
+    init_ok_ = pool_.init(sizeof(BenchItem), true, 1, item_num) == 0;
+  }
+
+  bool init_ok() const { return init_ok_; }
+
+  BenchItem* alloc() { return static_cast<BenchItem*>(pool_.alloc()); }
+  void free(BenchItem* item) { pool_.free(item); }
+
+private:
+  MemPoolItem pool_;
+  bool        init_ok_ = false;
+};
+
+template <typename Pool>
+static double run_once(Pool& pool, int thread_num, long ops, int batch) {
+  const double seconds = bench::run_threads(thread_num, [&](int) {
+    std::vector<BenchItem*> items(batch);
+    for (long i = 0; i < ops; i += batch) {
+      for (int j = 0; j < batch; j++) {
+        items[j] = pool.alloc();
+      }
+      for (int j = 0; j < batch; j++) {
+        if (items[j] != nullptr) {
+          pool.free(items[j]);
+        }
+      }
+    }
+  });
+  return seconds * 1e9 / ops;  // 每个线程的一次分配加释放的耗时
+}
+
+int main(int argc, char** argv) {
+  const int  items       = bench::arg_int(argc, argv, "items", 65536);
+  const long ops         = bench::arg_int(argc, argv, "ops", 2000000);
+  const int  batch       = bench::arg_int(argc, argv, "batch", 8);
+  const int  max_threads = bench::arg_int(argc, argv, "threads", bench::default_max_threads());
+
+  printf("mem pool benchmark. items=%d, ops=%ld, batch=%d\n\n", items, ops, batch);
+  printf("%-10s %8s %16s\n", "pool", "threads", "ns/(alloc+free)");
+
+  LockedPool locked(items);
+  for (int thread_num : bench::thread_counts(max_threads)) {
+    printf("%-10s %8d %16.1f\n", "locked", thread_num, run_once(locked, thread_num, ops, batch));
+  }
+
+  MemPoolSimple<BenchItem> pool("MemPoolBench");
+  if (pool.init(false, 1, items) != 0) {
+    fprintf(stderr, "failed to init mem pool\n");
+    return 1;
+  }
+  for (int thread_num : bench::thread_counts(max_threads)) {
+    printf("%-10s %8d %16.1f\n", "lock-free", thread_num, run_once(pool, thread_num, ops, batch));
+  }
+
+  ItemPool item_pool(items);
+  if (!item_pool.init_ok()) {
+    fprintf(stderr, "failed to init mem pool item\n");
+    return 1;
+  }
+  for (int thread_num : bench::thread_counts(max_threads)) {
+    printf("%-10s %8d %16.1f\n", "magazine", thread_num, run_once(item_pool, thread_num, ops, batch));
+  }
+  return 0;
+}
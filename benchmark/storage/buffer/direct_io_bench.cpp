@@ -0,0 +1,177 @@
+/**
+ * @file direct_io_bench.cpp
+ * @brief 数据文件使用直接IO和普通IO时的内存占用和延迟稳定性
+ * @details 多个线程随机读写数据文件中的页面，页面读写到按4KB对齐的页帧内存中(和 FramePool 一样用
+ * common::HugePageArena 分配)。同时有一个线程不停地顺序读另一个文件，制造页缓存的压力。
+ * - buffered: 普通IO，读到的页面在页帧和内核页缓存中各有一份，页缓存中的页面随时可能被压力线程挤掉，
+ *   读延迟取决于是否命中页缓存；
+ * - direct: O_DIRECT，页面只在页帧中缓存，每次读写都直接访问设备。
+ * 输出读写延迟的分位数，以及结束时数据文件在页缓存中占用的内存(mincore)。
+ *
+ * 参数：
+ *   --file_mb=N      数据文件大小(MB)，默认256
+ *   --pressure_mb=N  制造压力的文件大小(MB)，默认512，0表示没有压力
+ *   --threads=N      读写线程数，默认4
+ *   --ops=N          每个线程的读写次数，默认20000
+ *   --write_pct=N    写页面的比例，默认20
+ *   --frames=N       页帧数，默认4096
+ */
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bench_util.h"
+#include "common/io/io.h"
+#include "common/mem/huge_page_arena.h"
+#include "storage/buffer/page.h"
+
+static const char* BENCH_DIR = "./direct_io_bench_dir";
+
+struct Result {
+  bool     direct;
+  double   ops_per_sec;
+  double   p50_us;
+  double   p99_us;
+  double   p999_us;
+  double   max_us;
+  double   cached_mb;
+  uint64_t pressure_mb;
+};
+
+/**
+ * @brief 写一个指定大小的文件，落盘之后从页缓存中清掉
+ */
+static void create_file(const std::string& filename, size_t size) {
+  int               fd = open(filename.c_str(), O_CREAT | O_RDWR | O_TRUNC, 0644);
+  std::vector<char> chunk(1 << 20);
+  for (size_t offset = 0; offset < size; offset += chunk.size()) {
+    memset(chunk.data(), static_cast<int>(offset >> 20), chunk.size());
+    pwrite(fd, chunk.data(), chunk.size(), offset);
+  }
+  fsync(fd);
+  posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+  close(fd);
+}
+
+/**
+ * @brief 文件在页缓存中的大小
+ */
+static double cached_mb(const std::string& filename, size_t size) {
+  int   fd   = open(filename.c_str(), O_RDONLY);
+  void* addr = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (addr == MAP_FAILED) {
+    return -1;
+  }
+
+  const size_t               os_page = sysconf(_SC_PAGESIZE);
+  std::vector<unsigned char> vec((size + os_page - 1) / os_page);
+  mincore(addr, size, vec.data());
+  munmap(addr, size);
+  return std::count_if(vec.begin(), vec.end(), [](unsigned char v) { return v & 1; }) * os_page / (1024.0 * 1024);
+}
+
+static Result run(bool direct, size_t file_size, size_t pressure_size, int threads, long ops, int write_pct,
+    int frames) {
+  const std::string data_file     = std::string(BENCH_DIR) + "/data";
+  const std::string pressure_file = std::string(BENCH_DIR) + "/pressure";
+  Result result{};
+  result.direct = direct;
+  int fd        = open_file(data_file.c_str(), O_RDWR, 0644, result.direct);
+  // 上一轮留在页缓存中的页面不算
+  posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+
+  common::HugePageArena arena;
+  arena.init(static_cast<size_t>(frames) * BP_PAGE_SIZE);
+
+  // 压力线程一直顺序读，直到读写线程结束
+  std::atomic<bool>     stop{false};
+  std::atomic<uint64_t> pressure_bytes{0};
+  std::thread           pressure([&]() {
+    if (pressure_size == 0) {
+      return;
+    }
+    int               pressure_fd = open(pressure_file.c_str(), O_RDONLY);
+    std::vector<char> buf(1 << 20);
+    for (size_t offset = 0; !stop.load(); offset = (offset + buf.size()) % pressure_size) {
+      pressure_bytes += pread(pressure_fd, buf.data(), buf.size(), offset);
+    }
+    close(pressure_fd);
+  });
+
+  const PageNum                      page_count = static_cast<PageNum>(file_size / BP_PAGE_SIZE);
+  std::vector<std::vector<uint64_t>> latencies(threads);
+  const double seconds = bench::run_threads(threads, [&](int index) {
+    bench::FastRandom random(index + 1);
+    latencies[index].reserve(ops);
+    for (long i = 0; i < ops; i++) {
+      const PageNum page_num = static_cast<PageNum>(random.next() % page_count);
+      char*         frame    = arena.data() + (random.next() % frames) * BP_PAGE_SIZE;
+      const off_t   offset   = static_cast<off_t>(page_num) * BP_PAGE_SIZE;
+
+      const uint64_t begin = bench::now_ns();
+      if (static_cast<int>(random.next() % 100) < write_pct) {
+        pwrite(fd, frame, BP_PAGE_SIZE, offset);
+      } else {
+        preadn(fd, frame, BP_PAGE_SIZE, offset);
+      }
+      latencies[index].push_back(bench::now_ns() - begin);
+    }
+  });
+  stop = true;
+  pressure.join();
+  fdatasync(fd);
+  close(fd);
+
+  std::vector<uint64_t> all;
+  for (auto& thread_latencies : latencies) {
+    all.insert(all.end(), thread_latencies.begin(), thread_latencies.end());
+  }
+  std::sort(all.begin(), all.end());
+  result.ops_per_sec = all.size() / seconds;
+  result.p50_us      = all[all.size() / 2] / 1000.0;
+  result.p99_us      = all[all.size() * 99 / 100] / 1000.0;
+  result.p999_us     = all[all.size() * 999 / 1000] / 1000.0;
+  result.max_us      = all.back() / 1000.0;
+  result.cached_mb   = cached_mb(data_file, file_size);
+  result.pressure_mb = pressure_bytes.load() >> 20;
+  return result;
+}
+
+int main(int argc, char** argv) {
+  const size_t file_size     = bench::arg_int(argc, argv, "file_mb", 256) << 20;
+  const size_t pressure_size = bench::arg_int(argc, argv, "pressure_mb", 512) << 20;
+  const int    threads       = bench::arg_int(argc, argv, "threads", 4);
+  const long   ops           = bench::arg_int(argc, argv, "ops", 20000);
+  const int    write_pct     = bench::arg_int(argc, argv, "write_pct", 20);
+  const int    frames        = bench::arg_int(argc, argv, "frames", 4096);
+
+  printf("direct io benchmark. file=%zuMB, pressure=%zuMB, threads=%d, ops=%ld, write_pct=%d, frames=%d(%dMB)\n\n",
+      file_size >> 20, pressure_size >> 20, threads, ops, write_pct, frames, frames * BP_PAGE_SIZE >> 20);
+
+  std::filesystem::remove_all(BENCH_DIR);
+  std::filesystem::create_directories(BENCH_DIR);
+  create_file(std::string(BENCH_DIR) + "/data", file_size);
+  if (pressure_size > 0) {
+    create_file(std::string(BENCH_DIR) + "/pressure", pressure_size);
+  }
+
+  printf("%10s %10s %10s %10s %10s %10s %12s %12s\n", "mode", "ops/s", "p50_us", "p99_us", "p999_us", "max_us",
+      "cached_MB", "pressure_MB");
+  for (bool direct : {false, true}) {
+    Result result = run(direct, file_size, pressure_size, threads, ops, write_pct, frames);
+    printf("%10s %10.0f %10.1f %10.1f %10.1f %10.1f %12.1f %12lu\n",
+        direct ? (result.direct ? "direct" : "direct(n/a)") : "buffered", result.ops_per_sec, result.p50_us,
+        result.p99_us, result.p999_us, result.max_us, result.cached_mb, result.pressure_mb);
+  }
+
+  std::filesystem::remove_all(BENCH_DIR);
+  return 0;
+}
@@ -0,0 +1,152 @@
+/**
+ * @file double_write_bench.cpp
+ * @brief double write buffer 刷页面的吞吐
+ * @details 随机把页面写到几个数据文件中，比较：
+ * - legacy: 原来的做法。每个页面 lseek+write 到 double write buffer 文件，再写一次文件头；
+ *   攒够一批之后调用 sync()，然后逐个页面写数据文件，并逐个在 double write buffer 中标记失效；
+ * - batch: DiskDoubleWriteBuffer，一次写请求 + fdatasync 写 double write buffer，
+ *   数据文件中连续的页面合并写，每个文件 fdatasync 一次，所有请求一起通过 AsyncIoEngine 提交。
+ *   分别使用 --io_threads 个线程的线程池和 io_uring。
+ *
+ * 参数：
+ *   --pages=N       写多少个页面，默认20000
+ *   --files=N       数据文件个数，默认4
+ *   --file_pages=N  每个数据文件的页面数，默认4096
+ *   --batch=N       每批页面数，默认64
+ *   --io_threads=N  线程池的线程数，默认4
+ */
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstdio>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "bench_util.h"
+#include "common/io/io.h"
+#include "storage/buffer/double_write_buffer.h"
+
+using namespace storage;
+
+static const char* BENCH_DIR = "./double_write_bench_dir";
+
+struct PageWrite {
+  int32_t file;
+  PageNum page_num;
+};
+
+/**
+ * @brief 原来的 DiskDoubleWriteBuffer 的写法
+ */
+static void legacy_flush(int dblwr_fd, const std::vector<int>& fds, const std::vector<PageWrite>& batch, Page& page) {
+  struct Slot {
+    DoubleWritePageKey key;
+    int32_t            page_index;
+    bool               valid;
+  } slot;
+  int32_t page_cnt = 0;
+  for (size_t i = 0; i < batch.size(); i++) {
+    slot = {{batch[i].file, batch[i].page_num}, static_cast<int32_t>(i), true};
+    const off_t offset = sizeof(page_cnt) + i * (sizeof(slot) + sizeof(page));
+    lseek(dblwr_fd, offset, SEEK_SET);
+    writen(dblwr_fd, &slot, sizeof(slot));
+    writen(dblwr_fd, &page, sizeof(page));
+    page_cnt = i + 1;
+    lseek(dblwr_fd, 0, SEEK_SET);
+    writen(dblwr_fd, &page_cnt, sizeof(page_cnt));
+  }
+
+  sync();
+  for (size_t i = 0; i < batch.size(); i++) {
+    lseek(fds[batch[i].file], static_cast<off_t>(batch[i].page_num) * BP_PAGE_SIZE, SEEK_SET);
+    writen(fds[batch[i].file], &page, sizeof(page));
+    slot = {{batch[i].file, batch[i].page_num}, static_cast<int32_t>(i), false};
+    lseek(dblwr_fd, sizeof(page_cnt) + i * (sizeof(slot) + sizeof(page)), SEEK_SET);
+    writen(dblwr_fd, &slot, sizeof(slot));
+  }
+}
+
+static double run(const std::string& mode, const std::vector<PageWrite>& writes, int files, int file_pages,
+    int batch, int io_threads, common::AsyncIoBackend backend, DoubleWriteStats* stats) {
+  std::filesystem::remove_all(BENCH_DIR);
+  std::filesystem::create_directories(BENCH_DIR);
+
+  std::vector<int> fds;
+  for (int i = 0; i < files; i++) {
+    const std::string filename = std::string(BENCH_DIR) + "/data_" + std::to_string(i);
+    int fd = open(filename.c_str(), O_CREAT | O_RDWR, 0644);
+    // 数据文件事先分配好，只测覆盖写
+    posix_fallocate(fd, 0, static_cast<off_t>(file_pages) * BP_PAGE_SIZE);
+    fds.push_back(fd);
+  }
+  fsync(fds.front());
+
+  Page page;
+  page.init();
+  const std::string dblwr_file = std::string(BENCH_DIR) + "/dblwr.db";
+  uint64_t          begin      = 0;
+  double            seconds    = 0;
+  if (mode == "legacy") {
+    int dblwr_fd = open(dblwr_file.c_str(), O_CREAT | O_RDWR, 0644);
+    begin        = bench::now_ns();
+    std::vector<PageWrite> pending;
+    for (const PageWrite& write : writes) {
+      pending.push_back(write);
+      if (static_cast<int>(pending.size()) == batch) {
+        legacy_flush(dblwr_fd, fds, pending, page);
+        pending.clear();
+      }
+    }
+    legacy_flush(dblwr_fd, fds, pending, page);
+    seconds = (bench::now_ns() - begin) / 1e9;
+    close(dblwr_fd);
+  } else {
+    DiskDoubleWriteBuffer dblwr([&fds](int32_t id) { return fds[id]; }, batch, io_threads, backend);
+    dblwr.open_file(dblwr_file);
+    begin = bench::now_ns();
+    for (const PageWrite& write : writes) {
+      page.header.page_num = write.page_num;
+      dblwr.add_page(write.file, write.page_num, page);
+    }
+    dblwr.flush_page();
+    seconds = (bench::now_ns() - begin) / 1e9;
+    *stats  = dblwr.stats();
+  }
+
+  for (int fd : fds) {
+    close(fd);
+  }
+  return writes.size() / seconds;
+}
+
+int main(int argc, char** argv) {
+  const long pages      = bench::arg_int(argc, argv, "pages", 20000);
+  const int  files      = bench::arg_int(argc, argv, "files", 4);
+  const int  file_pages = bench::arg_int(argc, argv, "file_pages", 4096);
+  const int  batch      = bench::arg_int(argc, argv, "batch", 64);
+  const int  io_threads = bench::arg_int(argc, argv, "io_threads", 4);
+
+  printf("double write benchmark. pages=%ld, files=%d, file_pages=%d, batch=%d, io_threads=%d\n\n",
+      pages, files, file_pages, batch, io_threads);
+
+  // 同一批中的页面可能重复，和刷脏页一样被合并
+  std::mt19937           rand(1);
+  std::vector<PageWrite> writes;
+  for (long i = 0; i < pages; i++) {
+    writes.push_back({static_cast<int32_t>(rand() % files), static_cast<PageNum>(rand() % file_pages)});
+  }
+
+  printf("%12s %12s %10s %12s %12s\n", "mode", "pages/s", "batches", "data_writes", "data_syncs");
+  DoubleWriteStats stats;
+  printf("%12s %12.0f %10s %12s %12s\n", "legacy",
+      run("legacy", writes, files, file_pages, batch, 1, common::AsyncIoBackend::AUTO, &stats), "-", "-", "-");
+  for (common::AsyncIoBackend backend : {common::AsyncIoBackend::THREAD_POOL, common::AsyncIoBackend::IO_URING}) {
+    const double rate = run("batch", writes, files, file_pages, batch, io_threads, backend, &stats);
+    printf("%12s %12.0f %10lu %12lu %12lu\n", common::async_io_backend_name(backend), rate, stats.batches,
+        stats.data_writes, stats.data_syncs);
+  }
+
+  std::filesystem::remove_all(BENCH_DIR);
+  return 0;
+}
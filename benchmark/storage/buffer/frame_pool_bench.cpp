@@ -0,0 +1,147 @@
+/**
+ * @file frame_pool_bench.cpp
+ * @brief 比较页面放在不同内存上时随机访问页面的延迟和TLB缺失
+ * @details 分配 --frames 个页帧，单线程随机访问页面中的一个位置，比较三种内存：
+ * - heap：MemPoolSimple<Frame>，每个页帧自己分配页面(原来的方式)；
+ * - arena-4k：FramePool 关闭大页；
+ * - arena-huge：FramePool 使用大页，不可用时会退化，输出中会打印实际的内存类型。
+ * TLB缺失通过 perf_event_open 读取 dTLB-load-misses，没有权限或者不支持时显示 n/a。
+ *
+ * 参数：
+ *   --frames=N  页帧个数，默认32768(256MB页面)
+ *   --ops=N     访问次数，默认5000000
+ */
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <unistd.h>
+
+#if defined(__linux__)
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+#include "bench_util.h"
+#include "storage/buffer/frame_pool.h"
+
+using namespace storage;
+
+/**
+ * @brief 当前线程的 dTLB-load-misses 计数器
+ */
+class TlbMissCounter {
+public:
+  TlbMissCounter() {
+#if defined(__linux__)
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size           = sizeof(attr);
+    attr.type           = PERF_TYPE_HW_CACHE;
+    attr.config         = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                          (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    attr.disabled       = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv     = 1;
+    fd_ = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+#endif
+  }
+  ~TlbMissCounter() {
+    if (fd_ >= 0) {
+      close(fd_);
+    }
+  }
+
+  bool available() const { return fd_ >= 0; }
+
+  void start() {
+#if defined(__linux__)
+    if (fd_ >= 0) {
+      ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+      ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+  }
+
+  uint64_t stop() {
+    uint64_t count = 0;
+#if defined(__linux__)
+    if (fd_ >= 0) {
+      ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+      if (read(fd_, &count, sizeof(count)) != sizeof(count)) {
+        count = 0;
+      }
+    }
+#endif
+    return count;
+  }
+
+private:
+  int fd_ = -1;
+};
+
+static void run(const char* name, MemPoolSimple<Frame>& pool, int frame_num, long ops) {
+  if (pool.init(false, 1, frame_num) != 0) {
+    printf("%-12s failed to init\n", name);
+    return;
+  }
+  std::vector<Frame*> frames;
+  frames.reserve(frame_num);
+  for (int i = 0; i < frame_num; i++) {
+    frames.push_back(pool.alloc());
+  }
+  FramePool* frame_pool = dynamic_cast<FramePool*>(&pool);
+  const char* backing_name =
+    frame_pool != nullptr ? common::HugePageArena::backing_name(frame_pool->backing()) : "heap";
+
+  bench::FastRandom random(1);
+  TlbMissCounter counter;
+  uint64_t sum = 0;
+  counter.start();
+  const uint64_t begin = bench::now_ns();
+  for (long i = 0; i < ops; i++) {
+    const uint64_t r = random.next();
+    char* data = frames[r % frame_num]->data();
+    const size_t offset = (r >> 32) % (BP_PAGE_DATA_SIZE - 8);
+    sum += static_cast<unsigned char>(data[offset]);
+    data[offset] = static_cast<char>(i);
+  }
+  const uint64_t elapsed = bench::now_ns() - begin;
+  const uint64_t misses = counter.stop();
+
+  char miss_text[32] = "n/a";
+  if (counter.available()) {
+    snprintf(miss_text, sizeof(miss_text), "%.4f", static_cast<double>(misses) / ops);
+  }
+  printf("%-12s %-8s %12.1f %16s   (checksum %lu)\n", name, backing_name, static_cast<double>(elapsed) / ops,
+    miss_text, static_cast<unsigned long>(sum));
+
+  for (Frame* frame : frames) {
+    pool.free(frame);
+  }
+  pool.cleanup();
+}
+
+int main(int argc, char** argv) {
+  const int  frame_num = bench::arg_int(argc, argv, "frames", 32768);
+  const long ops       = bench::arg_int(argc, argv, "ops", 5000000);
+
+  printf("frame pool benchmark. frames=%d (%ld MB pages), ops=%ld\n\n", frame_num,
+    static_cast<long>(frame_num) * BP_PAGE_SIZE >> 20, ops);
+  printf("%-12s %-8s %12s %16s\n", "pool", "backing", "ns/op", "dTLB misses/op");
+
+  {
+    MemPoolSimple<Frame> pool("heap");
+    run("heap", pool, frame_num, ops);
+  }
+  {
+    FramePool pool("arena-4k");
+    pool.set_arena_options(false, 0);
+    run("arena-4k", pool, frame_num, ops);
+  }
+  {
+    FramePool pool("arena-huge");
+    run("arena-huge", pool, frame_num, ops);
+  }
+  return 0;
+}
@@ -0,0 +1,79 @@
+/**
+ * @file page_alloc_bench.cpp
+ * @brief 文件很大时分配一个页面的耗时
+ * @details 先分配 --pages 个页面，然后每次随机释放一个页面再分配一个，比较：
+ * - flat: 原来的做法，整个文件一个分配位图，每次从头找第一个空闲页面；
+ * - alloc_map: PageAllocMap，先找还有空闲页面的分配图页面，再从查找起点往后找。
+ * 文件头和分配图页面放在内存中，不读写文件。
+ *
+ * 参数：
+ *   --ops=N  每种文件大小释放再分配的次数，默认20000
+ */
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "bench_util.h"
+#include "common/bitmap/bitmap.h"
+#include "storage/buffer/page_alloc_map.h"
+
+using namespace storage;
+
+static double run_flat(int pages, long ops) {
+  std::vector<char> data(pages / 8 + 1, 0);
+  Bitmap            bitmap(data.data(), pages);
+  for (int i = 0; i < pages; i++) {
+    bitmap.set(i);
+  }
+
+  bench::FastRandom random(1);
+  const uint64_t    begin = bench::now_ns();
+  for (long i = 0; i < ops; i++) {
+    bitmap.clear(static_cast<int>(random.next() % (pages - 1)) + 1);
+    bitmap.set(bitmap.next_zero_bit(0));
+  }
+  return static_cast<double>(bench::now_ns() - begin) / ops;
+}
+
+static double run_alloc_map(int pages, long ops) {
+  std::map<PageNum, std::unique_ptr<Page>> map_pages;
+  auto fetcher = [&map_pages](PageNum page_num, bool create, Page*& page) {
+    auto& slot = map_pages[page_num];
+    if (create) {
+      slot = std::make_unique<Page>();
+    }
+    page = slot.get();
+    return page == nullptr ? RC::BUFFERPOOL_INVALID_PAGE_NUM : RC::SUCCESS;
+  };
+  PageAllocMap alloc_map(fetcher, [](PageNum) {});
+  Page         header_page;
+  alloc_map.create(header_page, 1);
+
+  PageNum page_num = BP_INVALID_PAGE_NUM;
+  while (alloc_map.allocated_pages() < pages) {
+    alloc_map.allocate(page_num);
+  }
+
+  bench::FastRandom random(1);
+  const uint64_t    begin = bench::now_ns();
+  for (long i = 0; i < ops; i++) {
+    // 随机的页面可能是分配图页面，这时不释放
+    alloc_map.deallocate(static_cast<PageNum>(random.next() % (pages - 1)) + 1);
+    alloc_map.allocate(page_num);
+  }
+  return static_cast<double>(bench::now_ns() - begin) / ops;
+}
+
+int main(int argc, char** argv) {
+  const long ops = bench::arg_int(argc, argv, "ops", 20000);
+  printf("page allocation benchmark. ops=%ld, pages_per_map=%d, max_page_num=%d\n\n",
+      ops, BPAllocMapPage::PAGES_PER_MAP, BPFileHeader::MAX_PAGE_NUM);
+
+  printf("%12s %10s %16s %16s\n", "pages", "file_GB", "flat_ns/op", "alloc_map_ns/op");
+  for (int pages : {60000, 1000000, 10000000, 50000000}) {
+    printf("%12d %10.1f %16.0f %16.0f\n", pages, static_cast<double>(pages) * BP_PAGE_SIZE / (1 << 30),
+        run_flat(pages, ops), run_alloc_map(pages, ops));
+  }
+  return 0;
+}
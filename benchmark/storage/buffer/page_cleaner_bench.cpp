@@ -0,0 +1,110 @@
+/**
+ * @file page_cleaner_bench.cpp
+ * @brief 比较有无后台刷脏页时前台访问的吞吐，以及前台淘汰时遇到脏页的次数
+ * @details 通过 FrameManager 模拟缓冲池：前台线程随机访问页面，一部分访问会修改页面；
+ * 未命中时淘汰页帧，淘汰脏页需要写盘(用 --write_us 模拟写页面和 double write 的延迟)。
+ * 开启 PageCleaner 时，后台线程用同样的延迟分批写脏页。
+ *
+ * 参数：
+ *   --frames=N     缓冲池页帧数，默认4096
+ *   --pages=N      页面总数，默认16384
+ *   --ops=N        每个线程的访问次数，默认200000
+ *   --threads=N    前台线程数，默认 bench::default_max_threads()
+ *   --write_pct=N  修改页面的访问比例，默认30
+ *   --write_us=N   写一个页面的延迟，默认20
+ */
+#include <cstdio>
+#include <thread>
+
+#include "bench_util.h"
+#include "storage/buffer/page_cleaner.h"
+
+using namespace storage;
+
+struct Result {
+  double           ops_per_sec;
+  uint64_t         dirty_purges;
+  PageCleanerStats stats;
+};
+
+static void write_delay(int write_us) {
+  if (write_us > 0) {
+    std::this_thread::sleep_for(std::chrono::microseconds(write_us));
+  }
+}
+
+static Result run(bool use_cleaner, int frames, int pages, long ops, int threads, int write_pct, int write_us) {
+  FrameManager manager("PageCleanerBench");
+  manager.init(frames);
+
+  auto purger = [write_us](Frame* frame) {
+    if (frame->is_dirty()) {
+      write_delay(write_us);
+      frame->clear_dirty();
+    }
+    return RC::SUCCESS;
+  };
+
+  PageCleanerOptions options;
+  options.interval_ms = 10;
+  PageCleaner cleaner(manager, [write_us](const std::vector<Frame*>& batch) {
+    // 一批页面先顺序写 double write buffer，再写回各自的位置
+    write_delay(write_us * static_cast<int>(batch.size()) / 2);
+    return RC::SUCCESS;
+  }, nullptr, options);
+  if (use_cleaner) {
+    cleaner.start();
+  }
+
+  const double seconds = bench::run_threads(threads, [&](int thread_index) {
+    bench::FastRandom random(thread_index + 1);
+    for (long i = 0; i < ops; i++) {
+      const PageNum page_num = static_cast<PageNum>(random.next() % pages);
+      Frame* frame = manager.get(1, page_num);
+      if (frame == nullptr) {
+        RC rc = manager.alloc_for_read(1, page_num, false, frame);
+        while (rc == RC::BUFFER_POOL_FULL) {
+          manager.purge_frames(8, purger);
+          rc = manager.alloc_for_read(1, page_num, false, frame);
+        }
+        if (frame == nullptr) {
+          continue;  // 其它线程刚刚加载了这个页面
+        }
+        frame->set_io_state(Frame::IoState::NONE);
+      }
+      if (static_cast<int>(random.next() % 100) < write_pct) {
+        frame->write_latch();
+        frame->mark_dirty();
+        frame->write_unlatch();
+      }
+      frame->unpin();
+    }
+  });
+
+  cleaner.stop();
+  Result result{ops * threads / seconds, manager.dirty_purge_count(), cleaner.stats()};
+  manager.purge_frames(frames, [](Frame*) { return RC::SUCCESS; });
+  manager.cleanup();
+  return result;
+}
+
+int main(int argc, char** argv) {
+  const int  frames    = bench::arg_int(argc, argv, "frames", 4096);
+  const int  pages     = bench::arg_int(argc, argv, "pages", 16384);
+  const long ops       = bench::arg_int(argc, argv, "ops", 200000);
+  const int  threads   = bench::arg_int(argc, argv, "threads", bench::default_max_threads());
+  const int  write_pct = bench::arg_int(argc, argv, "write_pct", 30);
+  const int  write_us  = bench::arg_int(argc, argv, "write_us", 20);
+
+  printf("page cleaner benchmark. frames=%d, pages=%d, ops=%ld, threads=%d, write_pct=%d, write_us=%d\n\n",
+    frames, pages, ops, threads, write_pct, write_us);
+  printf("%-8s %12s %14s %12s %14s %12s\n", "cleaner", "ops/s", "dirty purges", "dirty ratio", "flush pages/s",
+    "flushed");
+  for (bool use_cleaner : {false, true}) {
+    Result result = run(use_cleaner, frames, pages, ops, threads, write_pct, write_us);
+    printf("%-8s %12.0f %14lu %11.1f%% %14.0f %12lu\n", use_cleaner ? "on" : "off", result.ops_per_sec,
+      static_cast<unsigned long>(result.dirty_purges), result.stats.dirty_ratio * 100, result.stats.flush_rate,
+      static_cast<unsigned long>(result.stats.flushed_pages));
+  }
+  return 0;
+}
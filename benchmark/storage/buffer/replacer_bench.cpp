@@ -0,0 +1,111 @@
+/**
+ * @file replacer_bench.cpp
+ * @brief 比较不同替换策略的命中率和每次访问的耗时
+ * @details 通过 FrameManager 模拟缓冲池：命中时 get + unpin，未命中时淘汰一个页帧再 alloc。
+ * 测试以下几种访问模式：
+ * - hot-set：90% 的访问落在 10% 的页面上，页面总数是缓冲池容量的4倍；
+ * - scan-heavy：hot-set 的访问中间穿插对一张大表的顺序扫描；
+ * - loop-scan：反复顺序扫描一个比缓冲池稍大的表。
+ *
+ * 参数：
+ *   --frames=N   缓冲池页帧数，默认4096
+ *   --ops=N      访问次数，默认2000000
+ *   --shards=N   分片数，默认 FrameManager::DEFAULT_SHARD_NUM
+ */
+#include <cstdio>
+#include <string>
+
+#include "bench_util.h"
+#include "storage/buffer/frame_manager.h"
+
+using namespace storage;
+
+struct Workload {
+  const char* name;
+  std::function<PageNum(bench::FastRandom&, long)> next_page;
+};
+
+struct Result {
+  double hit_ratio;
+  double ns_per_op;
+};
+
+static Result run(const std::string& replacer_name, int frames, int shards, long ops, const Workload& workload) {
+  FrameManager manager("ReplacerBench");
+  if (manager.init(frames, shards, replacer_name) != RC::SUCCESS) {
+    fprintf(stderr, "failed to init frame manager with replacer %s\n", replacer_name.c_str());
+    abort();
+  }
+
+  auto purger = [](Frame*) { return RC::SUCCESS; };
+
+  bench::FastRandom random(1);
+  long hits = 0;
+  const uint64_t begin = bench::now_ns();
+  for (long i = 0; i < ops; i++) {
+    const PageNum page_num = workload.next_page(random, i);
+    Frame* frame = manager.get(1, page_num);
+    if (frame != nullptr) {
+      hits++;
+    } else {
+      frame = manager.alloc(1, page_num);
+      if (frame == nullptr) {
+        manager.purge_frames(1, purger);
+        frame = manager.alloc(1, page_num);
+      }
+      if (frame == nullptr) {
+        fprintf(stderr, "failed to alloc frame\n");
+        abort();
+      }
+    }
+    frame->unpin();
+  }
+  const uint64_t end = bench::now_ns();
+
+  manager.purge_frames(frames, purger);
+  manager.cleanup();
+  return Result{static_cast<double>(hits) / ops, static_cast<double>(end - begin) / ops};
+}
+
+int main(int argc, char** argv) {
+  const int  frames = bench::arg_int(argc, argv, "frames", 4096);
+  const long ops    = bench::arg_int(argc, argv, "ops", 2000000);
+  const int  shards = bench::arg_int(argc, argv, "shards", FrameManager::DEFAULT_SHARD_NUM);
+
+  const int hot_pages   = frames * 4 / 10;  // 热点页面能够放进缓冲池
+  const int total_pages = frames * 4;
+  const int table_pages = frames * 8;
+
+  auto hot_set = [=](bench::FastRandom& random, long) -> PageNum {
+    if (random.next() % 100 < 90) {
+      return static_cast<PageNum>(random.next() % hot_pages);
+    }
+    return static_cast<PageNum>(random.next() % total_pages);
+  };
+
+  std::vector<Workload> workloads = {
+    {"hot-set", hot_set},
+    {"scan-heavy",
+      [=](bench::FastRandom& random, long i) -> PageNum {
+        // 一半的访问是顺序扫描，扫描的页面和热点页面不重叠
+        if (i % 2 == 0) {
+          return static_cast<PageNum>(total_pages + (i / 2) % table_pages);
+        }
+        return hot_set(random, i);
+      }},
+    {"loop-scan",
+      [=](bench::FastRandom&, long i) -> PageNum {
+        return static_cast<PageNum>(i % (frames + frames / 10));
+      }},
+  };
+
+  printf("replacer benchmark. frames=%d, ops=%ld, shards=%d\n\n", frames, ops, shards);
+  printf("%-12s %-8s %10s %10s\n", "workload", "replacer", "hit ratio", "ns/op");
+  for (const Workload& workload : workloads) {
+    for (const char* replacer_name : {"lru", "clock", "2q"}) {
+      Result result = run(replacer_name, frames, shards, ops, workload);
+      printf("%-12s %-8s %9.2f%% %10.1f\n", workload.name, replacer_name, result.hit_ratio * 100, result.ns_per_op);
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,116 @@
+/**
+ * @file disk_log_handler_bench.cpp
+ * @brief DiskLogHandler 的追加吞吐和 wait_lsn 延迟
+ * @details
+ * - append: 每个线程只追加日志不等待，统计每秒追加的日志条数，日志由刷盘线程在后台落盘；
+ * - wait_lsn: 每个线程追加一条日志之后等它落盘，统计 wait_lsn 的平均、p50、p99 延迟。
+ *   并发等待的线程共用一次 fdatasync，线程越多吞吐越高。
+ *
+ * 参数：
+ *   --ops=N        append 测试每个线程追加的条数，默认200000
+ *   --commits=N    wait_lsn 测试每个线程提交的次数，默认1000
+ *   --size=N       每条日志的数据大小，默认128
+ *   --threads=N    最大线程数，默认32
+ */
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "bench_util.h"
+#include "storage/clog/disk_log_handler.h"
+
+static const char* BENCH_DIR = "./disk_log_handler_bench_dir";
+
+static double run_append(int thread_num, long ops, int size) {
+  std::filesystem::remove_all(BENCH_DIR);
+  DiskLogHandler handler;
+  if (IS_FAIL(handler.init(BENCH_DIR)) || IS_FAIL(handler.start())) {
+    return 0;
+  }
+
+  const std::string data(size, 'a');
+  const double seconds = bench::run_threads(thread_num, [&](int) {
+    for (long i = 0; i < ops; i++) {
+      LSN lsn = 0;
+      handler.append(lsn, LogModule::Id::BUFFER_POOL, data);
+    }
+  });
+
+  handler.stop();
+  handler.await_termination();
+  return thread_num * ops / seconds;
+}
+
+struct WaitResult {
+  double commits_per_sec;
+  double avg_us;
+  double p50_us;
+  double p99_us;
+};
+
+static WaitResult run_wait(int thread_num, long commits, int size) {
+  std::filesystem::remove_all(BENCH_DIR);
+  DiskLogHandler handler;
+  if (IS_FAIL(handler.init(BENCH_DIR)) || IS_FAIL(handler.start())) {
+    return {};
+  }
+
+  std::mutex            mutex;
+  std::vector<uint64_t> latencies;
+  const std::string     data(size, 'a');
+  const double seconds = bench::run_threads(thread_num, [&](int) {
+    std::vector<uint64_t> local;
+    local.reserve(commits);
+    for (long i = 0; i < commits; i++) {
+      LSN lsn = 0;
+      handler.append(lsn, LogModule::Id::BUFFER_POOL, data);
+      const uint64_t start = bench::now_ns();
+      handler.wait_lsn(lsn);
+      local.push_back(bench::now_ns() - start);
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    latencies.insert(latencies.end(), local.begin(), local.end());
+  });
+
+  handler.stop();
+  handler.await_termination();
+
+  std::sort(latencies.begin(), latencies.end());
+  double sum = 0;
+  for (uint64_t latency : latencies) {
+    sum += latency;
+  }
+  WaitResult result;
+  result.commits_per_sec = thread_num * commits / seconds;
+  result.avg_us          = sum / latencies.size() / 1000.0;
+  result.p50_us          = latencies[latencies.size() / 2] / 1000.0;
+  result.p99_us          = latencies[latencies.size() * 99 / 100] / 1000.0;
+  return result;
+}
+
+int main(int argc, char** argv) {
+  const long ops         = bench::arg_int(argc, argv, "ops", 200000);
+  const long commits     = bench::arg_int(argc, argv, "commits", 1000);
+  const int  size        = bench::arg_int(argc, argv, "size", 128);
+  const int  max_threads = bench::arg_int(argc, argv, "threads", 32);
+
+  printf("disk log handler benchmark. ops=%ld, commits=%ld, size=%d\n\n", ops, commits, size);
+
+  printf("%8s %14s\n", "threads", "appends/s");
+  for (int thread_num : bench::thread_counts(max_threads)) {
+    printf("%8d %14.0f\n", thread_num, run_append(thread_num, ops, size));
+  }
+
+  printf("\n%8s %14s %10s %10s %10s\n", "threads", "commits/s", "avg_us", "p50_us", "p99_us");
+  for (int thread_num : bench::thread_counts(max_threads)) {
+    WaitResult result = run_wait(thread_num, commits, size);
+    printf("%8d %14.0f %10.1f %10.1f %10.1f\n", thread_num, result.commits_per_sec, result.avg_us, result.p50_us,
+        result.p99_us);
+  }
+
+  std::filesystem::remove_all(BENCH_DIR);
+  return 0;
+}
@@ -0,0 +1,105 @@
+/**
+ * @file group_commit_bench.cpp
+ * @brief 并发提交时每秒能提交多少个事务(每次提交都要求日志落盘)
+ * @details 每个线程循环地追加一条日志然后等待它落盘：
+ * - serial: 原来的方式，提交时在一把全局锁内写这条日志再 fdatasync，每次提交一次落盘；
+ * - group: LogBuffer::group_commit，leader 把所有等待的日志合并成一次 writev 加 fdatasync。
+ *
+ * 参数：
+ *   --dir=PATH     日志文件目录，默认 ./group_commit_bench_dir，结束时删除
+ *   --commits=N    每个线程的提交次数，默认2000
+ *   --size=N       每条日志的数据大小，默认128
+ *   --threads=N    最大线程数，默认64
+ */
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <mutex>
+
+#include "bench_util.h"
+#include "storage/clog/log_buffer.h"
+#include "storage/clog/log_file.h"
+
+static const char* arg_str(int argc, char** argv, const char* name, const char* default_value) {
+  const size_t len = strlen(name);
+  for (int i = 1; i < argc; i++) {
+    if (strncmp(argv[i], "--", 2) == 0 && strncmp(argv[i] + 2, name, len) == 0 && argv[i][2 + len] == '=') {
+      return argv[i] + 3 + len;
+    }
+  }
+  return default_value;
+}
+
+struct Result {
+  double   commits_per_sec;
+  uint64_t syncs;
+};
+
+static Result run_serial(const std::string& filename, int thread_num, long commits, int size) {
+  LogFileWriter writer;
+  if (IS_FAIL(writer.open(filename, INT64_MAX))) {
+    return {0, 0};
+  }
+
+  std::mutex mutex;
+  LSN        current_lsn = 0;
+  const double seconds = bench::run_threads(thread_num, [&](int) {
+    for (long i = 0; i < commits; i++) {
+      LogEntry entry;
+      entry.init(0, LogModule(LogModule::Id::BUFFER_POOL), std::vector<char>(size, 'a'));
+
+      std::lock_guard<std::mutex> lock(mutex);
+      entry.set_lsn(++current_lsn);
+      writer.write(entry);
+      writer.sync();
+    }
+  });
+  return {thread_num * commits / seconds, static_cast<uint64_t>(current_lsn)};
+}
+
+static Result run_group(const std::string& filename, int thread_num, long commits, int size) {
+  LogFileWriter writer;
+  if (IS_FAIL(writer.open(filename, INT64_MAX))) {
+    return {0, 0};
+  }
+
+  LogBuffer buffer;
+  buffer.init(0);
+  const double seconds = bench::run_threads(thread_num, [&](int) {
+    for (long i = 0; i < commits; i++) {
+      LSN lsn = 0;
+      buffer.append(lsn, LogModule::Id::BUFFER_POOL, std::vector<char>(size, 'a'));
+      buffer.group_commit(writer, lsn);
+    }
+  });
+  return {thread_num * commits / seconds, buffer.flush_count()};
+}
+
+int main(int argc, char** argv) {
+  const std::string dir         = arg_str(argc, argv, "dir", "./group_commit_bench_dir");
+  const long        commits     = bench::arg_int(argc, argv, "commits", 2000);
+  const int         size        = bench::arg_int(argc, argv, "size", 128);
+  const int         max_threads = bench::arg_int(argc, argv, "threads", 64);
+
+  std::filesystem::remove_all(dir);
+  std::filesystem::create_directories(dir);
+
+  printf("group commit benchmark. dir=%s, commits=%ld, size=%d\n\n", dir.c_str(), commits, size);
+  printf("%-8s %8s %14s %10s %14s\n", "mode", "threads", "commits/s", "fsyncs", "commits/fsync");
+
+  int round = 0;
+  for (int thread_num : bench::thread_counts(max_threads)) {
+    for (const char* mode : {"serial", "group"}) {
+      const std::string filename = dir + "/bench_" + std::to_string(round++) + ".log";
+      Result result = strcmp(mode, "serial") == 0 ? run_serial(filename, thread_num, commits, size)
+                                                  : run_group(filename, thread_num, commits, size);
+      printf("%-8s %8d %14.0f %10lu %14.1f\n", mode, thread_num, result.commits_per_sec,
+          static_cast<unsigned long>(result.syncs),
+          result.syncs > 0 ? static_cast<double>(thread_num * commits) / result.syncs : 0.0);
+      std::filesystem::remove(filename);
+    }
+  }
+
+  std::filesystem::remove_all(dir);
+  return 0;
+}
@@ -0,0 +1,127 @@
+/**
+ * @file log_buffer_bench.cpp
+ * @brief 追加一条日志的耗时
+ * @details 每个线程循环地追加 --size 字节的日志，后台线程不停地把缓冲区刷到文件中：
+ * - deque: 原来的实现方式，每条日志一个 LogEntry(数据放在自己的 std::vector 中)，
+ *   在一把锁内分配LSN并放进 std::deque，刷盘时逐条写入，没有空间限制；
+ * - ring: LogBuffer，fetch_add 预留之后直接序列化到环形缓冲区中，追加时没有内存分配，
+ *   刷盘太慢时追加会等待缓冲区空间。
+ * 两种方式每次刷盘都会 fdatasync。
+ *
+ * 参数：
+ *   --ops=N        每个线程追加的日志条数，默认500000
+ *   --size=N       每条日志的数据大小，默认64
+ *   --threads=N    最大线程数，默认CPU核数
+ */
+#include <atomic>
+#include <cstdio>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <thread>
+
+#include "bench_util.h"
+#include "storage/clog/log_buffer.h"
+#include "storage/clog/log_file.h"
+
+/**
+ * @brief 原来的 LogBuffer 的追加和刷盘方式
+ */
+class DequeBuffer {
+public:
+  void append(LSN& lsn, const char* data, int32_t size) {
+    LogEntry entry;
+    entry.init(0, LogModule(LogModule::Id::BUFFER_POOL), std::vector<char>(data, data + size));
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    lsn = ++current_lsn_;
+    entry.set_lsn(lsn);
+    entries_.push_back(std::move(entry));
+  }
+
+  void flush(LogFileWriter& writer) {
+    std::deque<LogEntry> entries;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      entries.swap(entries_);
+    }
+    for (const LogEntry& entry : entries) {
+      writer.write(entry);
+    }
+    if (!entries.empty()) {
+      writer.sync();
+    }
+  }
+
+private:
+  std::mutex           mutex_;
+  std::deque<LogEntry> entries_;
+  LSN                  current_lsn_ = 0;
+};
+
+/**
+ * @brief 测试期间后台线程不停地刷盘
+ */
+template <typename Buffer>
+static double run_once(Buffer& buffer, const std::string& filename, int thread_num, long ops, int size) {
+  LogFileWriter writer;
+  if (IS_FAIL(writer.open(filename, INT64_MAX))) {
+    return 0;
+  }
+
+  std::atomic<bool> stop{false};
+  std::thread flusher([&]() {
+    while (!stop.load(std::memory_order_acquire)) {
+      buffer.flush(writer);
+      std::this_thread::yield();
+    }
+    buffer.flush(writer);
+  });
+
+  const std::vector<char> data(size, 'a');
+  const double seconds = bench::run_threads(thread_num, [&](int) {
+    LSN lsn = 0;
+    for (long i = 0; i < ops; i++) {
+      buffer.append(lsn, data.data(), size);
+    }
+  });
+
+  stop.store(true, std::memory_order_release);
+  flusher.join();
+  std::filesystem::remove(filename);
+  return seconds * 1e9 / ops;  // 每个线程追加一条的耗时
+}
+
+/**
+ * @brief 把 LogBuffer 包装成和 DequeBuffer 一样的接口
+ */
+class RingBuffer {
+public:
+  RingBuffer() { buffer_.init(0); }
+
+  void append(LSN& lsn, const char* data, int32_t size) {
+    buffer_.append(lsn, LogModule(LogModule::Id::BUFFER_POOL), data, size);
+  }
+  void flush(LogFileWriter& writer) { buffer_.flush(writer); }
+
+private:
+  LogBuffer buffer_;
+};
+
+int main(int argc, char** argv) {
+  const long ops         = bench::arg_int(argc, argv, "ops", 500000);
+  const int  size        = bench::arg_int(argc, argv, "size", 64);
+  const int  max_threads = bench::arg_int(argc, argv, "threads", bench::default_max_threads());
+  const std::string filename = "./log_buffer_bench.log";
+
+  printf("log buffer benchmark. ops=%ld, size=%d\n\n", ops, size);
+  printf("%-8s %8s %14s\n", "buffer", "threads", "ns/append");
+
+  for (int thread_num : bench::thread_counts(max_threads)) {
+    DequeBuffer deque_buffer;
+    printf("%-8s %8d %14.1f\n", "deque", thread_num, run_once(deque_buffer, filename, thread_num, ops, size));
+    RingBuffer ring_buffer;
+    printf("%-8s %8d %14.1f\n", "ring", thread_num, run_once(ring_buffer, filename, thread_num, ops, size));
+  }
+  return 0;
+}
@@ -0,0 +1,146 @@
+/**
+ * @file log_compress_bench.cpp
+ * @brief 日志压缩对写入量、CPU 和日志吞吐的影响
+ * @details 模拟写页面镜像为主的负载：每条日志是一个 8KB 的页面，页面中是格式相似的记录和没有用到的空闲空间。
+ * - codec: LZ4 单独压缩、解压一个页面的速度和压缩率；
+ * - log: 单线程追加日志，每 group 条等一次落盘，比较不压缩(threshold=0)和压缩时
+ *   写到文件的字节数、进程的 CPU 时间(包括刷盘线程)和按原始数据计算的日志 MB/s。
+ *
+ * 参数：
+ *   --pages=N      追加的页面数，默认20000
+ *   --fill=N       页面中记录占用的百分比，默认70
+ *   --group=N      每多少条日志等一次落盘，默认8
+ *   --threshold=N  压缩阈值，默认1024
+ */
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "bench_util.h"
+#include "common/compress/lz4.h"
+#include "storage/clog/disk_log_handler.h"
+
+static const char* BENCH_DIR = "./log_compress_bench_dir";
+static const int   PAGE_SIZE = 8192;
+
+/**
+ * @brief 生成一个页面：页头、按主键递增的定长记录，剩下的是0
+ */
+static std::string make_page(int page_num, int fill_percent) {
+  std::string  page(PAGE_SIZE, '\0');
+  unsigned int seed   = page_num * 2654435761u + 1;
+  const int    used   = PAGE_SIZE * fill_percent / 100;
+  int          offset = 64;
+  memcpy(&page[0], &page_num, sizeof(page_num));
+  for (int key = page_num * 1000; offset + 48 <= used; key++, offset += 48) {
+    seed = seed * 1103515245 + 12345;
+    char record[49];
+    snprintf(record, sizeof(record), "%08d|user_%06u|%010u|status=%d|", key, (seed >> 8) % 100000, seed,
+        static_cast<int>(seed % 3));
+    memcpy(&page[offset], record, 48);
+  }
+  return page;
+}
+
+struct LogResult {
+  double   seconds;
+  double   cpu_seconds;
+  uint64_t raw_bytes;
+  uint64_t file_bytes;
+};
+
+static LogResult run_log(const std::vector<std::string>& pages, long count, int group, int threshold) {
+  std::filesystem::remove_all(BENCH_DIR);
+  LogResult      result{};
+  DiskLogHandler handler;
+  // 不预分配，文件大小就是写入的字节数
+  if (IS_FAIL(handler.init(BENCH_DIR, DiskLogHandler::DEFAULT_MAX_ENTRIES_PER_FILE, 0))) {
+    return result;
+  }
+  handler.set_compress_threshold(threshold);
+  if (IS_FAIL(handler.start())) {
+    return result;
+  }
+
+  const std::clock_t cpu_begin = std::clock();
+  const uint64_t     begin     = bench::now_ns();
+  for (long i = 0; i < count; i++) {
+    const std::string& page = pages[i % pages.size()];
+    LSN                lsn  = 0;
+    handler.append(lsn, LogModule::Id::BUFFER_POOL, page);
+    result.raw_bytes += page.size();
+    if ((i + 1) % group == 0) {
+      handler.wait_lsn(lsn);
+    }
+  }
+  handler.wait_lsn(handler.current_lsn());
+  result.seconds     = (bench::now_ns() - begin) / 1e9;
+  result.cpu_seconds = static_cast<double>(std::clock() - cpu_begin) / CLOCKS_PER_SEC;
+
+  handler.stop();
+  handler.await_termination();
+  for (const auto& file : std::filesystem::directory_iterator(BENCH_DIR)) {
+    if (file.path().extension() == ".log") {
+      result.file_bytes += file.file_size();
+    }
+  }
+  return result;
+}
+
+int main(int argc, char** argv) {
+  const long count     = bench::arg_int(argc, argv, "pages", 20000);
+  const int  fill      = bench::arg_int(argc, argv, "fill", 70);
+  const int  group     = bench::arg_int(argc, argv, "group", 8);
+  const int  threshold = bench::arg_int(argc, argv, "threshold", 1024);
+
+  printf("log compress benchmark. pages=%ld, page_size=%d, fill=%d%%, group=%d, threshold=%d\n\n",
+      count, PAGE_SIZE, fill, group, threshold);
+
+  std::vector<std::string> pages;
+  for (int i = 0; i < 256; i++) {
+    pages.push_back(make_page(i, fill));
+  }
+
+  // 单独测试压缩和解压
+  {
+    std::vector<char> compressed(lz4_compress_bound(PAGE_SIZE));
+    std::vector<char> raw(PAGE_SIZE);
+    uint64_t          compressed_bytes = 0;
+    const int         rounds           = 20000;
+
+    uint64_t begin = bench::now_ns();
+    for (int i = 0; i < rounds; i++) {
+      const std::string& page = pages[i % pages.size()];
+      compressed_bytes += lz4_compress(page.data(), PAGE_SIZE, compressed.data(), compressed.size());
+    }
+    const double compress_seconds = (bench::now_ns() - begin) / 1e9;
+
+    const int size = lz4_compress(pages[0].data(), PAGE_SIZE, compressed.data(), compressed.size());
+    begin          = bench::now_ns();
+    for (int i = 0; i < rounds; i++) {
+      lz4_decompress(compressed.data(), size, raw.data(), PAGE_SIZE);
+    }
+    const double decompress_seconds = (bench::now_ns() - begin) / 1e9;
+
+    const double mb = static_cast<double>(rounds) * PAGE_SIZE / (1024 * 1024);
+    printf("codec: ratio=%.2f, compress=%.0f MB/s, decompress=%.0f MB/s\n\n",
+        static_cast<double>(rounds) * PAGE_SIZE / compressed_bytes, mb / compress_seconds, mb / decompress_seconds);
+  }
+
+  printf("%10s %12s %12s %8s %10s %12s %12s\n", "mode", "raw_MB", "written_MB", "ratio", "cpu_s", "cpu_us/page",
+      "log_MB/s");
+  for (int mode_threshold : {0, threshold}) {
+    LogResult result = run_log(pages, count, group, mode_threshold);
+    const double raw_mb     = result.raw_bytes / (1024.0 * 1024);
+    const double written_mb = result.file_bytes / (1024.0 * 1024);
+    printf("%10s %12.1f %12.1f %8.2f %10.2f %12.1f %12.1f\n", mode_threshold > 0 ? "lz4" : "none", raw_mb,
+        written_mb, raw_mb / written_mb, result.cpu_seconds, result.cpu_seconds * 1e6 / count,
+        raw_mb / result.seconds);
+  }
+
+  std::filesystem::remove_all(BENCH_DIR);
+  return 0;
+}
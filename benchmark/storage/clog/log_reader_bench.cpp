@@ -0,0 +1,118 @@
+/**
+ * @file log_reader_bench.cpp
+ * @brief LogFileReader 的顺序读取和定位开销
+ * @details 先写一个日志文件，然后比较：
+ * - scan: 从头遍历整个文件，BUFFERED 每条日志复制一份数据，MMAP 直接返回指向映射内存的视图；
+ * - seek: 随机选一个LSN，打开文件并读到这条日志，分别在有索引文件和没有索引文件时测试。
+ *   没有索引时要从文件开头逐条跳过。
+ *
+ * 参数：
+ *   --entries=N    日志条数，默认1000000
+ *   --size=N       每条日志的数据大小，默认128
+ *   --seeks=N      seek 测试的次数，默认200
+ */
+#include <cstdio>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "bench_util.h"
+#include "storage/clog/log_entry.h"
+#include "storage/clog/log_file.h"
+
+static const char* BENCH_DIR  = "./log_reader_bench_dir";
+static const char* BENCH_FILE = "./log_reader_bench_dir/clog_0.log";
+
+static bool write_file(long entries, int size) {
+  std::filesystem::remove_all(BENCH_DIR);
+  std::filesystem::create_directories(BENCH_DIR);
+
+  LogFileWriter writer;
+  if (IS_FAIL(writer.open(BENCH_FILE, entries + 1))) {
+    return false;
+  }
+
+  // 和 LogBuffer 一样成批写入
+  std::vector<LogEntry> batch;
+  for (long lsn = 1; lsn <= entries; lsn++) {
+    LogEntry entry;
+    entry.init(lsn, LogModule::Id::BUFFER_POOL, std::vector<char>(size, 'a'));
+    batch.emplace_back(std::move(entry));
+    if (batch.size() == 64 || lsn == entries) {
+      size_t written = 0;
+      if (IS_FAIL(writer.write_batch(batch, written))) {
+        return false;
+      }
+      batch.clear();
+    }
+  }
+  return IS_SUCC(writer.write_index()) && IS_SUCC(writer.sync());
+}
+
+static double run_scan(LogFileReader::Mode mode, long entries) {
+  LogFileReader reader;
+  if (IS_FAIL(reader.open(BENCH_FILE, mode))) {
+    return 0;
+  }
+
+  uint64_t       sum   = 0;
+  const uint64_t begin = bench::now_ns();
+  reader.iterate([&sum](LogEntry& entry) {
+    sum += entry.data()[entry.payload_size() - 1];
+    return RC::SUCCESS;
+  });
+  const double seconds = (bench::now_ns() - begin) / 1e9;
+  reader.close();
+  return sum == 0 ? 0 : entries / seconds;
+}
+
+/// 返回平均每次定位的耗时，单位微秒
+static double run_seek(LogFileReader::Mode mode, long entries, long seeks) {
+  std::mt19937_64 rand(1234);
+  const uint64_t  begin = bench::now_ns();
+  for (long i = 0; i < seeks; i++) {
+    const LSN     target = static_cast<LSN>(rand() % entries) + 1;
+    LogFileReader reader;
+    if (IS_FAIL(reader.open(BENCH_FILE, mode))) {
+      return 0;
+    }
+    reader.iterate([target](LogEntry& entry) {
+      return entry.lsn() == target ? RC::SUCCESS : RC::INTERNAL;
+    }, target);
+    reader.close();
+  }
+  return (bench::now_ns() - begin) / 1000.0 / seeks;
+}
+
+int main(int argc, char** argv) {
+  const long entries = bench::arg_int(argc, argv, "entries", 1000000);
+  const int  size    = bench::arg_int(argc, argv, "size", 128);
+  const long seeks   = bench::arg_int(argc, argv, "seeks", 200);
+
+  printf("log reader benchmark. entries=%ld, size=%d, seeks=%ld\n\n", entries, size, seeks);
+  if (!write_file(entries, size)) {
+    printf("failed to write log file\n");
+    return 1;
+  }
+
+  // 先读一遍，让文件进入 page cache
+  run_scan(LogFileReader::Mode::MMAP, entries);
+
+  printf("%10s %14s %14s %14s\n", "mode", "scan rec/s", "seek_us(idx)", "seek_us(none)");
+  for (auto mode : {LogFileReader::Mode::BUFFERED, LogFileReader::Mode::MMAP}) {
+    const double scan       = run_scan(mode, entries);
+    const double seek_index = run_seek(mode, entries, seeks);
+
+    const std::string index_file = LogFileWriter::index_filename(BENCH_FILE);
+    std::filesystem::rename(index_file, index_file + ".bak");
+    const double seek_none = run_seek(mode, entries, seeks);
+    std::filesystem::rename(index_file + ".bak", index_file);
+
+    printf("%10s %14.0f %14.1f %14.1f\n", mode == LogFileReader::Mode::MMAP ? "mmap" : "buffered", scan, seek_index,
+        seek_none);
+  }
+
+  std::filesystem::remove_all(BENCH_DIR);
+  return 0;
+}
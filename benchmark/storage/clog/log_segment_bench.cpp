@@ -0,0 +1,97 @@
+/**
+ * @file log_segment_bench.cpp
+ * @brief 日志文件预分配和回收对提交延迟的影响
+ * @details 单线程追加一条日志之后等它落盘，统计 wait_lsn 的 p50、p99、p999 和最大延迟。
+ * 每个文件的日志条数比较少，测试过程中会切换很多次文件：
+ * - growth: 不预分配(segment_size=0)，文件随写入增长，每次提交 fdatasync 都要更新文件大小；
+ * - prealloc: 新文件用 fallocate 预分配，O_DSYNC 写入；
+ * - recycle: 预分配，并且每写完一个文件就回收不再需要的文件，切换文件时直接改名使用。
+ *
+ * 参数：
+ *   --commits=N    提交次数，默认20000
+ *   --size=N       每条日志的数据大小，默认128
+ *   --entries=N    每个文件的日志条数，默认2048
+ *   --segment=N    预分配的文件大小(KB)，默认1024
+ */
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "bench_util.h"
+#include "storage/clog/disk_log_handler.h"
+
+static const char* BENCH_DIR = "./log_segment_bench_dir";
+
+struct LatencyResult {
+  double p50_us;
+  double p99_us;
+  double p999_us;
+  double max_us;
+  double commits_per_sec;
+};
+
+static LatencyResult run(long commits, int size, int entries_per_file, int64_t segment_size, bool recycle) {
+  std::filesystem::remove_all(BENCH_DIR);
+  DiskLogHandler handler;
+  if (IS_FAIL(handler.init(BENCH_DIR, entries_per_file, segment_size)) || IS_FAIL(handler.start())) {
+    return {};
+  }
+
+  std::vector<uint64_t> latencies;
+  latencies.reserve(commits);
+  const std::string data(size, 'a');
+  const uint64_t    begin = bench::now_ns();
+  for (long i = 0; i < commits; i++) {
+    LSN lsn = 0;
+    handler.append(lsn, LogModule::Id::BUFFER_POOL, data);
+    const uint64_t start = bench::now_ns();
+    handler.wait_lsn(lsn);
+    latencies.push_back(bench::now_ns() - start);
+
+    // 相当于每写完一个文件做一次检查点，只保留最近两个文件
+    if (recycle && lsn % entries_per_file == 0) {
+      handler.recycle(lsn - 2 * entries_per_file);
+    }
+  }
+  const double seconds = (bench::now_ns() - begin) / 1e9;
+
+  handler.stop();
+  handler.await_termination();
+
+  std::sort(latencies.begin(), latencies.end());
+  LatencyResult result;
+  result.p50_us          = latencies[latencies.size() / 2] / 1000.0;
+  result.p99_us          = latencies[latencies.size() * 99 / 100] / 1000.0;
+  result.p999_us         = latencies[latencies.size() * 999 / 1000] / 1000.0;
+  result.max_us          = latencies.back() / 1000.0;
+  result.commits_per_sec = commits / seconds;
+  return result;
+}
+
+int main(int argc, char** argv) {
+  const long    commits      = bench::arg_int(argc, argv, "commits", 20000);
+  const int     size         = bench::arg_int(argc, argv, "size", 128);
+  const int     entries      = bench::arg_int(argc, argv, "entries", 2048);
+  const int64_t segment_size = bench::arg_int(argc, argv, "segment", 1024) * 1024;
+
+  printf("log segment benchmark. commits=%ld, size=%d, entries_per_file=%d, segment_size=%ld\n\n",
+      commits, size, entries, segment_size);
+
+  printf("%10s %12s %10s %10s %10s %10s\n", "mode", "commits/s", "p50_us", "p99_us", "p999_us", "max_us");
+  struct Mode {
+    const char* name;
+    int64_t     segment_size;
+    bool        recycle;
+  };
+  for (const Mode& mode : {Mode{"growth", 0, false}, Mode{"prealloc", segment_size, false},
+           Mode{"recycle", segment_size, true}}) {
+    LatencyResult result = run(commits, size, entries, mode.segment_size, mode.recycle);
+    printf("%10s %12.0f %10.1f %10.1f %10.1f %10.1f\n", mode.name, result.commits_per_sec, result.p50_us,
+        result.p99_us, result.p999_us, result.max_us);
+  }
+
+  std::filesystem::remove_all(BENCH_DIR);
+  return 0;
+}
@@ -0,0 +1,145 @@
+/**
+ * @file parallel_replay_bench.cpp
+ * @brief 日志回放的吞吐，比较串行回放和 ParallelLogReplayer 按页面分区的并行回放
+ * @details 先用 DiskLogHandler 写一批页面日志，然后用不同的线程数回放。
+ * 每条日志的回放开销由两部分模拟：
+ * - 修改页面：在页面大小的内存上做 work 次计算，占用CPU；
+ * - 读页面：每 miss 条日志有一次页面不在内存中，睡眠 io_us 微秒模拟从磁盘读页面。
+ * 恢复时读页面通常是主要开销，单核机器上也能看到并行回放的效果，多核时计算部分也能并行。
+ *
+ * 参数：
+ *   --records=N    日志条数，默认200000
+ *   --pages=N      页面个数，默认10000
+ *   --barrier=N    每隔多少条日志插入一条屏障日志(比如分配页面)，默认10000
+ *   --work=N       每条日志修改页面的计算量，默认256
+ *   --miss=N       每多少条日志读一次页面，默认32，0表示不读
+ *   --io_us=N      读一次页面的耗时，默认100
+ *   --threads=N    最大线程数，默认16
+ */
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "bench_util.h"
+#include "storage/clog/disk_log_handler.h"
+#include "storage/clog/log_entry.h"
+#include "storage/clog/log_replayer.h"
+
+static const char* BENCH_DIR = "./parallel_replay_bench_dir";
+
+struct BenchPageLog {
+  PageNum page_num;  /// 小于0表示屏障日志
+  int32_t value;
+};
+
+/**
+ * @brief 模拟页面级别的 redo，不同页面的日志可以并行回放
+ */
+class BenchReplayer : public LogReplayer {
+public:
+  BenchReplayer(int pages, int work, int miss, int io_us)
+    : pages_(new uint64_t[static_cast<size_t>(pages) * PAGE_WORDS]()), work_(work), miss_(miss), io_us_(io_us) {}
+
+  RC replay(const LogEntry& entry) override {
+    BenchPageLog log;
+    memcpy(&log, entry.data(), sizeof(log));
+    if (log.page_num < 0) {
+      return RC::SUCCESS;
+    }
+
+    if (miss_ > 0 && entry.lsn() % miss_ == 0) {
+      std::this_thread::sleep_for(std::chrono::microseconds(io_us_));
+    }
+
+    uint64_t* page = &pages_[static_cast<size_t>(log.page_num) * PAGE_WORDS];
+    for (int i = 0; i < work_; i++) {
+      page[i % PAGE_WORDS] = page[i % PAGE_WORDS] * 31 + log.value + i;
+    }
+    return RC::SUCCESS;
+  }
+
+  uint64_t partition(const LogEntry& entry) const override {
+    BenchPageLog log;
+    memcpy(&log, entry.data(), sizeof(log));
+    return log.page_num < 0 ? BARRIER : page_partition(0, log.page_num);
+  }
+
+private:
+  static constexpr int PAGE_WORDS = 8192 / sizeof(uint64_t);
+
+  std::unique_ptr<uint64_t[]> pages_;
+  int                         work_;
+  int                         miss_;
+  int                         io_us_;
+};
+
+static bool write_log(long records, int pages, int barrier) {
+  std::filesystem::remove_all(BENCH_DIR);
+  DiskLogHandler handler;
+  if (IS_FAIL(handler.init(BENCH_DIR))) {
+    return false;
+  }
+
+  LSN lsn = 0;
+  for (long i = 1; i <= records; i++) {
+    BenchPageLog log;
+    log.page_num = (barrier > 0 && i % barrier == 0) ? -1 : static_cast<PageNum>((i * 7919) % pages);
+    log.value    = static_cast<int32_t>(i);
+    std::vector<char> data(sizeof(log));
+    memcpy(data.data(), &log, sizeof(log));
+    if (IS_FAIL(handler.append(lsn, LogModule::Id::BUFFER_POOL, std::move(data)))) {
+      return false;
+    }
+    // 不启动刷盘线程，缓冲区满之前自己刷
+    if (i % 4096 == 0 && IS_FAIL(handler.wait_lsn(lsn))) {
+      return false;
+    }
+  }
+  return IS_SUCC(handler.wait_lsn(lsn));
+}
+
+int main(int argc, char** argv) {
+  const long records     = bench::arg_int(argc, argv, "records", 200000);
+  const int  pages       = bench::arg_int(argc, argv, "pages", 10000);
+  const int  barrier     = bench::arg_int(argc, argv, "barrier", 10000);
+  const int  work        = bench::arg_int(argc, argv, "work", 256);
+  const int  miss        = bench::arg_int(argc, argv, "miss", 32);
+  const int  io_us       = bench::arg_int(argc, argv, "io_us", 100);
+  const int  max_threads = bench::arg_int(argc, argv, "threads", 16);
+
+  printf("parallel replay benchmark. records=%ld, pages=%d, barrier=%d, work=%d, miss=%d, io_us=%d\n\n",
+      records, pages, barrier, work, miss, io_us);
+  if (!write_log(records, pages, barrier)) {
+    printf("failed to write log\n");
+    return 1;
+  }
+
+  printf("%8s %12s %14s %10s\n", "threads", "seconds", "records/s", "speedup");
+  double serial_seconds = 0;
+  for (int thread_num : bench::thread_counts(max_threads)) {
+    DiskLogHandler handler;
+    if (IS_FAIL(handler.init(BENCH_DIR))) {
+      printf("failed to open log\n");
+      return 1;
+    }
+    handler.set_replay_threads(thread_num);
+
+    BenchReplayer  replayer(pages, work, miss, io_us);
+    const uint64_t begin = bench::now_ns();
+    if (IS_FAIL(handler.replay(replayer, 0))) {
+      printf("failed to replay log\n");
+      return 1;
+    }
+    const double seconds = (bench::now_ns() - begin) / 1e9;
+    if (thread_num == 1) {
+      serial_seconds = seconds;
+    }
+    printf("%8d %12.3f %14.0f %9.2fx\n", thread_num, seconds, records / seconds, serial_seconds / seconds);
+  }
+
+  std::filesystem::remove_all(BENCH_DIR);
+  return 0;
+}
@@ -2,25 +2,94 @@
 #include <sstream>
 #include <cstring>
 
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
 #include "common/bitmap/bitmap.h"
 
-int Bitmap::find_first_zero(char byte, int start) {
-  for (int i = start; i < 8; ++i) {
-    if ((byte & (1 << i)) == 0) {
-      return i;
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "Bitmap loads bytes as little-endian words");
+
+namespace {
+
+/// 从 word 开始跳过等于 skip 的字，返回第一个不相等的字，都相等时返回 end_word
+using SkipWordsFunc = int (*)(const char* bitmap, int word, int end_word, uint64_t skip);
+
+int skip_words_generic(const char* bitmap, int word, int end_word, uint64_t skip) {
+  for (; word < end_word; word++) {
+    uint64_t value;
+    memcpy(&value, bitmap + word * 8, sizeof(value));
+    if (value != skip) {
+      break;
     }
   }
-  return -1;
+  return word;
 }
 
-int Bitmap::find_first_one(char byte, int start) {
-  for (int i = start; i < 8; i++) {
-    if ((byte & (1 << i)) != 0) {
-      return i;
+#if defined(__x86_64__)
+__attribute__((target("avx2")))
+int skip_words_avx2(const char* bitmap, int word, int end_word, uint64_t skip) {
+  const __m256i pattern = _mm256_set1_epi64x(static_cast<long long>(skip));
+  for (; word + 8 <= end_word; word += 8) {
+    const char*   p    = bitmap + word * 8;
+    const __m256i v0   = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    const __m256i v1   = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 32));
+    const __m256i diff = _mm256_or_si256(_mm256_xor_si256(v0, pattern), _mm256_xor_si256(v1, pattern));
+    if (!_mm256_testz_si256(diff, diff)) {
+      break;
     }
   }
-  return -1;
+  // 剩下的不到8个字，或者找到的8个字中具体是哪一个
+  return skip_words_generic(bitmap, word, end_word, skip);
 }
+#endif
+
+bool avx2_supported() {
+#if defined(__x86_64__)
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2");
+#else
+  return false;
+#endif
+}
+
+SkipWordsFunc skip_words_func(bool avx2) {
+#if defined(__x86_64__)
+  if (avx2 && avx2_supported()) {
+    return skip_words_avx2;
+  }
+#endif
+  return skip_words_generic;
+}
+
+/// 当前使用的实现，函数内的静态变量避免其它文件的静态初始化先用到
+SkipWordsFunc& skip_words() {
+  static SkipWordsFunc func = skip_words_func(true);
+  return func;
+}
+
+/// summary 中从 word 开始(包含)第一个为1的位，没有时返回-1
+int next_summary_bit(const std::vector<uint64_t>& summary, int word) {
+  size_t   index = word / 64;
+  uint64_t bits  = index < summary.size() ? summary[index] & (~0ULL << (word % 64)) : 0;
+  while (bits == 0) {
+    if (++index >= summary.size()) {
+      return -1;
+    }
+    bits = summary[index];
+  }
+  return static_cast<int>(index * 64 + __builtin_ctzll(bits));
+}
+
+void set_summary_bit(std::vector<uint64_t>& summary, int word, bool value) {
+  if (value) {
+    summary[word / 64] |= 1ULL << (word % 64);
+  } else {
+    summary[word / 64] &= ~(1ULL << (word % 64));
+  }
+}
+
+}  // namespace
 
 Bitmap::Bitmap() : size_(0), bitmap_(nullptr) {}
 Bitmap::Bitmap(char* bitmap, int size) : size_(size), bitmap_(bitmap) {}
@@ -28,16 +97,24 @@ Bitmap::Bitmap(char* bitmap, int size) : size_(size), bitmap_(bitmap) {}
 void Bitmap::init(char* bitmap, int size) {
   size_ = size;
   bitmap_ = bitmap;
+  zero_summary_.clear();
+  one_summary_.clear();
 }
 
 void Bitmap::set(size_t index) {
   char &bits = bitmap_[index / 8];
   bits |= (1 << (index % 8));
+  if (summary_enabled()) {
+    update_summary(index / 64, index / 64);
+  }
 }
 
 void Bitmap::clear(size_t index) {
   char &bits = bitmap_[index / 8];
   bits &= ~(1 << (index % 8));
+  if (summary_enabled()) {
+    update_summary(index / 64, index / 64);
+  }
 }
 
 bool Bitmap::get(size_t index) const {
@@ -45,46 +122,123 @@ bool Bitmap::get(size_t index) const {
   return (bits & (1 << (index % 8))) != 0;
 }
 
-int Bitmap::next_zero_bit(int start) const {
-  int ret = -1;
-  int start_in_byte = start % 8;
-  for (int iter = start / 8, end = bytes(); iter < end; iter++) {
-    char byte = bitmap_[iter];
-    if (byte != -1) {
-      int index_in_byte = find_first_zero(byte, start_in_byte);
-      if (index_in_byte >= 0) {
-        ret = iter * 8 + index_in_byte;
-        break;
-      }
+void Bitmap::set_range(int start, int end) { fill_range(start, end, true); }
+
+void Bitmap::clear_range(int start, int end) { fill_range(start, end, false); }
+
+void Bitmap::fill_range(int start, int end, bool one) {
+  start = std::max(start, 0);
+  end   = std::min(end, size_);
+  if (start >= end) {
+    return;
+  }
+
+  auto set_bit = [this](int index, bool one) {
+    if (one) {
+      bitmap_[index / 8] |= (1 << (index % 8));
+    } else {
+      bitmap_[index / 8] &= ~(1 << (index % 8));
     }
-    start_in_byte = 0;
+  };
+
+  // 两头不满一个字节的逐位修改，中间整字节填充
+  int index = start;
+  for (; index < end && index % 8 != 0; index++) {
+    set_bit(index, one);
+  }
+  const int byte_end = end / 8 * 8;
+  if (index < byte_end) {
+    memset(bitmap_ + index / 8, one ? 0xFF : 0, (byte_end - index) / 8);
+    index = byte_end;
+  }
+  for (; index < end; index++) {
+    set_bit(index, one);
   }
 
-  if (ret >= size_) {
-    ret = -1;
+  if (summary_enabled()) {
+    update_summary(start / 64, (end - 1) / 64);
+  }
+}
+
+int Bitmap::count() const {
+  int ret = 0;
+  for (int word = 0, end = words(); word < end; word++) {
+    ret += __builtin_popcountll(load_word(word) & valid_bits(word));
   }
   return ret;
 }
 
-int Bitmap::next_one_bit(int start) const {
-  int ret = -1;
-  int start_in_byte = start % 8;
-  for (int iter = start / 8, end = bytes(); iter < end; iter++) {
-    char byte = bitmap_[iter];
-    if (byte != 0x00) {
-      int index_in_byte = find_first_one(byte, start_in_byte);
-      if (index_in_byte >= 0) {
-        ret = iter * 8 + index_in_byte;
-        break;
-      }
+uint64_t Bitmap::load_word(int word) const {
+  uint64_t  value  = 0;
+  const int offset = word * 8;
+  memcpy(&value, bitmap_ + offset, std::min(8, bytes() - offset));
+  return value;
+}
+
+uint64_t Bitmap::valid_bits(int word) const {
+  const int tail = size_ - word * 64;
+  return tail >= 64 ? ~0ULL : (1ULL << tail) - 1;
+}
+
+int Bitmap::next_bit(int start, bool one) const {
+  start = std::max(start, 0);
+  if (start >= size_) {
+    return -1;
+  }
+
+  // 取反之后要找的位都是1。最后一个字中超出 size_ 的位不算
+  const uint64_t flip       = one ? 0 : ~0ULL;
+  const int      word_count = words();
+  int            word       = start / 64;
+  uint64_t       bits       = (load_word(word) ^ flip) & valid_bits(word) & (~0ULL << (start % 64));
+  while (bits == 0) {
+    if (++word >= word_count) {
+      return -1;
+    }
+    if (summary_enabled()) {
+      word = next_summary_bit(one ? one_summary_ : zero_summary_, word);
+    } else {
+      // 只有完整的字可以直接读8个字节
+      word = skip_words()(bitmap_, word, size_ / 64, flip);
     }
-    start_in_byte = 0;
+    if (word < 0 || word >= word_count) {
+      return -1;
+    }
+    bits = (load_word(word) ^ flip) & valid_bits(word);
   }
+  return word * 64 + __builtin_ctzll(bits);
+}
+
+int Bitmap::next_zero_bit(int start) const { return next_bit(start, false); }
 
-  if (ret >= size_) {
-    ret = -1;
+int Bitmap::next_one_bit(int start) const { return next_bit(start, true); }
+
+void Bitmap::enable_summary() {
+  const size_t summary_words = (words() + 63) / 64;
+  zero_summary_.assign(std::max<size_t>(summary_words, 1), 0);
+  one_summary_.assign(std::max<size_t>(summary_words, 1), 0);
+  if (size_ > 0) {
+    update_summary(0, words() - 1);
   }
-  return ret;
+}
+
+void Bitmap::update_summary(int first_word, int last_word) {
+  for (int word = first_word; word <= last_word; word++) {
+    const uint64_t valid = valid_bits(word);
+    const uint64_t value = load_word(word) & valid;
+    set_summary_bit(zero_summary_, word, value != valid);
+    set_summary_bit(one_summary_, word, value != 0);
+  }
+}
+
+void Bitmap::set_avx2_enabled(bool enabled) { skip_words() = skip_words_func(enabled); }
+
+bool Bitmap::avx2_enabled() {
+#if defined(__x86_64__)
+  return skip_words() == skip_words_avx2;
+#else
+  return false;
+#endif
 }
 
 std::string Bitmap::to_string() const {
@@ -93,4 +247,4 @@ std::string Bitmap::to_string() const {
     ss << (get(i) ? "1" : "0");
   }
   return ss.str();
-}
\ No newline at end of file
+}
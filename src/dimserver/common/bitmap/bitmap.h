@@ -2,38 +2,80 @@
 
 #include <cstdint>
 #include <string>
+#include <vector>
 
+/**
+ * @brief 位图，不拥有内存，第 i 位是第 i / 8 个字节的第 i % 8 位
+ * @details 查找按64位字进行，CPU支持时用 AVX2 一次跳过多个全0或者全1的字。
+ * 很大的位图可以开启摘要(参考 enable_summary)，摘要中一位表示一个64位字中是否有0/1，
+ * 查找时先查摘要，摘要的一个字对应4096位。
+ */
 class Bitmap {
 public:
   explicit Bitmap();
   explicit Bitmap(char* bitmap, int size);
 
+  /**
+   * @brief 换成另一块内存，会关闭摘要
+   */
   void init(char* bitmap, int size);
 
   void set(size_t index);
   void clear(size_t index);
   bool get(size_t index) const;
 
+  /**
+   * @brief 设置/清除 [start, end) 范围内的位
+   */
+  void set_range(int start, int end);
+  void clear_range(int start, int end);
+
+  /**
+   * @brief 为1的位的个数
+   */
+  int count() const;
+
   /**
    * @param start 从哪个位开始查找，start是包含在内的
    */
   int next_zero_bit(int start) const;
   int next_one_bit(int start) const;
 
+  /**
+   * @brief 根据当前的内容建立摘要，之后修改位图只能通过 Bitmap 的接口
+   * @details 直接修改了 data() 之后需要再调用一次重新建立
+   */
+  void enable_summary();
+  bool summary_enabled() const { return !zero_summary_.empty(); }
+
   int size() const { return size_; }
   int bytes() const { return (size_ + 7) / 8; }
   std::string to_string() const;
-  
+
   // 获取位图数据的指针
   const char* data() const { return bitmap_; }
   char* data() { return bitmap_; }
 
+  /**
+   * @brief 查找时是否使用 AVX2，默认CPU支持时使用。给测试和性能测试比较不同的实现，不是线程安全的
+   */
+  static void set_avx2_enabled(bool enabled);
+  static bool avx2_enabled();
+
 private:
-  // 在字节中查找第一个0位
-  static int find_first_zero(char byte, int start);
-  // 在字节中查找第一个1位
-  static int find_first_one(char byte, int start);
+  int      words() const { return (size_ + 63) / 64; }
+  uint64_t load_word(int word) const;
+  /// 第 word 个字中在 size_ 范围内的位
+  uint64_t valid_bits(int word) const;
+
+  /// 查找第一个等于 one 的位
+  int  next_bit(int start, bool one) const;
+  void fill_range(int start, int end, bool one);
+  void update_summary(int first_word, int last_word);
 
   int size_ = 0;
   char* bitmap_{nullptr};
-};
\ No newline at end of file
+
+  std::vector<uint64_t> zero_summary_;  /// 第 i 位表示第 i 个字中有0
+  std::vector<uint64_t> one_summary_;   /// 第 i 位表示第 i 个字中有1
+};
@@ -0,0 +1,238 @@
+#include <cstring>
+
+#include "common/compress/lz4.h"
+
+static constexpr int      MIN_MATCH     = 4;
+static constexpr int      MFLIMIT       = 12;  // 最后一个匹配的开始位置距离结尾至少这么多字节
+static constexpr int      LAST_LITERALS = 5;   // 最后这么多字节一定是字面量
+static constexpr int      MAX_DISTANCE  = 65535;
+static constexpr int      HASH_LOG      = 12;
+static constexpr int      RUN_MASK      = 15;
+static constexpr int      SKIP_TRIGGER  = 6;   // 连续找不到匹配时加快跳过的速度
+
+static inline uint32_t read32(const char* p) {
+  uint32_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+static inline uint64_t read64(const char* p) {
+  uint64_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+static inline uint32_t hash4(uint32_t v) { return (v * 2654435761U) >> (32 - HASH_LOG); }
+
+/// 从 a 和 b 开始有多少字节相同，最多比较到 limit
+static inline int match_length(const char* a, const char* b, const char* limit) {
+  const char* start = a;
+  while (a + 8 <= limit) {
+    const uint64_t diff = read64(a) ^ read64(b);
+    if (diff != 0) {
+      return static_cast<int>(a - start) + (__builtin_ctzll(diff) >> 3);
+    }
+    a += 8;
+    b += 8;
+  }
+  while (a < limit && *a == *b) {
+    a++;
+    b++;
+  }
+  return static_cast<int>(a - start);
+}
+
+/// 写长度的扩展字节，token 中的4位已经是 RUN_MASK
+static inline char* write_length(char* op, int length) {
+  while (length >= 255) {
+    *op++ = static_cast<char>(255);
+    length -= 255;
+  }
+  *op++ = static_cast<char>(length);
+  return op;
+}
+
+int lz4_compress(const char* src, int src_size, char* dst, int dst_capacity) {
+  if (src_size < 0 || dst_capacity <= 0) {
+    return 0;
+  }
+
+  char*       op     = dst;
+  char* const oend   = dst + dst_capacity;
+  const char* anchor = src;
+  const char* ip     = src;
+  const char* iend   = src + src_size;
+
+  if (src_size > MFLIMIT) {
+    const char* const mflimit     = iend - MFLIMIT;
+    const char* const match_limit = iend - LAST_LITERALS;
+    int32_t table[1 << HASH_LOG];
+    memset(table, -1, sizeof(table));
+
+    int misses = 0;
+    while (ip < mflimit) {
+      const uint32_t sequence = read32(ip);
+      const uint32_t h        = hash4(sequence);
+      const int32_t  ref_pos  = table[h];
+      table[h]                = static_cast<int32_t>(ip - src);
+
+      if (ref_pos < 0 || (ip - src) - ref_pos > MAX_DISTANCE || read32(src + ref_pos) != sequence) {
+        ip += 1 + (misses++ >> SKIP_TRIGGER);
+        continue;
+      }
+      misses = 0;
+      const char* ref = src + ref_pos;
+
+      // 向前扩展匹配
+      while (ip > anchor && ref > src && ip[-1] == ref[-1]) {
+        ip--;
+        ref--;
+      }
+      const int match_len = MIN_MATCH + match_length(ip + MIN_MATCH, ref + MIN_MATCH, match_limit);
+
+      // token + 字面量长度 + 字面量 + 偏移 + 匹配长度
+      const int literal_len = static_cast<int>(ip - anchor);
+      if (op + 1 + literal_len / 255 + 1 + literal_len + 2 + (match_len - MIN_MATCH) / 255 + 1 > oend) {
+        return 0;
+      }
+      char* token = op++;
+      if (literal_len >= RUN_MASK) {
+        *token = static_cast<char>(RUN_MASK << 4);
+        op     = write_length(op, literal_len - RUN_MASK);
+      } else {
+        *token = static_cast<char>(literal_len << 4);
+      }
+      memcpy(op, anchor, literal_len);
+      op += literal_len;
+
+      const uint16_t offset = static_cast<uint16_t>(ip - ref);
+      *op++ = static_cast<char>(offset & 0xFF);
+      *op++ = static_cast<char>(offset >> 8);
+
+      const int extra = match_len - MIN_MATCH;
+      if (extra >= RUN_MASK) {
+        *token = static_cast<char>(*token | RUN_MASK);
+        op     = write_length(op, extra - RUN_MASK);
+      } else {
+        *token = static_cast<char>(*token | extra);
+      }
+
+      ip += match_len;
+      anchor = ip;
+      // 匹配的最后位置也放进哈希表，连续的重复数据可以接着匹配
+      if (ip - 2 < mflimit) {
+        table[hash4(read32(ip - 2))] = static_cast<int32_t>(ip - 2 - src);
+      }
+    }
+  }
+
+  // 剩下的都是字面量
+  const int literal_len = static_cast<int>(iend - anchor);
+  if (op + 1 + literal_len / 255 + 1 + literal_len > oend) {
+    return 0;
+  }
+  char* token = op++;
+  if (literal_len >= RUN_MASK) {
+    *token = static_cast<char>(RUN_MASK << 4);
+    op     = write_length(op, literal_len - RUN_MASK);
+  } else {
+    *token = static_cast<char>(literal_len << 4);
+  }
+  memcpy(op, anchor, literal_len);
+  op += literal_len;
+  return static_cast<int>(op - dst);
+}
+
+/// 读长度的扩展字节，出错时返回-1
+static inline int read_length(const uint8_t*& ip, const uint8_t* iend, int length) {
+  uint8_t b = 0;
+  do {
+    if (ip >= iend) {
+      return -1;
+    }
+    b = *ip++;
+    length += b;
+  } while (b == 255 && length < (1 << 30));
+  return b == 255 ? -1 : length;
+}
+
+int lz4_decompress(const char* src, int src_size, char* dst, int dst_capacity) {
+  if (src_size <= 0 || dst_capacity < 0) {
+    return -1;
+  }
+
+  const uint8_t*       ip   = reinterpret_cast<const uint8_t*>(src);
+  const uint8_t* const iend = ip + src_size;
+  char*                op   = dst;
+  char* const          oend = dst + dst_capacity;
+
+  while (true) {
+    const uint8_t token = *ip++;
+
+    int literal_len = token >> 4;
+    if (literal_len == RUN_MASK) {
+      literal_len = read_length(ip, iend, literal_len);
+      if (literal_len < 0) {
+        return -1;
+      }
+    }
+    if (literal_len > iend - ip || literal_len > oend - op) {
+      return -1;
+    }
+    memcpy(op, ip, literal_len);
+    op += literal_len;
+    ip += literal_len;
+
+    // 最后一个序列只有字面量
+    if (ip == iend) {
+      break;
+    }
+
+    if (iend - ip < 2) {
+      return -1;
+    }
+    const int offset = ip[0] | (ip[1] << 8);
+    ip += 2;
+    if (offset == 0 || offset > op - dst) {
+      return -1;
+    }
+
+    int match_len = token & RUN_MASK;
+    if (match_len == RUN_MASK) {
+      match_len = read_length(ip, iend, match_len);
+      if (match_len < 0) {
+        return -1;
+      }
+    }
+    match_len += MIN_MATCH;
+    if (match_len > oend - op) {
+      return -1;
+    }
+
+    const char* match = op - offset;
+    if (offset >= match_len) {
+      memcpy(op, match, match_len);
+      op += match_len;
+    } else if (offset >= 8) {
+      // 重叠的部分每次复制8字节，前面复制的结果正好是后面要用的
+      char* const end = op + match_len;
+      while (op + 8 <= end) {
+        memcpy(op, match, 8);
+        op += 8;
+        match += 8;
+      }
+      while (op < end) {
+        *op++ = *match++;
+      }
+    } else {
+      for (int i = 0; i < match_len; i++) {
+        *op++ = *match++;
+      }
+    }
+
+    if (ip >= iend) {
+      return -1;
+    }
+  }
+  return static_cast<int>(op - dst);
+}
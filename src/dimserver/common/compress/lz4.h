@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief LZ4 块格式(block format)的压缩和解压
+ * @details 和 liblz4 的 LZ4_compress_default/LZ4_decompress_safe 格式兼容，不包含帧格式(frame format)。
+ * 压缩使用单个哈希表的贪心匹配，适合日志这种压缩一次、很少读取的数据，速度优先。
+ * 解压会检查输入，损坏的数据不会越界读写。
+ */
+
+/**
+ * @brief size 字节的数据压缩之后最多有多少字节
+ */
+inline size_t lz4_compress_bound(size_t size) { return size + size / 255 + 16; }
+
+/**
+ * @brief 压缩
+ * @param src 原始数据
+ * @param src_size 原始数据大小
+ * @param dst 输出缓冲区
+ * @param dst_capacity 输出缓冲区大小，不小于 lz4_compress_bound(src_size) 时一定成功
+ * @return 压缩之后的大小，输出缓冲区放不下时返回0
+ */
+int lz4_compress(const char* src, int src_size, char* dst, int dst_capacity);
+
+/**
+ * @brief 解压
+ * @param src 压缩的数据
+ * @param src_size 压缩的数据大小
+ * @param dst 输出缓冲区
+ * @param dst_capacity 输出缓冲区大小
+ * @return 解压之后的大小，数据格式错误或者输出缓冲区放不下时返回-1
+ */
+int lz4_decompress(const char* src, int src_size, char* dst, int dst_capacity);
@@ -0,0 +1,613 @@
+#include <limits.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#if defined(__linux__)
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#endif
+
+#include "common/io/async_io.h"
+#include "common/io/io.h"
+#include "common/log/log.h"
+
+namespace common {
+
+const char* async_io_backend_name(AsyncIoBackend backend) {
+  switch (backend) {
+    case AsyncIoBackend::AUTO: return "auto";
+    case AsyncIoBackend::IO_URING: return "io_uring";
+    case AsyncIoBackend::THREAD_POOL: return "thread_pool";
+  }
+  return "unknown";
+}
+
+void AsyncIoRequest::prep_read(int fd, void* data, size_t size, off_t offset) {
+  this->op     = AsyncIoOp::READ;
+  this->fd     = fd;
+  this->iov    = nullptr;
+  this->iovcnt = 0;
+  this->buf    = {data, size};
+  this->offset = offset;
+  this->result = 0;
+}
+
+void AsyncIoRequest::prep_write(int fd, const void* data, size_t size, off_t offset) {
+  prep_read(fd, const_cast<void*>(data), size, offset);
+  this->op = AsyncIoOp::WRITE;
+}
+
+void AsyncIoRequest::prep_readv(int fd, struct iovec* iov, int iovcnt, off_t offset) {
+  this->op     = AsyncIoOp::READ;
+  this->fd     = fd;
+  this->iov    = iov;
+  this->iovcnt = iovcnt;
+  this->buf    = {nullptr, 0};
+  this->offset = offset;
+  this->result = 0;
+}
+
+void AsyncIoRequest::prep_writev(int fd, struct iovec* iov, int iovcnt, off_t offset) {
+  prep_readv(fd, iov, iovcnt, offset);
+  this->op = AsyncIoOp::WRITE;
+}
+
+void AsyncIoRequest::prep_fsync(int fd, bool datasync /* = true */) {
+  prep_readv(fd, nullptr, 0, 0);
+  this->op       = AsyncIoOp::FSYNC;
+  this->datasync = datasync;
+}
+
+/**
+ * @brief 跳过请求中已经完成的 n 字节
+ * @return 还剩多少字节
+ */
+static size_t consume_iovecs(AsyncIoRequest& request, size_t n) {
+  struct iovec* iov = request.iovecs();
+  int           cnt = request.iovec_count();
+  request.offset += n;
+  while (cnt > 0 && n >= iov->iov_len) {
+    n -= iov->iov_len;
+    iov->iov_len = 0;
+    iov++;
+    cnt--;
+  }
+  if (cnt > 0) {
+    iov->iov_base = static_cast<char*>(iov->iov_base) + n;
+    iov->iov_len -= n;
+  }
+  if (request.iov != nullptr) {
+    request.iov    = iov;
+    request.iovcnt = cnt;
+  }
+
+  size_t remaining = 0;
+  for (int i = 0; i < cnt; i++) {
+    remaining += iov[i].iov_len;
+  }
+  return remaining;
+}
+
+void AsyncIoEngine::execute_sync(AsyncIoRequest& request) {
+  switch (request.op) {
+    case AsyncIoOp::READ: {
+      struct iovec* iov    = request.iovecs();
+      off_t         offset = request.offset;
+      request.result       = 0;
+      for (int i = 0; i < request.iovec_count() && request.result == 0; i++) {
+        request.result = preadn(request.fd, iov[i].iov_base, iov[i].iov_len, offset);
+        offset += iov[i].iov_len;
+      }
+    } break;
+    case AsyncIoOp::WRITE: {
+      request.result = pwritevn(request.fd, request.iovecs(), request.iovec_count(), request.offset);
+    } break;
+    case AsyncIoOp::FSYNC: {
+      const int ret  = request.datasync ? ::fdatasync(request.fd) : ::fsync(request.fd);
+      request.result = ret == 0 ? 0 : errno;
+    } break;
+  }
+}
+
+int AsyncIoEngine::execute(AsyncIoRequest* requests, int count) {
+  std::vector<AsyncIoRequest*> completed(queue_depth_);
+  int next = 0;
+  int done = 0;
+  while (done < count) {
+    // 补满队列之后一次提交
+    while (next < count && inflight_ < queue_depth_ && prepare(&requests[next]) == 0) {
+      next++;
+    }
+    int ret = submit();
+    if (ret != 0) {
+      LOG_ERROR("failed to submit async io requests. backend=%s, error=%s", async_io_backend_name(backend()),
+          strerror(ret));
+      return ret;
+    }
+
+    ret = reap(1, completed.data(), static_cast<int>(completed.size()));
+    if (ret < 0) {
+      LOG_ERROR("failed to reap async io requests. backend=%s, error=%s", async_io_backend_name(backend()),
+          strerror(-ret));
+      return -ret;
+    }
+    done += ret;
+  }
+
+  for (int i = 0; i < count; i++) {
+    if (requests[i].result != 0) {
+      return requests[i].result;
+    }
+  }
+  return 0;
+}
+
+
+/******************** ThreadPoolIoEngine ********************/
+
+/**
+ * @brief 线程池实现的异步IO
+ */
+class ThreadPoolIoEngine : public AsyncIoEngine {
+public:
+  ThreadPoolIoEngine(int queue_depth, int threads);
+  ~ThreadPoolIoEngine() override;
+
+  AsyncIoBackend backend() const override { return AsyncIoBackend::THREAD_POOL; }
+
+  int prepare(AsyncIoRequest* request) override;
+  int submit() override;
+  int reap(int min_complete, AsyncIoRequest** completed, int max) override;
+
+private:
+  void thread_func();
+
+private:
+  std::vector<AsyncIoRequest*> pending_;  /// 准备好还没有提交的请求，只有调用者访问
+
+  std::mutex                  mutex_;  /// 保护下面的成员
+  std::condition_variable     work_cond_;
+  std::condition_variable     done_cond_;
+  std::deque<AsyncIoRequest*> queue_;
+  std::deque<AsyncIoRequest*> completed_;
+  bool                        stop_ = false;
+
+  std::vector<std::thread> threads_;
+};
+
+ThreadPoolIoEngine::ThreadPoolIoEngine(int queue_depth, int threads) : AsyncIoEngine(queue_depth) {
+  for (int i = 0; i < threads; i++) {
+    threads_.emplace_back(&ThreadPoolIoEngine::thread_func, this);
+  }
+}
+
+ThreadPoolIoEngine::~ThreadPoolIoEngine() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  work_cond_.notify_all();
+  for (auto& thread : threads_) {
+    thread.join();
+  }
+}
+
+int ThreadPoolIoEngine::prepare(AsyncIoRequest* request) {
+  if (inflight_ >= queue_depth_) {
+    return EAGAIN;
+  }
+  pending_.push_back(request);
+  inflight_++;
+  return 0;
+}
+
+int ThreadPoolIoEngine::submit() {
+  if (pending_.empty()) {
+    return 0;
+  }
+
+  // 只有一个请求时交给其他线程只会多一次线程切换
+  if (pending_.size() == 1 && inflight_ == 1) {
+    execute_sync(*pending_.front());
+    std::lock_guard<std::mutex> lock(mutex_);
+    completed_.push_back(pending_.front());
+    pending_.clear();
+    return 0;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    queue_.insert(queue_.end(), pending_.begin(), pending_.end());
+  }
+  if (pending_.size() == 1) {
+    work_cond_.notify_one();
+  } else {
+    work_cond_.notify_all();
+  }
+  pending_.clear();
+  return 0;
+}
+
+int ThreadPoolIoEngine::reap(int min_complete, AsyncIoRequest** completed, int max) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  const size_t wait_num = static_cast<size_t>(std::min(min_complete, inflight_ - static_cast<int>(pending_.size())));
+  done_cond_.wait(lock, [this, wait_num]() { return completed_.size() >= wait_num; });
+
+  int count = 0;
+  for (; count < max && !completed_.empty(); count++) {
+    completed[count] = completed_.front();
+    completed_.pop_front();
+  }
+  inflight_ -= count;
+  return count;
+}
+
+void ThreadPoolIoEngine::thread_func() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    work_cond_.wait(lock, [this]() { return stop_ || !queue_.empty(); });
+    if (queue_.empty()) {
+      return;
+    }
+
+    AsyncIoRequest* request = queue_.front();
+    queue_.pop_front();
+    lock.unlock();
+    execute_sync(*request);
+    lock.lock();
+    completed_.push_back(request);
+    done_cond_.notify_one();
+  }
+}
+
+
+/******************** IoUringEngine ********************/
+
+#if defined(__linux__) && defined(__NR_io_uring_setup)
+
+/**
+ * @brief io_uring 实现的异步IO，直接使用系统调用
+ */
+class IoUringEngine : public AsyncIoEngine {
+public:
+  explicit IoUringEngine(int queue_depth) : AsyncIoEngine(queue_depth) {}
+  ~IoUringEngine() override;
+
+  /**
+   * @brief 创建 io_uring 并映射提交队列和完成队列
+   * @return 成功返回0，失败返回errno
+   */
+  int init();
+
+  AsyncIoBackend backend() const override { return AsyncIoBackend::IO_URING; }
+
+  int register_files(const int* fds, int count) override;
+  int register_buffers(const struct iovec* buffers, int count) override;
+
+  int prepare(AsyncIoRequest* request) override;
+  int submit() override;
+  int reap(int min_complete, AsyncIoRequest** completed, int max) override;
+
+private:
+  /// 把请求填到提交队列的下一个位置，还不通知内核
+  void queue_request(AsyncIoRequest* request);
+  /// 处理一个完成事件，请求全部完成时返回 true，部分完成时继续提交剩下的部分
+  bool complete(AsyncIoRequest* request, int res);
+  /// 请求的内存完全落在哪个注册的内存中，没有时返回-1
+  int  find_buffer(const struct iovec& buf) const;
+  /// 调用 io_uring_enter，成功返回提交的请求数，失败返回负的errno
+  int  enter(unsigned to_submit, unsigned min_complete, unsigned flags);
+
+private:
+  int    ring_fd_      = -1;
+  void*  sq_ring_      = nullptr;
+  size_t sq_ring_size_ = 0;
+  void*  cq_ring_      = nullptr;
+  size_t cq_ring_size_ = 0;
+  struct io_uring_sqe* sqes_      = nullptr;
+  size_t               sqes_size_ = 0;
+
+  unsigned* sq_tail_  = nullptr;
+  unsigned* sq_mask_  = nullptr;
+  unsigned* sq_array_ = nullptr;
+  unsigned* cq_head_  = nullptr;
+  unsigned* cq_tail_  = nullptr;
+  unsigned* cq_mask_  = nullptr;
+  struct io_uring_cqe* cqes_ = nullptr;
+
+  unsigned sq_local_tail_ = 0;  /// 已经填好的提交队列位置，submit 时才通知内核
+  unsigned to_submit_     = 0;  /// 已经填好还没有被内核取走的请求数
+
+  std::unordered_map<int, int> files_;    /// 注册的文件描述符 -> 注册时的下标
+  std::vector<struct iovec>    buffers_;  /// 注册的内存
+};
+
+static int io_uring_register(int ring_fd, unsigned opcode, const void* arg, unsigned nr_args) {
+  return static_cast<int>(syscall(__NR_io_uring_register, ring_fd, opcode, arg, nr_args));
+}
+
+IoUringEngine::~IoUringEngine() {
+  // 内核还在使用请求的内存，等它们完成
+  std::vector<AsyncIoRequest*> completed(queue_depth_);
+  while (inflight_ > 0 && ring_fd_ >= 0) {
+    if (submit() != 0 || reap(inflight_, completed.data(), queue_depth_) < 0) {
+      break;
+    }
+  }
+
+  if (sqes_ != nullptr) {
+    munmap(sqes_, sqes_size_);
+  }
+  if (cq_ring_ != nullptr && cq_ring_ != sq_ring_) {
+    munmap(cq_ring_, cq_ring_size_);
+  }
+  if (sq_ring_ != nullptr) {
+    munmap(sq_ring_, sq_ring_size_);
+  }
+  if (ring_fd_ >= 0) {
+    close(ring_fd_);
+  }
+}
+
+int IoUringEngine::init() {
+  struct io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  ring_fd_ = static_cast<int>(syscall(__NR_io_uring_setup, queue_depth_, &params));
+  if (ring_fd_ < 0) {
+    return errno;
+  }
+
+  sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+  const bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+  if (single_mmap) {
+    sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+  }
+
+  void* ring = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_,
+      IORING_OFF_SQ_RING);
+  if (ring == MAP_FAILED) {
+    return errno;
+  }
+  sq_ring_ = ring;
+  if (single_mmap) {
+    cq_ring_ = sq_ring_;
+  } else {
+    ring = mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_,
+        IORING_OFF_CQ_RING);
+    if (ring == MAP_FAILED) {
+      return errno;
+    }
+    cq_ring_ = ring;
+  }
+
+  sqes_size_ = params.sq_entries * sizeof(struct io_uring_sqe);
+  ring = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES);
+  if (ring == MAP_FAILED) {
+    return errno;
+  }
+  sqes_ = static_cast<struct io_uring_sqe*>(ring);
+
+  char* sq = static_cast<char*>(sq_ring_);
+  char* cq = static_cast<char*>(cq_ring_);
+  sq_tail_  = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+  sq_mask_  = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+  sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+  cq_head_  = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+  cq_tail_  = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+  cq_mask_  = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+  cqes_     = reinterpret_cast<struct io_uring_cqe*>(cq + params.cq_off.cqes);
+
+  sq_local_tail_ = *sq_tail_;
+  // 提交队列可能比要求的大，同时进行的请求不超过提交队列，每个请求最多占一个位置
+  queue_depth_ = std::min<int>(queue_depth_, params.sq_entries);
+  return 0;
+}
+
+int IoUringEngine::register_files(const int* fds, int count) {
+  if (!files_.empty()) {
+    io_uring_register(ring_fd_, IORING_UNREGISTER_FILES, nullptr, 0);
+    files_.clear();
+  }
+  if (count <= 0) {
+    return 0;
+  }
+
+  if (io_uring_register(ring_fd_, IORING_REGISTER_FILES, fds, count) != 0) {
+    const int ret = errno;
+    LOG_WARN("failed to register files to io_uring. count=%d, error=%s", count, strerror(ret));
+    return ret;
+  }
+  for (int i = 0; i < count; i++) {
+    files_[fds[i]] = i;
+  }
+  return 0;
+}
+
+int IoUringEngine::register_buffers(const struct iovec* buffers, int count) {
+  if (!buffers_.empty()) {
+    io_uring_register(ring_fd_, IORING_UNREGISTER_BUFFERS, nullptr, 0);
+    buffers_.clear();
+  }
+  if (count <= 0) {
+    return 0;
+  }
+
+  if (io_uring_register(ring_fd_, IORING_REGISTER_BUFFERS, buffers, count) != 0) {
+    // 通常是超过了 RLIMIT_MEMLOCK
+    const int ret = errno;
+    LOG_WARN("failed to register buffers to io_uring. count=%d, error=%s", count, strerror(ret));
+    return ret;
+  }
+  buffers_.assign(buffers, buffers + count);
+  return 0;
+}
+
+int IoUringEngine::find_buffer(const struct iovec& buf) const {
+  const char* begin = static_cast<const char*>(buf.iov_base);
+  for (size_t i = 0; i < buffers_.size(); i++) {
+    const char* base = static_cast<const char*>(buffers_[i].iov_base);
+    if (begin >= base && begin + buf.iov_len <= base + buffers_[i].iov_len) {
+      return static_cast<int>(i);
+    }
+  }
+  return -1;
+}
+
+void IoUringEngine::queue_request(AsyncIoRequest* request) {
+  const unsigned       index = sq_local_tail_ & *sq_mask_;
+  struct io_uring_sqe* sqe   = &sqes_[index];
+  memset(sqe, 0, sizeof(*sqe));
+  sqe->user_data = reinterpret_cast<uint64_t>(request);
+
+  auto file_iter = files_.find(request->fd);
+  if (file_iter != files_.end()) {
+    sqe->fd = file_iter->second;
+    sqe->flags |= IOSQE_FIXED_FILE;
+  } else {
+    sqe->fd = request->fd;
+  }
+
+  const bool read = request->op == AsyncIoOp::READ;
+  if (request->op == AsyncIoOp::FSYNC) {
+    sqe->opcode      = IORING_OP_FSYNC;
+    sqe->fsync_flags = request->datasync ? IORING_FSYNC_DATASYNC : 0;
+  } else if (request->iov == nullptr && request->buf.iov_len <= UINT32_MAX && find_buffer(request->buf) >= 0) {
+    sqe->opcode    = read ? IORING_OP_READ_FIXED : IORING_OP_WRITE_FIXED;
+    sqe->off       = request->offset;
+    sqe->addr      = reinterpret_cast<uint64_t>(request->buf.iov_base);
+    sqe->len       = static_cast<uint32_t>(request->buf.iov_len);
+    sqe->buf_index = static_cast<uint16_t>(find_buffer(request->buf));
+  } else {
+    // 超过 IOV_MAX 的部分在这一段完成之后继续提交
+    sqe->opcode = read ? IORING_OP_READV : IORING_OP_WRITEV;
+    sqe->off    = request->offset;
+    sqe->addr   = reinterpret_cast<uint64_t>(request->iovecs());
+    sqe->len    = static_cast<uint32_t>(std::min(request->iovec_count(), IOV_MAX));
+  }
+
+  sq_array_[index] = index;
+  sq_local_tail_++;
+  to_submit_++;
+}
+
+int IoUringEngine::prepare(AsyncIoRequest* request) {
+  if (inflight_ >= queue_depth_) {
+    return EAGAIN;
+  }
+  queue_request(request);
+  inflight_++;
+  return 0;
+}
+
+int IoUringEngine::enter(unsigned to_submit, unsigned min_complete, unsigned flags) {
+  // 先让内核看到填好的请求
+  __atomic_store_n(sq_tail_, sq_local_tail_, __ATOMIC_RELEASE);
+  const int ret = static_cast<int>(syscall(__NR_io_uring_enter, ring_fd_, to_submit, min_complete, flags, nullptr, 0));
+  if (ret < 0) {
+    return -errno;
+  }
+  to_submit_ -= std::min<unsigned>(ret, to_submit_);
+  return ret;
+}
+
+int IoUringEngine::submit() {
+  while (to_submit_ > 0) {
+    const int ret = enter(to_submit_, 0, 0);
+    if (ret == -EINTR || ret == -EAGAIN || ret == -EBUSY) {
+      std::this_thread::yield();
+      continue;
+    }
+    if (ret < 0) {
+      return -ret;
+    }
+  }
+  return 0;
+}
+
+bool IoUringEngine::complete(AsyncIoRequest* request, int res) {
+  if (res == -EINTR || res == -EAGAIN) {
+    queue_request(request);
+    return false;
+  }
+  if (res < 0) {
+    request->result = -res;
+    return true;
+  }
+  if (request->op == AsyncIoOp::FSYNC) {
+    request->result = 0;
+    return true;
+  }
+
+  if (consume_iovecs(*request, static_cast<size_t>(res)) == 0) {
+    request->result = 0;
+    return true;
+  }
+  if (res == 0) {
+    // 没有进展，读的话是到了文件末尾
+    request->result = request->op == AsyncIoOp::READ ? -1 : EIO;
+    return true;
+  }
+  queue_request(request);
+  return false;
+}
+
+int IoUringEngine::reap(int min_complete, AsyncIoRequest** completed, int max) {
+  min_complete = std::min({min_complete, inflight_, max});
+  int count    = 0;
+  while (true) {
+    unsigned       head = *cq_head_;
+    const unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+    for (; head != tail && count < max; head++) {
+      const struct io_uring_cqe* cqe     = &cqes_[head & *cq_mask_];
+      AsyncIoRequest*            request = reinterpret_cast<AsyncIoRequest*>(cqe->user_data);
+      if (complete(request, cqe->res)) {
+        completed[count++] = request;
+        inflight_--;
+      }
+    }
+    __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+    if (count >= min_complete) {
+      break;
+    }
+
+    // 提交部分完成的请求剩下的部分，同时等待
+    const int ret = enter(to_submit_, min_complete - count, IORING_ENTER_GETEVENTS);
+    if (ret < 0 && ret != -EINTR && ret != -EAGAIN && ret != -EBUSY) {
+      return ret;
+    }
+  }
+
+  const int ret = submit();
+  return ret == 0 ? count : -ret;
+}
+
+#endif  // __NR_io_uring_setup
+
+std::unique_ptr<AsyncIoEngine> AsyncIoEngine::create(AsyncIoBackend backend /* = AUTO */,
+    int queue_depth /* = DEFAULT_QUEUE_DEPTH */, int threads /* = DEFAULT_THREADS */) {
+  queue_depth = std::max(queue_depth, 1);
+#if defined(__linux__) && defined(__NR_io_uring_setup)
+  if (backend != AsyncIoBackend::THREAD_POOL) {
+    auto engine = std::make_unique<IoUringEngine>(queue_depth);
+    const int ret = engine->init();
+    if (ret == 0) {
+      return engine;
+    }
+    LOG_WARN("io_uring is not available, fall back to thread pool. error=%s", strerror(ret));
+  }
+#endif
+  return std::make_unique<ThreadPoolIoEngine>(queue_depth, std::max(threads, 1));
+}
+
+} // namespace common
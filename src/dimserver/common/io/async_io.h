@@ -0,0 +1,144 @@
+#pragma once
+
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <memory>
+
+namespace common {
+
+/**
+ * @brief 异步IO的实现方式
+ */
+enum class AsyncIoBackend {
+  AUTO,         /// 优先使用 io_uring，内核不支持或者被禁止时使用 THREAD_POOL
+  IO_URING,     /// io_uring，一个线程就可以让设备上同时有多个请求
+  THREAD_POOL,  /// 几个线程执行阻塞的 pread/pwritev，任何系统都可以用
+};
+
+const char* async_io_backend_name(AsyncIoBackend backend);
+
+enum class AsyncIoOp {
+  READ,
+  WRITE,
+  FSYNC,
+};
+
+/**
+ * @brief 一个异步IO请求
+ * @details 和 preadn/pwritevn 一样，读写完整个请求才算完成，部分完成时由引擎继续提交剩下的部分。
+ * 请求提交之后到完成之前，请求本身和它引用的内存都不能释放或修改。
+ */
+struct AsyncIoRequest {
+  AsyncIoOp     op       = AsyncIoOp::READ;
+  int           fd       = -1;
+  struct iovec* iov      = nullptr;  /// 多段读写的数据段，部分完成时会被修改。为空时使用 buf
+  int           iovcnt   = 0;
+  struct iovec  buf      = {nullptr, 0};  /// 单段读写
+  off_t         offset   = 0;
+  bool          datasync = true;     /// FSYNC 只同步数据，相当于 fdatasync
+  void*         user_data = nullptr;
+  int           result    = 0;  /// 完成之后设置：成功返回0，读到文件末尾返回-1，失败返回errno
+
+  void prep_read(int fd, void* data, size_t size, off_t offset);
+  void prep_write(int fd, const void* data, size_t size, off_t offset);
+  void prep_readv(int fd, struct iovec* iov, int iovcnt, off_t offset);
+  void prep_writev(int fd, struct iovec* iov, int iovcnt, off_t offset);
+  void prep_fsync(int fd, bool datasync = true);
+
+  struct iovec* iovecs() { return iov != nullptr ? iov : &buf; }
+  int           iovec_count() const { return iov != nullptr ? iovcnt : 1; }
+};
+
+/**
+ * @brief 异步IO引擎
+ * @details 请求先通过 prepare 放进提交队列，submit 一次提交所有准备好的请求，reap 等待请求完成。
+ * 同时进行(已经准备但是还没有被 reap 取走)的请求不超过 queue_depth 个。
+ * 一般直接使用 execute：一个线程提交一批请求，设备上始终保持 queue_depth 个请求，全部完成之后返回。
+ *
+ * - io_uring：直接使用系统调用，不依赖 liburing。submit 只需要一次 io_uring_enter，
+ *   通过 register_files/register_buffers 注册的文件和内存不需要每次请求都在内核中查找和映射；
+ * - 线程池：threads 个线程从队列中取请求执行阻塞的IO。只有一个请求时在调用线程中直接执行。
+ *
+ * 同一个引擎同一时间只能由一个线程使用(io_uring 的提交队列只有一个生产者)，需要并发的地方各自创建引擎，
+ * 或者由调用者加锁。
+ */
+class AsyncIoEngine {
+public:
+  static constexpr int DEFAULT_QUEUE_DEPTH = 32;
+  static constexpr int DEFAULT_THREADS     = 4;
+
+  /**
+   * @brief 创建异步IO引擎
+   * @param backend 实现方式，AUTO 和 IO_URING 在 io_uring 不可用时都会退回线程池，通过 backend() 可以知道实际使用的方式
+   * @param queue_depth 最多同时进行多少个请求
+   * @param threads 线程池的线程数，io_uring 不使用
+   */
+  static std::unique_ptr<AsyncIoEngine> create(AsyncIoBackend backend = AsyncIoBackend::AUTO,
+      int queue_depth = DEFAULT_QUEUE_DEPTH, int threads = DEFAULT_THREADS);
+
+  virtual ~AsyncIoEngine() = default;
+
+  virtual AsyncIoBackend backend() const = 0;
+  int queue_depth() const { return queue_depth_; }
+  int inflight() const { return inflight_; }
+
+  /**
+   * @brief 注册经常读写的文件，替换之前注册的文件
+   * @details io_uring 提交这些文件上的请求时不需要再查找文件描述符。文件关闭之前需要用新的文件集合重新注册，
+   * 否则引擎中还引用着这个文件。线程池什么都不做
+   * @return 成功返回0，失败返回errno，失败时请求还是可以正常执行
+   */
+  virtual int register_files([[maybe_unused]] const int* fds, [[maybe_unused]] int count) { return 0; }
+
+  /**
+   * @brief 注册经常读写的内存，替换之前注册的内存
+   * @details io_uring 读写完全落在这些内存中的单段请求时使用 READ_FIXED/WRITE_FIXED，不需要每次都映射内存页。
+   * 注册的内存会被锁定，受 RLIMIT_MEMLOCK 的限制。线程池什么都不做
+   * @return 成功返回0，失败返回errno，失败时请求还是可以正常执行
+   */
+  virtual int register_buffers([[maybe_unused]] const struct iovec* buffers, [[maybe_unused]] int count) {
+    return 0;
+  }
+
+  /**
+   * @brief 把请求放进提交队列，不会发起系统调用
+   * @return 成功返回0，同时进行的请求已经达到 queue_depth 时返回 EAGAIN，需要先 reap
+   */
+  virtual int prepare(AsyncIoRequest* request) = 0;
+
+  /**
+   * @brief 提交所有准备好的请求
+   * @return 成功返回0，失败返回errno
+   */
+  virtual int submit() = 0;
+
+  /**
+   * @brief 等待请求完成
+   * @param min_complete 至少等待多少个请求完成，不超过 inflight()
+   * @param completed 输出参数，完成的请求
+   * @param max 最多返回多少个请求
+   * @return 完成的请求个数，失败时返回负的errno
+   */
+  virtual int reap(int min_complete, AsyncIoRequest** completed, int max) = 0;
+
+  /**
+   * @brief 执行一批请求，全部完成之后返回
+   * @details 请求之间没有顺序，需要先写再落盘时分两次调用。引擎中不能有其他还没有完成的请求
+   * @return 全部成功返回0，否则返回第一个失败的请求的 result，每个请求的 result 都会设置
+   */
+  int execute(AsyncIoRequest* requests, int count);
+
+protected:
+  explicit AsyncIoEngine(int queue_depth) : queue_depth_(queue_depth) {}
+
+  /**
+   * @brief 用阻塞的IO执行一个请求，设置 result
+   */
+  static void execute_sync(AsyncIoRequest& request);
+
+protected:
+  int queue_depth_ = 0;
+  int inflight_    = 0;  /// 已经准备、还没有被 reap 取走的请求数
+};
+
+} // namespace common
@@ -1,5 +1,10 @@
+#include <fcntl.h>
 #include <unistd.h>
 #include <errno.h>
+#include <limits.h>
+#include <algorithm>
+
+#include "common/io/io.h"
 
 /**
  * @file io.cpp
@@ -62,4 +67,90 @@ int readn(int fd, void* buf, size_t size) {
     }
   }
   return 0;
-}
\ No newline at end of file
+}
+/**
+ * @brief writevn函数实现
+ * @details 每次最多提交 IOV_MAX 个数据段，部分写入时跳过已经写完的数据段，
+ * 并调整写了一半的数据段的起始位置
+ */
+int writevn(int fd, struct iovec* iov, int iovcnt) {
+  while (iovcnt > 0) {
+    const ssize_t n = ::writev(fd, iov, std::min(iovcnt, IOV_MAX));
+    if (n < 0) {
+      if (errno != EAGAIN && errno != EINTR) {
+        return errno;
+      }
+      continue;
+    }
+
+    size_t left = static_cast<size_t>(n);
+    while (iovcnt > 0 && left >= iov->iov_len) {
+      left -= iov->iov_len;
+      iov++;
+      iovcnt--;
+    }
+    if (left > 0) {
+      iov->iov_base = static_cast<char*>(iov->iov_base) + left;
+      iov->iov_len -= left;
+    }
+  }
+  return 0;
+}
+
+int preadn(int fd, void* buf, size_t size, off_t offset) {
+  char* ptr = static_cast<char*>(buf);
+  while (size > 0) {
+    const ssize_t n = ::pread(fd, ptr, size, offset);
+    if (n > 0) {
+      ptr += n;
+      size -= n;
+      offset += n;
+      continue;
+    } else if (n == 0) { // 文件结束
+      return -1;
+    } else if (errno != EAGAIN && errno != EINTR) {
+      return errno;
+    }
+  }
+  return 0;
+}
+
+/**
+ * @brief pwritevn函数实现
+ * @details 和 writevn 一样处理部分写入，每次写入之后推进 offset
+ */
+int pwritevn(int fd, struct iovec* iov, int iovcnt, off_t offset) {
+  while (iovcnt > 0) {
+    const ssize_t n = ::pwritev(fd, iov, std::min(iovcnt, IOV_MAX), offset);
+    if (n < 0) {
+      if (errno != EAGAIN && errno != EINTR) {
+        return errno;
+      }
+      continue;
+    }
+
+    offset += n;
+    size_t left = static_cast<size_t>(n);
+    while (iovcnt > 0 && left >= iov->iov_len) {
+      left -= iov->iov_len;
+      iov++;
+      iovcnt--;
+    }
+    if (left > 0) {
+      iov->iov_base = static_cast<char*>(iov->iov_base) + left;
+      iov->iov_len -= left;
+    }
+  }
+  return 0;
+}
+
+int open_file(const char* filename, int flags, mode_t mode, bool& direct) {
+  if (direct) {
+    int fd = ::open(filename, flags | O_DIRECT, mode);
+    if (fd >= 0 || errno != EINVAL) {
+      return fd;
+    }
+    direct = false;
+  }
+  return ::open(filename, flags, mode);
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <sys/types.h>
+#include <sys/uio.h>
 
 /**
  * @brief 可靠地写入指定大小的数据
@@ -28,4 +29,62 @@ int writen(int fd, const void* buf, size_t size);
  *       处理EINTR（被信号中断）和EAGAIN（非阻塞IO暂时无法读取）的情况
  *       适用于网络编程和文件操作中的可靠读取
  */
-int readn(int fd, void* buf, size_t size);
\ No newline at end of file
+int readn(int fd, void* buf, size_t size);
+
+/**
+ * @brief 可靠地写入多段数据，相当于循环调用 writev
+ * 
+ * @param fd 文件描述符
+ * @param iov 数据段数组，部分写入时会被修改
+ * @param iovcnt 数据段个数，可以超过 IOV_MAX
+ * @return int 成功返回0，失败返回errno
+ * 
+ * @note 和 writen 一样处理部分写入、EINTR 和 EAGAIN，
+ *       用来把多条日志合并成一次系统调用
+ */
+int writevn(int fd, struct iovec* iov, int iovcnt);
+/**
+ * @brief 从指定位置可靠地读取指定大小的数据，相当于循环调用 pread
+ *
+ * @param fd 文件描述符
+ * @param buf 读取数据的缓冲区
+ * @param size 要读取的字节数
+ * @param offset 文件中的起始位置
+ * @return int 成功返回0，读到文件末尾返回-1，失败返回errno
+ */
+int preadn(int fd, void* buf, size_t size, off_t offset);
+
+/**
+ * @brief 从指定位置可靠地写入多段数据，相当于循环调用 pwritev，不修改文件偏移
+ *
+ * @param fd 文件描述符
+ * @param iov 数据段数组，部分写入时会被修改
+ * @param iovcnt 数据段个数，可以超过 IOV_MAX
+ * @param offset 文件中的起始位置
+ * @return int 成功返回0，失败返回errno
+ */
+int pwritevn(int fd, struct iovec* iov, int iovcnt, off_t offset);
+
+/**
+ * @brief 直接IO(O_DIRECT)要求内存地址、读写长度和文件偏移按这个大小对齐
+ */
+static constexpr size_t DIRECT_IO_ALIGN = 4096;
+
+/**
+ * @brief 打开文件，direct 为 true 时加上 O_DIRECT 绕过内核的页缓存
+ *
+ * @param filename 文件名
+ * @param flags open 的参数
+ * @param mode 创建文件时的权限
+ * @param direct 是否使用直接IO。文件系统不支持(比如 tmpfs 返回 EINVAL)时退回普通IO，
+ *               返回时设置成实际是否使用了直接IO
+ * @return int 成功返回文件描述符，失败返回-1，errno 是失败原因
+ */
+int open_file(const char* filename, int flags, mode_t mode, bool& direct);
+
+/**
+ * @brief 检查内存地址、长度和文件偏移是否满足直接IO的对齐要求
+ */
+inline bool direct_io_aligned(const void* buf, size_t size, off_t offset) {
+  return (reinterpret_cast<size_t>(buf) | size | static_cast<size_t>(offset)) % DIRECT_IO_ALIGN == 0;
+}
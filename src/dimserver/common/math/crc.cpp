@@ -1,65 +1,238 @@
+#include <array>
 #include <cstdint>
+#include <cstring>
 
-constexpr uint32_t crc_table[] = {
-  0x00000000, 0x77073096, 0xEE0E612C, 0x990951BA, 0x076DC419, 0x706AF48F, 0xE963A535, 0x9E6495A3,
-  0x0EDB8832, 0x79DCB8A4, 0xE0D5E91E, 0x97D2D988, 0x09B64C2B, 0x7EB17CBD, 0xE7B82D07, 0x90BF1D91,
-  0x1DB71064, 0x6AB020F2, 0xF3B97148, 0x84BE41DE, 0x1ADAD47D, 0x6DDDE4EB, 0xF4D4B551, 0x83D385C7,
-  0x136C9856, 0x646BA8C0, 0xFD62F97A, 0x8A65C9EC, 0x14015C4F, 0x63066CD9, 0xFA0F3D63, 0x8D080DF5,
-  0x3B6E20C8, 0x4C69105E, 0xD56041E4, 0xA2677172, 0x3C03E4D1, 0x4B04D447, 0xD20D85FD, 0xA50AB56B,
-  0x35B5A8FA, 0x42B2986C, 0xDBBBC9D6, 0xACBCF940, 0x32D86CE3, 0x45DF5C75, 0xDCD60DCF, 0xABD13D59,
-  0x26D930AC, 0x51DE003A, 0xC8D75180, 0xBFD06116, 0x21B4F4B5, 0x56B3C423, 0xCFBA9599, 0xB8BDA50F,
-  0x2802B89E, 0x5F058808, 0xC60CD9B2, 0xB10BE924, 0x2F6F7C87, 0x58684C11, 0xC1611DAB, 0xB6662D3D,
-  0x76DC4190, 0x01DB7106, 0x98D220BC, 0xEFD5102A, 0x71B18589, 0x06B6B51F, 0x9FBFE4A5, 0xE8B8D433,
-  0x7807C9A2, 0x0F00F934, 0x9609A88E, 0xE10E9818, 0x7F6A0DBB, 0x086D3D2D, 0x91646C97, 0xE6635C01,
-  0x6B6B51F4, 0x1C6C6162, 0x856530D8, 0xF262004E, 0x6C0695ED, 0x1B01A57B, 0x8208F4C1, 0xF50FC457,
-  0x65B0D9C6, 0x12B7E950, 0x8BBEB8EA, 0xFCB9887C, 0x62DD1DDF, 0x15DA2D49, 0x8CD37CF3, 0xFBD44C65,
-  0x4DB26158, 0x3AB551CE, 0xA3BC0074, 0xD4BB30E2, 0x4ADFA541, 0x3DD895D7, 0xA4D1C46D, 0xD3D6F4FB,
-  0x4369E96A, 0x346ED9FC, 0xAD678846, 0xDA60B8D0, 0x44042D73, 0x33031DE5, 0xAA0A4C5F, 0xDD0D7CC9,
-  0x5005713C, 0x270241AA, 0xBE0B1010, 0xC90C2086, 0x5768B525, 0x206F85B3, 0xB966D409, 0xCE61E49F,
-  0x5EDEF90E, 0x29D9C998, 0xB0D09822, 0xC7D7A8B4, 0x59B33D17, 0x2EB40D81, 0xB7BD5C3B, 0xC0BA6CAD,
-  0xEDB88320, 0x9ABFB3B6, 0x03B6E20C, 0x74B1D29A, 0xEAD54739, 0x9DD277AF, 0x04DB2615, 0x73DC1683,
-  0xE3630B12, 0x94643B84, 0x0D6D6A3E, 0x7A6A5AA8, 0xE40ECF0B, 0x9309FF9D, 0x0A00AE27, 0x7D079EB1,
-  0xF00F9344, 0x8708A3D2, 0x1E01F268, 0x6906C2FE, 0xF762575D, 0x806567CB, 0x196C3671, 0x6E6B06E7,
-  0xFED41B76, 0x89D32BE0, 0x10DA7A5A, 0x67DD4ACC, 0xF9B9DF6F, 0x8EBEEFF9, 0x17B7BE43, 0x60B08ED5,
-  0xD6D6A3E8, 0xA1D1937E, 0x38D8C2C4, 0x4FDFF252, 0xD1BB67F1, 0xA6BC5767, 0x3FB506DD, 0x48B2364B,
-  0xD80D2BDA, 0xAF0A1B4C, 0x36034AF6, 0x41047A60, 0xDF60EFC3, 0xA867DF55, 0x316E8EEF, 0x4669BE79,
-  0xCB61B38C, 0xBC66831A, 0x256FD2A0, 0x5268E236, 0xCC0C7795, 0xBB0B4703, 0x220216B9, 0x5505262F,
-  0xC5BA3BBE, 0xB2BD0B28, 0x2BB45A92, 0x5CB36A04, 0xC2D7FFA7, 0xB5D0CF31, 0x2CD99E8B, 0x5BDEAE1D,
-  0x9B64C2B0, 0xEC63F226, 0x756AA39C, 0x026D930A, 0x9C0906A9, 0xEB0E363F, 0x72076785, 0x05005713,
-  0x95BF4A82, 0xE2B87A14, 0x7BB12BAE, 0x0CB61B38, 0x92D28E9B, 0xE5D5BE0D, 0x7CDCEFB7, 0x0BDBDF21,
-  0x86D3D2D4, 0xF1D4E242, 0x68DDB3F8, 0x1FDA836E, 0x81BE16CD, 0xF6B9265B, 0x6FB077E1, 0x18B74777,
-  0x88085AE6, 0xFF0F6A70, 0x66063BCA, 0x11010B5C, 0x8F659EFF, 0xF862AE69, 0x616BFFD3, 0x166CCF45,
-  0xA00AE278, 0xD70DD2EE, 0x4E048354, 0x3903B3C2, 0xA7672661, 0xD06016F7, 0x4969474D, 0x3E6E77DB,
-  0xAED16A4A, 0xD9D65ADC, 0x40DF0B66, 0x37D83BF0, 0xA9BCAE53, 0xDEBB9EC5, 0x47B2CF7F, 0x30B5FFE9,
-  0xBDBDF21C, 0xCABAC28A, 0x53B39330, 0x24B4A3A6, 0xBAD03605, 0xCDD70693, 0x54DE5729, 0x23D967BF,
-  0xB3667A2E, 0xC4614AB8, 0x5D681B02, 0x2A6F2B94, 0xB40BBE37, 0xC30C8EA1, 0x5A05DF1B, 0x2D02EF8D
-};
+#if defined(__x86_64__)
+#include <nmmintrin.h>
+#include <wmmintrin.h>
+#endif
 
-uint32_t crc32(const void* data, uint32_t size) {
-  const uint8_t* buf = static_cast<const uint8_t*>(data);
-  uint32_t crc = 0xFFFFFFFF;
-  
-  // 处理每个字节直到达到 4 字节对齐
-  while (size > 0 && reinterpret_cast<uintptr_t>(buf) & 3) {
-    crc = crc_table[(crc ^ *buf++) & 0xFF] ^ (crc >> 8);
-    size--;
+#include "common/math/crc.h"
+
+namespace {
+
+/**
+ * @brief slicing-by-8 的查表，table[k][b] 是字节 b 后面跟 k 个0字节的 CRC
+ * @param poly 反射的多项式
+ */
+constexpr std::array<std::array<uint32_t, 256>, 8> make_crc_table(uint32_t poly) {
+  std::array<std::array<uint32_t, 256>, 8> table{};
+  for (uint32_t b = 0; b < 256; b++) {
+    uint32_t crc = b;
+    for (int i = 0; i < 8; i++) {
+      crc = (crc >> 1) ^ ((crc & 1) ? poly : 0);
+    }
+    table[0][b] = crc;
   }
-  
-  // 按 4 字节块处理
-  const uint32_t* buf32 = reinterpret_cast<const uint32_t*>(buf);
-  while (size >= 4) {
-    uint32_t tmp = *buf32++ ^ crc;
-    crc = crc_table[(tmp >> 24) & 0xFF] ^
-          crc_table[(tmp >> 16) & 0xFF] ^
-          crc_table[(tmp >> 8) & 0xFF] ^
-          crc_table[tmp & 0xFF];
-    size -= 4;
+  for (uint32_t b = 0; b < 256; b++) {
+    for (int k = 1; k < 8; k++) {
+      table[k][b] = (table[k - 1][b] >> 8) ^ table[0][table[k - 1][b] & 0xFF];
+    }
   }
-  
-  // 处理剩余字节
-  buf = reinterpret_cast<const uint8_t*>(buf32);
+  return table;
+}
+
+/**
+ * @brief 按 slicing-by-8 计算 CRC，输入和输出都是取反之后的值
+ */
+uint32_t crc_slice8(const std::array<std::array<uint32_t, 256>, 8>& table, const uint8_t* buf, size_t size,
+    uint32_t crc) {
+  while (size >= 8) {
+    uint64_t word;
+    memcpy(&word, buf, sizeof(word));
+    word ^= crc;
+    crc = table[7][word & 0xFF] ^
+          table[6][(word >> 8) & 0xFF] ^
+          table[5][(word >> 16) & 0xFF] ^
+          table[4][(word >> 24) & 0xFF] ^
+          table[3][(word >> 32) & 0xFF] ^
+          table[2][(word >> 40) & 0xFF] ^
+          table[1][(word >> 48) & 0xFF] ^
+          table[0][word >> 56];
+    buf += 8;
+    size -= 8;
+  }
+
   while (size--) {
-    crc = crc_table[(crc ^ *buf++) & 0xFF] ^ (crc >> 8);
+    crc = table[0][(crc ^ *buf++) & 0xFF] ^ (crc >> 8);
+  }
+  return crc;
+}
+
+constexpr uint32_t CRC32_POLY = 0xEDB88320;  // IEEE 802.3 多项式(反射)
+
+constexpr auto crc32_table = make_crc_table(CRC32_POLY);
+
+}  // namespace
+
+uint32_t crc32(const void* data, uint32_t size) {
+  return ~crc_slice8(crc32_table, static_cast<const uint8_t*>(data), size, 0xFFFFFFFF);
+}
+
+/******************** CRC32C ********************/
+
+namespace {
+
+constexpr uint32_t CRC32C_POLY = 0x82F63B78;  // Castagnoli 多项式(反射)
+
+constexpr auto crc32c_table = make_crc_table(CRC32C_POLY);
+
+uint32_t crc32c_slice8(const void* data, size_t size, uint32_t crc) {
+  return ~crc_slice8(crc32c_table, static_cast<const uint8_t*>(data), size, ~crc);
+}
+
+#if defined(__x86_64__)
+inline uint64_t load64(const uint8_t* buf) {
+  uint64_t word;
+  memcpy(&word, buf, sizeof(word));
+  return word;
+}
+
+/**
+ * @brief 用 crc32 指令计算，输入和输出都是取反之后的值
+ */
+__attribute__((target("sse4.2")))
+uint32_t crc32c_sse42_raw(const uint8_t* buf, size_t size, uint32_t crc) {
+  uint64_t crc64 = crc;
+  while (size >= 8) {
+    crc64 = _mm_crc32_u64(crc64, load64(buf));
+    buf += 8;
+    size -= 8;
+  }
+
+  uint32_t crc32 = static_cast<uint32_t>(crc64);
+  while (size--) {
+    crc32 = _mm_crc32_u8(crc32, *buf++);
+  }
+  return crc32;
+}
+
+uint32_t crc32c_sse42(const void* data, size_t size, uint32_t crc) {
+  return ~crc32c_sse42_raw(static_cast<const uint8_t*>(data), size, ~crc);
+}
+
+/**
+ * @brief x^n mod P，反射表示
+ */
+constexpr uint32_t crc32c_xpow(uint32_t n) {
+  uint32_t value = 0x80000000;  // x^0
+  for (uint32_t i = 0; i < n; i++) {
+    value = (value >> 1) ^ ((value & 1) ? CRC32C_POLY : 0);
+  }
+  return value;
+}
+
+/**
+ * @brief 三路交错计算的分段大小
+ * @details crc32 指令的延迟是3个周期，但是每个周期可以发射一条。把数据分成连续的三段同时计算，
+ * 再合并三段的结果：crc(A|B|C) = shift(crc(A), |B|+|C|) ^ shift(crc(B), |C|) ^ crc(C)，
+ * 其中 B、C 从0开始计算。shift(c, n) = c * x^(8n) mod P，用 PCLMULQDQ 乘上常量
+ * x^(8n-33) mod P，得到的64位乘积再用一条 crc32 指令约减(相当于乘 x^32 再模 P，
+ * 另外的一次 x 来自反射表示的乘积错开的一位)。
+ * 大块数据用长的分段，剩下的部分用短的分段，最后不够三段的用单路计算。
+ */
+constexpr size_t CRC32C_LONG_BLOCK  = 1024;
+constexpr size_t CRC32C_SHORT_BLOCK = 128;
+
+constexpr uint32_t CRC32C_LONG_K1  = crc32c_xpow(8 * CRC32C_LONG_BLOCK - 33);
+constexpr uint32_t CRC32C_LONG_K2  = crc32c_xpow(16 * CRC32C_LONG_BLOCK - 33);
+constexpr uint32_t CRC32C_SHORT_K1 = crc32c_xpow(8 * CRC32C_SHORT_BLOCK - 33);
+constexpr uint32_t CRC32C_SHORT_K2 = crc32c_xpow(16 * CRC32C_SHORT_BLOCK - 33);
+
+__attribute__((target("sse4.2,pclmul")))
+inline uint64_t crc32c_shift(uint64_t crc, uint32_t k) {
+  const __m128i product = _mm_clmulepi64_si128(_mm_cvtsi64_si128(static_cast<int64_t>(crc)),
+      _mm_cvtsi32_si128(static_cast<int>(k)), 0x00);
+  return _mm_crc32_u64(0, static_cast<uint64_t>(_mm_cvtsi128_si64(product)));
+}
+
+__attribute__((target("sse4.2,pclmul")))
+inline uint64_t crc32c_3way(const uint8_t*& buf, size_t& size, uint64_t crc, size_t block, uint32_t k1, uint32_t k2) {
+  while (size >= 3 * block) {
+    uint64_t       crc0 = crc;
+    uint64_t       crc1 = 0;
+    uint64_t       crc2 = 0;
+    const uint8_t* end  = buf + block;
+    for (; buf < end; buf += 8) {
+      crc0 = _mm_crc32_u64(crc0, load64(buf));
+      crc1 = _mm_crc32_u64(crc1, load64(buf + block));
+      crc2 = _mm_crc32_u64(crc2, load64(buf + 2 * block));
+    }
+    crc = crc32c_shift(crc0, k2) ^ crc32c_shift(crc1, k1) ^ crc2;
+    buf += 2 * block;
+    size -= 3 * block;
+  }
+  return crc;
+}
+
+__attribute__((target("sse4.2,pclmul")))
+uint32_t crc32c_pclmul(const void* data, size_t size, uint32_t crc) {
+  const uint8_t* buf   = static_cast<const uint8_t*>(data);
+  uint64_t       crc64 = static_cast<uint32_t>(~crc);
+  crc64 = crc32c_3way(buf, size, crc64, CRC32C_LONG_BLOCK, CRC32C_LONG_K1, CRC32C_LONG_K2);
+  crc64 = crc32c_3way(buf, size, crc64, CRC32C_SHORT_BLOCK, CRC32C_SHORT_K1, CRC32C_SHORT_K2);
+  return ~crc32c_sse42_raw(buf, size, static_cast<uint32_t>(crc64));
+}
+#endif
+
+using Crc32cFunc = uint32_t (*)(const void*, size_t, uint32_t);
+
+bool kernel_supported(Crc32cKernel kernel) {
+  switch (kernel) {
+    case Crc32cKernel::SLICE8: return true;
+#if defined(__x86_64__)
+    case Crc32cKernel::SSE42: return __builtin_cpu_supports("sse4.2");
+    case Crc32cKernel::PCLMUL: return __builtin_cpu_supports("sse4.2") && __builtin_cpu_supports("pclmul");
+#endif
+    default: return false;
+  }
+}
+
+Crc32cFunc kernel_func(Crc32cKernel kernel) {
+  if (!kernel_supported(kernel)) {
+    return crc32c_slice8;
+  }
+  switch (kernel) {
+#if defined(__x86_64__)
+    case Crc32cKernel::SSE42: return crc32c_sse42;
+    case Crc32cKernel::PCLMUL: return crc32c_pclmul;
+#endif
+    default: return crc32c_slice8;
+  }
+}
+
+Crc32cKernel choose_kernel() {
+  for (Crc32cKernel kernel : {Crc32cKernel::PCLMUL, Crc32cKernel::SSE42}) {
+    if (kernel_supported(kernel)) {
+      return kernel;
+    }
+  }
+  return Crc32cKernel::SLICE8;
+}
+
+}  // namespace
+
+uint32_t crc32c(const void* data, size_t size, uint32_t crc /* = 0 */) {
+  static const Crc32cFunc func = kernel_func(crc32c_kernel());
+  return func(data, size, crc);
+}
+
+uint32_t crc32c(Crc32cKernel kernel, const void* data, size_t size, uint32_t crc /* = 0 */) {
+  return kernel_func(kernel)(data, size, crc);
+}
+
+bool crc32c_kernel_supported(Crc32cKernel kernel) { return kernel_supported(kernel); }
+
+Crc32cKernel crc32c_kernel() {
+  static const Crc32cKernel kernel = choose_kernel();
+  return kernel;
+}
+
+const char* crc32c_kernel_name(Crc32cKernel kernel) {
+  switch (kernel) {
+    case Crc32cKernel::SLICE8: return "slice8";
+    case Crc32cKernel::SSE42: return "sse42";
+    case Crc32cKernel::PCLMUL: return "pclmul";
+    default: return "unknown";
   }
-  return crc ^ 0xFFFFFFFF;
-}
\ No newline at end of file
+}
@@ -1,6 +1,47 @@
 #pragma once
 
 
+#include <cstddef>
 #include <cstdint>
 
-uint32_t crc32(const void* data, uint32_t size);
\ No newline at end of file
+/**
+ * @brief 计算 CRC32(IEEE 802.3 多项式，和 zlib 的 crc32 相同)
+ * @details slicing-by-8 查表。新的代码应该使用 crc32c
+ */
+uint32_t crc32(const void* data, uint32_t size);
+
+/**
+ * @brief CRC32C 的实现
+ */
+enum class Crc32cKernel
+{
+  SLICE8,  /// slicing-by-8 查表，任何CPU都可以用
+  SSE42,   /// SSE4.2 的 crc32 指令，每次8字节
+  PCLMUL,  /// 三路交错的 crc32 指令，用 PCLMULQDQ 把三段的结果合并起来
+};
+
+/**
+ * @brief 计算 CRC32C(Castagnoli 多项式)
+ * @details 运行时根据CPU选择最快的实现(参考 crc32c_kernel)：PCLMUL、SSE42、SLICE8。
+ * 可以分段计算：把前一段的结果作为 crc 传入，和一次计算整段数据的结果相同
+ * @param crc 前一段数据的 CRC，第一段传0
+ */
+uint32_t crc32c(const void* data, size_t size, uint32_t crc = 0);
+
+/**
+ * @brief 使用指定的实现计算 CRC32C，给测试和性能测试使用
+ * @details CPU不支持时使用 SLICE8
+ */
+uint32_t crc32c(Crc32cKernel kernel, const void* data, size_t size, uint32_t crc = 0);
+
+/**
+ * @brief 当前CPU是否支持这种实现
+ */
+bool crc32c_kernel_supported(Crc32cKernel kernel);
+
+/**
+ * @brief crc32c 运行时选择的实现
+ */
+Crc32cKernel crc32c_kernel();
+
+const char* crc32c_kernel_name(Crc32cKernel kernel);
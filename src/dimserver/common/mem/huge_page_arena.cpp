@@ -0,0 +1,183 @@
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <cerrno>
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+
+#if defined(__linux__)
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
+#endif
+
+#include "common/log/log.h"
+#include "common/mem/huge_page_arena.h"
+
+namespace common {
+
+static size_t round_up(size_t n, size_t align) {
+  return (n + align - 1) / align * align;
+}
+
+HugePageArena::~HugePageArena() {
+  cleanup();
+}
+
+int HugePageArena::init(size_t size, bool use_huge_page /* = true */, int numa_node_num /* = 0 */) {
+  if (data_ != nullptr) {
+    LOG_WARN("huge page arena has been initialized. size=%lu", static_cast<unsigned long>(size_));
+    return 0;
+  }
+  if (size == 0) {
+    LOG_ERROR("Invalid arguments, size:%lu.", static_cast<unsigned long>(size));
+    return -1;
+  }
+
+  const size_t os_page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  if (use_huge_page) {
+    size = round_up(size, HUGE_PAGE_SIZE);
+#if defined(MAP_HUGETLB)
+    void* ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (ptr != MAP_FAILED) {
+      data_     = map_base_ = static_cast<char*>(ptr);
+      size_     = map_size_ = size;
+      backing_  = Backing::HUGETLB;
+    }
+#endif
+    if (data_ == nullptr) {
+      data_ = map_aligned(size);
+      if (data_ != nullptr) {
+        size_ = size;
+#if defined(MADV_HUGEPAGE)
+        backing_ = madvise(data_, size_, MADV_HUGEPAGE) == 0 ? Backing::THP : Backing::NORMAL;
+#else
+        backing_ = Backing::NORMAL;
+#endif
+      }
+    }
+  } else {
+    size = round_up(size, os_page_size);
+    void* ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ptr != MAP_FAILED) {
+      data_    = map_base_ = static_cast<char*>(ptr);
+      size_    = map_size_ = size;
+      backing_ = Backing::NORMAL;
+    }
+  }
+
+  if (data_ == nullptr) {
+    LOG_ERROR("Failed to map memory. size=%lu, error=%s", static_cast<unsigned long>(size), strerror(errno));
+    return -1;
+  }
+
+  if (numa_node_num > 1) {
+    bind_numa_nodes(numa_node_num);
+  }
+
+  LOG_INFO("huge page arena initialized. size=%lu, backing=%s, numa_nodes=%d",
+    static_cast<unsigned long>(size_), backing_name(backing_), numa_node_num_);
+  return 0;
+}
+
+char* HugePageArena::map_aligned(size_t size) {
+  // 多映射一个大页，把首尾不对齐的部分还回去，透明大页只能用在对齐的区间上
+  const size_t map_size = size + HUGE_PAGE_SIZE;
+  void* ptr = mmap(nullptr, map_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (ptr == MAP_FAILED) {
+    return nullptr;
+  }
+
+  char* base    = static_cast<char*>(ptr);
+  char* aligned = reinterpret_cast<char*>(round_up(reinterpret_cast<uintptr_t>(base), HUGE_PAGE_SIZE));
+  const size_t head = static_cast<size_t>(aligned - base);
+  const size_t tail = map_size - head - size;
+  if (head > 0) {
+    munmap(base, head);
+  }
+  if (tail > 0) {
+    munmap(aligned + size, tail);
+  }
+  map_base_ = aligned;
+  map_size_ = size;
+  return aligned;
+}
+
+void HugePageArena::bind_numa_nodes(int numa_node_num) {
+#if defined(__linux__) && defined(SYS_mbind)
+  const int system_nodes = system_numa_node_num();
+  if (numa_node_num > system_nodes) {
+    numa_node_num = system_nodes;
+  }
+  if (numa_node_num <= 1) {
+    return;
+  }
+
+  const size_t segment_size = round_up(size_ / numa_node_num, HUGE_PAGE_SIZE);
+  for (int node = 0; node < numa_node_num; node++) {
+    const size_t offset = segment_size * node;
+    if (offset >= size_) {
+      break;
+    }
+    const size_t length = std::min(segment_size, size_ - offset);
+
+    // MPOL_PREFERRED：节点内存不够时还可以从其它节点分配，不会因为绑定失败而OOM
+    unsigned long node_mask = 1UL << node;
+    long ret = syscall(SYS_mbind, data_ + offset, length, MPOL_PREFERRED, &node_mask, sizeof(node_mask) * 8, 0);
+    if (ret != 0) {
+      LOG_INFO("failed to bind memory to numa node, ignore it. node=%d, error=%s", node, strerror(errno));
+      return;
+    }
+  }
+  numa_node_num_ = numa_node_num;
+#else
+  (void)numa_node_num;
+#endif
+}
+
+int HugePageArena::numa_node_of(const void* addr) const {
+  if (numa_node_num_ <= 1 || addr < data_ || addr >= data_ + size_) {
+    return -1;
+  }
+  const size_t segment_size = round_up(size_ / numa_node_num_, HUGE_PAGE_SIZE);
+  return static_cast<int>((static_cast<const char*>(addr) - data_) / segment_size);
+}
+
+void HugePageArena::cleanup() {
+  if (map_base_ != nullptr) {
+    munmap(map_base_, map_size_);
+  }
+  data_          = nullptr;
+  size_          = 0;
+  map_base_      = nullptr;
+  map_size_      = 0;
+  backing_       = Backing::NONE;
+  numa_node_num_ = 0;
+}
+
+const char* HugePageArena::backing_name(Backing backing) {
+  switch (backing) {
+    case Backing::NONE:    return "none";
+    case Backing::HUGETLB: return "hugetlb";
+    case Backing::THP:     return "thp";
+    case Backing::NORMAL:  return "normal";
+  }
+  return "unknown";
+}
+
+int HugePageArena::system_numa_node_num() {
+  DIR* dir = opendir("/sys/devices/system/node");
+  if (dir == nullptr) {
+    return 1;
+  }
+  int count = 0;
+  while (struct dirent* entry = readdir(dir)) {
+    if (strncmp(entry->d_name, "node", 4) == 0 && entry->d_name[4] >= '0' && entry->d_name[4] <= '9') {
+      count++;
+    }
+  }
+  closedir(dir);
+  return count > 0 ? count : 1;
+}
+
+} // namespace common
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace common {
+
+/**
+ * @brief 一块连续的大内存，尽量使用大页
+ * @details 给缓冲池页面这类一次性分配、常驻内存的大块内存使用，减少TLB缺失：
+ * 1. 先尝试 MAP_HUGETLB(需要系统预留了大页)；
+ * 2. 失败时按大页大小对齐地映射普通内存，再通过 madvise(MADV_HUGEPAGE) 申请透明大页；
+ * 3. 都不支持时就是普通的匿名映射。
+ * 降级不会报错，只记录日志，通过 backing() 可以知道实际使用的是哪一种。
+ *
+ * 可以把内存平均分成 numa_node_num 段，每段通过 mbind 优先放在对应的NUMA节点上。
+ * 绑定在第一次访问之前完成，失败时同样只记录日志。
+ */
+class HugePageArena {
+public:
+  static constexpr size_t HUGE_PAGE_SIZE = 2UL << 20;  /// 大页大小，x86_64 上默认是2MB
+
+  enum class Backing {
+    NONE,     /// 还没有初始化
+    HUGETLB,  /// MAP_HUGETLB
+    THP,      /// 透明大页
+    NORMAL,   /// 普通页面
+  };
+
+public:
+  HugePageArena() = default;
+  ~HugePageArena();
+
+  HugePageArena(const HugePageArena&)            = delete;
+  HugePageArena& operator=(const HugePageArena&) = delete;
+
+  /**
+   * @brief 映射内存
+   * @param size 需要的字节数，使用大页时会向上取整为大页大小的整数倍
+   * @param use_huge_page 是否尝试使用大页
+   * @param numa_node_num 按多少个NUMA节点分段绑定，小于等于1时不绑定，超过系统的节点数时按系统节点数
+   * @return 0表示成功，其他表示失败
+   */
+  int  init(size_t size, bool use_huge_page = true, int numa_node_num = 0);
+  void cleanup();
+
+  char*   data() const { return data_; }
+  size_t  size() const { return size_; }
+  Backing backing() const { return backing_; }
+  int     numa_node_num() const { return numa_node_num_; }
+
+  /// 地址所在的段对应的NUMA节点，没有绑定时返回-1
+  int numa_node_of(const void* addr) const;
+
+  static const char* backing_name(Backing backing);
+
+  /// 系统中NUMA节点的个数，无法获取时返回1
+  static int system_numa_node_num();
+
+private:
+  /// 按大页大小对齐地映射普通内存
+  char* map_aligned(size_t size);
+  void  bind_numa_nodes(int numa_node_num);
+
+private:
+  char*   data_          = nullptr;
+  size_t  size_          = 0;
+  char*   map_base_      = nullptr;  /// 实际映射的起始地址，对齐时会多映射一些
+  size_t  map_size_      = 0;
+  Backing backing_       = Backing::NONE;
+  int     numa_node_num_ = 0;
+};
+
+} // namespace common
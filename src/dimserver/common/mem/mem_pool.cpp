@@ -14,6 +14,13 @@ int MemPoolItem::init(int item_size, bool dynamic, int pool_num, int item_num_pe
   }
 
   this->item_size_ = item_size;
+  if (dynamic) {
+    caches_.reset(new ThreadCache[common::ThreadIndex::MAX_THREADS]);
+  }
+  if (slots_.init(item_num_per_pool) != 0) {
+    LOG_ERROR("Too many items per pool, item_num_per_pool:%d, name:%s.", item_num_per_pool, this->name_.c_str());
+    return -1;
+  }
   this->item_num_per_pool_ = item_num_per_pool;
   this->dynamic_ = true;
   for (int i = 0; i < pool_num; ++i) {
@@ -36,12 +43,13 @@ void MemPoolItem::cleanup() {
   }
 
   std::unique_lock<std::shared_mutex> lock(this->mutex_);
-  used_.clear();
-  frees_.clear();
+  clear_magazines();
+  caches_.reset();
+  slots_.clear();
   this->size_ = 0;
 
   for (auto* pool : pools_) {
-    free(pool);
+    ::free(pool);
   }
   pools_.clear();
   
@@ -62,12 +70,14 @@ int MemPoolItem::extend() {
     return -1;
   }
 
+  if (slots_.add_chunk(pool, static_cast<size_t>(this->item_size_)) < 0) {
+    ::free(pool);
+    LOG_ERROR("Too many pools, max:%d, size:%d, item_num_per_pool:%d, name:%s.", common::SlotFreeList::MAX_CHUNK_NUM,
+      this->size_, this->item_num_per_pool_, this->name_.c_str());
+    return -1;
+  }
   pools_.push_back(pool);
   this->size_ += this->item_num_per_pool_;
-  for (int i = 0; i < this->item_num_per_pool_; ++i) {
-    void* item = static_cast<char*>(pool) + i * this->item_size_;
-    frees_.push_back(item);
-  }
   lock.unlock();
 
   LOG_INFO("Extend one pool, size:%d, item_size:%d, item_num_per_pool:%d, name:%s.",
@@ -76,9 +86,16 @@ int MemPoolItem::extend() {
 }
 
 void* MemPoolItem::alloc() {
-  std::unique_lock<std::shared_mutex> lock(this->mutex_);
-  
-  if (frees_.empty()) {
+  int32_t slot = -1;
+  const int thread_index = common::ThreadIndex::current();
+  if (thread_index >= 0 && caches_ != nullptr) {
+    slot = cache_alloc(caches_[thread_index]);
+  }
+
+  if (slot < 0) {
+    slot = slots_.pop();
+  }
+  while (slot < 0) {
     if (!this->dynamic_) {
       return nullptr;
     }
@@ -87,17 +104,42 @@ void* MemPoolItem::alloc() {
       LOG_ERROR("Failed to alloc memory, name:%s", this->name_.c_str());
       return nullptr;
     }
+    slot = slots_.pop();
   }
-  
-  void* item = frees_.front();
-  frees_.pop_front();
-  used_.insert(item);
-  lock.unlock();
 
+  void* item = slots_.item_of(slot);
   memset(item, 0, this->item_size_);
   return item;
 }
 
+int32_t MemPoolItem::cache_alloc(ThreadCache& cache) {
+  if (cache.loaded == nullptr || cache.loaded->count == 0) {
+    if (cache.previous != nullptr && cache.previous->count > 0) {
+      std::swap(cache.loaded, cache.previous);
+    } else {
+      // 两个弹匣都空了：从仓库换一个满的弹匣回来，空的 previous 留在仓库
+      Magazine* full = nullptr;
+      {
+        std::lock_guard<std::mutex> lock(depot_mutex_);
+        if (full_magazines_.empty()) {
+          return -1;
+        }
+        full = full_magazines_.back();
+        full_magazines_.pop_back();
+        if (cache.previous != nullptr) {
+          empty_magazines_.push_back(cache.previous);
+        }
+      }
+      cache.previous = cache.loaded;
+      cache.loaded   = full;
+    }
+  }
+
+  const int32_t slot = cache.loaded->slots[--cache.loaded->count];
+  slots_.mark_used(slot);
+  return slot;
+}
+
 MemPoolItem::item_unique_ptr MemPoolItem::alloc_unique_ptr() {
   void* item = alloc();
   if (item == nullptr) {
@@ -113,13 +155,68 @@ void MemPoolItem::free(void* item) {
     return;
   }
 
-  std::unique_lock<std::shared_mutex> lock(this->mutex_);
-  auto it = used_.find(item);
-  if (it == used_.end()) {
+  const int32_t slot = slots_.slot_of(item);
+  if (slot < 0 || !slots_.mark_free(slot)) {
     LOG_WARN("Try to free an item not in used list, name:%s", this->name_.c_str());
     return;
   }
-  
-  used_.erase(it);
-  frees_.push_back(item);
-}
\ No newline at end of file
+
+  const int thread_index = common::ThreadIndex::current();
+  if (thread_index >= 0 && caches_ != nullptr && cache_free(caches_[thread_index], slot)) {
+    return;
+  }
+  slots_.push(slot);
+}
+
+bool MemPoolItem::cache_free(ThreadCache& cache, int32_t slot) {
+  if (cache.loaded == nullptr || cache.loaded->count == MAGAZINE_SIZE) {
+    if (cache.previous != nullptr && cache.previous->count < MAGAZINE_SIZE) {
+      std::swap(cache.loaded, cache.previous);
+    } else {
+      // 两个弹匣都满了：把满的 previous 交给仓库，换一个空的弹匣
+      Magazine* empty = nullptr;
+      {
+        std::lock_guard<std::mutex> lock(depot_mutex_);
+        if (cache.previous != nullptr) {
+          full_magazines_.push_back(cache.previous);
+          cache.previous = nullptr;
+        }
+        if (!empty_magazines_.empty()) {
+          empty = empty_magazines_.back();
+          empty_magazines_.pop_back();
+        }
+      }
+      if (empty == nullptr) {
+        empty = new (std::nothrow) Magazine();
+        if (empty == nullptr) {
+          return false;
+        }
+      }
+      cache.previous = cache.loaded;
+      cache.loaded   = empty;
+    }
+  }
+
+  cache.loaded->slots[cache.loaded->count++] = slot;
+  return true;
+}
+
+void MemPoolItem::clear_magazines() {
+  if (caches_ != nullptr) {
+    for (int i = 0; i < common::ThreadIndex::MAX_THREADS; i++) {
+      delete caches_[i].loaded;
+      delete caches_[i].previous;
+      caches_[i] = ThreadCache();
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(depot_mutex_);
+  for (Magazine* magazine : full_magazines_) {
+    delete magazine;
+  }
+  for (Magazine* magazine : empty_magazines_) {
+    delete magazine;
+  }
+  full_magazines_.clear();
+  empty_magazines_.clear();
+}
@@ -4,12 +4,16 @@
 #include <set>
 #include <list>
 #include <string>
+#include <mutex>
+#include <vector>
 #include <shared_mutex>
 #include <memory>
 #include <functional>
 #include <sstream>
 
 #include "common/log/log.h"
+#include "common/mem/slot_free_list.h"
+#include "common/thread/thread_index.h"
 
 constexpr int DEFAULT_ITEM_NUM_PER_POOL = 128;
 constexpr int DEFAULT_POOL_NUM = 1;
@@ -59,6 +63,12 @@ protected:
 };
 
 
+/**
+ * @brief 固定类型对象的内存池
+ * @details 对象在 extend 时一批一批地构造好，alloc/free 时只调用 reinit/reset。
+ * 空闲对象和使用中的标记由 common::SlotFreeList 管理，alloc/free 不加锁；
+ * extend/cleanup 仍然由 mutex_ 互斥。
+ */
 template <typename T>
 class MemPoolSimple : public MemPool<T> {
 public:
@@ -86,23 +96,46 @@ public:
 
 	int get_item_num_per_pool() const { return item_num_per_pool_; }
 
-	int used_num() {
-		std::shared_lock<std::shared_mutex> lock(this->mutex_);
-		return used_.size();
-	}
+	int used_num() const { return slots_.used_num(); }
+
+protected:
+	/**
+	 * @brief 分配/释放一批对象的内存，extend 和 cleanup 使用
+	 * @details 子类可以改为从其它内存(比如大页)上构造对象，参考 storage::FramePool。
+	 * 基类析构时调用的 cleanup 不会再分派到子类，重载了这两个函数的子类需要在自己的析构函数中调用 cleanup。
+	 */
+	virtual T* new_items(int item_num) { return new T[item_num]; }
+	virtual void delete_items(T* items, [[maybe_unused]] int item_num) { delete[] items; }
 
 protected:
 	std::list<T*> pools_;
-	std::set<T*> used_;
-	std::list<T*> frees_;
+	common::SlotFreeList slots_;  /// 空闲对象和使用中的标记
 	int item_num_per_pool_;
 };
 
 
+/**
+ * @brief 固定大小内存块的内存池
+ * @details 空闲内存块由 common::SlotFreeList 管理。在它上面参考 Bonwick 的 slab 分配器
+ * 加了一层按线程划分的弹匣(magazine)缓存：
+ * - 每个线程有两个弹匣 loaded 和 previous，每个弹匣是一个最多 MAGAZINE_SIZE 个空闲块的栈，
+ *   alloc/free 只操作自己的弹匣，不和其它线程竞争；
+ * - loaded 空了(分配)或者满了(释放)时先和 previous 交换，还不行再和共享的仓库(depot)
+ *   交换一个满的或者空的弹匣，仓库由一把锁保护，每 MAGAZINE_SIZE 次操作最多访问一次；
+ * - 仓库也没有满的弹匣时直接从 SlotFreeList 分配。
+ *
+ * 一个线程分配的块可以由另一个线程释放，它会进入释放线程的弹匣，再通过仓库流转到其它线程。
+ * 弹匣中的块不算使用中，重复释放仍然能检查出来。
+ *
+ * 其它线程弹匣中的块当前线程拿不到，所以只有可以扩展(dynamic)的内存池才启用线程缓存，
+ * 固定大小的内存池仍然保证所有空闲块都能分配出去。
+ */
 class MemPoolItem {
 public:
 	using item_unique_ptr = std::unique_ptr<void, std::function<void(void* const)>>;
 
+	static constexpr int MAGAZINE_SIZE = 32;  /// 每个弹匣最多缓存多少个空闲块
+
 public:
 	MemPoolItem(const std::string tag)
 		: name_(std::move(tag))
@@ -128,8 +161,8 @@ public:
 	void free(void* item);
 
 	bool is_used(void* item) {
-		std::shared_lock<std::shared_mutex> lock(mutex_);
-		return used_.find(item) != used_.end();
+		const int32_t slot = slots_.slot_of(item);
+		return slot >= 0 && slots_.is_used(slot);
 	}
 
 	std::string to_string() {
@@ -139,8 +172,8 @@ public:
 			<< "dynamic:" << (dynamic_ ? "true" : "false") << ","
 			<< "size:" << size_ << ","
 			<< "pool_size:" << pools_.size() << ","
-			<< "used_size:" << used_.size() << ","
-			<< "free_size:" << frees_.size();
+			<< "used_size:" << slots_.used_num() << ","
+			<< "free_size:" << size_ - slots_.used_num();
     return ss.str();
 	}
 
@@ -150,10 +183,25 @@ public:
 	int get_item_size() const { return item_size_; }
 	int get_item_num_per_pool() const { return item_num_per_pool_; }
 
-	int get_used_num() {
-		std::shared_lock<std::shared_mutex> lock(mutex_);
-		return used_.size();
-	}
+	int get_used_num() const { return slots_.used_num(); }
+
+private:
+	struct Magazine {
+		int     count = 0;
+		int32_t slots[MAGAZINE_SIZE];
+	};
+
+	/// 一个线程的弹匣，只有这个线程会访问
+	struct alignas(64) ThreadCache {
+		Magazine* loaded   = nullptr;
+		Magazine* previous = nullptr;
+	};
+
+	/// 从线程缓存中分配，返回-1表示缓存和仓库中都没有空闲块
+	int32_t cache_alloc(ThreadCache& cache);
+	/// 释放到线程缓存中，内存不够分配弹匣时返回false
+	bool    cache_free(ThreadCache& cache, int32_t slot);
+	void    clear_magazines();
 
 protected:
   mutable std::shared_mutex mutex_;
@@ -163,9 +211,13 @@ protected:
   int             item_size_;
   int             item_num_per_pool_;
 
-  std::list<void *> pools_;
-  std::set<void *>  used_;
-  std::list<void *> frees_;
+  std::list<void *>    pools_;
+  common::SlotFreeList slots_;  /// 空闲内存块和使用中的标记
+
+  std::unique_ptr<ThreadCache[]> caches_;           /// 按 common::ThreadIndex 划分的线程缓存
+  std::mutex                     depot_mutex_;
+  std::vector<Magazine*>         full_magazines_;   /// 仓库中满的弹匣
+  std::vector<Magazine*>         empty_magazines_;  /// 仓库中空的弹匣
 };
 
 
@@ -191,6 +243,10 @@ int MemPoolSimple<T>::init(bool dynamic, int pool_num, int item_num_per_pool) {
 		return -1;
 	}
 
+	if (slots_.init(item_num_per_pool) != 0) {
+		LOG_ERROR("Too many items per pool, item_num_per_pool:%d, name:%s.", item_num_per_pool, this->name_.c_str());
+		return -1;
+	}
 	this->item_num_per_pool_ = item_num_per_pool;
 	this->dynamic_ = true;
 	for (int i = 0; i < pool_num; ++i) {
@@ -214,12 +270,11 @@ void MemPoolSimple<T>::cleanup() {
 		return;
 	}
 	std::unique_lock<std::shared_mutex> lock(this->mutex_);
-	used_.clear();
-	frees_.clear();
+	slots_.clear();
 	this->size_ = 0;
 
 	for (auto* pool : pools_) {
-		delete[] pool;
+		delete_items(pool, item_num_per_pool_);
 	}
 	pools_.clear();
 	lock.unlock();
@@ -235,18 +290,21 @@ int MemPoolSimple<T>::extend() {
 	}
 
 	std::unique_lock<std::shared_mutex> lock(this->mutex_);
-	T* pool = new T[item_num_per_pool_];
+	T* pool = new_items(item_num_per_pool_);
 	if (!pool) {
 		LOG_ERROR("Failed to extend memory pool, size:%d, item_num_per_pool:%d, name:%s.",
 			this->size_, this->item_num_per_pool_, this->name_.c_str());
 		return -1;
 	}
 
+	if (slots_.add_chunk(pool, sizeof(T)) < 0) {
+		delete_items(pool, item_num_per_pool_);
+		LOG_ERROR("Too many pools, max:%d, size:%d, item_num_per_pool:%d, name:%s.", common::SlotFreeList::MAX_CHUNK_NUM,
+			this->size_, this->item_num_per_pool_, this->name_.c_str());
+		return -1;
+	}
 	pools_.push_back(pool);
 	this->size_ += item_num_per_pool_;
-	for (int i = 0; i < item_num_per_pool_; ++i) {
-		frees_.push_back(pool + i);
-	}
 
 	LOG_INFO("Extend one pool, size:%d, item_num_per_pool:%d, name:%s.",
 		this->size_, this->item_num_per_pool_, this->name_.c_str());
@@ -255,26 +313,21 @@ int MemPoolSimple<T>::extend() {
 
 template<typename T>
 T* MemPoolSimple<T>::alloc() {
-	std::unique_lock<std::shared_mutex> lock(this->mutex_);
-	
-	if (frees_.empty()) {
+	int32_t slot = slots_.pop();
+	while (slot < 0) {
 		if (!this->dynamic_) {
-			lock.unlock();
 			return nullptr;
 		}
 
+		// 并发时可能多个线程同时扩展，多出来的对象留给以后用
 		if (extend() != 0) {
-			lock.unlock();
 			LOG_ERROR("Failed to alloc memory, name:%s", this->name_.c_str());
 			return nullptr;
 		}
+		slot = slots_.pop();
 	}
-	
-	T* item = frees_.front();
-	frees_.pop_front();
-	used_.insert(item);
 
-	lock.unlock();
+	T* item = static_cast<T*>(slots_.item_of(slot));
 	item->reinit(); // 调用已有对象进行set
 	return item;
 }
@@ -285,22 +338,16 @@ void MemPoolSimple<T>::free(T* item) {
 		LOG_WARN("Invalid item pointer (nullptr), name:%s", this->name_.c_str());
 		return;
 	}
-	
-	item->reset();
 
-	std::unique_lock<std::shared_mutex> lock(this->mutex_);
-	
 	// 检查是否是已使用项
-	auto it = used_.find(item);
-	if (it == used_.end()) {
+	const int32_t slot = slots_.slot_of(item);
+	if (slot < 0 || !slots_.mark_free(slot)) {
 		LOG_WARN("Try to free an item not in used list, name:%s", this->name_.c_str());
 		return;
 	}
-	
-	used_.erase(it);
-	frees_.push_back(item);
-	lock.unlock();
-	return;
+
+	item->reset();
+	slots_.push(slot);
 }
 
 template<typename T>
@@ -311,7 +358,7 @@ std::string MemPoolSimple<T>::to_string() {
 		<< "dynamic:" << this->dynamic_ << ","
 		<< "size:" << this->size_ << ","
 		<< "pool_size:" << this->pools_.size() << ","
-		<< "used_size:" << this->used_.size() << ","
-		<< "free_size:" << this->frees_.size();
+		<< "used_size:" << this->slots_.used_num() << ","
+		<< "free_size:" << this->size_ - this->slots_.used_num();
   return ss.str();
 }
\ No newline at end of file
@@ -0,0 +1,175 @@
+#include "common/mem/slot_free_list.h"
+
+namespace common {
+
+SlotFreeList::~SlotFreeList() {
+  clear();
+}
+
+int SlotFreeList::init(int slots_per_chunk) {
+  if (slots_per_chunk <= 0 || slots_per_chunk > MAX_SLOTS_PER_CHUNK) {
+    return -1;
+  }
+  slots_per_chunk_ = slots_per_chunk;
+  return 0;
+}
+
+int SlotFreeList::add_chunk(void* base, size_t stride) {
+  const int chunk_index = chunk_num_.load(std::memory_order_relaxed);
+  if (chunk_index >= MAX_CHUNK_NUM || slots_per_chunk_ <= 0) {
+    return -1;
+  }
+
+  Chunk* chunk  = new Chunk();
+  chunk->base   = static_cast<char*>(base);
+  chunk->stride = stride;
+  chunk->next.reset(new std::atomic<uint32_t>[slots_per_chunk_]);
+  const int words = (slots_per_chunk_ + 63) / 64;
+  chunk->used.reset(new std::atomic<uint64_t>[words]);
+  for (int i = 0; i < words; i++) {
+    chunk->used[i].store(0, std::memory_order_relaxed);
+  }
+
+  chunks_[chunk_index].store(chunk, std::memory_order_release);
+
+  // 插入排序索引，和 slot_of 之间是一个顺序锁
+  const uint32_t  version = index_version_.load(std::memory_order_relaxed);
+  const uintptr_t address = reinterpret_cast<uintptr_t>(base);
+  index_version_.store(version + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  int pos = chunk_index;
+  for (; pos > 0 && sorted_base_[pos - 1].load(std::memory_order_relaxed) > address; pos--) {
+    sorted_base_[pos].store(sorted_base_[pos - 1].load(std::memory_order_relaxed), std::memory_order_relaxed);
+    sorted_chunk_[pos].store(sorted_chunk_[pos - 1].load(std::memory_order_relaxed), std::memory_order_relaxed);
+  }
+  sorted_base_[pos].store(address, std::memory_order_relaxed);
+  sorted_chunk_[pos].store(chunk_index, std::memory_order_relaxed);
+  chunk_num_.store(chunk_index + 1, std::memory_order_release);
+  index_version_.store(version + 2, std::memory_order_release);
+
+  // 倒序压栈，这样先分配出去的是地址小的对象
+  for (int i = slots_per_chunk_ - 1; i >= 0; i--) {
+    push(make_slot(chunk_index, i));
+  }
+  return chunk_index;
+}
+
+void SlotFreeList::clear() {
+  const int chunk_num = chunk_num_.load(std::memory_order_acquire);
+  for (int i = 0; i < chunk_num; i++) {
+    delete chunks_[i].exchange(nullptr, std::memory_order_acq_rel);
+  }
+  chunk_num_.store(0, std::memory_order_release);
+  head_.store(EMPTY, std::memory_order_release);
+}
+
+void SlotFreeList::push(int32_t slot) {
+  uint64_t head = head_.load(std::memory_order_relaxed);
+  while (true) {
+    next_of(slot).store(static_cast<uint32_t>(head), std::memory_order_relaxed);
+    const uint64_t new_head = (((head >> 32) + 1) << 32) | static_cast<uint32_t>(slot);
+    if (head_.compare_exchange_weak(head, new_head, std::memory_order_release, std::memory_order_relaxed)) {
+      return;
+    }
+  }
+}
+
+int32_t SlotFreeList::pop() {
+  uint64_t head = head_.load(std::memory_order_acquire);
+  while (true) {
+    const uint32_t slot = static_cast<uint32_t>(head);
+    if (slot == EMPTY) {
+      return -1;
+    }
+    // 槽位可能已经被别的线程取走又放回，next 是过期的，这时版本号一定变了，CAS会失败
+    const uint32_t next     = next_of(static_cast<int32_t>(slot)).load(std::memory_order_relaxed);
+    const uint64_t new_head = (((head >> 32) + 1) << 32) | next;
+    if (head_.compare_exchange_weak(head, new_head, std::memory_order_acquire, std::memory_order_acquire)) {
+      mark_used(static_cast<int32_t>(slot));
+      return static_cast<int32_t>(slot);
+    }
+  }
+}
+
+bool SlotFreeList::mark_used(int32_t slot) {
+  const int      index = index_of(slot);
+  const uint64_t bit   = 1ULL << (index % 64);
+  return (chunk_of(slot).used[index / 64].fetch_or(bit, std::memory_order_relaxed) & bit) == 0;
+}
+
+bool SlotFreeList::mark_free(int32_t slot) {
+  const int      index = index_of(slot);
+  const uint64_t bit   = 1ULL << (index % 64);
+  const uint64_t old   = chunk_of(slot).used[index / 64].fetch_and(~bit, std::memory_order_relaxed);
+  if ((old & bit) == 0) {
+    return false;
+  }
+  return true;
+}
+
+void* SlotFreeList::item_of(int32_t slot) const {
+  const Chunk& chunk = chunk_of(slot);
+  return chunk.base + static_cast<size_t>(index_of(slot)) * chunk.stride;
+}
+
+int32_t SlotFreeList::slot_of(const void* item) const {
+  const uintptr_t address = reinterpret_cast<uintptr_t>(item);
+
+  // 找起始地址不大于 item 的最后一个批次
+  int chunk_index = -1;
+  while (true) {
+    const uint32_t version = index_version_.load(std::memory_order_acquire);
+    if (version % 2 != 0) {
+      continue;  // add_chunk 正在插入，很快就结束
+    }
+    int low  = 0;
+    int high = chunk_num_.load(std::memory_order_relaxed);
+    while (low < high) {
+      const int mid = (low + high) / 2;
+      if (sorted_base_[mid].load(std::memory_order_relaxed) <= address) {
+        low = mid + 1;
+      } else {
+        high = mid;
+      }
+    }
+    chunk_index = low > 0 ? sorted_chunk_[low - 1].load(std::memory_order_relaxed) : -1;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (index_version_.load(std::memory_order_relaxed) == version) {
+      break;
+    }
+  }
+  if (chunk_index < 0) {
+    return -1;
+  }
+
+  const Chunk* chunk = chunks_[chunk_index].load(std::memory_order_acquire);
+  const char*  ptr   = static_cast<const char*>(item);
+  if (ptr >= chunk->base + chunk->stride * slots_per_chunk_) {
+    return -1;
+  }
+  const size_t offset = static_cast<size_t>(ptr - chunk->base);
+  if (offset % chunk->stride != 0) {
+    return -1;
+  }
+  return make_slot(chunk_index, static_cast<int>(offset / chunk->stride));
+}
+
+bool SlotFreeList::is_used(int32_t slot) const {
+  const int index = index_of(slot);
+  return (chunk_of(slot).used[index / 64].load(std::memory_order_relaxed) & (1ULL << (index % 64))) != 0;
+}
+
+int SlotFreeList::used_num() const {
+  int num = 0;
+  const int chunk_num = chunk_num_.load(std::memory_order_acquire);
+  const int words     = (slots_per_chunk_ + 63) / 64;
+  for (int i = 0; i < chunk_num; i++) {
+    const Chunk* chunk = chunks_[i].load(std::memory_order_acquire);
+    for (int w = 0; w < words; w++) {
+      num += __builtin_popcountll(chunk->used[w].load(std::memory_order_relaxed));
+    }
+  }
+  return num;
+}
+
+} // namespace common
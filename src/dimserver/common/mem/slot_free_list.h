@@ -0,0 +1,122 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+
+namespace common {
+
+/**
+ * @brief 内存池的空闲槽位管理，分配和释放不加锁
+ * @details 内存池的每一批(chunk)对象占一段槽位，槽位号的高位是批次号，低 INDEX_BITS 位是批内下标，
+ * 换算只需要移位。
+ * - 空闲槽位组成一个 Treiber 栈：栈顶是一个64位的原子变量，低32位是槽位号，高32位是版本号，
+ *   每次修改都加一，避免ABA问题；每个槽位的下一个空闲槽位记在单独的数组中，
+ *   不会覆盖对象本身的内容(MemPoolSimple 中空闲的对象仍然是构造好的)。
+ * - 槽位是否在使用用一个原子位图记录，用来检查重复释放，不需要额外分配内存。
+ *
+ * 每批的元数据在 add_chunk 时分配，直到 clear 才释放，所以并发的 pop 读到过期的槽位也是安全的。
+ * add_chunk 和 clear 需要调用者互斥，clear 时不能有并发的分配和释放。
+ *
+ * 批次数最多 MAX_CHUNK_NUM，之后 add_chunk 失败，内存池不能再扩展(MemPool::extend 返回-1)。
+ * 按默认每批的对象个数，这已经远远超过目前的用法；需要更多对象时应该加大每批的个数。
+ */
+class SlotFreeList {
+public:
+  static constexpr int MAX_CHUNK_NUM       = 1024;  /// 最多多少批，固定大小的数组，参考类的说明
+  static constexpr int INDEX_BITS          = 21;
+  static constexpr int MAX_SLOTS_PER_CHUNK = 1 << INDEX_BITS;  /// 每批最多多少个槽位
+
+public:
+  SlotFreeList() = default;
+  ~SlotFreeList();
+
+  SlotFreeList(const SlotFreeList&)            = delete;
+  SlotFreeList& operator=(const SlotFreeList&) = delete;
+
+  /**
+   * @brief 设置每批的槽位个数，必须在 add_chunk 之前调用
+   * @return 0表示成功，个数超过 MAX_SLOTS_PER_CHUNK 时返回-1
+   */
+  int init(int slots_per_chunk);
+
+  /**
+   * @brief 增加一批槽位，全部放到空闲栈中
+   * @param base 这一批对象的起始地址
+   * @param stride 对象的大小
+   * @return 批次号，超过 MAX_CHUNK_NUM 时返回-1
+   */
+  int add_chunk(void* base, size_t stride);
+
+  /// 释放所有批次的元数据
+  void clear();
+
+  /**
+   * @brief 取一个空闲槽位并标记为使用中
+   * @return 槽位号，没有空闲槽位时返回-1
+   */
+  int32_t pop();
+
+  /**
+   * @brief 设置槽位的使用中标记，给不经过空闲栈的分配使用(比如 MemPoolItem 的线程缓存)
+   * @return 槽位已经在使用中时返回false
+   */
+  bool mark_used(int32_t slot);
+
+  /**
+   * @brief 清除槽位的使用中标记
+   * @return 槽位不在使用中(重复释放)时返回false，这时不能再 push
+   */
+  bool mark_free(int32_t slot);
+
+  /**
+   * @brief 把 mark_free 之后的槽位放回空闲栈
+   */
+  void push(int32_t slot);
+
+  void* item_of(int32_t slot) const;
+
+  /**
+   * @brief 对象所在的槽位
+   * @details 在按起始地址排序的批次中二分查找，和 add_chunk 并发时重试
+   * @return 不属于任何批次时返回-1
+   */
+  int32_t slot_of(const void* item) const;
+
+  bool is_used(int32_t slot) const;
+
+  /// 使用中的槽位个数，需要遍历位图，只用于统计
+  int used_num() const;
+  int chunk_num() const { return chunk_num_.load(std::memory_order_acquire); }
+  int slots_per_chunk() const { return slots_per_chunk_; }
+
+private:
+  static constexpr uint32_t EMPTY = 0xFFFFFFFFU;
+
+  struct Chunk {
+    char*                                   base   = nullptr;
+    size_t                                  stride = 0;
+    std::unique_ptr<std::atomic<uint32_t>[]> next;  /// 空闲栈中下一个槽位
+    std::unique_ptr<std::atomic<uint64_t>[]> used;  /// 使用中的位图
+  };
+
+  static int32_t make_slot(int chunk_index, int index) { return (chunk_index << INDEX_BITS) | index; }
+  static int     index_of(int32_t slot) { return slot & (MAX_SLOTS_PER_CHUNK - 1); }
+
+  Chunk& chunk_of(int32_t slot) const { return *chunks_[slot >> INDEX_BITS].load(std::memory_order_acquire); }
+  std::atomic<uint32_t>& next_of(int32_t slot) const { return chunk_of(slot).next[index_of(slot)]; }
+
+private:
+  int                   slots_per_chunk_ = 0;
+  std::atomic<int>      chunk_num_{0};
+  std::atomic<Chunk*>   chunks_[MAX_CHUNK_NUM] = {};
+
+  /// 按起始地址排序的批次号，给 slot_of 查找。add_chunk 修改期间 index_version_ 是奇数，读者发现版本变化就重试
+  std::atomic<uintptr_t> sorted_base_[MAX_CHUNK_NUM]  = {};
+  std::atomic<int>       sorted_chunk_[MAX_CHUNK_NUM] = {};
+  std::atomic<uint32_t>  index_version_{0};
+  alignas(64) std::atomic<uint64_t> head_{EMPTY};  /// 高32位版本号，低32位槽位号
+};
+
+} // namespace common
@@ -0,0 +1,136 @@
+#include <limits>
+
+#include "common/thread/epoch.h"
+
+namespace common {
+
+/**
+ * @brief 线程在 EpochManager 中的状态
+ * @details 线程退出时归还槽位
+ */
+struct ThreadEpochState {
+  int slot    = -1;
+  int nesting = 0;
+
+  ~ThreadEpochState();
+};
+
+static thread_local ThreadEpochState thread_epoch_state;
+
+EpochManager& EpochManager::instance() {
+  static EpochManager manager;
+  return manager;
+}
+
+EpochManager::~EpochManager() {
+  for (Retired& retired : retired_) {
+    retired.deleter();
+  }
+  retired_.clear();
+}
+
+int EpochManager::thread_slot() {
+  if (thread_epoch_state.slot >= 0) {
+    return thread_epoch_state.slot;
+  }
+
+  for (int i = 0; i < MAX_THREADS; i++) {
+    bool expected = false;
+    if (!slots_[i].in_use.load(std::memory_order_relaxed) &&
+        slots_[i].in_use.compare_exchange_strong(expected, true, std::memory_order_acq_rel)) {
+      int max_slot = max_slot_.load(std::memory_order_relaxed);
+      while (max_slot < i + 1 && !max_slot_.compare_exchange_weak(max_slot, i + 1, std::memory_order_acq_rel)) {
+      }
+      thread_epoch_state.slot = i;
+      return i;
+    }
+  }
+  return -1;
+}
+
+void EpochManager::release_slot(int slot) {
+  slots_[slot].epoch.store(0, std::memory_order_release);
+  slots_[slot].in_use.store(false, std::memory_order_release);
+}
+
+uint64_t EpochManager::min_active_epoch() const {
+  uint64_t min_epoch = std::numeric_limits<uint64_t>::max();
+  const int max_slot = max_slot_.load(std::memory_order_acquire);
+  for (int i = 0; i < max_slot; i++) {
+    const uint64_t epoch = slots_[i].epoch.load(std::memory_order_seq_cst);
+    if (epoch != 0 && epoch < min_epoch) {
+      min_epoch = epoch;
+    }
+  }
+  return min_epoch;
+}
+
+void EpochManager::retire(std::function<void()> deleter) {
+  std::lock_guard lock(retired_mutex_);
+  const uint64_t epoch = global_epoch_.fetch_add(1, std::memory_order_seq_cst);
+  retired_.push_back(Retired{epoch, std::move(deleter)});
+}
+
+size_t EpochManager::reclaim() {
+  const uint64_t min_epoch = min_active_epoch();
+
+  std::vector<Retired> reclaimable;
+  {
+    std::lock_guard lock(retired_mutex_);
+    auto iter = retired_.begin();
+    while (iter != retired_.end()) {
+      if (iter->epoch < min_epoch) {
+        reclaimable.push_back(std::move(*iter));
+        iter = retired_.erase(iter);
+      } else {
+        ++iter;
+      }
+    }
+  }
+
+  // deleter 可能比较慢，不在锁内执行
+  for (Retired& retired : reclaimable) {
+    retired.deleter();
+  }
+  return reclaimable.size();
+}
+
+size_t EpochManager::pending() const {
+  std::lock_guard lock(retired_mutex_);
+  return retired_.size();
+}
+
+ThreadEpochState::~ThreadEpochState() {
+  if (slot >= 0) {
+    EpochManager::instance().release_slot(slot);
+    slot = -1;
+  }
+}
+
+EpochGuard::EpochGuard() {
+  ThreadEpochState& state = thread_epoch_state;
+  if (state.nesting++ > 0) {
+    slot_ = state.slot;
+    return;
+  }
+
+  EpochManager& manager = EpochManager::instance();
+  slot_ = manager.thread_slot();
+  if (slot_ < 0) {
+    return;
+  }
+  // seq_cst：保证进入临界区的记录先于之后对数据结构的读取被写者看到
+  manager.slots_[slot_].epoch.store(manager.global_epoch_.load(std::memory_order_seq_cst), std::memory_order_seq_cst);
+}
+
+EpochGuard::~EpochGuard() {
+  ThreadEpochState& state = thread_epoch_state;
+  if (--state.nesting > 0) {
+    return;
+  }
+  if (slot_ >= 0) {
+    EpochManager::instance().slots_[slot_].epoch.store(0, std::memory_order_release);
+  }
+}
+
+} // namespace common
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <mutex>
+#include <atomic>
+#include <vector>
+#include <cstdint>
+#include <functional>
+
+namespace common {
+
+/**
+ * @brief 基于纪元(epoch)的内存回收
+ * @details 无锁数据结构中，写者把一块内存从结构中摘下来之后，可能还有读者持有指向它的指针，
+ * 不能马上释放。EpochManager 记录每个正在读的线程进入时的纪元：
+ * - 读者通过 EpochGuard 进入/退出临界区，进入时记录当前的全局纪元；
+ * - 写者摘下内存之后调用 retire，这块内存记录为当前纪元，同时全局纪元加一；
+ * - 之后进入的读者看到的是更大的纪元，不可能再拿到这块内存。当所有活跃读者的纪元
+ *   都大于这块内存的纪元时，就可以安全释放了。
+ *
+ * 读者的开销只有进入和退出时各一次原子写，不需要加锁。所有数据结构共享一个全局实例。
+ */
+class EpochManager {
+public:
+  static constexpr int MAX_THREADS = 256;  /// 同时处于临界区的最大线程数
+
+public:
+  static EpochManager& instance();
+
+  /**
+   * @brief 推迟到所有可能持有这块内存的读者退出之后再执行deleter
+   * @details 调用时，这块内存必须已经从数据结构中摘下来了，新来的读者不可能再拿到
+   */
+  void retire(std::function<void()> deleter);
+
+  /**
+   * @brief 执行所有可以安全执行的deleter
+   * @return 执行的个数
+   */
+  size_t reclaim();
+
+  /// 还没有执行的deleter个数
+  size_t pending() const;
+
+  uint64_t current_epoch() const { return global_epoch_.load(std::memory_order_acquire); }
+
+private:
+  friend class EpochGuard;
+  friend struct ThreadEpochState;
+
+  EpochManager() = default;
+  ~EpochManager();
+
+  struct alignas(64) ThreadSlot {
+    std::atomic<bool>     in_use{false};
+    std::atomic<uint64_t> epoch{0};  /// 0表示当前不在临界区
+  };
+
+  struct Retired {
+    uint64_t              epoch;
+    std::function<void()> deleter;
+  };
+
+  /// 当前线程的槽位，第一次使用时分配，线程退出时归还。没有空闲槽位时返回-1
+  int  thread_slot();
+  void release_slot(int slot);
+
+  /// 所有活跃读者中最小的纪元，没有活跃读者时返回UINT64_MAX
+  uint64_t min_active_epoch() const;
+
+private:
+  std::atomic<uint64_t> global_epoch_{1};
+  ThreadSlot            slots_[MAX_THREADS];
+  std::atomic<int>      max_slot_{0};  /// 曾经用过的最大槽位+1
+
+  mutable std::mutex   retired_mutex_;
+  std::vector<Retired> retired_;
+};
+
+/**
+ * @brief 读者临界区
+ * @details 可以嵌套，只有最外层的 EpochGuard 真正进入和退出。
+ * 没有空闲的线程槽位时 active() 返回false，调用者需要退回到加锁的路径。
+ */
+class EpochGuard {
+public:
+  EpochGuard();
+  ~EpochGuard();
+
+  EpochGuard(const EpochGuard&)            = delete;
+  EpochGuard& operator=(const EpochGuard&) = delete;
+
+  bool active() const { return slot_ >= 0; }
+
+private:
+  int slot_ = -1;
+};
+
+} // namespace common
@@ -0,0 +1,159 @@
+#include <thread>
+#include <climits>
+
+#if defined(__linux__)
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#endif
+
+#include "common/thread/rw_latch.h"
+
+namespace common {
+
+static_assert(sizeof(RwLatch) == 8, "RwLatch should fit in 8 bytes");
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "futex needs a plain 32-bit word");
+
+static inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__)
+  asm volatile("yield");
+#endif
+}
+
+void RwLatch::park(uint32_t expected) {
+#if defined(__linux__)
+  // state_ 不再等于expected时马上返回，不会错过唤醒
+  syscall(SYS_futex, reinterpret_cast<uint32_t*>(&state_), FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0);
+#else
+  (void)expected;
+  std::this_thread::yield();
+#endif
+}
+
+void RwLatch::unpark_all() {
+  state_.fetch_and(~PARKED, std::memory_order_relaxed);
+#if defined(__linux__)
+  syscall(SYS_futex, reinterpret_cast<uint32_t*>(&state_), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+#endif
+}
+
+template <typename Acquire>
+void RwLatch::wait(Acquire&& acquire) {
+  uint32_t state = state_.load(std::memory_order_relaxed);
+  for (int spin = 0; ; spin++) {
+    if (acquire(state)) {
+      return;
+    }
+
+    if (spin < SPIN_COUNT) {
+      cpu_relax();
+      state = state_.load(std::memory_order_relaxed);
+      continue;
+    }
+
+    // 先标记有线程挂起，解闩的线程看到标记才会唤醒
+    if ((state & PARKED) == 0 &&
+        !state_.compare_exchange_weak(state, state | PARKED, std::memory_order_relaxed)) {
+      continue;
+    }
+    park(state | PARKED);
+    state = state_.load(std::memory_order_relaxed);
+  }
+}
+
+bool RwLatch::try_read_latch() {
+  uint32_t state = state_.load(std::memory_order_relaxed);
+  while ((state & WRITER) == 0) {
+    if (state_.compare_exchange_weak(state, state + 1, std::memory_order_acquire, std::memory_order_relaxed)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void RwLatch::read_latch() {
+  wait([this](uint32_t& state) {
+    while ((state & WRITER) == 0) {
+      if (state_.compare_exchange_weak(state, state + 1, std::memory_order_acquire, std::memory_order_relaxed)) {
+        return true;
+      }
+    }
+    return false;
+  });
+}
+
+void RwLatch::read_unlatch() {
+  const uint32_t old_state = state_.fetch_sub(1, std::memory_order_release);
+  // 只有等待读者退出的写者需要最后一个读者唤醒
+  if ((old_state & PARKED) != 0 && (old_state & READER_MASK) == 1) {
+    unpark_all();
+  }
+}
+
+bool RwLatch::try_write_latch() {
+  uint32_t state = state_.load(std::memory_order_relaxed);
+  while ((state & ~PARKED) == 0) {
+    if (state_.compare_exchange_weak(state, state | WRITER, std::memory_order_acquire, std::memory_order_relaxed)) {
+      version_.fetch_add(1, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_release);
+      return true;
+    }
+  }
+  return false;
+}
+
+void RwLatch::write_latch() {
+  // 先占住 WRITER，新的读者就进不来了，然后等已有的读者退出
+  wait([this](uint32_t& state) {
+    while ((state & WRITER) == 0) {
+      if (state_.compare_exchange_weak(state, state | WRITER, std::memory_order_acquire, std::memory_order_relaxed)) {
+        return true;
+      }
+    }
+    return false;
+  });
+  wait([this](uint32_t& state) {
+    if ((state & READER_MASK) == 0) {
+      std::atomic_thread_fence(std::memory_order_acquire);
+      return true;
+    }
+    return false;
+  });
+
+  // 版本号变为奇数，乐观读的读者在写者释放之前都不能通过验证
+  version_.fetch_add(1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+}
+
+void RwLatch::write_unlatch() {
+  version_.fetch_add(1, std::memory_order_release);
+  const uint32_t old_state = state_.fetch_and(~WRITER, std::memory_order_release);
+  if ((old_state & PARKED) != 0) {
+    unpark_all();
+  }
+}
+
+uint32_t RwLatch::optimistic_read() {
+  for (int spin = 0; spin < SPIN_COUNT; spin++) {
+    const uint32_t version = version_.load(std::memory_order_acquire);
+    if ((version & 1) == 0) {
+      return version;
+    }
+    cpu_relax();
+  }
+
+  // 写者持有的时间比较长，跟着读闩挂起等写者释放
+  read_latch();
+  const uint32_t version = version_.load(std::memory_order_acquire);
+  read_unlatch();
+  return version;
+}
+
+bool RwLatch::validate(uint32_t version) const {
+  std::atomic_thread_fence(std::memory_order_acquire);
+  return version_.load(std::memory_order_relaxed) == version;
+}
+
+} // namespace common
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <utility>
+
+namespace common {
+
+/**
+ * @brief 紧凑的读写闩(latch)，给页帧这类数量很多、持有时间很短的对象使用
+ * @details 只占8个字节：一个32位的状态字和一个32位的版本号。
+ * - 状态字：低30位是读者个数，WRITER 表示有写者持有或者正在等待读者退出，
+ *   PARKED 表示有线程在等待；
+ * - 版本号：写者持有时为奇数，每次加写闩和解写闩都加一。
+ *
+ * 加闩时先自旋一小段时间，仍然拿不到就挂起(Linux 上使用 futex，其它平台让出CPU)，
+ * 解闩时只有在有线程挂起的情况下才需要唤醒。
+ * 写者设置 WRITER 之后新的读者不能再进入，避免写者饿死。
+ *
+ * 乐观读不修改任何共享状态，读多写少时没有缓存行的争用：
+ * @code
+ * uint32_t version;
+ * do {
+ *   version = latch.optimistic_read();
+ *   ... 读取数据，读到的数据可能不一致，只能拷贝出来，不能根据它解引用指针 ...
+ * } while (!latch.validate(version));
+ * @endcode
+ *
+ * 闩不可重入，读闩也不能升级为写闩。
+ */
+class RwLatch {
+public:
+  static constexpr int SPIN_COUNT = 128;  /// 挂起之前自旋的次数
+
+public:
+  RwLatch() = default;
+
+  RwLatch(const RwLatch&)            = delete;
+  RwLatch& operator=(const RwLatch&) = delete;
+
+  void read_latch();
+  bool try_read_latch();
+  void read_unlatch();
+
+  void write_latch();
+  bool try_write_latch();
+  void write_unlatch();
+
+  /**
+   * @brief 开始乐观读
+   * @details 有写者持有时等待写者释放，等待时间长时会挂起
+   * @return 当前版本号，用于 validate
+   */
+  uint32_t optimistic_read();
+
+  /**
+   * @brief 检查乐观读期间是否有写者修改过
+   */
+  bool validate(uint32_t version) const;
+
+  bool is_write_latched() const { return (state_.load(std::memory_order_relaxed) & WRITER) != 0; }
+  int  reader_count() const { return static_cast<int>(state_.load(std::memory_order_relaxed) & READER_MASK); }
+  uint32_t version() const { return version_.load(std::memory_order_acquire); }
+
+private:
+  static constexpr uint32_t WRITER      = 1U << 31;
+  static constexpr uint32_t PARKED      = 1U << 30;
+  static constexpr uint32_t READER_MASK = PARKED - 1;
+
+  /// 在state_上挂起，直到state_不再等于expected
+  void park(uint32_t expected);
+  /// 清除 PARKED 并唤醒所有挂起的线程
+  void unpark_all();
+
+  /**
+   * @brief 等待直到acquire返回true
+   * @details 先自旋，再设置 PARKED 挂起。acquire 的参数是最近读到的状态字，
+   * CAS失败时由acquire更新
+   */
+  template <typename Acquire>
+  void wait(Acquire&& acquire);
+
+private:
+  std::atomic<uint32_t> state_{0};
+  std::atomic<uint32_t> version_{0};
+};
+
+/**
+ * @brief 读闩的RAII封装
+ * @details 可以移动，方便B+树这类结构做闩耦合(latch coupling)：先拿到子节点的闩，
+ * 再把父节点的guard释放或者覆盖掉
+ */
+class ReadLatchGuard {
+public:
+  ReadLatchGuard() = default;
+  explicit ReadLatchGuard(RwLatch& latch) : latch_(&latch) { latch_->read_latch(); }
+  ~ReadLatchGuard() { release(); }
+
+  ReadLatchGuard(ReadLatchGuard&& other) noexcept : latch_(std::exchange(other.latch_, nullptr)) {}
+  ReadLatchGuard& operator=(ReadLatchGuard&& other) noexcept {
+    if (this != &other) {
+      release();
+      latch_ = std::exchange(other.latch_, nullptr);
+    }
+    return *this;
+  }
+
+  ReadLatchGuard(const ReadLatchGuard&)            = delete;
+  ReadLatchGuard& operator=(const ReadLatchGuard&) = delete;
+
+  bool owns_latch() const { return latch_ != nullptr; }
+
+  void release() {
+    if (latch_ != nullptr) {
+      latch_->read_unlatch();
+      latch_ = nullptr;
+    }
+  }
+
+private:
+  RwLatch* latch_ = nullptr;
+};
+
+/**
+ * @brief 写闩的RAII封装，参考 ReadLatchGuard
+ */
+class WriteLatchGuard {
+public:
+  WriteLatchGuard() = default;
+  explicit WriteLatchGuard(RwLatch& latch) : latch_(&latch) { latch_->write_latch(); }
+  ~WriteLatchGuard() { release(); }
+
+  WriteLatchGuard(WriteLatchGuard&& other) noexcept : latch_(std::exchange(other.latch_, nullptr)) {}
+  WriteLatchGuard& operator=(WriteLatchGuard&& other) noexcept {
+    if (this != &other) {
+      release();
+      latch_ = std::exchange(other.latch_, nullptr);
+    }
+    return *this;
+  }
+
+  WriteLatchGuard(const WriteLatchGuard&)            = delete;
+  WriteLatchGuard& operator=(const WriteLatchGuard&) = delete;
+
+  bool owns_latch() const { return latch_ != nullptr; }
+
+  void release() {
+    if (latch_ != nullptr) {
+      latch_->write_unlatch();
+      latch_ = nullptr;
+    }
+  }
+
+private:
+  RwLatch* latch_ = nullptr;
+};
+
+} // namespace common
@@ -0,0 +1,43 @@
+#include <atomic>
+
+#include "common/thread/thread_index.h"
+
+namespace common {
+
+static std::atomic<bool> thread_index_used[ThreadIndex::MAX_THREADS];
+
+/**
+ * @brief 线程退出时归还编号
+ */
+struct ThreadIndexHolder {
+  int index = -1;
+  bool assigned = false;
+
+  ~ThreadIndexHolder() {
+    if (index >= 0) {
+      thread_index_used[index].store(false, std::memory_order_release);
+    }
+  }
+};
+
+static thread_local ThreadIndexHolder thread_index_holder;
+
+int ThreadIndex::current() {
+  ThreadIndexHolder& holder = thread_index_holder;
+  if (holder.assigned) {
+    return holder.index;
+  }
+
+  holder.assigned = true;
+  for (int i = 0; i < MAX_THREADS; i++) {
+    bool expected = false;
+    if (!thread_index_used[i].load(std::memory_order_relaxed) &&
+        thread_index_used[i].compare_exchange_strong(expected, true, std::memory_order_acq_rel)) {
+      holder.index = i;
+      break;
+    }
+  }
+  return holder.index;
+}
+
+} // namespace common
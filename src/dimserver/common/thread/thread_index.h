@@ -0,0 +1,21 @@
+#pragma once
+
+namespace common {
+
+/**
+ * @brief 给线程分配一个小的、稠密的编号
+ * @details 用来索引按线程划分的数组(比如 MemPoolItem 的线程缓存)。
+ * 编号在线程第一次调用时分配，线程退出时归还，之后可能分配给新的线程。
+ */
+class ThreadIndex {
+public:
+  static constexpr int MAX_THREADS = 256;
+
+  /**
+   * @brief 当前线程的编号，范围是[0, MAX_THREADS)
+   * @return 编号用完时返回-1，调用者需要退回到不按线程划分的路径
+   */
+  static int current();
+};
+
+} // namespace common
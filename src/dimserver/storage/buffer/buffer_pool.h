@@ -10,66 +10,19 @@
 #include "common/types.h"
 
 #include "common/bitmap/bitmap.h"
+#include "common/io/async_io.h"
 #include "common/mem/mem_pool.h"
-#include "storage/buffer/lru_cache.h"
 #include "storage/buffer/frame.h"
+#include "storage/buffer/frame_manager.h"
+#include "storage/buffer/scan_ring.h"
+#include "storage/buffer/prefetcher.h"
+#include "storage/buffer/page_cleaner.h"
 #include "storage/buffer/page.h"
+#include "storage/buffer/page_alloc_map.h"
 #include "storage/buffer/double_write_buffer.h"
 #include "storage/buffer/buffer_pool_log.h"
 
 namespace storage {
-/**
- * @brief 管理页面Frame
- * @ingroup BufferPool
- * @details 管理内存中的页帧。内存是有限的，内存中能够存放的页帧个数也是有限的。
- * 当内存中的页帧不够用时，需要从内存中淘汰一些页帧，以便为新的页帧腾出空间。
- * 这个管理器负责为所有的BufferPool提供页帧管理服务，也就是所有的BufferPool磁盘文件
- * 在访问时都使用这个管理器映射到内存。
- */
-class FrameManager {
-public:
-	FrameManager(const std::string& tag);
-	~FrameManager();
-
-	RC init(int pool_num);
-	RC cleanup();
-
-	Frame* get(int buffer_pool_id, PageNum page_num);
-	std::list<Frame*> find_list(int buffer_pool_id);
-
-	Frame* alloc(int buffer_pool_id, PageNum page_num);
-	RC free(int buffer_pool_id, PageNum page_num, Frame* frame);
-	int purge_frames(int count, std::function<RC(Frame*)> purger);
-
-	size_t frame_num() const;
-	size_t total_frame_num() const;
-
-private:
-	Frame* get_internal(const FrameId& frame_id);
-	RC free_internal(const FrameId& frame_id, Frame* frame);
-
-	struct FrameIdHash {
-		size_t operator()(const FrameId& frame_id) const {
-			return frame_id.hash();
-		}
-	};
-
-	std::mutex mutex_;
-	LruCache<FrameId, Frame*, FrameIdHash> frames_; // 采用LRU缓存
-	MemPoolSimple<Frame> allocator_; // 采用内存池
-};
-
-struct BPFileHeader
-{
-  int32_t buffer_pool_id;   //! buffer pool id
-  int32_t page_count;       //! 当前文件一共有多少个页面
-  int32_t allocated_pages;  //! 已经分配了多少个页面
-  char    bitmap[0];        //! 页面分配位图, 第0个页面(就是当前页面)，总是1
-
-  static const int MAX_PAGE_NUM = (BP_PAGE_DATA_SIZE - sizeof(page_count) - sizeof(allocated_pages)) * 8;
-
-  std::string to_string() const;
-};
 
 class BufferPool final {
 public:
@@ -81,7 +34,13 @@ public:
 
 	RC close_file();
 
-	RC get_this_page(PageNum page_num, Frame** frame);
+	/**
+	 * @brief 获取指定页面，并pin住
+	 * @details 只保证页面不会被淘汰。读写页面内容时需要再加页面的读写闩，参考 Frame::read_latch
+	 * @param ring 顺序扫描时传入扫描自己的页帧环(参考 BufferPoolIterator::scan_ring)，
+	 * 扫描访问的页面不会在替换策略中被提升，也最多只占用环大小个页帧
+	 */
+	RC get_this_page(PageNum page_num, Frame** frame, ScanRing* ring = nullptr);
 
 	RC allocate_page(Frame** frame);
 
@@ -111,13 +70,15 @@ public:
 	std::string filename() const { return filename_; }
 
 protected:
-  RC allocate_frame(PageNum page_num, Frame **buf);
+  RC allocate_frame(PageNum page_num, Frame **buf, ScanRing* ring = nullptr);
 
   RC purge_frame(PageNum page_num, Frame *used_frame);
   RC check_page_num(PageNum page_num);
 
+  /// 读数据文件中的页面，通过 BufferPoolManager::io_backend 指定的 common::AsyncIoEngine 提交
   RC load_page(PageNum page_num, Frame *frame);
 
+  /// 脏页交给 double write buffer，和同一批的其他页面一起通过异步IO写盘
   RC flush_page_internal(Frame &frame);
 
 private:
@@ -131,7 +92,10 @@ private:
   int32_t       buffer_pool_id_ = -1;
   Frame        *hdr_frame_      = nullptr;  /// 文件头页面
   BPFileHeader *file_header_    = nullptr;  /// 文件头
+  /// 页面分配图，文件头和分配图页面的页帧打开文件时 pin 住，直到关闭文件
+  std::unique_ptr<PageAllocMap> alloc_map_;
   std::set<PageNum>  disposed_pages_;            /// 已经释放的页面
+  std::unique_ptr<PrefetchStream> prefetch_stream_; /// 检测 get_this_page 的顺序访问，参考 Prefetcher
 
   std::string filename_;  /// 文件名
 
@@ -141,15 +105,42 @@ private:
 
 class BufferPoolManager final {
 public:
+	/**
+	 * @brief 所有 BufferPool 的脏页中最小的 recLSN，给检查点使用，参考 Checkpointer
+	 */
+	LSN min_rec_lsn() const { return frame_manager_.min_rec_lsn(); }
+
+	/**
+	 * @brief 数据文件和 double write buffer 文件是否使用直接IO(O_DIRECT)，需要在打开文件之前设置
+	 * @details 页面已经缓存在页帧中，再经过内核的页缓存就缓存了两份。直接IO要求内存按 DIRECT_IO_ALIGN 对齐，
+	 * 页帧的页面由 FramePool 按4KB对齐分配，DiskDoubleWriteBuffer 使用自己对齐的写盘缓冲区。
+	 * 文件系统不支持时退回普通IO，参考 open_file
+	 */
+	void set_direct_io(bool direct_io) { direct_io_ = direct_io; }
+	bool direct_io() const { return direct_io_; }
+
+	/**
+	 * @brief 读写数据文件的异步IO实现方式，需要在打开文件之前设置
+	 * @details BufferPool 读页面和 DiskDoubleWriteBuffer 写页面都通过 common::AsyncIoEngine 提交，
+	 * 一个线程就可以让设备上同时有多个请求。io_uring 不可用时退回线程池，参考 common::AsyncIoEngine::create
+	 */
+	void set_io_backend(common::AsyncIoBackend backend) { io_backend_ = backend; }
+	common::AsyncIoBackend io_backend() const { return io_backend_; }
 
 private:
 	FrameManager frame_manager_{"BufferPool"};
+	Prefetcher prefetcher_{frame_manager_};  /// 所有 BufferPool 共享的预读线程
 
 	std::unique_ptr<DoubleWriteBuffer> dbwr_buffer_;
+	/// 后台刷脏页，还没有创建：BufferPoolManager 目前没有初始化 dbwr_buffer_ 的流程，
+	/// 创建时刷盘回调要经过 dbwr_buffer_，日志增长速度来自 LogHandler::current_lsn
+	std::unique_ptr<PageCleaner> page_cleaner_;
 
 	std::unordered_map<std::string, BufferPool*> buffer_pools_;
 	std::unordered_map<int32_t, BufferPool*> id_to_buffer_pools_;
 	std::atomic<int32_t> next_buffer_pool_id{1};
+	bool direct_io_ = false;
+	common::AsyncIoBackend io_backend_ = common::AsyncIoBackend::AUTO;
 };
 
 class BufferPoolIterator {
@@ -161,9 +152,15 @@ public:
   bool    has_next();
   PageNum next();
   RC      reset();
+
+  /**
+   * @brief 顺序扫描使用的页帧环，遍历时传给 BufferPool::get_this_page
+   */
+  ScanRing& scan_ring() { return scan_ring_; }
 private:
 	Bitmap bitmpa_;
 	PageNum current_page_num_ = -1;
+	ScanRing scan_ring_;
 };
 
 } // namespace storage
@@ -97,6 +97,12 @@ public:
   ///! @copydoc LogReplayer::replay
   RC replay(const LogEntry &entry) override;
 
+  /**
+   * @brief 分配/释放页面会修改 buffer pool 的头页面(页面分配位图和页面个数)，
+   * 并且后面这些页面上的日志都要在分配之后回放，所以作为并行回放的屏障
+   */
+  uint64_t partition(const LogEntry &/*entry*/) const override { return BARRIER; }
+
 private:
   BufferPoolManager &bp_manager_;
 };
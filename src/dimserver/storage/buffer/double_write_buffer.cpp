@@ -1,42 +1,88 @@
 #include <unistd.h>
 #include <fcntl.h>
-#include <mutex>
+#include <sys/uio.h>
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <unordered_map>
 
 #include "storage/buffer/double_write_buffer.h"
+#include "storage/buffer/buffer_pool.h"
 #include "common/log/log.h"
 #include "common/io/io.h"
 #include "common/math/crc.h"
 
+namespace storage {
+
 struct DoubleWritePage {
 public:
-  DoubleWritePage() = default;
-  DoubleWritePage(int32_t buffer_pool_id, PageNum page_num, int32_t page_index, Page& page);
+  DoubleWritePage(int32_t buffer_pool_id, PageNum page_num, int32_t slot, Page* page);
 
 public:
   DoubleWritePageKey key;
-  int32_t            page_index = -1; /// 页面在double write buffer文件中的页索引
-  bool               valid = true; /// 表示页面是否有效，在页面被删除时，需要同时标记磁盘上的值。
-  Page               page;
-
-  static const int32_t SIZE;
+  int32_t            slot = -1;      /// 在写盘缓冲区和文件中的位置，第 slot+1 个页面
+  Page              *page = nullptr; /// 指向写盘缓冲区中的页面
 };
 
-DoubleWritePage::DoubleWritePage(int32_t buffer_pool_id, PageNum page_num,int32_t page_index, 
-  Page &_page) :key{buffer_pool_id, page_num}, page_index(page_index), page(_page) {}
+DoubleWritePage::DoubleWritePage(int32_t buffer_pool_id, PageNum page_num, int32_t slot, Page *page)
+  : key{buffer_pool_id, page_num}, slot(slot), page(page) {}
 
 
-const int32_t DoubleWritePage::SIZE = sizeof(DoubleWritePage);
+uint32_t DoubleWriteBufferHeader::calc_check_sum() const {
+  const uint32_t crc = crc32c(this, offsetof(DoubleWriteBufferHeader, check_sum));
+  return crc32c(entries, sizeof(Entry) * page_cnt, crc);
+}
 
-const int32_t DoubleWriteBufferHeader::SIZE = sizeof(DoubleWriteBufferHeader);
+bool DoubleWriteBufferHeader::is_valid() const {
+  return magic == MAGIC && page_cnt >= 0 && page_cnt <= MAX_PAGES && check_sum == calc_check_sum();
+}
 
 
 /************************ DiskDoubleWriteBuffer ****************************/
-DiskDoubleWriteBuffer::DiskDoubleWriteBuffer(BufferPoolManager &bp_manager, int max_pages /*=16*/) 
-  : max_pages_(max_pages), bp_manager_(bp_manager) {}
+DiskDoubleWriteBuffer::DiskDoubleWriteBuffer(FileResolver resolver, int max_pages /*=DEFAULT_MAX_PAGES*/,
+    int io_threads /*=DEFAULT_IO_THREADS*/, common::AsyncIoBackend io_backend /*=AUTO*/)
+  : max_pages_(std::clamp(max_pages, 1, DoubleWriteBufferHeader::MAX_PAGES)),
+    resolver_(std::move(resolver)) {
+  // 一批页面的数据文件写请求可以同时进行
+  io_engine_ = common::AsyncIoEngine::create(io_backend, max_pages_, io_threads);
+  ensure_buffer(max_pages_);
+}
 
 DiskDoubleWriteBuffer::~DiskDoubleWriteBuffer() {
-  flush_page();
-  close(file_desc_);
+  if (file_desc_ >= 0) {
+    clear_pages();
+    close(file_desc_);
+  }
+  for (const auto &pair : dblwr_pages_) {
+    delete pair.second;
+  }
+  free(buffer_);
+}
+
+RC DiskDoubleWriteBuffer::ensure_buffer(int page_num) {
+  if (buffer_ != nullptr && page_num <= buffer_pages_) {
+    return RC::SUCCESS;
+  }
+
+  // 只在没有攒着的页面时调用，不需要复制原来的内容
+  const size_t size   = static_cast<size_t>(page_num + 1) * BP_PAGE_SIZE;
+  char        *buffer = static_cast<char *>(aligned_alloc(DIRECT_IO_ALIGN, size));
+  if (buffer == nullptr) {
+    LOG_ERROR("Failed to allocate double write buffer. size=%ld", size);
+    return RC::OUT_OF_MEMORY;
+  }
+  free(buffer_);
+  buffer_       = buffer;
+  buffer_pages_ = page_num;
+
+  // 注册失败时照常读写
+  struct iovec registered = {buffer_, size};
+  io_engine_->register_buffers(&registered, 1);
+  return RC::SUCCESS;
+}
+
+Page *DiskDoubleWriteBuffer::slot_page(int32_t slot) const {
+  return reinterpret_cast<Page *>(buffer_ + static_cast<size_t>(slot + 1) * BP_PAGE_SIZE);
 }
 
 RC DiskDoubleWriteBuffer::open_file(const std::string& filename) {
@@ -45,65 +91,82 @@ RC DiskDoubleWriteBuffer::open_file(const std::string& filename) {
     return RC::BUFFERPOOL_OPENED;
   }
 
-  int fd = open(filename.c_str(), O_CREAT | O_RDWR, 0644);
+  bool direct = direct_io_;
+  int  fd     = ::open_file(filename.c_str(), O_CREAT | O_RDWR, 0644, direct);
   if (fd < 0) {
     LOG_ERROR("Failed to open or creat %s, due to %s.", filename.c_str(), strerror(errno));
     return RC::SCHEMA_DB_EXIST;
   }
+  if (direct_io_ && !direct) {
+    LOG_WARN("file system does not support direct io, fall back to buffered io. file=%s", filename.c_str());
+  }
 
   file_desc_ = fd;
+  direct_io_ = direct;
+  io_engine_->register_files(&file_desc_, 1);
   return load_pages();
 }
 
 RC DiskDoubleWriteBuffer::load_pages() {
-  if (file_desc_ < 0) {
-    LOG_ERROR("Failed to load pages, due to file desc is invalid.");
-    return RC::BUFFERPOOL_OPENED;
-  }
-
+  std::lock_guard<std::mutex> lock(mutex_);
   if (!dblwr_pages_.empty()) {
     LOG_ERROR("Failed to load pages, due to double write buffer is not empty. opened?");
     return RC::BUFFERPOOL_OPENED;
   }
 
-  if (lseek(file_desc_, 0, SEEK_SET) == -1) {
-    LOG_ERROR("Failed to load page header, due to failed to lseek:%s.", strerror(errno));
-    return RC::IOERR_SEEK;
+  // 直接IO时只能按页面读到对齐的内存中
+  common::AsyncIoRequest header_request;
+  header_request.prep_read(file_desc_, buffer_, BP_PAGE_SIZE, 0);
+  int ret = io_engine_->execute(&header_request, 1);
+  if (ret == -1) {
+    // 新文件
+    return RC::SUCCESS;
   }
-
-  int ret = readn(file_desc_, &header_, sizeof(header_));
-  if (ret != 0 && ret != -1) {
+  if (ret != 0) {
     LOG_ERROR("Failed to load page header, file_desc:%d, due to failed to read data:%s, ret=%d",
-      file_desc_, strerror(errno), ret);
+      file_desc_, strerror(ret), ret);
     return RC::IOERR_READ;
   }
+  auto header = std::make_unique<DoubleWriteBufferHeader>(*reinterpret_cast<DoubleWriteBufferHeader *>(buffer_));
+  if (!header->is_valid()) {
+    // 文件头还没有写完整，那么数据文件一定还没有开始写
+    LOG_WARN("double write buffer header is invalid, ignore it. page_cnt=%d", header->page_cnt);
+    return RC::SUCCESS;
+  }
+  RC rc = ensure_buffer(header->page_cnt);
+  if (IS_FAIL(rc)) {
+    return rc;
+  }
 
-  for (int page_num = 0; page_num < header_.page_cnt; page_num++) {
-    int64_t offset = ((int64_t)page_num) * DoubleWritePage::SIZE + DoubleWriteBufferHeader::SIZE;
-
-    if (lseek(file_desc_, offset, SEEK_SET) == -1) {
-      LOG_ERROR("Failed to load page %d, offset=%ld, due to failed to lseek:%s.",
-        page_num, offset, strerror(errno));
-      return RC::IOERR_SEEK;
+  // 所有页面一起读，第 i 个页面读到第 i 个槽位
+  std::vector<common::AsyncIoRequest> requests(header->page_cnt);
+  for (int i = 0; i < header->page_cnt; i++) {
+    requests[i].prep_read(file_desc_, slot_page(i), sizeof(Page), static_cast<int64_t>(i + 1) * BP_PAGE_SIZE);
+  }
+  io_engine_->execute(requests.data(), header->page_cnt);
+
+  for (int i = 0; i < header->page_cnt; i++) {
+    const DoubleWriteBufferHeader::Entry &entry = header->entries[i];
+    if (requests[i].result != 0) {
+      LOG_WARN("Failed to load page, file_desc:%d, index:%d, ret=%d, page count=%d",
+        file_desc_, i, requests[i].result, header->page_cnt);
+      continue;
     }
 
-    auto dblwr_page = std::make_unique<DoubleWritePage>();
-    Page &page     = dblwr_page->page;
-    page.header.check_sum = (CheckSum)-1;
-
-    ret = readn(file_desc_, dblwr_page.get(), DoubleWritePage::SIZE);
-    if (ret != 0) {
-      LOG_ERROR("Failed to load page, file_desc:%d, page num:%d, due to failed to read data:%s, ret=%d, page count=%d",
-        file_desc_, page_num, strerror(errno), ret, page_num);
-      return RC::IOERR_READ;
+    // 跳过损坏的页面，加载的页面在缓冲区中还是连续的
+    const int32_t slot       = static_cast<int32_t>(dblwr_pages_.size());
+    auto          dblwr_page =
+        std::make_unique<DoubleWritePage>(entry.buffer_pool_id, entry.page_num, slot, slot_page(slot));
+    if (slot != i) {
+      memcpy(dblwr_page->page, slot_page(i), sizeof(Page));
     }
 
-    const CheckSum check_sum = crc32(page.data, BP_PAGE_DATA_SIZE);
-    if (check_sum == page.header.check_sum) {
+    const CheckSum check_sum = crc32c(dblwr_page->page, sizeof(Page));
+    if (check_sum == entry.check_sum) {
       DoubleWritePageKey key = dblwr_page->key;
       dblwr_pages_.insert(std::pair<DoubleWritePageKey, DoubleWritePage *>(key, dblwr_page.release()));
     } else {
-      LOG_TRACE("got a page with an invalid checksum. on disk:%d, in memory:%d", page.header.check_sum, check_sum);
+      LOG_TRACE("got a page with an invalid checksum. on disk:%u, in memory:%u", entry.check_sum, check_sum);
     }
   }
 
@@ -111,70 +174,251 @@ RC DiskDoubleWriteBuffer::load_pages() {
   return RC::SUCCESS;
 }
 
-RC DiskDoubleWriteBuffer::flush_page()
-{
-  sync();
+RC DiskDoubleWriteBuffer::recover() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return flush_pages(true /*skip_unresolved*/);
+}
 
+RC DiskDoubleWriteBuffer::flush_page() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return flush_pages();
+}
+
+RC DiskDoubleWriteBuffer::flush_pages(bool skip_unresolved /* = false */) {
+  if (dblwr_pages_.empty()) {
+    return RC::SUCCESS;
+  }
+
+  std::vector<DoubleWritePage*> pages;
+  pages.reserve(dblwr_pages_.size());
   for (const auto &pair : dblwr_pages_) {
-    RC rc = write_page(pair.second);
-    if (rc != RC::SUCCESS) {
-      return rc;
-    }
-    pair.second->valid = false;
-    write_page_internal(pair.second);
-    delete pair.second;
+    pages.push_back(pair.second);
   }
 
-  dblwr_pages_.clear();
-  header_.page_cnt = 0;
+  RC rc = write_batch(pages);
+  if (IS_SUCC(rc)) {
+    rc = write_data_files(pages, skip_unresolved);
+  }
+  if (IS_FAIL(rc)) {
+    // 页面留在内存中，下次再写
+    LOG_ERROR("Failed to flush pages in double write buffer. page num=%ld, rc=%s", pages.size(), strrc(rc));
+    return rc;
+  }
 
+  for (DoubleWritePage *page : pages) {
+    delete page;
+  }
+  dblwr_pages_.clear();
+  stats_.batches++;
+  stats_.pages += pages.size();
   return RC::SUCCESS;
 }
 
-RC DiskDoubleWriteBuffer::add_page(BufferPool* bp, PageNum page_num, Page& page)
-{
-  DoubleWritePageKey key{bp->id(), page_num};
-  auto iter = dblwr_pages_.find(key);
-  if (iter != dblwr_pages_.end()) {
-    iter->second->page = page;
-    LOG_TRACE("[cache hit]add page into double write buffer. buffer_pool_id:%d,page_num:%d,lsn=%ld, dwb size=%d",
-      bp->id(), page_num, page.lsn, static_cast<int>(dblwr_pages_.size()));
-    return write_page_internal(iter->second);
+RC DiskDoubleWriteBuffer::write_batch(const std::vector<DoubleWritePage*>& pages) {
+  if (file_desc_ < 0) {
+    LOG_ERROR("Failed to write double write buffer, due to file desc is invalid.");
+    return RC::FILE_NOT_OPEN;
   }
 
-  int64_t          page_cnt   = dblwr_pages_.size();
-  DoubleWritePage *dblwr_page = new DoubleWritePage(bp->id(), page_num, page_cnt, page);
-  dblwr_pages_.insert(std::pair<DoubleWritePageKey, DoubleWritePage *>(key, dblwr_page));
-  LOG_TRACE("insert page into double write buffer. buffer_pool_id:%d,page_num:%d,lsn=%d, dwb size:%d",
-    bp->id(), page_num, page.lsn, static_cast<int>(dblwr_pages_.size()));
-
-  RC rc = write_page_internal(dblwr_page);
-  if (OB_FAIL(rc)) {
-    LOG_WARN("failed to write page into double write buffer. rc=%s buffer_pool_id:%d,page_num:%d,lsn=%d.",
-        strrc(rc), bp->id(), page_num, page.lsn);
-    return rc;
+  // 缓冲区的第0个页面是文件头，页面已经按槽位放在后面，整个缓冲区一次写入
+  memset(buffer_, 0, BP_PAGE_SIZE);
+  auto header = new (buffer_) DoubleWriteBufferHeader();
+  header->page_cnt = static_cast<int32_t>(pages.size());
+  for (DoubleWritePage *page : pages) {
+    header->entries[page->slot] = {page->key.buffer_pool_id, page->key.page_num, crc32c(page->page, sizeof(Page))};
   }
+  header->check_sum = header->calc_check_sum();
+
+  common::AsyncIoRequest request;
+  request.prep_write(file_desc_, buffer_, static_cast<size_t>(pages.size() + 1) * BP_PAGE_SIZE, 0);
+  int ret = io_engine_->execute(&request, 1);
+  if (ret != 0) {
+    LOG_ERROR("Failed to write double write buffer. page num=%ld, error=%s", pages.size(), strerror(ret));
+    return RC::IOERR_WRITE;
+  }
+  request.prep_fsync(file_desc_);
+  ret = io_engine_->execute(&request, 1);
+  if (ret != 0) {
+    LOG_ERROR("Failed to sync double write buffer. error=%s", strerror(ret));
+    return RC::IOERR_SYNC;
+  }
+  return RC::SUCCESS;
+}
 
-  if (page_cnt + 1 > header_.page_cnt) {
-    header_.page_cnt = page_cnt + 1;
-    if (lseek(file_desc_, 0, SEEK_SET) == -1) {
-      LOG_ERROR("Failed to add page header due to failed to seek %s.", strerror(errno));
-      return RC::IOERR_SEEK;
+RC DiskDoubleWriteBuffer::write_data_files(const std::vector<DoubleWritePage*>& pages, bool skip_unresolved) {
+  // 按数据文件分组，每个文件中的页面按页号排序
+  std::unordered_map<int32_t, int> fds;
+  std::vector<std::pair<int, DoubleWritePage*>> file_pages;
+  file_pages.reserve(pages.size());
+  for (DoubleWritePage *page : pages) {
+    auto iter = fds.find(page->key.buffer_pool_id);
+    if (iter == fds.end()) {
+      iter = fds.emplace(page->key.buffer_pool_id, resolver_(page->key.buffer_pool_id)).first;
+    }
+    if (iter->second < 0) {
+      if (!skip_unresolved) {
+        // 还没有写到数据文件，不能当作已经落盘，整批留在内存中下次再写
+        LOG_ERROR("buffer pool is not opened, cannot write its page. buffer_pool_id=%d, page_num=%d",
+          page->key.buffer_pool_id, page->key.page_num);
+        return RC::FILE_NOT_OPEN;
+      }
+      LOG_WARN("buffer pool is not opened, skip its page. buffer_pool_id=%d, page_num=%d",
+        page->key.buffer_pool_id, page->key.page_num);
+      continue;
+    }
+    file_pages.emplace_back(iter->second, page);
+  }
+  std::sort(file_pages.begin(), file_pages.end(), [](const auto &left, const auto &right) {
+    return left.first != right.first ? left.first < right.first
+                                     : left.second->key.page_num < right.second->key.page_num;
+  });
+
+  // 同一个文件中页号连续的页面合并成一个写请求，所有文件的写请求一起提交
+  std::vector<struct iovec>           iov(file_pages.size());
+  std::vector<common::AsyncIoRequest> requests;
+  std::vector<int>                    files;
+  for (size_t begin = 0, end = 0; begin < file_pages.size(); begin = end) {
+    const int fd = file_pages[begin].first;
+    for (end = begin; end < file_pages.size() && file_pages[end].first == fd &&
+                      file_pages[end].second->key.page_num ==
+                          file_pages[begin].second->key.page_num + static_cast<PageNum>(end - begin);
+         end++) {
+      iov[end] = {file_pages[end].second->page, sizeof(Page)};
     }
 
-    if (writen(file_desc_, &header_, sizeof(header_)) != 0) {
-      LOG_ERROR("Failed to add page header due to %s.", strerror(errno));
-      return RC::IOERR_WRITE;
+    const int64_t offset = static_cast<int64_t>(file_pages[begin].second->key.page_num) * BP_PAGE_SIZE;
+    requests.emplace_back();
+    if (end - begin == 1) {
+      // 单个页面在注册过的写盘缓冲区中
+      requests.back().prep_write(fd, iov[begin].iov_base, sizeof(Page), offset);
+    } else {
+      requests.back().prep_writev(fd, &iov[begin], static_cast<int>(end - begin), offset);
+    }
+    if (files.empty() || files.back() != fd) {
+      files.push_back(fd);
     }
   }
 
-  if (static_cast<int>(dblwr_pages_.size()) >= max_pages_) {
-    RC rc = flush_page();
-    if (rc != RC::SUCCESS) {
-      LOG_ERROR("Failed to flush pages in double write buffer");
+  int ret = io_engine_->execute(requests.data(), static_cast<int>(requests.size()));
+  if (ret != 0) {
+    LOG_ERROR("Failed to write pages to data files. files=%ld, writes=%ld, error=%s",
+      files.size(), requests.size(), strerror(ret));
+    return RC::IOERR_WRITE;
+  }
+  stats_.data_writes += requests.size();
+
+  // 每个写过的文件落盘一次
+  requests.assign(files.size(), common::AsyncIoRequest());
+  for (size_t i = 0; i < files.size(); i++) {
+    requests[i].prep_fsync(files[i]);
+  }
+  ret = io_engine_->execute(requests.data(), static_cast<int>(requests.size()));
+  if (ret != 0) {
+    LOG_ERROR("Failed to sync data files. files=%ld, error=%s", files.size(), strerror(ret));
+    return RC::IOERR_SYNC;
+  }
+  stats_.data_syncs += files.size();
+  return RC::SUCCESS;
+}
+
+RC DiskDoubleWriteBuffer::write_empty_header() {
+  memset(buffer_, 0, BP_PAGE_SIZE);
+  auto header = new (buffer_) DoubleWriteBufferHeader();
+  header->check_sum = header->calc_check_sum();
+  common::AsyncIoRequest request;
+  request.prep_write(file_desc_, buffer_, BP_PAGE_SIZE, 0);
+  int ret = io_engine_->execute(&request, 1);
+  if (ret != 0) {
+    LOG_ERROR("Failed to clear double write buffer. error=%s", strerror(ret));
+    return RC::IOERR_WRITE;
+  }
+  request.prep_fsync(file_desc_);
+  ret = io_engine_->execute(&request, 1);
+  if (ret != 0) {
+    LOG_ERROR("Failed to sync double write buffer. error=%s", strerror(ret));
+    return RC::IOERR_SYNC;
+  }
+  return RC::SUCCESS;
+}
+
+RC DiskDoubleWriteBuffer::add_page(BufferPool* bp, PageNum page_num, Page& page) {
+  return add_page(bp->id(), page_num, page);
+}
+
+RC DiskDoubleWriteBuffer::add_page(int32_t buffer_pool_id, PageNum page_num, const Page& page) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  DoubleWritePageKey key{buffer_pool_id, page_num};
+  auto iter = dblwr_pages_.find(key);
+  if (iter != dblwr_pages_.end()) {
+    *iter->second->page = page;
+    iter->second->page->calc_checksum();
+    LOG_TRACE("[cache hit]add page into double write buffer. buffer_pool_id:%d,page_num:%d,lsn=%ld, dwb size=%d",
+      buffer_pool_id, page_num, page.header.lsn, static_cast<int>(dblwr_pages_.size()));
+    return RC::SUCCESS;
+  }
+
+  // 从文件中加载的页面可能比 max_pages 多，缓冲区满了先写盘
+  if (static_cast<int>(dblwr_pages_.size()) >= buffer_pages_) {
+    RC rc = flush_pages();
+    if (IS_SUCC(rc)) {
+      rc = ensure_buffer(max_pages_);
+    }
+    if (IS_FAIL(rc)) {
       return rc;
     }
   }
 
+  const int32_t slot       = static_cast<int32_t>(dblwr_pages_.size());
+  auto          dblwr_page = new DoubleWritePage(buffer_pool_id, page_num, slot, slot_page(slot));
+  *dblwr_page->page = page;
+  dblwr_page->page->calc_checksum();
+  dblwr_pages_.emplace(key, dblwr_page);
+  LOG_TRACE("insert page into double write buffer. buffer_pool_id:%d,page_num:%d,lsn=%ld, dwb size:%d",
+    buffer_pool_id, page_num, page.header.lsn, static_cast<int>(dblwr_pages_.size()));
+
+  if (static_cast<int>(dblwr_pages_.size()) >= max_pages_) {
+    return flush_pages();
+  }
+  return RC::SUCCESS;
+}
+
+RC DiskDoubleWriteBuffer::read_page(BufferPool* bp, PageNum page_num, Page& page) {
+  return read_page(bp->id(), page_num, page);
+}
+
+RC DiskDoubleWriteBuffer::read_page(int32_t buffer_pool_id, PageNum page_num, Page& page) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto iter = dblwr_pages_.find(DoubleWritePageKey{buffer_pool_id, page_num});
+  if (iter == dblwr_pages_.end()) {
+    return RC::BUFFERPOOL_INVALID_PAGE_NUM;
+  }
+  page = *iter->second->page;
+  LOG_TRACE("double write buffer read page. buffer_pool_id:%d,page_num:%d,lsn=%ld",
+    buffer_pool_id, page_num, page.header.lsn);
   return RC::SUCCESS;
-}
\ No newline at end of file
+}
+
+RC DiskDoubleWriteBuffer::clear_pages(BufferPool* /*bp*/) {
+  return clear_pages();
+}
+
+RC DiskDoubleWriteBuffer::clear_pages() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  RC rc = flush_pages();
+  if (IS_FAIL(rc) || file_desc_ < 0) {
+    return rc;
+  }
+  return write_empty_header();
+}
+
+int DiskDoubleWriteBuffer::pending_pages() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return static_cast<int>(dblwr_pages_.size());
+}
+
+DoubleWriteStats DiskDoubleWriteBuffer::stats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+} // namespace storage
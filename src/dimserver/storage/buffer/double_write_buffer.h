@@ -1,17 +1,21 @@
 #pragma once
 
+#include <functional>
+#include <memory>
 #include <unordered_map>
 #include <mutex>
+#include <string>
+#include <vector>
 
 #include "common/types.h"
 #include "common/rc.h"
+#include "common/io/async_io.h"
 #include "storage/buffer/page.h"
-#include "storage/buffer/buffer_pool.h"
-
 
+namespace storage {
 
 struct DoubleWritePage;
-class BufferPoolManager;
+class BufferPool;
 
 class DoubleWriteBuffer {
 public:
@@ -24,10 +28,30 @@ public:
 };
 
 
+/**
+ * @brief double write buffer 文件头，占用文件的第一个页面
+ * @details 记录最近一批页面各自属于哪个文件的哪个页面，以及页面内容的校验和(crc32c)。
+ * 第 i 个页面放在文件的第 i+1 个页面的位置上，和文件头一起用一次 pwritev 写入。
+ */
 struct DoubleWriteBufferHeader {
-  int32_t page_cnt = 0;
-  static const int32_t SIZE;
+  struct Entry {
+    int32_t  buffer_pool_id;
+    PageNum  page_num;
+    uint32_t check_sum;  /// 页面内容的 crc32c
+  };
+
+  static constexpr uint32_t MAGIC     = 0x42525744;  /// "DWRB"
+  static constexpr int      MAX_PAGES = (BP_PAGE_SIZE - 3 * sizeof(uint32_t)) / sizeof(Entry);
+
+  uint32_t magic     = MAGIC;
+  int32_t  page_cnt  = 0;
+  uint32_t check_sum = 0;  /// 覆盖 magic、page_cnt 和前 page_cnt 个 entries
+  Entry    entries[MAX_PAGES];
+
+  uint32_t calc_check_sum() const;
+  bool     is_valid() const;
 };
+static_assert(sizeof(DoubleWriteBufferHeader) <= BP_PAGE_SIZE, "double write buffer header exceeds a page");
 
 struct DoubleWritePageKey {
   int32_t buffer_pool_id;
@@ -44,35 +68,125 @@ struct DoubleWritePageKeyHash {
   }
 };
 
+/**
+ * @brief double write buffer 的统计
+ */
+struct DoubleWriteStats {
+  uint64_t batches       = 0;  /// 写了多少批
+  uint64_t pages         = 0;  /// 一共写了多少个页面
+  uint64_t data_writes   = 0;  /// 写数据文件的请求数，连续的页面合并成一个
+  uint64_t data_syncs    = 0;  /// 数据文件的 fdatasync 次数
+};
+
+/**
+ * @brief 基于文件的 double write buffer
+ * @ingroup BufferPool
+ * @details 页面写盘之前先在内存中攒成一批，攒够 max_pages 个页面或者调用 flush_page 时一起写：
+ * 1. 文件头和这批页面用一次写请求写到 double write buffer 文件，一次 fdatasync；
+ * 2. 按数据文件分组，每个文件中的页面按页号排序，连续的页面合并成一个写请求，
+ *    所有数据文件的写请求一起交给 common::AsyncIoEngine，设备上同时有多个请求；
+ * 3. 每个写过的数据文件 fdatasync 一次，这些请求同样一起提交。
+ * 第2步写了一半时崩溃，重启时用第1步写好的页面覆盖数据文件中可能写坏的页面(参考 recover)。
+ * 不再需要原来的每个页面 lseek+write、写文件头以及整个系统的 sync。
+ * 使用 io_uring 时，double write buffer 文件和写盘缓冲区注册到引擎中，读写时不需要再查找文件和映射内存。
+ *
+ * 还没有写盘的页面可以通过 read_page 读到。页面只有在 flush_page 返回之后才真正落盘，
+ * 清除脏页标记之前(比如 PageCleaner 刷完一批)需要调用 flush_page。
+ *
+ * 写盘的页面由 double write buffer 设置页面自己的校验和(参考 Page::calc_checksum)，读页面时可以用它检查页面是否损坏。
+ *
+ * 数据文件通过 FileResolver 按 buffer pool id 找到，页面在数据文件中的位置是 page_num * BP_PAGE_SIZE。
+ *
+ * 攒着的页面复制到一块按 DIRECT_IO_ALIGN 对齐的写盘缓冲区中，第0个页面是文件头，
+ * 写 double write buffer 文件就是一次写整个缓冲区，写数据文件也直接使用缓冲区中的页面。
+ * 所以数据文件使用 O_DIRECT 打开时也可以写，set_direct_io 之后 double write buffer 文件也用 O_DIRECT 打开。
+ */
 class DiskDoubleWriteBuffer : public DoubleWriteBuffer {
 public:
-  DiskDoubleWriteBuffer(BufferPoolManager &bp_manager, int max_pages = 16);
+  /// 返回 buffer pool 数据文件的描述符，没有打开时返回-1
+  using FileResolver = std::function<int(int32_t buffer_pool_id)>;
+
+  static constexpr int DEFAULT_MAX_PAGES  = 64;
+  static constexpr int DEFAULT_IO_THREADS = 4;
+
+public:
+  /**
+   * @param resolver 根据 buffer pool id 找到数据文件
+   * @param max_pages 每批最多多少个页面，不超过 DoubleWriteBufferHeader::MAX_PAGES
+   * @param io_threads 异步IO使用线程池时的线程数
+   * @param io_backend 异步IO的实现方式，参考 common::AsyncIoEngine::create
+   */
+  DiskDoubleWriteBuffer(FileResolver resolver, int max_pages = DEFAULT_MAX_PAGES,
+      int io_threads = DEFAULT_IO_THREADS, common::AsyncIoBackend io_backend = common::AsyncIoBackend::AUTO);
   virtual ~DiskDoubleWriteBuffer();
 
+  /**
+   * @brief 使用直接IO打开 double write buffer 文件，需要在 open_file 之前设置
+   * @details 文件系统不支持时退回普通IO，打开之后 direct_io 返回实际的方式
+   */
+  void set_direct_io(bool direct_io) { direct_io_ = direct_io; }
+  bool direct_io() const { return direct_io_; }
+
   RC open_file(const std::string& filename);
+
+  /**
+   * @brief 把攒着的页面写到 double write buffer 文件和数据文件中并落盘
+   */
   RC flush_page();
 
   RC add_page(BufferPool *bp, PageNum page_num, Page &page) override;
   RC read_page(BufferPool *bp, PageNum page_num, Page &page) override;
-
   RC clear_pages(BufferPool *bp) override;
+
+  RC add_page(int32_t buffer_pool_id, PageNum page_num, const Page &page);
+  RC read_page(int32_t buffer_pool_id, PageNum page_num, Page &page);
+
+  /**
+   * @brief 把所有页面写盘，并清空文件中的页面，不会再被恢复
+   */
+  RC clear_pages();
+
+  /**
+   * @brief 把 open_file 时从文件中加载的页面写回数据文件
+   * @details 需要在 buffer pool 都打开之后、回放日志之前调用。找不到数据文件的页面会被跳过，
+   * 比如文件已经删除了。正常写盘时(flush_page、add_page、clear_pages)找不到数据文件会返回
+   * FILE_NOT_OPEN，页面留在内存中
+   */
   RC recover();
 
+  int pending_pages() const;
+  DoubleWriteStats stats() const;
+
+  /// 实际使用的异步IO实现方式
+  common::AsyncIoBackend io_backend() const { return io_engine_->backend(); }
+
 private:
-  RC write_page(DoubleWritePage *page);
-  RC write_page_internal(DoubleWritePage *page);
+  RC    ensure_buffer(int page_num);
+  Page *slot_page(int32_t slot) const;
 
   RC load_pages();
+  /// @param skip_unresolved 跳过找不到数据文件的页面，只在 recover 时使用
+  RC flush_pages(bool skip_unresolved = false);
+  RC write_batch(const std::vector<DoubleWritePage*>& pages);
+  RC write_data_files(const std::vector<DoubleWritePage*>& pages, bool skip_unresolved);
+  RC write_empty_header();
 
 private:
-  int file_desc_ = -1;
-  int max_pages_ = 0;
+  int file_desc_  = -1;
+  int max_pages_  = 0;
+  bool direct_io_ = false;
 
-  BufferPoolManager& bp_manager_;
-  DoubleWriteBufferHeader header_;
+  char *buffer_       = nullptr;  /// 写盘缓冲区，文件头加上 buffer_pages_ 个页面
+  int   buffer_pages_ = 0;
 
+  FileResolver resolver_;
+
+  std::unique_ptr<common::AsyncIoEngine> io_engine_;  /// 读写文件，由 mutex_ 保证同一时间只有一个线程使用
+
+  mutable std::mutex mutex_;  /// 保护下面的成员
   std::unordered_map<DoubleWritePageKey, DoubleWritePage*,
     DoubleWritePageKeyHash> dblwr_pages_;
+  DoubleWriteStats stats_;
 };
 
 
@@ -82,9 +196,11 @@ public:
   virtual ~VacuousDoubleWriteBuffer() = default;
   RC add_page(BufferPool *bp, PageNum page_num, Page &page) override;
 
-  RC read_page(BufferPool *bp, PageNum page_num, Page &page) override { 
+  RC read_page(BufferPool *bp, PageNum page_num, Page &page) override {
     return RC::BUFFERPOOL_INVALID_PAGE_NUM;
   }
 
   RC clear_pages(BufferPool *bp) override { return RC::SUCCESS; }
-};
\ No newline at end of file
+};
+
+} // namespace storage
@@ -34,8 +34,17 @@ std::string FrameId::to_string() const {
 // Frame实现
 Frame::Frame() : 
   pin_count_(0), 
-  acc_time_(0) {
-  page_.init();
+  acc_time_(0),
+  own_page_(std::make_unique<Page>()) {
+  page_ = own_page_.get();
+  page_->init();
+}
+
+Frame::Frame(Page* page) : 
+  pin_count_(0), 
+  acc_time_(0),
+  page_(page) {
+  page_->init();
 }
 
 Frame::~Frame() {
@@ -51,15 +60,15 @@ void Frame::set_frame_id(const FrameId& frame_id) {
 }
 
 Page& Frame::page() { 
-  return page_; 
+  return *page_; 
 }
 
 const Page& Frame::page() const { 
-  return page_; 
+  return *page_; 
 }
 
 PageNum Frame::page_num() const { 
-  return page_.header.page_num; 
+  return page_->header.page_num; 
 }
 
 void Frame::pin() { 
@@ -67,11 +76,33 @@ void Frame::pin() {
 }
 
 void Frame::unpin() {
-  if (pin_count_ > 0) {
-    --pin_count_;
+  int pins = pin_count_.load(std::memory_order_relaxed);
+  while (pins > 0 && !pin_count_.compare_exchange_weak(pins, pins - 1, std::memory_order_acq_rel)) {
   }
 }
 
+bool Frame::try_pin() {
+  int pins = pin_count_.load(std::memory_order_relaxed);
+  while (pins >= 0) {
+    if (pin_count_.compare_exchange_weak(pins, pins + 1, std::memory_order_acq_rel)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool Frame::try_evict(int expected_pins /* = 0 */) {
+  return pin_count_.compare_exchange_strong(expected_pins, PIN_EVICTING, std::memory_order_acq_rel);
+}
+
+void Frame::cancel_evict() {
+  pin_count_.store(0, std::memory_order_release);
+}
+
+void Frame::pin_after_evict() {
+  pin_count_.store(1, std::memory_order_release);
+}
+
 int Frame::pin_count() const { 
   return pin_count_; 
 }
@@ -83,15 +114,22 @@ void Frame::access() {
 }
 
 bool Frame::is_dirty() const { 
-  return page_.header.flags & PAGE_DIRTY_FLAG;
+  return page_->header.flags & PAGE_DIRTY_FLAG;
 }
 
 void Frame::mark_dirty() { 
-  page_.header.flags |= PAGE_DIRTY_FLAG;
+  page_->header.flags |= PAGE_DIRTY_FLAG;
+}
+
+void Frame::mark_dirty(LSN rec_lsn) {
+  LSN expected = 0;
+  rec_lsn_.compare_exchange_strong(expected, rec_lsn, std::memory_order_acq_rel);
+  page_->header.flags |= PAGE_DIRTY_FLAG;
 }
 
 void Frame::clear_dirty() {
-  page_.header.flags &= ~PAGE_DIRTY_FLAG;
+  page_->header.flags &= ~PAGE_DIRTY_FLAG;
+  rec_lsn_.store(0, std::memory_order_release);
 }
 
 int Frame::buffer_pool_id() const {
@@ -103,31 +141,32 @@ void Frame::set_buffer_pool_id(int id) {
 }
 
 LSN Frame::lsn() const {
-  return page_.header.lsn;
+  return page_->header.lsn;
 }
 
 void Frame::set_lsn(LSN lsn) {
-  page_.header.lsn = lsn;
+  page_->header.lsn = lsn;
 }
 
 void Frame::set_page_num(PageNum page_num) {
-  page_.header.page_num = page_num;
+  frame_id_.page_num = page_num;
+  page_->header.page_num = page_num;
 }
 
 PageType Frame::page_type() const {
-  return static_cast<PageType>(page_.header.page_type);
+  return static_cast<PageType>(page_->header.page_type);
 }
 
 void Frame::set_page_type(PageType type) {
-  page_.header.page_type = static_cast<uint8_t>(type);
+  page_->header.page_type = static_cast<uint8_t>(type);
 }
 
 void Frame::calc_checksum() {
-  page_.calc_checksum();
+  page_->calc_checksum();
 }
 
 bool Frame::verify_checksum() const {
-  return page_.verify_checksum();
+  return page_->verify_checksum();
 }
 
 std::string Frame::to_string() const {
@@ -1,11 +1,12 @@
 #pragma once
 
 #include <string>
-#include <mutex>
 #include <atomic>
+#include <memory>
 #include <sstream>
 
 #include "common/log/log.h"
+#include "common/thread/rw_latch.h"
 #include "storage/buffer/page.h"
 
 namespace storage {
@@ -28,6 +29,9 @@ struct FrameId {
   std::string to_string() const;
 };
 
+/// 有脏页帧没有记录 recLSN(通过 Frame::mark_dirty() 标记)时 FrameManager::min_rec_lsn 的返回值
+static constexpr LSN BP_UNKNOWN_REC_LSN = -1;
+
 /**
  * 帧类，缓冲池的基本单位，用于管理内存中的页面
  */
@@ -35,8 +39,16 @@ class Frame {
 public:
   // 构造函数和析构函数
   Frame();
+  /**
+   * @brief 使用外部的页面内存，比如 FramePool 中按4KB对齐的大页内存
+   * @details 页面内存由调用者管理，生命周期要比Frame长
+   */
+  explicit Frame(Page* page);
   ~Frame();
 
+  Frame(const Frame&)            = delete;
+  Frame& operator=(const Frame&) = delete;
+
   /**
    * @brief reinit 和 reset 在 MemPoolSimple 中使用
    * @details 在 MemPoolSimple 分配和释放一个Frame对象时，不会调用构造函数和析构函数，
@@ -44,24 +56,36 @@ public:
    */
   void reinit() {
     pin_count_ = 0;
-    acc_time_ = 0;
-    frame_id_ = FrameId();
-    page_.init();
+    clear_for_reuse();
   }
 
   void reset() {
     pin_count_ = 0;
+    clear_for_reuse();
+  }
+
+  /**
+   * @brief FrameManager 复用页帧时使用
+   * @details 和 reset 一样清空页帧，但是不修改引用计数。页帧在空闲列表中时一直处于
+   * PIN_EVICTING 状态，无锁查找拿到过期指针的读者不能pin住它。
+   */
+  void clear_for_reuse() {
+    published_key_.store(FrameId().hash(), std::memory_order_release);
     acc_time_ = 0;
+    scan_only_.store(false, std::memory_order_relaxed);
+    referenced_.store(false, std::memory_order_relaxed);
+    io_state_ = IoState::NONE;
+    rec_lsn_.store(0, std::memory_order_relaxed);
     frame_id_ = FrameId();
-    page_.init();
+    page_->init();
   }
 
-  void clear_page() { memset(&page_, 0, sizeof(page_)); }
+  void clear_page() { memset(page_, 0, sizeof(Page)); }
 
   // 获取帧ID
   const FrameId& frame_id() const;
 
-  char* data() { return page_.data; }
+  char* data() { return page_->data; }
   
   // 设置帧ID
   void set_frame_id(const FrameId& frame_id);
@@ -73,6 +97,9 @@ public:
   // 获取页号
   PageNum page_num() const;
   
+  /// 正在被淘汰或者在空闲列表中时的引用计数，这时不能被pin住
+  static constexpr int PIN_EVICTING = -1;
+
   // 增加引用计数
   void pin();
   
@@ -84,13 +111,63 @@ public:
 
   bool can_purge() const { return pin_count_.load() == 0; }
 
+  /**
+   * @brief 无锁查找时pin住页帧
+   * @details 页帧正在被淘汰(PIN_EVICTING)时失败。成功之后还需要用 published_key 检查页帧
+   * 是否仍然对应要找的页面，因为页帧可能在找到之后、pin住之前被淘汰并复用了。
+   */
+  bool try_pin();
+
+  /**
+   * @brief 开始淘汰页帧：引用计数从expected_pins变为PIN_EVICTING
+   * @details 成功之后无锁查找的读者就不能再pin住这个页帧了
+   */
+  bool try_evict(int expected_pins = 0);
+
+  /// 取消淘汰，引用计数恢复为0
+  void cancel_evict();
+
+  /// 淘汰完成之后直接复用页帧：引用计数从PIN_EVICTING变为1
+  void pin_after_evict();
+
+  /**
+   * @brief 发布页帧当前的FrameId，无锁查找的读者用它检查页帧是否仍然对应要找的页面
+   * @details 在页帧的其它状态都设置好之后调用，读者看到新的FrameId时一定能看到这些状态
+   */
+  void publish_frame_id() { published_key_.store(frame_id_.hash(), std::memory_order_release); }
+  size_t published_key() const { return published_key_.load(std::memory_order_acquire); }
+
+  /**
+   * @brief 无锁命中时记录访问，替换策略在淘汰时处理，参考 Replacer
+   */
+  void touch() {
+    if (!referenced_.load(std::memory_order_relaxed)) {
+      referenced_.store(true, std::memory_order_relaxed);
+    }
+  }
+  bool referenced() const { return referenced_.load(std::memory_order_relaxed); }
+  bool clear_referenced() {
+    return referenced_.load(std::memory_order_relaxed) && referenced_.exchange(false, std::memory_order_relaxed);
+  }
+
   void access();
   
   // 设置/获取脏页标记 - 直接使用Page中的标记
   bool is_dirty() const;
+  /// 不记录 recLSN，检查点不知道恢复要从哪里开始，在它被刷盘之前不会推进恢复起点。修改页面要用 mark_dirty(LSN)
   void mark_dirty();
   void clear_dirty();
 
+  /**
+   * @brief 标记脏页，同时记录 recLSN
+   * @details recLSN 是页面从干净变脏之后第一条修改它的日志的LSN，检查点用所有脏页中最小的
+   * recLSN 作为恢复的起点，参考 FrameManager::min_rec_lsn。页面已经是脏页时保留原来的 recLSN。
+   * 要在追加日志之前调用，rec_lsn 传 LogHandler::current_lsn() + 1，这样检查点不会漏掉
+   * 已经写了日志但是还没有标记脏页的修改。
+   */
+  void mark_dirty(LSN rec_lsn);
+  LSN  rec_lsn() const { return rec_lsn_.load(std::memory_order_acquire); }
+
   int buffer_pool_id() const;
   void set_buffer_pool_id(int id);
 
@@ -103,15 +180,72 @@ public:
 
   void calc_checksum();
   bool verify_checksum() const;
+
+  /**
+   * @brief 页帧在替换策略中的位置，由 Replacer 维护
+   */
+  int32_t replacer_slot() const { return replacer_slot_; }
+  void set_replacer_slot(int32_t slot) { replacer_slot_ = slot; }
+
+  /**
+   * @brief 页帧是否只被顺序扫描访问过，参考 ScanRing
+   * @details 由 FrameManager 维护，无锁命中时也可能被清除
+   */
+  bool scan_only() const { return scan_only_.load(std::memory_order_relaxed); }
+  void set_scan_only(bool scan_only) { scan_only_.store(scan_only, std::memory_order_relaxed); }
+
+  /**
+   * @brief 页帧上读IO的状态，参考 Prefetcher
+   * @details 页帧映射之后、数据读取完成之前处于READING状态，其它线程拿到这个页帧时需要等待。
+   * - NONE: 页面数据可用
+   * - READING: 正在读取
+   * - PREFETCHED: 预读完成，还没有被访问过
+   * - FAILED: 读取失败，下一个访问者需要重新读取
+   */
+  enum class IoState : uint8_t { NONE, READING, PREFETCHED, FAILED };
+
+  IoState io_state() const { return io_state_.load(std::memory_order_acquire); }
+  void set_io_state(IoState state) { io_state_.store(state, std::memory_order_release); }
+  bool cas_io_state(IoState expected, IoState desired) {
+    return io_state_.compare_exchange_strong(expected, desired, std::memory_order_acq_rel);
+  }
   
+  /**
+   * @brief 页面内容的读写闩
+   * @details 和引用计数相互独立：pin 保证页帧不会被淘汰，闩保证页面内容的一致性。
+   * 先pin住再加闩，先解闩再unpin。B+树等结构做闩耦合时可以使用
+   * common::ReadLatchGuard/WriteLatchGuard 包装 latch()。
+   */
+  void read_latch() { latch_.read_latch(); }
+  bool try_read_latch() { return latch_.try_read_latch(); }
+  void read_unlatch() { latch_.read_unlatch(); }
+  void write_latch() { latch_.write_latch(); }
+  bool try_write_latch() { return latch_.try_write_latch(); }
+  void write_unlatch() { latch_.write_unlatch(); }
+
+  /**
+   * @brief 乐观读，不加闩，读完之后用 validate 检查期间有没有写者，参考 common::RwLatch
+   */
+  uint32_t optimistic_read() { return latch_.optimistic_read(); }
+  bool validate(uint32_t version) const { return latch_.validate(version); }
+
+  common::RwLatch& latch() { return latch_; }
+
   std::string to_string() const;
 
 private:
   std::atomic<int> pin_count_{0};       // 引用计数
+  common::RwLatch latch_;               // 页面读写闩
   unsigned long acc_time_ = 0;          // 最后访问时间（用于LRU替换）
   FrameId frame_id_;                    // 帧ID
-  Page page_;                           // 页面数据
-  std::mutex mutex_;                    // 互斥锁，用于并发控制
+  std::atomic<size_t> published_key_{FrameId().hash()}; // 无锁查找用来检查的FrameId
+  int32_t replacer_slot_ = -1;          // 在替换策略中的位置
+  std::atomic<bool> scan_only_{false};  // 是否只被顺序扫描访问过
+  std::atomic<bool> referenced_{false}; // 访问位，无锁命中时设置
+  std::atomic<IoState> io_state_{IoState::NONE}; // 读IO状态
+  std::atomic<LSN> rec_lsn_{0};         // 变脏之后第一条修改日志的LSN，干净页是0
+  Page* page_ = nullptr;                // 页面数据，和页帧的元数据分开存放
+  std::unique_ptr<Page> own_page_;      // 没有外部页面内存时自己分配的页面
 };
 
 } // namespace storage
\ No newline at end of file
@@ -0,0 +1,526 @@
+#include <thread>
+
+#include "storage/buffer/frame_manager.h"
+#include "common/thread/epoch.h"
+
+namespace storage {
+
+FrameManager::FrameManager(const std::string& tag) : allocator_(tag) { }
+
+FrameManager::~FrameManager() {
+	allocator_.cleanup();
+}
+
+RC FrameManager::init(int pool_num, int shard_num /* = DEFAULT_SHARD_NUM */,
+    const std::string& replacer_name /* = "lru" */) {
+  if (pool_num <= 0 || shard_num <= 0) {
+    LOG_ERROR("Invalid arguments, pool_num:%d, shard_num:%d.", pool_num, shard_num);
+    return RC::INVALID_ARGUMENT;
+  }
+
+	int ret = allocator_.init(false, 1, pool_num);
+	if (ret != 0) {
+		LOG_ERROR("Failed to initialize frame manager, ret:%d.", ret);
+		return RC::NO_MEM_POOL;
+	}
+
+  shard_bits_ = 0;
+  while ((1 << shard_bits_) < shard_num) {
+    shard_bits_++;
+  }
+
+  shards_.clear();
+  for (int i = 0; i < (1 << shard_bits_); i++) {
+    auto shard = std::make_unique<Shard>();
+    Replacer* replacer = nullptr;
+    RC rc = Replacer::create(replacer_name, replacer);
+    if (IS_FAIL(rc)) {
+      shards_.clear();
+      return rc;
+    }
+    shard->replacer.reset(replacer);
+    shard->table = std::make_unique<PageTable>(pool_num / (1 << shard_bits_) + 1);
+    shards_.emplace_back(std::move(shard));
+  }
+  replacer_name_ = shards_.front()->replacer->name();
+
+  // 所有的页帧在初始化时一次性从内存池中取出，轮流分配到各个分片的空闲列表中
+  for (int i = 0; i < pool_num; i++) {
+    Frame* frame = allocator_.alloc();
+    if (frame == nullptr) {
+      LOG_ERROR("Failed to alloc frame from memory pool. index=%d, pool_num=%d", i, pool_num);
+      return RC::NO_MEM_POOL;
+    }
+    // 空闲页帧一直处于淘汰状态，无锁查找拿到过期指针的读者不能pin住它
+    frame->try_evict();
+    shards_[i % shards_.size()]->free_frames.push_back(frame);
+  }
+
+  LOG_INFO("frame manager initialized. frames=%d, shards=%d, replacer=%s",
+    pool_num, static_cast<int>(shards_.size()), replacer_name_.c_str());
+	return RC::SUCCESS;
+}
+
+RC FrameManager::cleanup() {
+  for (auto& shard : shards_) {
+    std::lock_guard lock(shard->mutex);
+    if (!shard->table->empty()) {
+      LOG_ERROR("There are still frames in the frame manager, cannot cleanup.");
+      return RC::NO_MEM_POOL;
+    }
+  }
+
+  for (auto& shard : shards_) {
+    for (Frame* frame : shard->free_frames) {
+      allocator_.free(frame);
+    }
+    shard->free_frames.clear();
+  }
+  shards_.clear();
+  return RC::SUCCESS;
+}
+
+size_t FrameManager::shard_index(const FrameId& frame_id) const {
+  // Fibonacci hashing，避免同一个文件中连续的页号都落在少数几个分片上
+  const uint64_t h = static_cast<uint64_t>(frame_id.hash()) * 0x9E3779B97F4A7C15ULL;
+  return shard_bits_ == 0 ? 0 : static_cast<size_t>(h >> (64 - shard_bits_));
+}
+
+Frame* FrameManager::get(int buffer_pool_id, PageNum page_num, ScanRing* ring /* = nullptr */) {
+  FrameId frame_id(buffer_pool_id, page_num);
+  Shard& shard = shard_of(frame_id);
+  {
+    common::EpochGuard guard;
+    if (guard.active()) {
+      Frame* frame = shard.table->find(frame_id);
+      if (frame == nullptr) {
+        return nullptr;
+      }
+
+      // pin住之后页帧就不会再被淘汰了，但是在找到和pin住之间可能已经被复用，需要再检查一次
+      if (frame->try_pin()) {
+        if (frame->published_key() == frame_id.hash()) {
+          if (ring == nullptr) {
+            frame->set_scan_only(false);
+            frame->touch();
+          }
+          return frame;
+        }
+        frame->unpin();
+      }
+      // 页帧正在被淘汰或者复用，到加锁的路径上等结果
+    }
+  }
+
+  std::lock_guard lock_guard(shard.mutex);
+  return get_internal(shard, frame_id, ring == nullptr);
+}
+
+Frame* FrameManager::get_internal(Shard& shard, const FrameId &frame_id, bool promote) {
+  Frame* frame = shard.table->find(frame_id);
+  if (frame == nullptr) {
+    return nullptr;
+  }
+
+  frame->pin();
+  if (promote) {
+    // 被扫描以外的访问命中，说明是共享的页面，扫描不能再复用它
+    frame->set_scan_only(false);
+    shard.replacer->access(frame);
+  }
+  return frame;
+}
+
+std::list<Frame*> FrameManager::find_list(int buffer_pool_id) {
+  std::list<Frame*> frames;
+  for (auto& shard : shards_) {
+    std::lock_guard lock(shard->mutex);
+    shard->table->foreach([&frames, buffer_pool_id](const FrameId& frame_id, Frame* frame) {
+      if (frame_id.buffer_pool_id == buffer_pool_id) {
+        frame->pin();
+        frames.push_back(frame);
+      }
+      return true;
+    });
+  }
+  return frames;
+}
+
+Frame* FrameManager::alloc(int buffer_pool_id, PageNum page_num) {
+  FrameId frame_id(buffer_pool_id, page_num);
+  const size_t home = shard_index(frame_id);
+
+  Frame* frame = take_free_frame(home);
+  if (frame == nullptr) {
+    return nullptr;
+  }
+
+  Shard& shard = *shards_[home];
+  std::lock_guard lock(shard.mutex);
+  attach(shard, frame_id, frame, false /*scan_only*/);
+  return frame;
+}
+
+Frame* FrameManager::alloc(int buffer_pool_id, PageNum page_num, ScanRing& ring,
+    const std::function<RC(Frame*)>& purger) {
+  FrameId frame_id(buffer_pool_id, page_num);
+  const size_t home = shard_index(frame_id);
+
+  Frame* frame = recycle_ring_frame(ring, purger);
+  if (frame != nullptr) {
+    ring.reused_count_++;
+  } else {
+    frame = take_free_frame(home);
+    if (frame == nullptr) {
+      return nullptr;
+    }
+  }
+
+  Shard& shard = *shards_[home];
+  {
+    std::lock_guard lock(shard.mutex);
+    attach(shard, frame_id, frame, true /*scan_only*/);
+  }
+  ring.record(frame);
+  return frame;
+}
+
+RC FrameManager::alloc_for_read(int buffer_pool_id, PageNum page_num, bool scan_only, Frame*& frame) {
+  frame = nullptr;
+  FrameId frame_id(buffer_pool_id, page_num);
+  const size_t home = shard_index(frame_id);
+  Shard& shard = *shards_[home];
+  {
+    std::lock_guard lock(shard.mutex);
+    if (shard.table->find(frame_id) != nullptr) {
+      return RC::SUCCESS;
+    }
+  }
+
+  Frame* free_frame = take_free_frame(home);
+  if (free_frame == nullptr) {
+    return RC::BUFFER_POOL_FULL;
+  }
+
+  attach_for_read(home, frame_id, free_frame, scan_only, frame);
+  return RC::SUCCESS;
+}
+
+RC FrameManager::alloc_for_read(int buffer_pool_id, PageNum page_num, ScanRing& ring,
+    const std::function<RC(Frame*)>& purger, Frame*& frame) {
+  frame = nullptr;
+  FrameId frame_id(buffer_pool_id, page_num);
+  const size_t home = shard_index(frame_id);
+  Shard& shard = *shards_[home];
+  {
+    std::lock_guard lock(shard.mutex);
+    if (shard.table->find(frame_id) != nullptr) {
+      return RC::SUCCESS;
+    }
+  }
+
+  Frame* free_frame = purger ? recycle_ring_frame(ring, purger) : nullptr;
+  const bool reused = free_frame != nullptr;
+  if (!reused) {
+    free_frame = take_free_frame(home);
+    if (free_frame == nullptr) {
+      return RC::BUFFER_POOL_FULL;
+    }
+  }
+
+  attach_for_read(home, frame_id, free_frame, true /*scan_only*/, frame);
+  if (frame != nullptr) {
+    ring.reused_count_ += reused ? 1 : 0;
+    ring.record(frame);
+  }
+  return RC::SUCCESS;
+}
+
+void FrameManager::attach_for_read(size_t home, const FrameId& frame_id, Frame* free_frame, bool scan_only,
+    Frame*& frame) {
+  Shard& shard = *shards_[home];
+  std::lock_guard lock(shard.mutex);
+  if (shard.table->find(frame_id) != nullptr) {
+    // 取空闲页帧时没有持有锁，其它线程可能已经映射了这个页面
+    shard.free_frames.push_back(free_frame);
+    return;
+  }
+
+  // IO状态要在发布之前设置好，否则无锁命中的读者可能读到还没有加载的页面
+  attach(shard, frame_id, free_frame, scan_only, Frame::IoState::READING);
+  frame = free_frame;
+}
+
+Frame* FrameManager::take_free_frame(size_t home) {
+  Shard& shard = *shards_[home];
+  std::unique_lock lock(shard.mutex);
+  while (shard.free_frames.empty()) {
+    lock.unlock();
+    if (!steal_free_frames(home)) {
+      return nullptr;
+    }
+    lock.lock();
+  }
+
+  Frame* frame = shard.free_frames.back();
+  shard.free_frames.pop_back();
+  return frame;
+}
+
+void FrameManager::attach(Shard& shard, const FrameId& frame_id, Frame* frame, bool scan_only,
+    Frame::IoState io_state /* = Frame::IoState::NONE */) {
+  ASSERT(frame->pin_count() == Frame::PIN_EVICTING, "Frame is in use. frame=%s", frame->to_string().c_str());
+  frame->set_buffer_pool_id(frame_id.buffer_pool_id);
+  frame->set_page_num(frame_id.page_num);
+  frame->set_scan_only(scan_only);
+  frame->set_io_state(io_state);
+  frame->pin_after_evict();
+  // 所有状态都设置好之后再发布，最后放进哈希表
+  frame->publish_frame_id();
+
+  Frame* old_frame = shard.table->insert(frame_id, frame);
+  if (old_frame != nullptr && old_frame != frame) {
+    // 调用者应该先get再alloc，这里保持原来覆盖的语义
+    shard.replacer->remove(old_frame);
+  }
+  shard.replacer->insert(frame);
+}
+
+Frame* FrameManager::recycle_ring_frame(ScanRing& ring, const std::function<RC(Frame*)>& purger) {
+  ScanRing::Entry& oldest = ring.oldest();
+  if (oldest.frame == nullptr) {
+    return nullptr;
+  }
+
+  // 环中记录的页帧可能已经被淘汰，甚至已经加载了别的页面，所以按照记录的frame_id重新查找
+  Shard& shard = shard_of(oldest.frame_id);
+  std::lock_guard lock(shard.mutex);
+  Frame* frame = shard.table->find(oldest.frame_id);
+  if (frame == nullptr || frame != oldest.frame) {
+    return nullptr;
+  }
+
+  if (!frame->scan_only() || !frame->try_evict()) {
+    return nullptr;
+  }
+
+  RC rc = purger(frame);
+  if (IS_FAIL(rc)) {
+    frame->cancel_evict();
+    LOG_WARN("failed to recycle ring frame. frame_id=%s, rc=%s",
+      frame->frame_id().to_string().c_str(), strrc(rc));
+    return nullptr;
+  }
+
+  detach(shard, frame);
+  return frame;
+}
+
+bool FrameManager::steal_free_frames(size_t home) {
+  const size_t shard_count = shards_.size();
+  for (size_t i = 1; i < shard_count; i++) {
+    Shard& donor = *shards_[(home + i) % shard_count];
+
+    std::vector<Frame*> stolen;
+    {
+      std::lock_guard lock(donor.mutex);
+      if (donor.free_frames.empty()) {
+        continue;
+      }
+      // 借走一半，避免两个分片之间来回借
+      const size_t steal_num = (donor.free_frames.size() + 1) / 2;
+      stolen.assign(donor.free_frames.end() - steal_num, donor.free_frames.end());
+      donor.free_frames.resize(donor.free_frames.size() - steal_num);
+    }
+
+    Shard& shard = *shards_[home];
+    std::lock_guard lock(shard.mutex);
+    shard.free_frames.insert(shard.free_frames.end(), stolen.begin(), stolen.end());
+    return true;
+  }
+  return false;
+}
+
+RC FrameManager::free(int buffer_pool_id, PageNum page_num, Frame* frame) {
+  FrameId frame_id(buffer_pool_id, page_num);
+  Shard& shard = shard_of(frame_id);
+
+  std::lock_guard lock(shard.mutex);
+  return free_internal(shard, frame_id, frame);
+}
+
+RC FrameManager::free_internal(Shard& shard, const FrameId& frame_id, Frame* frame) {
+  Frame* out = shard.table->find(frame_id);
+  bool ret = out != nullptr;
+
+  ASSERT(ret && frame == out,
+    "failed to free frame. found=%d, frameId=%s, frame_source=%p, frame=%p, pinCount=%d, lbt=%s",
+    ret, frame_id.to_string().c_str(), out, frame, frame->pin_count(), common::stacktrace().c_str());
+
+  if (!ret) {
+    return RC::PAGE_NOT_FOUND;
+  }
+
+  // 调用者持有唯一的引用，但是无锁查找的读者可能刚刚pin住它，正在检查FrameId，稍等一下
+  bool evicted = false;
+  for (int i = 0; i < FREE_EVICT_RETRY && !(evicted = frame->try_evict(1)); i++) {
+    std::this_thread::yield();
+  }
+  if (!evicted) {
+    LOG_WARN("failed to free frame, frame is still pinned. frame=%s", frame->to_string().c_str());
+    return RC::PAGE_UNPIN_ERROR;
+  }
+
+  detach(shard, frame);
+  shard.free_frames.push_back(frame);
+  return RC::SUCCESS;
+}
+
+void FrameManager::detach(Shard& shard, Frame* frame) {
+  // 替换策略可能会用到frame_id，需要在清空页帧之前移除
+  shard.replacer->remove(frame);
+  shard.table->erase(frame->frame_id());
+  // 页帧保持淘汰状态，直到下一次 attach
+  frame->clear_for_reuse();
+}
+
+int FrameManager::purge_frames(int count, std::function<RC(Frame*)> purger) {
+  if (count <= 0) count = 1;
+
+  const size_t shard_count = shards_.size();
+  const size_t start = purge_cursor_.fetch_add(1, std::memory_order_relaxed);
+
+  int freed_count = 0;
+  for (size_t i = 0; i < shard_count && freed_count < count; i++) {
+    Shard& shard = *shards_[(start + i) % shard_count];
+    freed_count += purge_shard(shard, count - freed_count, purger);
+  }
+  LOG_INFO("purge frame done. number=%d", freed_count);
+  return freed_count;
+}
+
+int FrameManager::purge_shard(Shard& shard, int count, const std::function<RC(Frame*)>& purger) {
+  std::lock_guard lock(shard.mutex);
+
+  std::vector<Frame*> can_purge_frame;
+  can_purge_frame.reserve(count); // 预分配
+
+  // 优先淘汰干净的页帧，不够的时候才用脏页帧补上，避免前台线程刷脏页
+  std::vector<Frame*> dirty_frames;
+  // 通过 try_evict 占住页帧，之后无锁查找的读者就不能再pin住它了
+  auto purge_finder = [&can_purge_frame, &dirty_frames, count](Frame* frame) {
+    if (!frame->can_purge()) {
+      return true;
+    }
+    if (frame->is_dirty()) {
+      if (dirty_frames.size() < static_cast<size_t>(count) && frame->try_evict()) {
+        dirty_frames.push_back(frame);
+      }
+      return true;
+    }
+    if (frame->try_evict()) {
+      can_purge_frame.push_back(frame);
+      if (can_purge_frame.size() >= static_cast<size_t>(count)) {
+        return false;
+      }
+    }
+    return true;
+  };
+
+  shard.replacer->foreach_victim(purge_finder);
+  for (Frame* frame : dirty_frames) {
+    if (can_purge_frame.size() < static_cast<size_t>(count)) {
+      can_purge_frame.push_back(frame);
+      dirty_purge_count_.fetch_add(1, std::memory_order_relaxed);
+    } else {
+      frame->cancel_evict();
+    }
+  }
+  LOG_TRACE("purge frames find %ld pages total", can_purge_frame.size());
+
+  int freed_count = 0;
+  for (Frame* frame : can_purge_frame) {
+    RC rc = purger(frame);
+    if (rc == RC::SUCCESS) {
+      detach(shard, frame);
+      shard.free_frames.push_back(frame);
+      freed_count++;
+    } else {
+      frame->cancel_evict();
+      LOG_WARN("failed to purge frame. frame_id=%s, rc=%s",
+        frame->frame_id().to_string().c_str(), strrc(rc));
+    }
+  }
+  return freed_count;
+}
+
+void FrameManager::find_cold_dirty_frames(int count, std::vector<Frame*>& frames) {
+  const size_t shard_count = shards_.size();
+  const size_t start = clean_cursor_.fetch_add(1, std::memory_order_relaxed);
+
+  for (size_t i = 0; i < shard_count && static_cast<int>(frames.size()) < count; i++) {
+    Shard& shard = *shards_[(start + i) % shard_count];
+    std::lock_guard lock(shard.mutex);
+    shard.replacer->foreach_cold([&frames, count](Frame* frame) {
+      if (frame->can_purge() && frame->is_dirty() && frame->io_state() == Frame::IoState::NONE) {
+        frame->pin();
+        frames.push_back(frame);
+      }
+      return static_cast<int>(frames.size()) < count;
+    });
+  }
+}
+
+size_t FrameManager::dirty_frame_num() const {
+  size_t num = 0;
+  for (const auto& shard : shards_) {
+    std::lock_guard lock(shard->mutex);
+    shard->table->foreach([&num](const FrameId&, Frame* frame) {
+      if (frame->is_dirty()) {
+        num++;
+      }
+      return true;
+    });
+  }
+  return num;
+}
+
+LSN FrameManager::min_rec_lsn() const {
+  LSN min_lsn = 0;
+  for (const auto& shard : shards_) {
+    std::lock_guard lock(shard->mutex);
+    bool unknown = false;
+    shard->table->foreach([&min_lsn, &unknown](const FrameId&, Frame* frame) {
+      const LSN rec_lsn = frame->rec_lsn();
+      if (rec_lsn > 0) {
+        if (min_lsn == 0 || rec_lsn < min_lsn) {
+          min_lsn = rec_lsn;
+        }
+      } else if (frame->is_dirty()) {
+        // mark_dirty(LSN) 先记录 recLSN 再设置脏页标记，这里是没有记录 recLSN 的脏页
+        unknown = true;
+        return false;
+      }
+      return true;
+    });
+    if (unknown) {
+      return BP_UNKNOWN_REC_LSN;
+    }
+  }
+  return min_lsn;
+}
+
+size_t FrameManager::frame_num() const {
+  size_t num = 0;
+  for (const auto& shard : shards_) {
+    std::lock_guard lock(shard->mutex);
+    num += shard->table->size();
+  }
+  return num;
+}
+
+size_t FrameManager::total_frame_num() const {
+  return allocator_.size();
+}
+
+} // namespace storage
@@ -0,0 +1,210 @@
+#pragma once
+
+#include <string>
+#include <list>
+#include <mutex>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <functional>
+
+#include "common/rc.h"
+#include "common/types.h"
+#include "storage/buffer/frame.h"
+#include "storage/buffer/frame_pool.h"
+#include "storage/buffer/replacer.h"
+#include "storage/buffer/scan_ring.h"
+#include "storage/buffer/page_table.h"
+
+namespace storage {
+
+/**
+ * @brief 管理页面Frame
+ * @ingroup BufferPool
+ * @details 管理内存中的页帧。内存是有限的，内存中能够存放的页帧个数也是有限的。
+ * 当内存中的页帧不够用时，需要从内存中淘汰一些页帧，以便为新的页帧腾出空间。
+ * 这个管理器负责为所有的BufferPool提供页帧管理服务，也就是所有的BufferPool磁盘文件
+ * 在访问时都使用这个管理器映射到内存。
+ *
+ * 为了避免所有的页面访问都竞争同一把锁，FrameManager 按照 FrameId::hash() 把页帧
+ * 划分到多个分片(Shard)中。每个分片有自己的锁、哈希表、替换策略和空闲帧列表，
+ * 不同分片上的访问互不影响。
+ * 某个分片的空闲帧用完时，会从其它分片"借"一批空闲帧；淘汰页帧时，从一个轮转的
+ * 分片开始依次按照各个分片的替换策略查找可以淘汰的页帧。
+ * 替换策略(LRU、CLOCK、2Q)在初始化时按名字指定，参考 Replacer::create。
+ * 顺序扫描可以带上一个 ScanRing 访问页帧，命中时不提升页帧，加载新页面时复用环中的页帧，
+ * 避免一次大的扫描把热点页面挤出去。
+ *
+ * 命中(get)不加锁：在分片的 PageTable 中找到页帧之后，用 Frame::try_pin 通过CAS增加引用计数，
+ * 再检查页帧发布的FrameId，确认页帧没有在这期间被淘汰复用；访问记录在页帧的访问位上，
+ * 由替换策略在淘汰时处理。修改映射(分配、淘汰、释放)仍然在分片锁下进行，淘汰前先通过
+ * Frame::try_evict 把引用计数置为 Frame::PIN_EVICTING，空闲列表中的页帧也一直保持这个状态。
+ * 页帧的内存直到 cleanup 才会归还给内存池，读者拿到的过期指针总是指向有效的 Frame。
+ */
+class FrameManager {
+public:
+	static constexpr int DEFAULT_SHARD_NUM = 16;
+	static constexpr int FREE_EVICT_RETRY  = 1000; /// 释放页帧时等待无锁读者放手的最大重试次数
+
+public:
+	FrameManager(const std::string& tag);
+	~FrameManager();
+
+	/**
+	 * @brief 初始化
+	 * @param pool_num 页帧的个数
+	 * @param shard_num 分片个数，会向上取整为2的幂
+	 * @param replacer_name 替换策略名称，参考 Replacer::create
+	 */
+	RC init(int pool_num, int shard_num = DEFAULT_SHARD_NUM, const std::string& replacer_name = "lru");
+
+	/**
+	 * @brief 设置页面内存的分配方式，需要在 init 之前调用，参考 FramePool
+	 */
+	void set_arena_options(bool use_huge_page, int numa_node_num) {
+		allocator_.set_arena_options(use_huge_page, numa_node_num);
+	}
+	common::HugePageArena::Backing page_backing() const { return allocator_.backing(); }
+	RC cleanup();
+
+	/**
+	 * @brief 获取已经映射的页帧，并pin住
+	 * @details 命中时不加锁，页帧正在被淘汰时退回到加锁的路径
+	 * @param ring 顺序扫描使用的页帧环。不为空时，命中的页帧不会在替换策略中被提升
+	 */
+	Frame* get(int buffer_pool_id, PageNum page_num, ScanRing* ring = nullptr);
+	std::list<Frame*> find_list(int buffer_pool_id);
+
+	Frame* alloc(int buffer_pool_id, PageNum page_num);
+
+	/**
+	 * @brief 为顺序扫描分配页帧
+	 * @details 优先复用环中最老的页帧：如果它没有被pin住，并且没有被扫描以外的访问命中过，
+	 * 就调用purger(比如刷脏页)之后直接拿来加载新页面；否则按照普通的方式分配，
+	 * 分配到的页帧记录到环中。
+	 * 与 alloc 一样，没有空闲页帧时返回nullptr，由调用者淘汰页帧之后重试。
+	 * @param purger 复用页帧之前的处理函数，与 purge_frames 的相同
+	 */
+	Frame* alloc(int buffer_pool_id, PageNum page_num, ScanRing& ring, const std::function<RC(Frame*)>& purger);
+	/**
+	 * @brief 页面还没有映射时，分配一个页帧用来读取页面
+	 * @details 检查和映射在同一把分片锁下完成，不会覆盖其它线程(比如预读线程)刚刚映射的页帧。
+	 * 分配到的页帧是pin住的，处于 Frame::IoState::READING 状态，读取完成之后由调用者修改状态。
+	 * 只使用空闲页帧，不会淘汰页帧。
+	 * @param scan_only 页帧是否只被顺序扫描访问，参考 ScanRing
+	 * @param[out] frame 分配到的页帧。页面已经被映射时为nullptr
+	 * @return 没有空闲页帧时返回 BUFFER_POOL_FULL
+	 */
+	RC alloc_for_read(int buffer_pool_id, PageNum page_num, bool scan_only, Frame*& frame);
+	/**
+	 * @brief 顺序扫描时分配页帧用来读取页面
+	 * @details 和 alloc(buffer_pool_id, page_num, ring, purger) 一样优先复用环中最老的页帧，
+	 * 分配到的页帧记录到环中，其它和上面的 alloc_for_read 相同。purger 为空时不复用，只记录
+	 */
+	RC alloc_for_read(int buffer_pool_id, PageNum page_num, ScanRing& ring, const std::function<RC(Frame*)>& purger,
+		Frame*& frame);
+
+	RC free(int buffer_pool_id, PageNum page_num, Frame* frame);
+
+	/**
+	 * @brief 淘汰页帧
+	 * @details 从一个轮转的分片开始，依次在各个分片中查找可以淘汰的页帧，直到找够count个
+	 * 或者所有分片都找过一遍。
+	 * @param count 期望淘汰的个数
+	 * @param purger 淘汰页帧之前的处理函数，比如刷脏页
+	 * @return 实际淘汰的个数
+	 */
+	int purge_frames(int count, std::function<RC(Frame*)> purger);
+
+	/**
+	 * @brief 按照淘汰顺序找出马上就会被淘汰的脏页帧，给后台刷脏页使用
+	 * @details 从一个轮转的分片开始，通过 Replacer::foreach_cold 查找没有被pin住的脏页帧，
+	 * 不会修改替换策略的状态。找到的页帧会被pin住，调用者用完之后需要unpin。
+	 * @param count 最多找多少个
+	 * @param[out] frames 找到的页帧
+	 */
+	void find_cold_dirty_frames(int count, std::vector<Frame*>& frames);
+
+	/// 当前脏页帧的个数，需要遍历所有分片
+	size_t dirty_frame_num() const;
+
+	/**
+	 * @brief 所有脏页帧中最小的 recLSN，参考 Frame::mark_dirty(LSN)
+	 * @details 所有 BufferPool 共用页帧，这就是检查点时恢复的起点。没有脏页帧时返回0。
+	 * 有脏页帧没有记录 recLSN 时不知道它的修改从哪里开始，返回 BP_UNKNOWN_REC_LSN
+	 */
+	LSN min_rec_lsn() const;
+
+	/// 淘汰时不得不刷脏页的次数。后台刷脏页正常工作时，这个值应该增长得很慢
+	uint64_t dirty_purge_count() const { return dirty_purge_count_.load(std::memory_order_relaxed); }
+
+	size_t frame_num() const;
+	size_t total_frame_num() const;
+	int shard_num() const { return static_cast<int>(shards_.size()); }
+	const std::string& replacer_name() const { return replacer_name_; }
+
+private:
+	/**
+	 * @brief 一个分片
+	 * @details 按缓存行对齐，避免不同分片的锁之间出现伪共享
+	 */
+	struct alignas(64) Shard {
+		mutable std::mutex mutex;
+		std::unique_ptr<PageTable> table;   /// 当前分片上已映射的页帧，查找不加锁
+		std::unique_ptr<Replacer> replacer; /// 当前分片的替换策略
+		std::vector<Frame*> free_frames;    /// 当前分片上的空闲页帧，都处于 Frame::PIN_EVICTING 状态
+	};
+
+	size_t shard_index(const FrameId& frame_id) const;
+	Shard& shard_of(const FrameId& frame_id) { return *shards_[shard_index(frame_id)]; }
+
+	Frame* get_internal(Shard& shard, const FrameId& frame_id, bool promote);
+	RC free_internal(Shard& shard, const FrameId& frame_id, Frame* frame);
+
+	/**
+	 * @brief 从home分片的空闲列表中取一个页帧，必要时从其它分片借
+	 * @details 调用时不能持有任何分片的锁
+	 */
+	Frame* take_free_frame(size_t home);
+
+	/**
+	 * @brief 把页帧映射到frame_id上，并pin住。需要持有分片锁
+	 * @details 页帧必须处于 Frame::PIN_EVICTING 状态，设置好所有状态之后才发布给无锁查找的读者
+	 */
+	void attach(Shard& shard, const FrameId& frame_id, Frame* frame, bool scan_only,
+		Frame::IoState io_state = Frame::IoState::NONE);
+
+	/**
+	 * @brief 解除页帧的映射，页帧不放回空闲列表。需要持有分片锁
+	 * @details 页帧必须已经通过 Frame::try_evict 进入淘汰状态，解除之后仍然保持这个状态
+	 */
+	void detach(Shard& shard, Frame* frame);
+
+	/**
+	 * @brief 页面还没有映射时把 free_frame 映射上去，处于 READING 状态；已经映射时放回空闲列表
+	 */
+	void attach_for_read(size_t home, const FrameId& frame_id, Frame* free_frame, bool scan_only, Frame*& frame);
+
+	/**
+	 * @brief 尝试回收环中最老的页帧，成功时返回解除映射的页帧
+	 */
+	Frame* recycle_ring_frame(ScanRing& ring, const std::function<RC(Frame*)>& purger);
+	int purge_shard(Shard& shard, int count, const std::function<RC(Frame*)>& purger);
+
+	/**
+	 * @brief 从其它分片借一批空闲页帧放到home分片上
+	 * @details 调用时不能持有任何分片的锁。每次最多只持有一个分片的锁。
+	 * @return 是否借到了空闲页帧
+	 */
+	bool steal_free_frames(size_t home);
+
+	std::vector<std::unique_ptr<Shard>> shards_;
+	int shard_bits_ = 0;
+	std::atomic<size_t> purge_cursor_{0}; /// 下一次淘汰从哪个分片开始
+	std::atomic<size_t> clean_cursor_{0}; /// 下一次查找脏页从哪个分片开始
+	std::atomic<uint64_t> dirty_purge_count_{0};
+	std::string replacer_name_;
+	FramePool allocator_; // 采用内存池，页面放在大页内存上
+};
+
+} // namespace storage
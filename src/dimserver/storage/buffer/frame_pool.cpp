@@ -0,0 +1,56 @@
+#include <new>
+
+#include "storage/buffer/frame_pool.h"
+
+namespace storage {
+
+static_assert(sizeof(Page) == BP_PAGE_SIZE, "pages in the arena must stay 4KB aligned");
+
+FramePool::FramePool(std::string tag) : MemPoolSimple<Frame>(std::move(tag)) {}
+
+FramePool::~FramePool() {
+  // 基类析构时不会再调用到 delete_items
+  cleanup();
+}
+
+void FramePool::set_arena_options(bool use_huge_page, int numa_node_num) {
+  use_huge_page_ = use_huge_page;
+  numa_node_num_ = numa_node_num;
+}
+
+common::HugePageArena::Backing FramePool::backing() const {
+  std::shared_lock<std::shared_mutex> lock(this->mutex_);
+  if (pools_.empty()) {
+    return common::HugePageArena::Backing::NONE;
+  }
+  auto iter = arenas_.find(pools_.front());
+  return iter == arenas_.end() ? common::HugePageArena::Backing::NONE : iter->second->backing();
+}
+
+Frame* FramePool::new_items(int item_num) {
+  auto arena = std::make_unique<common::HugePageArena>();
+  if (arena->init(static_cast<size_t>(item_num) * BP_PAGE_SIZE, use_huge_page_, numa_node_num_) != 0) {
+    return nullptr;
+  }
+
+  Frame* frames = static_cast<Frame*>(::operator new(sizeof(Frame) * item_num, std::nothrow));
+  if (frames == nullptr) {
+    return nullptr;
+  }
+  for (int i = 0; i < item_num; i++) {
+    new (frames + i) Frame(reinterpret_cast<Page*>(arena->data() + static_cast<size_t>(i) * BP_PAGE_SIZE));
+  }
+
+  arenas_.emplace(frames, std::move(arena));
+  return frames;
+}
+
+void FramePool::delete_items(Frame* items, int item_num) {
+  for (int i = 0; i < item_num; i++) {
+    items[i].~Frame();
+  }
+  ::operator delete(items);
+  arenas_.erase(items);
+}
+
+} // namespace storage
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <string>
+
+#include "common/mem/mem_pool.h"
+#include "common/mem/huge_page_arena.h"
+#include "storage/buffer/frame.h"
+
+namespace storage {
+
+/**
+ * @brief 页帧的内存池，页面放在大页内存上
+ * @ingroup BufferPool
+ * @details MemPoolSimple 用 new T[] 分配对象，每个8KB的页面都和页帧的元数据放在一起，
+ * 分散在普通的4KB页面上，访问页面时TLB缺失很多。
+ * FramePool 把页帧的元数据和页面分开：元数据是一个普通的数组，页面放在一块
+ * common::HugePageArena 上，每个页面按4KB对齐(也方便以后直接IO)，可以按NUMA节点分段。
+ * 大页不可用时自动退回普通页面。
+ */
+class FramePool : public MemPoolSimple<Frame> {
+public:
+  explicit FramePool(std::string tag);
+  ~FramePool() override;
+
+  /**
+   * @brief 设置页面内存的分配方式，需要在 init 之前调用
+   * @param use_huge_page 是否尝试使用大页
+   * @param numa_node_num 按多少个NUMA节点分段，参考 common::HugePageArena::init
+   */
+  void set_arena_options(bool use_huge_page, int numa_node_num);
+
+  /// 第一批页帧的页面实际使用的内存类型
+  common::HugePageArena::Backing backing() const;
+
+protected:
+  Frame* new_items(int item_num) override;
+  void   delete_items(Frame* items, int item_num) override;
+
+private:
+  bool use_huge_page_ = true;
+  int  numa_node_num_ = 0;
+  std::map<Frame*, std::unique_ptr<common::HugePageArena>> arenas_;  /// 每批页帧对应的页面内存
+};
+
+} // namespace storage
@@ -81,7 +81,7 @@ public:
     items_.pop_back();
   }
 
-  void foreach_reverse(std::function<bool(const Key&, const Value&)> func) {
+  void foreach_reverse(std::function<bool(const Key&, const Value&)> func) const {
     for (auto it = items_.rbegin(); it != items_.rend(); ++it) {
       bool ret = func(it->key, it->value);
       if (!ret) {
@@ -90,7 +90,7 @@ public:
     }
   }
 
-  void foreach(std::function<bool(const Key&, const Value&)> func) {
+  void foreach(std::function<bool(const Key&, const Value&)> func) const {
     for (auto it = items_.begin(); it != items_.end(); ++it) {
       bool ret = func(it->key, it->value);
       if (!ret) {
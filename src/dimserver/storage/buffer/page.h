@@ -1,6 +1,7 @@
 #pragma once
 
 #include "common/types.h"
+#include "common/math/crc.h"
 #include <string.h>
 
 using TrxID = int32_t;
@@ -29,7 +30,8 @@ enum PageType {
   DATA_PAGE = 2,
   INDEX_PAGE = 3,
   OVERFLOW_PAGE = 4,
-  FREE_PAGE = 5
+  FREE_PAGE = 5,
+  ALLOC_MAP_PAGE = 6
 };
 
 
@@ -72,38 +74,13 @@ struct Page {
     memset(data, 0, BP_PAGE_DATA_SIZE);
   }
 
-  void calc_checksum() {
-    static uint32_t crc_table[256];
-    static bool table_initialized = false;
-    
-    // 初始化CRC表（只执行一次）
-    if (!table_initialized) {
-      for (uint32_t i = 0; i < 256; i++) {
-        uint32_t c = i;
-        for (uint32_t j = 0; j < 8; j++) {
-          c = (c & 1) ? (0xEDB88320 ^ (c >> 1)) : (c >> 1);
-        }
-        crc_table[i] = c;
-      }
-      table_initialized = true;
-    }
-    
-    // 计算CRC32（只对data部分进行校验）
-    uint32_t crc = 0xFFFFFFFF;
-    for (size_t i = 0; i < BP_PAGE_DATA_SIZE; i++) {
-      crc = crc_table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
-    }
-    
-    header.check_sum = static_cast<CheckSum>(~crc);
-  }
+  /**
+   * @brief 页面数据的校验和(crc32c)，写盘之前设置到 header.check_sum 中，读盘之后用来检查页面是否损坏
+   */
+  CheckSum compute_checksum() const { return crc32c(data, BP_PAGE_DATA_SIZE); }
 
-  bool verify_checksum() const {
-    CheckSum old_checksum = header.check_sum;
-    const_cast<Page*>(this)->calc_checksum();
-    bool valid = (old_checksum == header.check_sum);
-    const_cast<Page*>(this)->header.check_sum = old_checksum;
-    return valid;
-  }
+  void calc_checksum() { header.check_sum = compute_checksum(); }
 
+  bool verify_checksum() const { return header.check_sum == compute_checksum(); }
 };
 
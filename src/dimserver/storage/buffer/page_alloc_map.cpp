@@ -0,0 +1,263 @@
+#include <algorithm>
+#include <sstream>
+
+#include "storage/buffer/page_alloc_map.h"
+#include "common/log/log.h"
+
+namespace storage {
+
+static_assert(sizeof(BPFileHeader) + BPFileHeader::MAX_MAP_PAGES * sizeof(PageNum) <= BP_PAGE_DATA_SIZE,
+    "file header exceeds a page");
+static_assert(sizeof(BPAllocMapPage) + BPAllocMapPage::PAGES_PER_MAP / 8 <= BP_PAGE_DATA_SIZE,
+    "allocation map exceeds a page");
+static_assert(static_cast<int64_t>(BPFileHeader::MAX_MAP_PAGES) * BPAllocMapPage::PAGES_PER_MAP <= INT32_MAX,
+    "page number overflow");
+
+std::string BPFileHeader::to_string() const {
+  std::stringstream ss;
+  ss << "buffer_pool_id:" << buffer_pool_id << ", page_count:" << page_count
+     << ", allocated_pages:" << allocated_pages << ", map_page_count:" << map_page_count;
+  return ss.str();
+}
+
+PageAllocMap::PageAllocMap(PageFetcher fetcher, DirtyMarker marker)
+  : fetcher_(std::move(fetcher)), marker_(std::move(marker)) {}
+
+PageNum PageAllocMap::map_page_num(int map_index) {
+  return map_index == 0 ? BP_HEADER_PAGE + 1 : map_index * BPAllocMapPage::PAGES_PER_MAP;
+}
+
+bool PageAllocMap::is_map_page(PageNum page_num) {
+  return page_num == BP_HEADER_PAGE + 1 || (page_num > 0 && page_num % BPAllocMapPage::PAGES_PER_MAP == 0);
+}
+
+RC PageAllocMap::create(Page& header_page, int32_t buffer_pool_id) {
+  header_page.init();
+  header_page.header.page_num  = BP_HEADER_PAGE;
+  header_page.header.page_type = HEADER_PAGE;
+
+  header_ = reinterpret_cast<BPFileHeader*>(header_page.data);
+  header_->buffer_pool_id  = buffer_pool_id;
+  header_->page_count      = 0;
+  header_->allocated_pages = 0;
+  header_->map_page_count  = 0;
+  maps_.clear();
+  non_full_.clear();
+
+  RC rc = add_maps(1);
+  if (IS_FAIL(rc)) {
+    return rc;
+  }
+  set_allocated(0, BP_HEADER_PAGE);
+  return RC::SUCCESS;
+}
+
+RC PageAllocMap::open(Page& header_page) {
+  header_ = reinterpret_cast<BPFileHeader*>(header_page.data);
+  maps_.clear();
+  non_full_.clear();
+  if (header_->map_page_count <= 0 || header_->map_page_count > BPFileHeader::MAX_MAP_PAGES) {
+    LOG_ERROR("invalid file header. %s", header_->to_string().c_str());
+    return RC::INTERNAL;
+  }
+
+  for (int i = 0; i < header_->map_page_count; i++) {
+    RC rc = load_map(i, false);
+    if (IS_FAIL(rc)) {
+      return rc;
+    }
+  }
+  LOG_INFO("page allocation map opened. %s", header_->to_string().c_str());
+  return RC::SUCCESS;
+}
+
+void PageAllocMap::close() {
+  header_ = nullptr;
+  maps_.clear();
+  non_full_.clear();
+}
+
+RC PageAllocMap::add_maps(int map_count) {
+  if (map_count > BPFileHeader::MAX_MAP_PAGES) {
+    LOG_WARN("too many pages in a file. map_count=%d, max=%d", map_count, BPFileHeader::MAX_MAP_PAGES);
+    return RC::BUFFERPOOL_FILE_FULL;
+  }
+
+  while (header_->map_page_count < map_count) {
+    const int index = header_->map_page_count;
+    RC rc = load_map(index, true);
+    if (IS_FAIL(rc)) {
+      return rc;
+    }
+    header_->map_pages[index] = map_page_num(index);
+    header_->map_page_count++;
+    // 分配图页面管理的第一个页面(第0个是文件头)，就是它自己
+    set_allocated(index, map_page_num(index) - maps_[index].map->first_page);
+    LOG_INFO("add page allocation map. index=%d, page_num=%d", index, map_page_num(index));
+  }
+  return RC::SUCCESS;
+}
+
+RC PageAllocMap::load_map(int map_index, bool create) {
+  const PageNum page_num = create ? map_page_num(map_index) : header_->map_pages[map_index];
+  Page*         page     = nullptr;
+  RC            rc       = fetcher_(page_num, create, page);
+  if (IS_FAIL(rc)) {
+    LOG_ERROR("failed to fetch page allocation map. index=%d, page_num=%d, rc=%s", map_index, page_num, strrc(rc));
+    return rc;
+  }
+
+  auto map = reinterpret_cast<BPAllocMapPage*>(page->data);
+  if (create) {
+    page->init();
+    page->header.page_num  = page_num;
+    page->header.page_type = ALLOC_MAP_PAGE;
+    map->first_page        = map_index * BPAllocMapPage::PAGES_PER_MAP;
+    map->allocated_pages   = 0;
+    marker_(page_num);
+  } else if (map->first_page != map_index * BPAllocMapPage::PAGES_PER_MAP) {
+    LOG_ERROR("invalid page allocation map. index=%d, page_num=%d, first_page=%d",
+        map_index, page_num, map->first_page);
+    return RC::INTERNAL;
+  }
+
+  MapState state;
+  state.page = page;
+  state.map  = map;
+  state.bitmap.init(map->bitmap, BPAllocMapPage::PAGES_PER_MAP);
+  const int first_zero = state.bitmap.next_zero_bit(0);
+  state.hint           = first_zero < 0 ? BPAllocMapPage::PAGES_PER_MAP : first_zero;
+  maps_.push_back(state);
+  non_full_.resize(maps_.size() / 64 + 1, 0);
+  update_summary(map_index);
+  return RC::SUCCESS;
+}
+
+void PageAllocMap::update_summary(int map_index) {
+  const uint64_t bit = 1ULL << (map_index % 64);
+  if (maps_[map_index].map->allocated_pages < BPAllocMapPage::PAGES_PER_MAP) {
+    non_full_[map_index / 64] |= bit;
+  } else {
+    non_full_[map_index / 64] &= ~bit;
+  }
+}
+
+int PageAllocMap::first_non_full() const {
+  for (size_t i = 0; i < non_full_.size(); i++) {
+    if (non_full_[i] != 0) {
+      return static_cast<int>(i * 64 + __builtin_ctzll(non_full_[i]));
+    }
+  }
+  return -1;
+}
+
+void PageAllocMap::set_allocated(int map_index, int bit) {
+  MapState& state = maps_[map_index];
+  state.bitmap.set(bit);
+  state.map->allocated_pages++;
+  header_->allocated_pages++;
+  header_->page_count = std::max(header_->page_count, state.map->first_page + bit + 1);
+  update_summary(map_index);
+  marker_(state.page->header.page_num);
+  marker_(BP_HEADER_PAGE);
+}
+
+void PageAllocMap::set_free(int map_index, int bit) {
+  MapState& state = maps_[map_index];
+  state.bitmap.clear(bit);
+  state.map->allocated_pages--;
+  header_->allocated_pages--;
+  state.hint = std::min(state.hint, bit);
+  update_summary(map_index);
+  marker_(state.page->header.page_num);
+  marker_(BP_HEADER_PAGE);
+}
+
+RC PageAllocMap::allocate(PageNum& page_num) {
+  int index = first_non_full();
+  if (index < 0) {
+    RC rc = add_maps(header_->map_page_count + 1);
+    if (IS_FAIL(rc)) {
+      return rc;
+    }
+    index = header_->map_page_count - 1;
+  }
+
+  // 起点之前的页面都已经分配，从起点开始找
+  MapState& state = maps_[index];
+  const int bit   = state.bitmap.next_zero_bit(state.hint);
+  if (bit < 0) {
+    LOG_ERROR("page allocation map is inconsistent. index=%d, allocated_pages=%d, hint=%d",
+        index, state.map->allocated_pages, state.hint);
+    return RC::INTERNAL;
+  }
+  state.hint = bit + 1;
+  set_allocated(index, bit);
+  page_num = state.map->first_page + bit;
+  return RC::SUCCESS;
+}
+
+RC PageAllocMap::deallocate(PageNum page_num) {
+  if (page_num <= BP_HEADER_PAGE || page_num >= header_->page_count || is_map_page(page_num)) {
+    LOG_WARN("cannot deallocate page. page_num=%d, %s", page_num, header_->to_string().c_str());
+    return RC::BUFFERPOOL_INVALID_PAGE_NUM;
+  }
+
+  const int index = page_num / BPAllocMapPage::PAGES_PER_MAP;
+  const int bit   = page_num % BPAllocMapPage::PAGES_PER_MAP;
+  if (!maps_[index].bitmap.get(bit)) {
+    LOG_WARN("page is not allocated. page_num=%d", page_num);
+    return RC::BUFFERPOOL_INVALID_PAGE_NUM;
+  }
+  set_free(index, bit);
+  return RC::SUCCESS;
+}
+
+RC PageAllocMap::redo_allocate(PageNum page_num) {
+  if (page_num <= BP_HEADER_PAGE || page_num >= BPFileHeader::MAX_PAGE_NUM) {
+    return RC::BUFFERPOOL_INVALID_PAGE_NUM;
+  }
+
+  const int index = page_num / BPAllocMapPage::PAGES_PER_MAP;
+  const int bit   = page_num % BPAllocMapPage::PAGES_PER_MAP;
+  RC rc = add_maps(index + 1);
+  if (IS_FAIL(rc)) {
+    return rc;
+  }
+  if (!maps_[index].bitmap.get(bit)) {
+    set_allocated(index, bit);
+  }
+  return RC::SUCCESS;
+}
+
+RC PageAllocMap::redo_deallocate(PageNum page_num) {
+  if (page_num <= BP_HEADER_PAGE || is_map_page(page_num)) {
+    return RC::BUFFERPOOL_INVALID_PAGE_NUM;
+  }
+  if (is_allocated(page_num)) {
+    set_free(page_num / BPAllocMapPage::PAGES_PER_MAP, page_num % BPAllocMapPage::PAGES_PER_MAP);
+  }
+  return RC::SUCCESS;
+}
+
+bool PageAllocMap::is_allocated(PageNum page_num) const {
+  if (page_num < 0 || page_num >= header_->page_count) {
+    return false;
+  }
+  return maps_[page_num / BPAllocMapPage::PAGES_PER_MAP].bitmap.get(page_num % BPAllocMapPage::PAGES_PER_MAP);
+}
+
+PageNum PageAllocMap::next_allocated(PageNum start) const {
+  start = std::max(start, 0);
+  for (int index = start / BPAllocMapPage::PAGES_PER_MAP; index < static_cast<int>(maps_.size()); index++) {
+    const int from = index == start / BPAllocMapPage::PAGES_PER_MAP ? start % BPAllocMapPage::PAGES_PER_MAP : 0;
+    const int bit  = maps_[index].bitmap.next_one_bit(from);
+    if (bit >= 0) {
+      const PageNum page_num = maps_[index].map->first_page + bit;
+      return page_num < header_->page_count ? page_num : BP_INVALID_PAGE_NUM;
+    }
+  }
+  return BP_INVALID_PAGE_NUM;
+}
+
+} // namespace storage
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "common/rc.h"
+#include "common/types.h"
+#include "common/bitmap/bitmap.h"
+#include "storage/buffer/page.h"
+
+namespace storage {
+
+/**
+ * @brief 分配图页面的内容，放在页面的 data 中
+ * @ingroup BufferPool
+ * @details 每个分配图页面用一个位图管理连续的 PAGES_PER_MAP 个页面，包括它自己
+ */
+struct BPAllocMapPage
+{
+  PageNum first_page;       //! 管理的第一个页面
+  int32_t allocated_pages;  //! 管理的页面中已经分配了多少个
+  char    bitmap[0];        //! 页面分配位图，第 i 位对应 first_page + i
+
+  static const int PAGES_PER_MAP = (BP_PAGE_DATA_SIZE - sizeof(first_page) - sizeof(allocated_pages)) * 8;
+};
+
+/**
+ * @brief 文件头，放在文件第0个页面的 data 中
+ * @ingroup BufferPool
+ * @details 文件头只记录分配图页面在哪里。第 i 个分配图页面管理 [i * PAGES_PER_MAP, (i + 1) * PAGES_PER_MAP)，
+ * 放在这个范围的第一个页面上，第0个范围的第一个页面是文件头，所以放在第1个页面上。
+ * 一个文件最多 MAX_PAGE_NUM 个页面，8KB 的页面大约 1TB。
+ */
+struct BPFileHeader
+{
+  int32_t buffer_pool_id;   //! buffer pool id
+  int32_t page_count;       //! 当前文件一共有多少个页面
+  int32_t allocated_pages;  //! 已经分配了多少个页面，包括文件头和分配图页面
+  int32_t map_page_count;   //! 分配图页面的个数
+  PageNum map_pages[0];     //! 分配图页面的页号
+
+  static const int MAX_MAP_PAGES = (BP_PAGE_DATA_SIZE - 4 * sizeof(int32_t)) / sizeof(PageNum);
+  static const int MAX_PAGE_NUM  = MAX_MAP_PAGES * BPAllocMapPage::PAGES_PER_MAP;
+
+  std::string to_string() const;
+};
+
+/**
+ * @brief 页面分配图
+ * @ingroup BufferPool
+ * @details 文件头指向若干个分配图页面，每个分配图页面用位图管理一段页面，文件增长时按需增加分配图页面。
+ * 内存中另外维护两层摘要，分配时不需要遍历整个位图：
+ * - 一个位图记录哪些分配图页面还有空闲的页面，分配时从编号最小的一个开始，文件尽量紧凑；
+ * - 每个分配图页面记录一个查找起点，起点之前的页面都已经分配。分配从起点往后找，释放时把起点移回来，
+ *   所以分配均摊是 O(1) 的。
+ * 分配的页面号不小于 page_count 时文件变大，page_count 随之增加。
+ *
+ * 文件头和分配图页面常驻内存(比如 BufferPool 中 pin 住的页帧)，通过 PageFetcher 获取，
+ * 修改之后通过 DirtyMarker 通知调用者标记成脏页。
+ * 不是线程安全的，由 BufferPool 的锁保护。
+ */
+class PageAllocMap {
+public:
+  /// 获取文件头或者分配图页面，create 为 true 时是文件中新增的页面，不需要从文件中读
+  using PageFetcher = std::function<RC(PageNum page_num, bool create, Page*& page)>;
+  /// 文件头或者分配图页面被修改了
+  using DirtyMarker = std::function<void(PageNum page_num)>;
+
+public:
+  PageAllocMap(PageFetcher fetcher, DirtyMarker marker);
+  ~PageAllocMap() = default;
+
+  /**
+   * @brief 初始化新文件的文件头，并创建第一个分配图页面
+   * @param header_page 文件的第0个页面
+   */
+  RC create(Page& header_page, int32_t buffer_pool_id);
+
+  /**
+   * @brief 打开已有的文件，加载所有分配图页面，建立摘要
+   */
+  RC open(Page& header_page);
+
+  void close();
+
+  /**
+   * @brief 分配一个页面，优先使用页面号最小的空闲页面
+   * @return 文件已经达到 MAX_PAGE_NUM 个页面时返回 BUFFERPOOL_FILE_FULL
+   */
+  RC allocate(PageNum& page_num);
+
+  /**
+   * @brief 释放一个页面，文件头和分配图页面不能释放
+   */
+  RC deallocate(PageNum page_num);
+
+  /**
+   * @brief 回放日志时把页面标记为已分配，已经分配时什么都不做
+   * @details 分配图页面可能还没有落盘，需要时创建到这个页面为止的分配图页面
+   */
+  RC redo_allocate(PageNum page_num);
+
+  /**
+   * @brief 回放日志时把页面标记为未分配，已经是未分配时什么都不做
+   */
+  RC redo_deallocate(PageNum page_num);
+
+  bool is_allocated(PageNum page_num) const;
+
+  /**
+   * @brief 从 start 开始(包括 start)的第一个已经分配的页面，没有时返回 BP_INVALID_PAGE_NUM
+   */
+  PageNum next_allocated(PageNum start) const;
+
+  /**
+   * @brief 第 map_index 个分配图页面的页面号
+   */
+  static PageNum map_page_num(int map_index);
+  static bool    is_map_page(PageNum page_num);
+
+  const BPFileHeader* header() const { return header_; }
+  int32_t page_count() const { return header_->page_count; }
+  int32_t allocated_pages() const { return header_->allocated_pages; }
+  int32_t map_page_count() const { return header_->map_page_count; }
+
+private:
+  /// 内存中的一个分配图页面
+  struct MapState {
+    Page*           page = nullptr;
+    BPAllocMapPage* map  = nullptr;
+    Bitmap          bitmap;
+    int             hint = 0;  /// 查找空闲页面的起点，之前的页面都已经分配
+  };
+
+  /// 创建分配图页面，直到有 map_count 个
+  RC   add_maps(int map_count);
+  RC   load_map(int map_index, bool create);
+  void set_allocated(int map_index, int bit);
+  void set_free(int map_index, int bit);
+  void update_summary(int map_index);
+  /// 第一个还有空闲页面的分配图页面，没有时返回-1
+  int  first_non_full() const;
+
+private:
+  PageFetcher fetcher_;
+  DirtyMarker marker_;
+
+  BPFileHeader*         header_ = nullptr;
+  std::vector<MapState> maps_;
+  std::vector<uint64_t> non_full_;  /// 第 i 位表示第 i 个分配图页面还有空闲的页面
+};
+
+} // namespace storage
@@ -0,0 +1,196 @@
+#include <algorithm>
+#include <chrono>
+
+#include "storage/buffer/page_cleaner.h"
+#include "common/log/log.h"
+
+namespace storage {
+
+static uint64_t steady_now_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+PageCleaner::PageCleaner(FrameManager& frame_manager, FlushBatch flush, LsnSource lsn_source /* = nullptr */,
+    const PageCleanerOptions& options /* = PageCleanerOptions() */)
+  : frame_manager_(frame_manager),
+    flush_(std::move(flush)),
+    lsn_source_(std::move(lsn_source)),
+    options_(options) {}
+
+PageCleaner::~PageCleaner() {
+  stop();
+}
+
+RC PageCleaner::start() {
+  if (options_.interval_ms <= 0 || options_.max_io_pages <= 0 || options_.batch_pages <= 0 ||
+      options_.low_dirty_pct < 0 || options_.high_dirty_pct <= options_.low_dirty_pct) {
+    LOG_ERROR("Invalid page cleaner options. interval_ms=%d, max_io_pages=%d, batch_pages=%d, dirty_pct=[%d, %d]",
+      options_.interval_ms, options_.max_io_pages, options_.batch_pages,
+      options_.low_dirty_pct, options_.high_dirty_pct);
+    return RC::INVALID_ARGUMENT;
+  }
+
+  std::lock_guard lock(mutex_);
+  if (running_) {
+    LOG_ERROR("Page cleaner has already been started");
+    return RC::INTERNAL;
+  }
+
+  running_ = true;
+  thread_  = std::thread(&PageCleaner::thread_func, this);
+  LOG_INFO("page cleaner started. interval_ms=%d, max_io_pages=%d", options_.interval_ms, options_.max_io_pages);
+  return RC::SUCCESS;
+}
+
+void PageCleaner::stop() {
+  {
+    std::lock_guard lock(mutex_);
+    if (!running_) {
+      return;
+    }
+    running_ = false;
+  }
+  cond_.notify_all();
+  thread_.join();
+  LOG_INFO("page cleaner stopped");
+}
+
+void PageCleaner::wakeup() {
+  {
+    std::lock_guard lock(mutex_);
+    wakeup_ = true;
+  }
+  cond_.notify_all();
+}
+
+void PageCleaner::thread_func() {
+  std::unique_lock lock(mutex_);
+  while (running_) {
+    lock.unlock();
+    run_once();
+    lock.lock();
+
+    cond_.wait_for(lock, std::chrono::milliseconds(options_.interval_ms),
+      [this]() { return !running_ || wakeup_; });
+    wakeup_ = false;
+  }
+}
+
+int PageCleaner::flush_target(double dirty_ratio, double lsn_rate) const {
+  const double dirty_pct = dirty_ratio * 100;
+
+  double pct = 0;
+  if (dirty_pct >= options_.high_dirty_pct) {
+    pct = 100;
+  } else if (dirty_pct > options_.low_dirty_pct) {
+    pct = (dirty_pct - options_.low_dirty_pct) * 100 / (options_.high_dirty_pct - options_.low_dirty_pct);
+  }
+
+  if (options_.lsn_high_rate > 0) {
+    pct = std::max(pct, std::min(100.0, lsn_rate * 100 / options_.lsn_high_rate));
+  }
+
+  int target = static_cast<int>(options_.max_io_pages * pct / 100);
+  if (pct > 0 && target == 0) {
+    target = 1;
+  }
+  return target;
+}
+
+int PageCleaner::run_once() {
+  const uint64_t now = steady_now_ns();
+  const double elapsed_sec = last_round_ns_ == 0 ? 0 : (now - last_round_ns_) / 1e9;
+  last_round_ns_ = now;
+
+  const size_t total_frames = frame_manager_.total_frame_num();
+  const size_t dirty_pages  = frame_manager_.dirty_frame_num();
+  const double dirty_ratio  = total_frames == 0 ? 0 : static_cast<double>(dirty_pages) / total_frames;
+
+  double lsn_rate = 0;
+  if (lsn_source_) {
+    const LSN lsn = lsn_source_();
+    if (elapsed_sec > 0 && lsn > last_lsn_) {
+      lsn_rate = (lsn - last_lsn_) / elapsed_sec;
+    }
+    last_lsn_ = lsn;
+  }
+
+  const int target = std::min(flush_target(dirty_ratio, lsn_rate), static_cast<int>(dirty_pages));
+
+  int  flushed = 0;
+  bool failed  = false;
+  std::vector<Frame*> frames;
+  while (flushed < target) {
+    frames.clear();
+    frame_manager_.find_cold_dirty_frames(std::min(options_.batch_pages, target - flushed), frames);
+    if (frames.empty()) {
+      break;
+    }
+
+    if (IS_FAIL(flush_frames(frames))) {
+      failed = true;
+      break;
+    }
+    if (frames.empty()) {
+      // 找到的页面都在被修改，下一轮再刷
+      break;
+    }
+    flushed += static_cast<int>(frames.size());
+  }
+
+  std::lock_guard lock(stats_mutex_);
+  stats_.rounds++;
+  stats_.flushed_pages += flushed;
+  stats_.failed_batches += failed ? 1 : 0;
+  stats_.dirty_pages = dirty_pages;
+  stats_.dirty_ratio = dirty_ratio;
+  stats_.lsn_rate    = lsn_rate;
+  stats_.last_target = target;
+  if (elapsed_sec > 0) {
+    // 滑动平均，避免单轮的抖动
+    stats_.flush_rate = stats_.flush_rate * 0.7 + (flushed / elapsed_sec) * 0.3;
+  }
+  LOG_TRACE("page cleaner round done. dirty=%zu/%zu, lsn_rate=%.0f, target=%d, flushed=%d",
+    dirty_pages, total_frames, lsn_rate, target, flushed);
+  return flushed;
+}
+
+RC PageCleaner::flush_frames(std::vector<Frame*>& frames) {
+  // 刷盘期间持有读闩，写者改不了页面，刷盘成功之后清除脏页标记不会丢掉别人的修改。
+  // 一次要加多个页面的闩，只用 try 避免和做闩耦合的写者死锁，加不上的页面留给下一轮
+  size_t latched = 0;
+  for (Frame* frame : frames) {
+    if (frame->try_read_latch()) {
+      frames[latched++] = frame;
+    } else {
+      frame->unpin();
+    }
+  }
+  frames.resize(latched);
+  if (frames.empty()) {
+    return RC::SUCCESS;
+  }
+
+  RC rc = flush_(frames);
+  if (IS_SUCC(rc)) {
+    for (Frame* frame : frames) {
+      frame->clear_dirty();
+    }
+  } else {
+    LOG_WARN("failed to flush dirty pages. count=%zu, rc=%s", frames.size(), strrc(rc));
+  }
+
+  for (Frame* frame : frames) {
+    frame->read_unlatch();
+    frame->unpin();
+  }
+  return rc;
+}
+
+PageCleanerStats PageCleaner::stats() const {
+  std::lock_guard lock(stats_mutex_);
+  return stats_;
+}
+
+} // namespace storage
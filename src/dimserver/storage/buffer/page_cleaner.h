@@ -0,0 +1,120 @@
+#pragma once
+
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <functional>
+#include <condition_variable>
+
+#include "common/rc.h"
+#include "common/types.h"
+#include "storage/buffer/frame.h"
+#include "storage/buffer/frame_manager.h"
+
+namespace storage {
+
+/**
+ * @brief 后台刷脏页的配置
+ */
+struct PageCleanerOptions {
+  int     interval_ms    = 100; /// 两轮之间的间隔
+  int     max_io_pages   = 256; /// 每轮最多刷多少个页面
+  int     batch_pages    = 16;  /// 每次交给 flush 函数的页面个数
+  int     low_dirty_pct  = 10;  /// 脏页比例低于它时不主动刷(日志增长很快时除外)
+  int     high_dirty_pct = 50;  /// 脏页比例达到它时按照 max_io_pages 全速刷
+  int64_t lsn_high_rate  = 0;   /// 每秒日志增长达到它时全速刷，0表示不考虑日志增长
+};
+
+/**
+ * @brief 后台刷脏页的统计
+ */
+struct PageCleanerStats {
+  uint64_t rounds         = 0;   /// 执行的轮数
+  uint64_t flushed_pages  = 0;   /// 一共刷了多少个页面
+  uint64_t failed_batches = 0;   /// 刷盘失败的批次
+  size_t   dirty_pages    = 0;   /// 最近一轮开始时的脏页个数
+  double   dirty_ratio    = 0;   /// 最近一轮开始时的脏页比例，0~1
+  double   lsn_rate       = 0;   /// 日志增长速度，LSN/s
+  double   flush_rate     = 0;   /// 刷脏页速度的滑动平均，页面/s
+  int      last_target    = 0;   /// 最近一轮计划刷的页面个数
+};
+
+/**
+ * @brief 后台刷脏页线程
+ * @ingroup BufferPool
+ * @details 原来脏页只有在 flush_page/flush_all_pages 或者被淘汰时才会写盘，前台线程需要承担
+ * 写页面以及 double write 的开销。PageCleaner 在后台周期性地按照淘汰顺序找出冷的脏页帧
+ * (参考 FrameManager::find_cold_dirty_frames)，分批交给 flush 函数写盘(比如经过 DoubleWriteBuffer)，
+ * 这样前台淘汰页帧时基本都能找到干净的页帧。
+ *
+ * 每轮刷多少页面参考 InnoDB 的 adaptive flushing，取下面两者中较大的那个：
+ * - 脏页比例：低于 low_dirty_pct 不刷，达到 high_dirty_pct 全速刷，中间线性增长；
+ * - 日志增长速度：达到 lsn_high_rate 时全速刷。日志增长越快，需要越快地推进刷盘，
+ *   检查点才能跟上，恢复时间才不会变长。
+ * 前台线程在淘汰时遇到脏页，可以调用 wakeup 提前唤醒后台线程。
+ *
+ * @note 刷盘时页帧是pin住的，并且持有页面的读闩(参考 Frame::read_latch)，修改页面的线程要先加写闩。
+ * 刷盘成功之后由 PageCleaner 在释放读闩之前清除脏页标记，所以不会清掉刷盘之后才做的修改。
+ * 正在被修改(加不上读闩)的页面这一轮跳过。
+ */
+class PageCleaner {
+public:
+  /// 把一批页帧写到磁盘上
+  using FlushBatch = std::function<RC(const std::vector<Frame*>& frames)>;
+  /// 当前的日志序列号，比如 LogHandler::current_lsn
+  using LsnSource = std::function<LSN()>;
+
+public:
+  PageCleaner(FrameManager& frame_manager, FlushBatch flush, LsnSource lsn_source = nullptr,
+      const PageCleanerOptions& options = PageCleanerOptions());
+  ~PageCleaner();
+
+  RC   start();
+  void stop();
+
+  /**
+   * @brief 唤醒后台线程，马上开始下一轮
+   */
+  void wakeup();
+
+  /**
+   * @brief 执行一轮刷脏页
+   * @return 这一轮刷的页面个数
+   */
+  int run_once();
+
+  /**
+   * @brief 根据脏页比例和日志增长速度计算这一轮要刷多少页面
+   */
+  int flush_target(double dirty_ratio, double lsn_rate) const;
+
+  PageCleanerStats stats() const;
+  const PageCleanerOptions& options() const { return options_; }
+
+private:
+  void thread_func();
+  /// 刷一批pin住的页帧，结束时释放pin。frames 只保留真正交给 flush 函数的页帧
+  RC   flush_frames(std::vector<Frame*>& frames);
+
+private:
+  FrameManager&      frame_manager_;
+  FlushBatch         flush_;
+  LsnSource          lsn_source_;
+  PageCleanerOptions options_;
+
+  std::thread             thread_;
+  std::mutex              mutex_;
+  std::condition_variable cond_;
+  bool                    running_ = false;
+  bool                    wakeup_  = false;
+
+  /// run_once 只在一个线程中执行，下面的状态不需要加锁
+  uint64_t last_round_ns_ = 0;
+  LSN      last_lsn_      = 0;
+
+  mutable std::mutex stats_mutex_;
+  PageCleanerStats   stats_;
+};
+
+} // namespace storage
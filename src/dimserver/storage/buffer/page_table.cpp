@@ -0,0 +1,167 @@
+#include "storage/buffer/page_table.h"
+#include "common/thread/epoch.h"
+
+namespace storage {
+
+static size_t round_up_power_of_two(size_t n) {
+  size_t capacity = 16;
+  while (capacity < n) {
+    capacity <<= 1;
+  }
+  return capacity;
+}
+
+PageTable::PageTable(size_t capacity /* = 64 */) {
+  table_.store(new Table(round_up_power_of_two(capacity)), std::memory_order_release);
+}
+
+PageTable::~PageTable() {
+  delete table_.load(std::memory_order_acquire);
+}
+
+size_t PageTable::index_of(uint64_t key, size_t mask) {
+  // splitmix64 的混淆函数，FrameId::hash 的低位就是页号，直接取模会让连续的页面挤在一起
+  key ^= key >> 30;
+  key *= 0xBF58476D1CE4E5B9ULL;
+  key ^= key >> 27;
+  key *= 0x94D049BB133111EBULL;
+  key ^= key >> 31;
+  return static_cast<size_t>(key) & mask;
+}
+
+size_t PageTable::capacity() const {
+  return table_.load(std::memory_order_acquire)->mask + 1;
+}
+
+Frame* PageTable::find(const FrameId& frame_id) const {
+  const Table* table = table_.load(std::memory_order_acquire);
+  const uint64_t key = key_of(frame_id);
+  const size_t   mask = table->mask;
+
+  size_t index = index_of(key, mask);
+  for (size_t i = 0; i <= mask; i++, index = (index + 1) & mask) {
+    const Slot& slot = table->slots[index];
+    const uint64_t slot_key = slot.key.load(std::memory_order_acquire);
+    if (slot_key == key) {
+      return slot.frame.load(std::memory_order_acquire);
+    }
+    if (slot_key == EMPTY_KEY) {
+      return nullptr;
+    }
+  }
+  return nullptr;
+}
+
+Frame* PageTable::insert(const FrameId& frame_id, Frame* frame) {
+  {
+    const Table* table = table_.load(std::memory_order_relaxed);
+    if ((used_ + 1) * 4 > (table->mask + 1) * 3) {
+      // 墓碑很多时只是清理一下，元素很多时扩容
+      rebuild((size_ + 1) * 2);
+    }
+  }
+
+  Table* table = table_.load(std::memory_order_relaxed);
+  const uint64_t key  = key_of(frame_id);
+  const size_t   mask = table->mask;
+
+  int64_t tombstone = -1;
+  size_t  index     = index_of(key, mask);
+  for (size_t i = 0; i <= mask; i++, index = (index + 1) & mask) {
+    Slot& slot = table->slots[index];
+    const uint64_t slot_key = slot.key.load(std::memory_order_relaxed);
+    if (slot_key == key) {
+      return slot.frame.exchange(frame, std::memory_order_acq_rel);
+    }
+    if (slot_key == TOMBSTONE_KEY) {
+      if (tombstone < 0) {
+        tombstone = static_cast<int64_t>(index);
+      }
+      continue;
+    }
+    if (slot_key == EMPTY_KEY) {
+      break;
+    }
+  }
+
+  if (tombstone < 0) {
+    used_++;
+  } else {
+    index = static_cast<size_t>(tombstone);
+  }
+
+  // 先写页帧再写key，读者看到key时一定能看到页帧
+  Slot& slot = table->slots[index];
+  slot.frame.store(frame, std::memory_order_relaxed);
+  slot.key.store(key, std::memory_order_release);
+  size_++;
+  return nullptr;
+}
+
+bool PageTable::erase(const FrameId& frame_id) {
+  Table* table = table_.load(std::memory_order_relaxed);
+  const uint64_t key  = key_of(frame_id);
+  const size_t   mask = table->mask;
+
+  size_t index = index_of(key, mask);
+  for (size_t i = 0; i <= mask; i++, index = (index + 1) & mask) {
+    Slot& slot = table->slots[index];
+    const uint64_t slot_key = slot.key.load(std::memory_order_relaxed);
+    if (slot_key == key) {
+      slot.key.store(TOMBSTONE_KEY, std::memory_order_release);
+      slot.frame.store(nullptr, std::memory_order_release);
+      size_--;
+      return true;
+    }
+    if (slot_key == EMPTY_KEY) {
+      return false;
+    }
+  }
+  return false;
+}
+
+void PageTable::foreach(const std::function<bool(const FrameId&, Frame*)>& func) const {
+  const Table* table = table_.load(std::memory_order_relaxed);
+  for (size_t i = 0; i <= table->mask; i++) {
+    const Slot& slot = table->slots[i];
+    const uint64_t key = slot.key.load(std::memory_order_relaxed);
+    if (key == EMPTY_KEY || key == TOMBSTONE_KEY) {
+      continue;
+    }
+    const FrameId frame_id(static_cast<int32_t>(key >> 32), static_cast<PageNum>(key & 0xFFFFFFFFULL));
+    if (!func(frame_id, slot.frame.load(std::memory_order_relaxed))) {
+      return;
+    }
+  }
+}
+
+void PageTable::rebuild(size_t capacity) {
+  Table* old_table = table_.load(std::memory_order_relaxed);
+  Table* new_table = new Table(round_up_power_of_two(capacity * 4 / 3 + 1));
+
+  const size_t mask = new_table->mask;
+  for (size_t i = 0; i <= old_table->mask; i++) {
+    const Slot& old_slot = old_table->slots[i];
+    const uint64_t key = old_slot.key.load(std::memory_order_relaxed);
+    if (key == EMPTY_KEY || key == TOMBSTONE_KEY) {
+      continue;
+    }
+
+    size_t index = index_of(key, mask);
+    while (new_table->slots[index].key.load(std::memory_order_relaxed) != EMPTY_KEY) {
+      index = (index + 1) & mask;
+    }
+    new_table->slots[index].frame.store(old_slot.frame.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    new_table->slots[index].key.store(key, std::memory_order_relaxed);
+  }
+  used_ = size_;
+
+  table_.store(new_table, std::memory_order_release);
+
+  // 可能还有读者在旧数组上查找
+  common::EpochManager& epoch_manager = common::EpochManager::instance();
+  epoch_manager.retire([old_table]() { delete old_table; });
+  epoch_manager.reclaim();
+}
+
+} // namespace storage
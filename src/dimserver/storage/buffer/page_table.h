@@ -0,0 +1,89 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <cstdint>
+#include <functional>
+
+#include "storage/buffer/frame.h"
+
+namespace storage {
+
+/**
+ * @brief FrameId 到 Frame* 的哈希表，查找不加锁
+ * @ingroup BufferPool
+ * @details 单写者多读者的开放寻址(线性探测)哈希表，FrameManager 的每个分片一个：
+ * - 写者(insert/erase/foreach)由分片锁互斥；
+ * - 读者(find)不加锁，但是需要在 common::EpochGuard 内调用。
+ *
+ * 每个槽位的 key 和 frame 都是原子变量。写入时先写 frame 再写 key，删除时把 key 改成墓碑。
+ * 读者可能看到一个刚被删除或者替换的页帧，所以拿到页帧之后需要pin住再检查页帧当前的
+ * FrameId(参考 Frame::try_pin 和 Frame::published_key)。
+ *
+ * 墓碑和有效元素超过容量的3/4时，写者重新分配一个数组，把有效元素搬过去之后原子地替换，
+ * 旧数组交给 EpochManager，等所有读者都离开之后再释放。
+ */
+class PageTable {
+public:
+  explicit PageTable(size_t capacity = 64);
+  ~PageTable();
+
+  PageTable(const PageTable&)            = delete;
+  PageTable& operator=(const PageTable&) = delete;
+
+  /**
+   * @brief 查找页帧，不加锁
+   * @details 返回的页帧没有pin住，也可能已经不再对应frame_id
+   */
+  Frame* find(const FrameId& frame_id) const;
+
+  /**
+   * @brief 插入或者覆盖
+   * @return 被覆盖的页帧，没有时返回nullptr
+   */
+  Frame* insert(const FrameId& frame_id, Frame* frame);
+
+  /**
+   * @brief 删除
+   * @return 是否存在
+   */
+  bool erase(const FrameId& frame_id);
+
+  /**
+   * @brief 遍历所有元素，需要和写者互斥。func返回false时停止遍历
+   */
+  void foreach(const std::function<bool(const FrameId&, Frame*)>& func) const;
+
+  size_t size() const { return size_; }
+  bool   empty() const { return size_ == 0; }
+  size_t capacity() const;
+
+private:
+  static constexpr uint64_t EMPTY_KEY     = ~0ULL;      /// 从来没有用过的槽位，FrameId() 的key
+  static constexpr uint64_t TOMBSTONE_KEY = ~0ULL - 1;  /// 已经删除的槽位
+
+  struct Slot {
+    std::atomic<uint64_t> key{EMPTY_KEY};
+    std::atomic<Frame*>   frame{nullptr};
+  };
+
+  struct Table {
+    explicit Table(size_t capacity) : mask(capacity - 1), slots(new Slot[capacity]) {}
+
+    size_t                  mask;
+    std::unique_ptr<Slot[]> slots;
+  };
+
+  static uint64_t key_of(const FrameId& frame_id) { return static_cast<uint64_t>(frame_id.hash()); }
+  static size_t   index_of(uint64_t key, size_t mask);
+
+  /// 重新分配一个数组，容量至少能放下capacity个元素
+  void rebuild(size_t capacity);
+
+private:
+  std::atomic<Table*> table_{nullptr};
+  size_t              size_ = 0;  /// 有效元素个数
+  size_t              used_ = 0;  /// 有效元素和墓碑的个数
+};
+
+} // namespace storage
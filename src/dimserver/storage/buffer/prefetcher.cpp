@@ -0,0 +1,289 @@
+#include <algorithm>
+#include <chrono>
+
+#include "storage/buffer/prefetcher.h"
+#include "common/log/log.h"
+
+namespace storage {
+
+/******************** PrefetchStream ********************/
+
+PrefetchStream::PrefetchStream(int buffer_pool_id, PageReader reader, Purger purger /* = nullptr */,
+    int window /* = DEFAULT_WINDOW */)
+  : buffer_pool_id_(buffer_pool_id),
+    reader_(std::move(reader)),
+    purger_(std::move(purger)),
+    window_(window > 0 ? window : DEFAULT_WINDOW) {}
+
+void PrefetchStream::reset() {
+  last_page_     = BP_INVALID_PAGE_NUM;
+  run_length_    = 0;
+  prefetch_next_ = BP_INVALID_PAGE_NUM;
+}
+
+bool PrefetchStream::sequential() const {
+  return run_length_ >= Prefetcher::SEQUENTIAL_THRESHOLD;
+}
+
+/******************** Prefetcher ********************/
+
+Prefetcher::Prefetcher(FrameManager& frame_manager) : frame_manager_(frame_manager) {}
+
+Prefetcher::~Prefetcher() {
+  cleanup();
+}
+
+RC Prefetcher::init(int thread_num /* = DEFAULT_THREAD_NUM */) {
+  if (thread_num < 0) {
+    LOG_ERROR("Invalid prefetch thread number: %d", thread_num);
+    return RC::INVALID_ARGUMENT;
+  }
+  if (!threads_.empty()) {
+    LOG_ERROR("Prefetcher has already been initialized");
+    return RC::INTERNAL;
+  }
+
+  stop_ = false;
+  // 线程数为0时不做预读，get_page 退化为同步读取
+  for (int i = 0; i < thread_num; i++) {
+    threads_.emplace_back(&Prefetcher::worker, this);
+  }
+  LOG_INFO("prefetcher initialized. threads=%d", thread_num);
+  return RC::SUCCESS;
+}
+
+void Prefetcher::cleanup() {
+  if (threads_.empty()) {
+    return;
+  }
+
+  wait_idle();
+  {
+    std::lock_guard lock(mutex_);
+    stop_ = true;
+  }
+  task_cond_.notify_all();
+  for (std::thread& thread : threads_) {
+    thread.join();
+  }
+  threads_.clear();
+}
+
+RC Prefetcher::get_page(PrefetchStream& stream, PageNum page_num, const Bitmap& allocated, Frame*& frame,
+    ScanRing* ring /* = nullptr */) {
+  on_access(stream, page_num, allocated);
+
+  const int buffer_pool_id = stream.buffer_pool_id_;
+  while (true) {
+    frame = frame_manager_.get(buffer_pool_id, page_num, ring);
+    if (frame != nullptr) {
+      bool prefetched = false;
+      if (wait_io(*frame, prefetched)) {
+        if (prefetched) {
+          hits_.fetch_add(1, std::memory_order_relaxed);
+        }
+        return RC::SUCCESS;
+      }
+      return load(stream, page_num, frame);
+    }
+
+    // 顺序扫描优先复用环中的页帧，新分配的页帧也要记录到环中
+    auto alloc = [&]() {
+      return ring != nullptr ? frame_manager_.alloc_for_read(buffer_pool_id, page_num, *ring, stream.purger_, frame)
+                             : frame_manager_.alloc_for_read(buffer_pool_id, page_num, false, frame);
+    };
+    RC rc = alloc();
+    if (rc == RC::BUFFER_POOL_FULL && stream.purger_) {
+      frame_manager_.purge_frames(1, stream.purger_);
+      rc = alloc();
+    }
+    if (IS_FAIL(rc)) {
+      LOG_WARN("failed to alloc frame. buffer_pool_id=%d, page_num=%d, rc=%s",
+        buffer_pool_id, page_num, strrc(rc));
+      return rc;
+    }
+
+    if (frame == nullptr) {
+      // 页面刚刚被别的线程(比如预读线程)映射，重新获取
+      continue;
+    }
+
+    if (stream.sequential() && !threads_.empty()) {
+      misses_.fetch_add(1, std::memory_order_relaxed);
+    }
+    return load(stream, page_num, frame);
+  }
+}
+
+RC Prefetcher::load(PrefetchStream& stream, PageNum page_num, Frame*& frame) {
+  RC rc = stream.reader_(page_num, frame);
+  if (IS_FAIL(rc)) {
+    LOG_WARN("failed to load page. buffer_pool_id=%d, page_num=%d, rc=%s",
+      stream.buffer_pool_id_, page_num, strrc(rc));
+    frame->set_io_state(Frame::IoState::FAILED);
+    frame->unpin();
+    frame = nullptr;
+    return rc;
+  }
+
+  frame->set_io_state(Frame::IoState::NONE);
+  return RC::SUCCESS;
+}
+
+void Prefetcher::on_access(PrefetchStream& stream, PageNum page_num, const Bitmap& allocated) {
+  // 跳过没有分配的页面之后紧接着上一次访问的页面，也认为是顺序访问
+  const bool sequential = stream.last_page_ != BP_INVALID_PAGE_NUM && page_num > stream.last_page_ &&
+      (page_num == stream.last_page_ + 1 || page_num == allocated.next_one_bit(stream.last_page_ + 1));
+  stream.run_length_ = sequential ? stream.run_length_ + 1 : 1;
+  stream.last_page_  = page_num;
+
+  if (!stream.sequential()) {
+    stream.prefetch_next_ = BP_INVALID_PAGE_NUM;
+    return;
+  }
+  if (threads_.empty()) {
+    return;
+  }
+
+  // 已经预读但是还没有访问的页面超过半个窗口时，先不提交
+  const PageNum start = std::max(page_num + 1, stream.prefetch_next_);
+  const int ahead = start - page_num - 1;
+  if (ahead > stream.window_ / 2) {
+    return;
+  }
+
+  std::vector<PageNum> pages;
+  const int count = stream.window_ - ahead;
+  for (int next = allocated.next_one_bit(start); next >= 0 && static_cast<int>(pages.size()) < count;
+       next = allocated.next_one_bit(next + 1)) {
+    pages.push_back(next);
+  }
+  if (pages.empty()) {
+    return;
+  }
+
+  stream.prefetch_next_ = pages.back() + 1;
+  submit(stream, pages);
+}
+
+void Prefetcher::submit(PrefetchStream& stream, std::vector<PageNum>& pages) {
+  {
+    std::lock_guard lock(mutex_);
+    for (size_t begin = 0; begin < pages.size(); begin += BATCH_PAGES) {
+      const size_t end = std::min(pages.size(), begin + BATCH_PAGES);
+      tasks_.push_back(Task{stream.buffer_pool_id_, stream.reader_, stream.purger_,
+        std::vector<PageNum>(pages.begin() + begin, pages.begin() + end)});
+    }
+  }
+  issued_.fetch_add(pages.size(), std::memory_order_relaxed);
+  task_cond_.notify_all();
+}
+
+void Prefetcher::worker() {
+  std::unique_lock lock(mutex_);
+  while (true) {
+    task_cond_.wait(lock, [this]() { return stop_ || !tasks_.empty(); });
+    if (tasks_.empty()) {
+      return;
+    }
+
+    Task task = std::move(tasks_.front());
+    tasks_.pop_front();
+    running_++;
+
+    lock.unlock();
+    run_task(task);
+    lock.lock();
+
+    running_--;
+    if (tasks_.empty() && running_ == 0) {
+      idle_cond_.notify_all();
+    }
+  }
+}
+
+void Prefetcher::run_task(const Task& task) {
+  for (size_t i = 0; i < task.pages.size(); i++) {
+    const PageNum page_num = task.pages[i];
+
+    Frame* frame = nullptr;
+    RC rc = frame_manager_.alloc_for_read(task.buffer_pool_id, page_num, true /*scan_only*/, frame);
+    if (rc == RC::BUFFER_POOL_FULL && task.purger) {
+      frame_manager_.purge_frames(1, task.purger);
+      rc = frame_manager_.alloc_for_read(task.buffer_pool_id, page_num, true /*scan_only*/, frame);
+    }
+    if (IS_FAIL(rc)) {
+      // 缓冲池已经满了，剩下的页面也不用预读了
+      dropped_.fetch_add(task.pages.size() - i, std::memory_order_relaxed);
+      LOG_TRACE("drop prefetch. buffer_pool_id=%d, page_num=%d, rc=%s", task.buffer_pool_id, page_num, strrc(rc));
+      return;
+    }
+
+    if (frame == nullptr) {
+      skipped_.fetch_add(1, std::memory_order_relaxed);
+      continue;
+    }
+
+    rc = task.reader(page_num, frame);
+    if (IS_SUCC(rc)) {
+      frame->set_io_state(Frame::IoState::PREFETCHED);
+      loaded_.fetch_add(1, std::memory_order_relaxed);
+    } else {
+      // 留给访问者重新读取
+      frame->set_io_state(Frame::IoState::FAILED);
+      failed_.fetch_add(1, std::memory_order_relaxed);
+      LOG_WARN("failed to prefetch page. buffer_pool_id=%d, page_num=%d, rc=%s",
+        task.buffer_pool_id, page_num, strrc(rc));
+    }
+    frame->unpin();
+  }
+}
+
+void Prefetcher::wait_idle() {
+  std::unique_lock lock(mutex_);
+  idle_cond_.wait(lock, [this]() { return tasks_.empty() && running_ == 0; });
+}
+
+bool Prefetcher::wait_io(Frame& frame, bool& prefetched) {
+  prefetched = false;
+  for (int i = 0;; i++) {
+    switch (frame.io_state()) {
+      case Frame::IoState::NONE: {
+        return true;
+      }
+      case Frame::IoState::PREFETCHED: {
+        if (frame.cas_io_state(Frame::IoState::PREFETCHED, Frame::IoState::NONE)) {
+          prefetched = true;
+          return true;
+        }
+      } break;
+      case Frame::IoState::FAILED: {
+        // 只有一个访问者负责重新读取，其它访问者继续等待
+        if (frame.cas_io_state(Frame::IoState::FAILED, Frame::IoState::READING)) {
+          return false;
+        }
+      } break;
+      case Frame::IoState::READING: {
+        if (i < 64) {
+          std::this_thread::yield();
+        } else {
+          std::this_thread::sleep_for(std::chrono::microseconds(20));
+        }
+      } break;
+    }
+  }
+}
+
+PrefetchStats Prefetcher::stats() const {
+  PrefetchStats stats;
+  stats.issued  = issued_.load(std::memory_order_relaxed);
+  stats.loaded  = loaded_.load(std::memory_order_relaxed);
+  stats.hits    = hits_.load(std::memory_order_relaxed);
+  stats.misses  = misses_.load(std::memory_order_relaxed);
+  stats.skipped = skipped_.load(std::memory_order_relaxed);
+  stats.dropped = dropped_.load(std::memory_order_relaxed);
+  stats.failed  = failed_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+} // namespace storage
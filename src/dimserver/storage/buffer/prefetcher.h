@@ -0,0 +1,170 @@
+#pragma once
+
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <functional>
+#include <condition_variable>
+
+#include "common/rc.h"
+#include "common/types.h"
+#include "common/bitmap/bitmap.h"
+#include "storage/buffer/frame.h"
+#include "storage/buffer/frame_manager.h"
+
+namespace storage {
+
+/**
+ * @brief 一个顺序访问流的预读状态
+ * @ingroup BufferPool
+ * @details 类似 Linux 的 file_ra_state。每个 BufferPool(以及每个扫描)有一个自己的实例，
+ * 记录最近访问的页面，判断是否在顺序访问，以及已经预读到了哪里。
+ * 不是线程安全的，同一个实例只能在一个线程中使用(BufferPool 中由它自己的锁保护)。
+ */
+class PrefetchStream {
+public:
+  /// 读取一个页面到页帧中，比如 BufferPool::load_page
+  using PageReader = std::function<RC(PageNum page_num, Frame* frame)>;
+  /// 没有空闲页帧时淘汰页帧之前的处理函数，参考 FrameManager::purge_frames
+  using Purger = std::function<RC(Frame*)>;
+
+  static constexpr int DEFAULT_WINDOW = 32;  /// 默认预读32个页面，即256KB
+
+public:
+  /**
+   * @param purger 为空时，预读只使用空闲页帧，不会为了预读淘汰页帧
+   */
+  PrefetchStream(int buffer_pool_id, PageReader reader, Purger purger = nullptr, int window = DEFAULT_WINDOW);
+  ~PrefetchStream() = default;
+
+  /**
+   * @brief 清空访问历史，比如重新开始一次扫描
+   */
+  void reset();
+
+  /// 当前是否处于顺序访问
+  bool sequential() const;
+
+  int buffer_pool_id() const { return buffer_pool_id_; }
+  int window() const { return window_; }
+
+private:
+  friend class Prefetcher;
+
+  int        buffer_pool_id_ = -1;
+  PageReader reader_;
+  Purger     purger_;
+  int        window_ = DEFAULT_WINDOW;
+
+  PageNum last_page_     = BP_INVALID_PAGE_NUM; /// 最近访问的页面
+  int     run_length_    = 0;                   /// 连续顺序访问的页面个数
+  PageNum prefetch_next_ = BP_INVALID_PAGE_NUM; /// 下一个还没有提交预读的页面
+};
+
+/**
+ * @brief 预读统计
+ */
+struct PrefetchStats {
+  uint64_t issued  = 0; /// 提交给后台读取的页面个数
+  uint64_t loaded  = 0; /// 后台读取成功的页面个数
+  uint64_t hits    = 0; /// 访问时页面已经被预读(或正在预读)的次数
+  uint64_t misses  = 0; /// 顺序访问时页面还没有被预读，只能同步读取的次数
+  uint64_t skipped = 0; /// 预读时页面已经在缓冲池中的次数
+  uint64_t dropped = 0; /// 没有空闲页帧放弃预读的页面个数
+  uint64_t failed  = 0; /// 后台读取失败的页面个数
+};
+
+/**
+ * @brief 顺序访问的异步预读
+ * @ingroup BufferPool
+ * @details BufferPool::load_page 每次同步读取一个页面，顺序扫描的速度受限于单个页面的读取延迟。
+ * Prefetcher 在检测到顺序访问之后，按照页面分配位图(跳过没有分配的页面)找到后续 window 个页面，
+ * 分批交给后台线程读取。页面在读取之前就已经映射到缓冲池中，处于 Frame::IoState::READING 状态，
+ * 访问者拿到这样的页帧时会等待读取完成。
+ *
+ * 类似 Linux 的异步预读，已经预读但还没有访问的页面少于半个窗口时，才提交下一批预读，
+ * 这样读取和访问可以重叠，每次提交的IO也比较大。
+ *
+ * 所有 BufferPool 共享一个 Prefetcher。关闭文件之前需要调用 wait_idle，保证没有正在进行的预读。
+ * @note 目前使用线程池执行读取，io_uring 等异步IO接口可以之后替换 worker 的实现。
+ */
+class Prefetcher {
+public:
+  static constexpr int DEFAULT_THREAD_NUM   = 2;
+  static constexpr int SEQUENTIAL_THRESHOLD = 2; /// 连续访问几个页面之后认为是顺序访问
+  static constexpr int BATCH_PAGES          = 8; /// 每个后台任务读取的页面个数
+
+public:
+  explicit Prefetcher(FrameManager& frame_manager);
+  ~Prefetcher();
+
+  RC   init(int thread_num = DEFAULT_THREAD_NUM);
+  void cleanup();
+
+  /**
+   * @brief 获取一个页面，并pin住
+   * @details BufferPool::get_this_page 的实现：记录这次访问并按需提交预读；
+   * 页面在缓冲池中时等待可能正在进行的读取，否则分配页帧同步读取。
+   * @param allocated 页面分配位图，预读时跳过没有分配的页面。调用期间不能被修改
+   * @param ring 顺序扫描使用的页帧环，参考 ScanRing。没有命中时优先复用环中的页帧(需要 stream 有 purger)，
+   * 新分配的页帧也记录到环中
+   */
+  RC get_page(PrefetchStream& stream, PageNum page_num, const Bitmap& allocated, Frame*& frame,
+      ScanRing* ring = nullptr);
+
+  /**
+   * @brief 记录一次页面访问，检测到顺序访问时提交预读
+   */
+  void on_access(PrefetchStream& stream, PageNum page_num, const Bitmap& allocated);
+
+  /**
+   * @brief 等待所有已经提交的预读完成
+   */
+  void wait_idle();
+
+  PrefetchStats stats() const;
+
+  /**
+   * @brief 等待页帧上正在进行的读取完成
+   * @details 从 FrameManager 拿到页帧之后调用。
+   * @param[out] prefetched 页面是否是预读进来之后第一次被访问
+   * @return false 表示之前的读取失败了，调用者需要自己读取页面，之后设置页帧的IO状态
+   */
+  static bool wait_io(Frame& frame, bool& prefetched);
+
+private:
+  struct Task {
+    int                     buffer_pool_id;
+    PrefetchStream::PageReader reader;
+    PrefetchStream::Purger  purger;
+    std::vector<PageNum>    pages;
+  };
+
+  void submit(PrefetchStream& stream, std::vector<PageNum>& pages);
+  void worker();
+  void run_task(const Task& task);
+  RC   load(PrefetchStream& stream, PageNum page_num, Frame*& frame);
+
+private:
+  FrameManager& frame_manager_;
+
+  std::vector<std::thread> threads_;
+  std::mutex               mutex_;
+  std::condition_variable  task_cond_;  /// 有新任务或者需要退出
+  std::condition_variable  idle_cond_;  /// 所有任务都完成了
+  std::deque<Task>         tasks_;
+  int                      running_ = 0; /// 正在执行的任务个数
+  bool                     stop_    = false;
+
+  std::atomic<uint64_t> issued_{0};
+  std::atomic<uint64_t> loaded_{0};
+  std::atomic<uint64_t> hits_{0};
+  std::atomic<uint64_t> misses_{0};
+  std::atomic<uint64_t> skipped_{0};
+  std::atomic<uint64_t> dropped_{0};
+  std::atomic<uint64_t> failed_{0};
+};
+
+} // namespace storage
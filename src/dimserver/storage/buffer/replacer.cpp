@@ -0,0 +1,283 @@
+#include "storage/buffer/replacer.h"
+#include "common/log/log.h"
+
+namespace storage {
+
+RC Replacer::create(const std::string& name, Replacer*& replacer) {
+  if (name.empty() || name == "lru") {
+    replacer = new LruReplacer();
+  } else if (name == "clock") {
+    replacer = new ClockReplacer();
+  } else if (name == "2q") {
+    replacer = new TwoQueueReplacer();
+  } else {
+    LOG_ERROR("unknown replacer name: %s", name.c_str());
+    return RC::INVALID_ARGUMENT;
+  }
+  return RC::SUCCESS;
+}
+
+/******************** LruReplacer ********************/
+
+void LruReplacer::access(Frame* frame) {
+  frame->clear_referenced();
+  Frame* out = nullptr;
+  (void)frames_.get(frame, out);
+}
+
+void LruReplacer::insert(Frame* frame) {
+  frame->clear_referenced();
+  frames_.put(frame, frame);
+}
+
+void LruReplacer::foreach_victim(const std::function<bool(Frame*)>& func) {
+  // 无锁命中过的页帧不能在遍历的时候移动，遍历完之后再提升
+  std::vector<Frame*> touched;
+  bool stopped = false;
+  frames_.foreach_reverse([&func, &touched, &stopped]([[maybe_unused]] Frame* const& key, Frame* const& frame) {
+    if (frame->clear_referenced()) {
+      touched.push_back(frame);
+      return true;
+    }
+    stopped = !func(frame);
+    return !stopped;
+  });
+
+  for (Frame* frame : touched) {
+    access(frame);
+  }
+
+  // 提升之后它们排在最近使用的一端，和原来一样，仍然要让调用者看到所有的页帧
+  for (size_t i = 0; !stopped && i < touched.size(); i++) {
+    stopped = !func(touched[i]);
+  }
+}
+
+void LruReplacer::foreach_cold(const std::function<bool(Frame*)>& func) const {
+  frames_.foreach_reverse([&func]([[maybe_unused]] Frame* const& key, Frame* const& frame) {
+    return frame->referenced() || func(frame);
+  });
+}
+
+/******************** SlotReplacer ********************/
+
+int32_t SlotReplacer::alloc_slot(Frame* frame, uint8_t queue) {
+  int32_t slot = -1;
+  if (!free_slots_.empty()) {
+    slot = free_slots_.back();
+    free_slots_.pop_back();
+  } else {
+    slot = static_cast<int32_t>(slots_.size());
+    slots_.emplace_back();
+  }
+
+  Slot& s      = slots_[slot];
+  s.frame      = frame;
+  s.queue      = queue;
+  frame->clear_referenced();
+  s.prev       = -1;
+  s.next       = -1;
+  frame->set_replacer_slot(slot);
+  size_++;
+  return slot;
+}
+
+void SlotReplacer::free_slot(int32_t slot) {
+  Slot& s = slots_[slot];
+  s.frame->set_replacer_slot(-1);
+  s.frame      = nullptr;
+  free_slots_.push_back(slot);
+  size_--;
+}
+
+bool SlotReplacer::clock_sweep(uint8_t queue, const std::function<bool(Frame*)>& func) {
+  const size_t slot_num = slots_.size();
+  if (slot_num == 0) {
+    return true;
+  }
+
+  std::vector<size_t> second_chance;
+  for (size_t i = 0; i < slot_num; i++) {
+    const size_t index = (hand_ + i) % slot_num;
+    Slot& slot = slots_[index];
+    if (slot.frame == nullptr || slot.queue != queue) {
+      continue;
+    }
+
+    if (slot.frame->clear_referenced()) {
+      second_chance.push_back(index);
+      continue;
+    }
+
+    if (!func(slot.frame)) {
+      hand_ = (index + 1) % slot_num;
+      return false;
+    }
+  }
+
+  for (size_t index : second_chance) {
+    Slot& slot = slots_[index];
+    if (slot.frame == nullptr || slot.queue != queue || slot.frame->referenced()) {
+      continue;
+    }
+    if (!func(slot.frame)) {
+      hand_ = (index + 1) % slot_num;
+      return false;
+    }
+  }
+  return true;
+}
+
+bool SlotReplacer::cold_scan(uint8_t queue, const std::function<bool(Frame*)>& func) const {
+  const size_t slot_num = slots_.size();
+  for (size_t i = 0; i < slot_num; i++) {
+    const Slot& slot = slots_[(hand_ + i) % slot_num];
+    if (slot.frame == nullptr || slot.queue != queue || slot.frame->referenced()) {
+      continue;
+    }
+    if (!func(slot.frame)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/******************** ClockReplacer ********************/
+
+void ClockReplacer::insert(Frame* frame) {
+  alloc_slot(frame, 0);
+}
+
+void ClockReplacer::remove(Frame* frame) {
+  const int32_t slot = frame->replacer_slot();
+  if (slot < 0) {
+    return;
+  }
+  free_slot(slot);
+}
+
+void ClockReplacer::foreach_victim(const std::function<bool(Frame*)>& func) {
+  clock_sweep(0, func);
+}
+
+void ClockReplacer::foreach_cold(const std::function<bool(Frame*)>& func) const {
+  cold_scan(0, func);
+}
+
+/******************** TwoQueueReplacer ********************/
+
+void TwoQueueReplacer::insert(Frame* frame) {
+  auto iter = ghost_seq_.find(frame->frame_id());
+  if (iter != ghost_seq_.end()) {
+    // 最近从 A1in 中淘汰过，说明不是只访问一次的页面，直接进入 Am
+    ghost_seq_.erase(iter);
+    alloc_slot(frame, AM);
+    return;
+  }
+
+  const int32_t slot = alloc_slot(frame, A1IN);
+  a1in_push_back(slot);
+}
+
+void TwoQueueReplacer::remove(Frame* frame) {
+  const int32_t slot = frame->replacer_slot();
+  if (slot < 0) {
+    return;
+  }
+
+  if (slots_[slot].queue == A1IN) {
+    a1in_unlink(slot);
+    remember_ghost(frame->frame_id());
+  }
+  free_slot(slot);
+}
+
+void TwoQueueReplacer::foreach_victim(const std::function<bool(Frame*)>& func) {
+  const size_t a1in_quota = size_ * A1IN_PERCENT / 100;
+  if (a1in_size_ > a1in_quota || a1in_size_ == size_) {
+    // A1in 超出份额，访问过的页帧晋升到 Am，没访问过的作为候选
+    for (int32_t slot = a1in_head_; slot != -1;) {
+      Slot& s = slots_[slot];
+      const int32_t next = s.next;
+      if (s.frame->clear_referenced()) {
+        a1in_unlink(slot);
+        s.queue = AM;
+      } else if (!func(s.frame)) {
+        return;
+      }
+      slot = next;
+    }
+
+    (void)clock_sweep(AM, func);
+    return;
+  }
+
+  if (!clock_sweep(AM, func)) {
+    return;
+  }
+
+  // Am 中没有可以淘汰的页帧，只能淘汰份额内的 A1in
+  for (int32_t slot = a1in_head_; slot != -1; slot = slots_[slot].next) {
+    if (!func(slots_[slot].frame)) {
+      return;
+    }
+  }
+}
+
+void TwoQueueReplacer::foreach_cold(const std::function<bool(Frame*)>& func) const {
+  // A1in 中没有访问过的页帧总是先于 Am 被淘汰
+  for (int32_t slot = a1in_head_; slot != -1; slot = slots_[slot].next) {
+    const Slot& s = slots_[slot];
+    if (!s.frame->referenced() && !func(s.frame)) {
+      return;
+    }
+  }
+  (void)cold_scan(AM, func);
+}
+
+void TwoQueueReplacer::a1in_push_back(int32_t slot) {
+  Slot& s = slots_[slot];
+  s.prev = a1in_tail_;
+  s.next = -1;
+  if (a1in_tail_ != -1) {
+    slots_[a1in_tail_].next = slot;
+  } else {
+    a1in_head_ = slot;
+  }
+  a1in_tail_ = slot;
+  a1in_size_++;
+}
+
+void TwoQueueReplacer::a1in_unlink(int32_t slot) {
+  Slot& s = slots_[slot];
+  if (s.prev != -1) {
+    slots_[s.prev].next = s.next;
+  } else {
+    a1in_head_ = s.next;
+  }
+  if (s.next != -1) {
+    slots_[s.next].prev = s.prev;
+  } else {
+    a1in_tail_ = s.prev;
+  }
+  s.prev = s.next = -1;
+  a1in_size_--;
+}
+
+void TwoQueueReplacer::remember_ghost(const FrameId& frame_id) {
+  const uint64_t seq = next_ghost_seq_++;
+  ghost_seq_[frame_id] = seq;
+  ghosts_.emplace_back(frame_id, seq);
+
+  const size_t capacity = std::max<size_t>(1, slots_.size() * A1OUT_PERCENT / 100);
+  while (ghosts_.size() > capacity) {
+    const auto& [oldest_id, oldest_seq] = ghosts_.front();
+    auto iter = ghost_seq_.find(oldest_id);
+    if (iter != ghost_seq_.end() && iter->second == oldest_seq) {
+      ghost_seq_.erase(iter);
+    }
+    ghosts_.pop_front();
+  }
+}
+
+} // namespace storage
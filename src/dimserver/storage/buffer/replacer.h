@@ -0,0 +1,201 @@
+#pragma once
+
+#include <deque>
+#include <string>
+#include <vector>
+#include <functional>
+#include <unordered_map>
+
+#include "common/rc.h"
+#include "storage/buffer/frame.h"
+#include "storage/buffer/lru_cache.h"
+
+namespace storage {
+
+/**
+ * @brief 页帧替换策略
+ * @ingroup BufferPool
+ * @details FrameManager 的每个分片都有一个自己的替换策略实例，记录当前分片上所有已映射的页帧，
+ * 在需要淘汰页帧时给出淘汰顺序。所有接口都在分片锁的保护下调用。
+ * 替换策略只决定"先淘汰谁"，页帧能否真的被淘汰(比如是否被pin住)由 FrameManager 判断。
+ *
+ * 无锁命中(参考 PageTable)时拿不到分片锁，不能调用 access，只调用 Frame::touch 设置页帧的访问位。
+ * 各个替换策略在淘汰时通过 Frame::clear_referenced 处理这些访问：CLOCK 和 2Q 本来就是访问位，
+ * LRU 则在淘汰时把设置了访问位的页帧移到链表头部(延迟提升)。
+ */
+class Replacer {
+public:
+  Replacer()          = default;
+  virtual ~Replacer() = default;
+
+  /**
+   * @brief 一个新的页帧被映射
+   */
+  virtual void insert(Frame* frame) = 0;
+
+  /**
+   * @brief 页面命中
+   */
+  virtual void access(Frame* frame) = 0;
+
+  /**
+   * @brief 页帧被释放，不再参与替换
+   */
+  virtual void remove(Frame* frame) = 0;
+
+  /**
+   * @brief 按照淘汰的优先顺序遍历页帧
+   * @details 每个页帧最多遍历一次。func返回false时停止遍历。
+   * 遍历过程中可能会调整替换策略的内部状态(比如清除CLOCK的访问位)，但是不会删除页帧，
+   * 真正的删除由调用者之后通过 remove 完成。
+   */
+  virtual void foreach_victim(const std::function<bool(Frame*)>& func) = 0;
+
+  /**
+   * @brief 按照淘汰的优先顺序遍历马上就会被淘汰的页帧，不修改替换策略的状态
+   * @details 给后台刷脏页使用，提前把冷的脏页刷掉。与 foreach_victim 不同，
+   * 这里不会清除访问位，也不会调整队列，访问过的页帧直接跳过。
+   */
+  virtual void foreach_cold(const std::function<bool(Frame*)>& func) const = 0;
+
+  virtual size_t size() const = 0;
+  virtual const char* name() const = 0;
+
+  /**
+   * @brief 根据名字创建替换策略
+   * @param name 替换策略名称：lru、clock、2q
+   * @param replacer 输出参数，返回创建的替换策略
+   */
+  static RC create(const std::string& name, Replacer*& replacer);
+};
+
+/**
+ * @brief LRU 替换策略
+ * @details 每次命中都会把页帧移动到链表头部，淘汰时从链表尾部开始。
+ * 无锁命中只设置访问位，淘汰时遇到设置了访问位的页帧再把它移动到链表头部。
+ */
+class LruReplacer : public Replacer {
+public:
+  LruReplacer() : frames_(0) {}
+  virtual ~LruReplacer() = default;
+
+  void insert(Frame* frame) override;
+  void access(Frame* frame) override;
+  void remove(Frame* frame) override { frames_.remove(frame); }
+  void foreach_victim(const std::function<bool(Frame*)>& func) override;
+  void foreach_cold(const std::function<bool(Frame*)>& func) const override;
+
+  size_t size() const override { return frames_.count(); }
+  const char* name() const override { return "lru"; }
+
+private:
+  LruCache<Frame*, Frame*> frames_;
+};
+
+/**
+ * @brief 使用一个定长数组保存页帧的替换策略的公共部分
+ * @details 页帧在数组中的位置记录在 Frame::replacer_slot() 中，命中时不需要查找，也不需要改动
+ * 任何链表指针，只设置页帧的访问位(Frame::touch)。数组只在当前分片的页帧数超过历史最大值时才会增长。
+ */
+class SlotReplacer : public Replacer {
+public:
+  virtual ~SlotReplacer() = default;
+
+  void access(Frame* frame) override { frame->touch(); }
+
+  size_t size() const override { return size_; }
+
+protected:
+  struct Slot {
+    Frame*  frame      = nullptr;
+    uint8_t queue      = 0;  /// 子类自定义的队列标识
+    int32_t prev       = -1; /// 子类自定义的链表指针
+    int32_t next       = -1;
+  };
+
+  int32_t alloc_slot(Frame* frame, uint8_t queue);
+  void    free_slot(int32_t slot);
+
+  /**
+   * @brief 在属于queue的页帧上执行一轮CLOCK扫描
+   * @details 第一圈清除访问位并给出访问位为0的页帧，第一圈中被清除访问位的页帧在第二圈给出，
+   * 保证每个页帧最多给出一次
+   * @return func是否一直返回true
+   */
+  bool clock_sweep(uint8_t queue, const std::function<bool(Frame*)>& func);
+
+  /**
+   * @brief 从CLOCK指针开始遍历属于queue并且访问位为0的页帧，不修改任何状态
+   * @return func是否一直返回true
+   */
+  bool cold_scan(uint8_t queue, const std::function<bool(Frame*)>& func) const;
+
+  std::vector<Slot>    slots_;
+  std::vector<int32_t> free_slots_;
+  size_t               size_ = 0;
+  size_t               hand_ = 0;  /// CLOCK 指针
+};
+
+/**
+ * @brief CLOCK 替换策略
+ * @details 淘汰时指针在数组上循环扫描，访问位为1的页帧清除访问位给第二次机会，为0的页帧作为候选
+ */
+class ClockReplacer : public SlotReplacer {
+public:
+  virtual ~ClockReplacer() = default;
+
+  void insert(Frame* frame) override;
+  void remove(Frame* frame) override;
+  void foreach_victim(const std::function<bool(Frame*)>& func) override;
+  void foreach_cold(const std::function<bool(Frame*)>& func) const override;
+
+  const char* name() const override { return "clock"; }
+};
+
+/**
+ * @brief 2Q 替换策略
+ * @details 参考 Johnson & Shasha 的 2Q 算法，为了让命中时只设置访问位，做了如下调整：
+ * - 新页帧先进入 A1in 先进先出队列，命中只设置访问位；
+ * - 淘汰时如果 A1in 超过了它的份额，就从 A1in 的队头开始，访问过的页帧晋升到 Am，没访问过的作为候选；
+ * - Am 使用 CLOCK 管理；
+ * - 从 A1in 中淘汰的页面记录在 A1out 中(只记录FrameId)，再次被加载时直接进入 Am。
+ * 这样只访问一次的扫描页面会很快从 A1in 中被淘汰，不会冲掉 Am 中的热点页面。
+ */
+class TwoQueueReplacer : public SlotReplacer {
+public:
+  virtual ~TwoQueueReplacer() = default;
+
+  void insert(Frame* frame) override;
+  void remove(Frame* frame) override;
+  void foreach_victim(const std::function<bool(Frame*)>& func) override;
+  void foreach_cold(const std::function<bool(Frame*)>& func) const override;
+
+  const char* name() const override { return "2q"; }
+
+private:
+  enum Queue : uint8_t { A1IN = 0, AM = 1 };
+
+  struct FrameIdHash {
+    size_t operator()(const FrameId& frame_id) const { return frame_id.hash(); }
+  };
+
+  void a1in_push_back(int32_t slot);
+  void a1in_unlink(int32_t slot);
+  void remember_ghost(const FrameId& frame_id);
+
+private:
+  static constexpr int A1IN_PERCENT  = 25; /// A1in 占常驻页帧的比例
+  static constexpr int A1OUT_PERCENT = 50; /// A1out 记录的页面数占数组大小的比例
+
+  int32_t a1in_head_ = -1;
+  int32_t a1in_tail_ = -1;
+  size_t  a1in_size_ = 0;
+
+  /// A1out：按淘汰顺序记录页面，ghost_seq_ 记录每个页面最近一次进入A1out的序号，
+  /// 用来识别 ghosts_ 中已经过期的重复记录
+  std::deque<std::pair<FrameId, uint64_t>>            ghosts_;
+  std::unordered_map<FrameId, uint64_t, FrameIdHash>  ghost_seq_;
+  uint64_t                                            next_ghost_seq_ = 0;
+};
+
+} // namespace storage
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include "storage/buffer/frame.h"
+
+namespace storage {
+
+/**
+ * @brief 顺序扫描使用的私有页帧环
+ * @ingroup BufferPool
+ * @details 参考 PostgreSQL 的 ring buffer。一次全表扫描会访问大量只用一次的页面，
+ * 如果这些页面都和普通访问一样进入替换策略，就会把热点页面(比如索引页)挤出缓冲池。
+ * 使用 ScanRing 访问页面时：
+ * - 命中的页面不会在替换策略中被提升；
+ * - 需要加载新页面时，优先复用环中最老的那个页帧，扫描最多只占用环大小个页帧；
+ * - 如果环中的页面被其它非扫描的访问命中过，就认为它是共享的热点页面，不再复用。
+ *
+ * ScanRing 不是线程安全的，每个扫描(比如一个 BufferPoolIterator)使用自己的实例。
+ */
+class ScanRing {
+public:
+  static constexpr int DEFAULT_SIZE = 16;  /// 默认16个页帧，即128KB
+
+public:
+  explicit ScanRing(int size = DEFAULT_SIZE) : entries_(size > 0 ? size : DEFAULT_SIZE) {}
+  ~ScanRing() = default;
+
+  int size() const { return static_cast<int>(entries_.size()); }
+
+  /// 复用环中页帧的次数
+  uint64_t reused_count() const { return reused_count_; }
+
+  /**
+   * @brief 清空环，之前的页帧留在缓冲池中按普通页面淘汰
+   */
+  void reset() {
+    for (Entry& entry : entries_) {
+      entry = Entry();
+    }
+    next_ = 0;
+  }
+
+private:
+  friend class FrameManager;
+
+  struct Entry {
+    Frame*  frame = nullptr;
+    FrameId frame_id;
+  };
+
+  /// 下一个要被替换的位置，也就是环中最老的页帧
+  Entry& oldest() { return entries_[next_]; }
+
+  void record(Frame* frame) {
+    entries_[next_] = Entry{frame, frame->frame_id()};
+    next_ = (next_ + 1) % entries_.size();
+  }
+
+private:
+  std::vector<Entry> entries_;
+  size_t             next_         = 0;
+  uint64_t           reused_count_ = 0;
+};
+
+} // namespace storage
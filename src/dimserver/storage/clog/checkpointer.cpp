@@ -0,0 +1,173 @@
+#include <chrono>
+#include <cstring>
+#include <vector>
+
+#include "storage/clog/checkpointer.h"
+#include "storage/clog/log_handler.h"
+#include "common/log/log.h"
+
+Checkpointer::Checkpointer(LogHandler& log_handler, RecLsnSource rec_lsn_source, FlushRequest request_flush /* = nullptr */,
+    const CheckpointOptions& options /* = CheckpointOptions() */)
+  : log_handler_(log_handler),
+    rec_lsn_source_(std::move(rec_lsn_source)),
+    request_flush_(std::move(request_flush)),
+    options_(options) {}
+
+Checkpointer::~Checkpointer() {
+  stop();
+}
+
+RC Checkpointer::init(const std::string& control_file) {
+  std::lock_guard lock(checkpoint_mutex_);
+  RC rc = control_file_.open(control_file);
+  if (IS_FAIL(rc)) {
+    LOG_ERROR("Failed to open control file. filename=%s, rc=%s", control_file.c_str(), strrc(rc));
+    return rc;
+  }
+  stats_.checkpoint_lsn = control_file_.data().checkpoint_lsn;
+  stats_.redo_lsn       = control_file_.data().redo_lsn;
+  return RC::SUCCESS;
+}
+
+LSN Checkpointer::redo_lsn() const {
+  std::lock_guard lock(checkpoint_mutex_);
+  return control_file_.data().redo_lsn;
+}
+
+RC Checkpointer::start() {
+  if (options_.target_recovery_ms <= 0 || options_.replay_lsn_per_sec <= 0 || options_.check_interval_ms <= 0) {
+    LOG_ERROR("Invalid checkpoint options. target_recovery_ms=%d, replay_lsn_per_sec=%ld, check_interval_ms=%d",
+      options_.target_recovery_ms, options_.replay_lsn_per_sec, options_.check_interval_ms);
+    return RC::INVALID_ARGUMENT;
+  }
+
+  std::lock_guard lock(mutex_);
+  if (running_) {
+    LOG_ERROR("Checkpointer has already been started");
+    return RC::INTERNAL;
+  }
+
+  running_ = true;
+  thread_  = std::thread(&Checkpointer::thread_func, this);
+  LOG_INFO("checkpointer started. target_recovery_ms=%d, target_lsn_distance=%ld",
+    options_.target_recovery_ms, target_lsn_distance());
+  return RC::SUCCESS;
+}
+
+void Checkpointer::stop() {
+  {
+    std::lock_guard lock(mutex_);
+    if (!running_) {
+      return;
+    }
+    running_ = false;
+  }
+  cond_.notify_all();
+  thread_.join();
+  LOG_INFO("checkpointer stopped");
+}
+
+void Checkpointer::thread_func() {
+  std::unique_lock lock(mutex_);
+  while (running_) {
+    lock.unlock();
+    if (need_checkpoint()) {
+      RC rc = checkpoint();
+      if (IS_FAIL(rc)) {
+        LOG_WARN("Failed to do checkpoint. rc=%s", strrc(rc));
+      }
+    }
+    lock.lock();
+
+    cond_.wait_for(lock, std::chrono::milliseconds(options_.check_interval_ms), [this]() { return !running_; });
+  }
+}
+
+int64_t Checkpointer::target_lsn_distance() const {
+  return static_cast<int64_t>(options_.target_recovery_ms) * options_.replay_lsn_per_sec / 1000;
+}
+
+bool Checkpointer::need_checkpoint() const {
+  const LSN current_lsn = log_handler_.current_lsn();
+  std::lock_guard lock(checkpoint_mutex_);
+  const ControlFileData& data = control_file_.data();
+  return current_lsn > data.checkpoint_lsn && current_lsn - data.redo_lsn >= target_lsn_distance() / 2;
+}
+
+RC Checkpointer::checkpoint() {
+  std::lock_guard lock(checkpoint_mutex_);
+
+  // 先取当前LSN再找脏页：找脏页之后才标记的脏页，它的日志一定在 current_lsn 之后
+  const LSN current_lsn = log_handler_.current_lsn();
+  LSN       redo_lsn    = current_lsn + 1;
+  const LSN rec_lsn     = rec_lsn_source_ ? rec_lsn_source_() : 0;
+  if (rec_lsn < 0) {
+    // 有不知道 recLSN 的脏页，它可能依赖任何一条日志，等它刷盘之后再推进恢复起点
+    stats_.flush_requests++;
+    LOG_INFO("dirty page without rec lsn, keep redo lsn. redo_lsn=%ld, current_lsn=%ld",
+        control_file_.data().redo_lsn, current_lsn);
+    if (request_flush_) {
+      request_flush_();
+    }
+    return RC::SUCCESS;
+  }
+  if (rec_lsn > 0 && rec_lsn < redo_lsn) {
+    redo_lsn = rec_lsn;
+  }
+  // 恢复起点不能越过已经落盘的日志，否则写到控制文件和回收日志时会跳过还需要的日志
+  const LSN flushed_lsn = log_handler_.flushed_lsn();
+  if (redo_lsn > flushed_lsn + 1) {
+    redo_lsn = flushed_lsn + 1;
+  }
+
+  const ControlFileData& last = control_file_.data();
+  if (last.checkpoint_lsn > 0 && redo_lsn == last.redo_lsn) {
+    LOG_DEBUG("redo lsn does not move, skip checkpoint. redo_lsn=%ld", redo_lsn);
+  } else {
+    std::vector<char> data(sizeof(redo_lsn));
+    memcpy(data.data(), &redo_lsn, sizeof(redo_lsn));
+    LSN checkpoint_lsn = 0;
+    RC  rc             = log_handler_.append(checkpoint_lsn, LogModule::Id::CHECKPOINT, std::move(data));
+    if (IS_SUCC(rc)) {
+      rc = log_handler_.wait_lsn(checkpoint_lsn);
+    }
+    if (IS_FAIL(rc)) {
+      LOG_ERROR("Failed to write checkpoint log. redo_lsn=%ld, rc=%s", redo_lsn, strrc(rc));
+      return rc;
+    }
+
+    ControlFileData new_data;
+    new_data.checkpoint_lsn = checkpoint_lsn;
+    new_data.redo_lsn       = redo_lsn;
+    rc = control_file_.write(new_data);
+    if (IS_FAIL(rc)) {
+      LOG_ERROR("Failed to write control file. checkpoint_lsn=%ld, redo_lsn=%ld, rc=%s",
+          checkpoint_lsn, redo_lsn, strrc(rc));
+      return rc;
+    }
+
+    stats_.checkpoints++;
+    stats_.checkpoint_lsn = checkpoint_lsn;
+    stats_.redo_lsn       = redo_lsn;
+    LOG_INFO("checkpoint done. checkpoint_lsn=%ld, redo_lsn=%ld, current_lsn=%ld", checkpoint_lsn, redo_lsn, current_lsn);
+
+    // 控制文件已经落盘，redo_lsn 之前的日志不会再用到了
+    rc = log_handler_.recycle(redo_lsn);
+    if (IS_FAIL(rc)) {
+      LOG_WARN("Failed to recycle log. redo_lsn=%ld, rc=%s", redo_lsn, strrc(rc));
+    }
+  }
+
+  // 恢复起点被旧的脏页拖住，恢复时间会超过目标
+  if (request_flush_ && current_lsn - redo_lsn >= target_lsn_distance()) {
+    stats_.flush_requests++;
+    LOG_INFO("dirty pages are too old, request flush. redo_lsn=%ld, current_lsn=%ld", redo_lsn, current_lsn);
+    request_flush_();
+  }
+  return RC::SUCCESS;
+}
+
+CheckpointStats Checkpointer::stats() const {
+  std::lock_guard lock(checkpoint_mutex_);
+  return stats_;
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <mutex>
+#include <thread>
+#include <functional>
+#include <condition_variable>
+
+#include "common/rc.h"
+#include "common/types.h"
+#include "storage/clog/control_file.h"
+
+class LogHandler;
+
+/**
+ * @brief 检查点的配置
+ */
+struct CheckpointOptions {
+  int     target_recovery_ms = 30000;   /// 期望的最长恢复时间
+  int64_t replay_lsn_per_sec = 200000;  /// 恢复时每秒能回放多少条日志，用来把恢复时间换算成日志条数
+  int     check_interval_ms  = 1000;    /// 后台线程多久检查一次是否需要做检查点
+};
+
+/**
+ * @brief 检查点的统计
+ */
+struct CheckpointStats {
+  uint64_t checkpoints    = 0;  /// 一共做了多少次检查点
+  uint64_t flush_requests = 0;  /// 脏页太旧，检查点推进不了恢复起点，请求刷脏页的次数
+  LSN      checkpoint_lsn = 0;  /// 最近一次检查点日志的LSN
+  LSN      redo_lsn       = 0;  /// 最近一次检查点记录的恢复起点
+};
+
+/**
+ * @brief 模糊检查点(fuzzy checkpoint)
+ * @ingroup CLog
+ * @details 不刷脏页，也不阻塞对页面的修改，只记录恢复时可以从哪里开始回放：
+ * 1. 先取当前的LSN，再取所有脏页中最小的 recLSN(参考 Frame::mark_dirty(LSN))，
+ *    两者中较小的就是恢复起点 redo_lsn，它之前的修改都已经在数据文件中了。
+ *    redo_lsn 不超过已经落盘的日志之后的第一个LSN(LogHandler::flushed_lsn() + 1)；
+ * 2. 通过 LogHandler 写一条检查点日志(LogModule::Id::CHECKPOINT)并等它落盘；
+ * 3. 把检查点日志的LSN和 redo_lsn 写到控制文件(ControlFile)中；
+ * 4. 控制文件落盘之后调用 LogHandler::recycle 回收 redo_lsn 之前的日志文件。
+ * 重启时先读控制文件，从 redo_lsn 开始回放，参考 redo_lsn()。
+ *
+ * 恢复时间大致是 redo_lsn 之后的日志条数除以回放速度。后台线程在日志增长了目标恢复时间一半
+ * 对应的条数时做一次检查点，这样恢复起点能够跟上的时候恢复时间不会超过目标。
+ * 恢复起点被很旧的脏页拖住时，检查点也推进不了它，这时调用 request_flush(比如 PageCleaner::wakeup)
+ * 让后台尽快刷脏页。
+ */
+class Checkpointer {
+public:
+  /// 所有脏页中最小的 recLSN，比如 BufferPoolManager::min_rec_lsn，没有脏页时返回0，
+  /// 有脏页不知道 recLSN 时返回负数，这时不推进恢复起点
+  using RecLsnSource = std::function<LSN()>;
+  /// 请求后台尽快刷脏页
+  using FlushRequest = std::function<void()>;
+
+public:
+  Checkpointer(LogHandler& log_handler, RecLsnSource rec_lsn_source, FlushRequest request_flush = nullptr,
+      const CheckpointOptions& options = CheckpointOptions());
+  ~Checkpointer();
+
+  /**
+   * @brief 读取控制文件
+   * @param control_file 控制文件名，一般和日志文件放在同一个目录
+   */
+  RC init(const std::string& control_file);
+
+  /**
+   * @brief 恢复时从这个LSN开始回放，LogHandler::replay 的 start_lsn
+   */
+  LSN redo_lsn() const;
+
+  RC   start();
+  void stop();
+
+  /**
+   * @brief 马上做一次检查点
+   */
+  RC checkpoint();
+
+  /**
+   * @brief 当前的日志是否已经多到需要做检查点了
+   */
+  bool need_checkpoint() const;
+
+  /**
+   * @brief 目标恢复时间换算成的日志条数
+   */
+  int64_t target_lsn_distance() const;
+
+  CheckpointStats          stats() const;
+  const CheckpointOptions& options() const { return options_; }
+
+private:
+  void thread_func();
+
+private:
+  LogHandler&       log_handler_;
+  RecLsnSource      rec_lsn_source_;
+  FlushRequest      request_flush_;
+  CheckpointOptions options_;
+
+  mutable std::mutex checkpoint_mutex_;  /// 保护 control_file_ 和 stats_，同时只做一个检查点
+  ControlFile        control_file_;
+  CheckpointStats    stats_;
+
+  std::thread             thread_;
+  std::mutex              mutex_;
+  std::condition_variable cond_;
+  bool                    running_ = false;
+};
@@ -0,0 +1,107 @@
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <cstddef>
+#include <filesystem>
+
+#include "storage/clog/control_file.h"
+#include "common/io/io.h"
+#include "common/log/log.h"
+#include "common/math/crc.h"
+
+static constexpr uint32_t CONTROL_FILE_MAGIC   = 0x4C544E43U;  // "CNTL"
+static constexpr uint32_t CONTROL_FILE_VERSION = 1;
+
+/**
+ * @brief 控制文件在磁盘上的格式
+ */
+struct ControlFileHeader final {
+  uint32_t magic;
+  uint32_t version;
+  LSN      checkpoint_lsn;
+  LSN      redo_lsn;
+  uint32_t check_sum;  // 前面所有字段的 CRC32C
+  uint32_t reserved;
+
+  uint32_t calc_check_sum() const { return crc32c(this, offsetof(ControlFileHeader, check_sum)); }
+};
+
+RC ControlFile::open(const std::string& filename) {
+  filename_ = filename;
+  data_     = ControlFileData();
+
+  int fd = ::open(filename.c_str(), O_RDONLY);
+  if (fd < 0) {
+    if (errno == ENOENT) {
+      LOG_INFO("control file does not exist, no checkpoint yet. filename=%s", filename.c_str());
+      return RC::SUCCESS;
+    }
+    LOG_ERROR("failed to open control file. filename=%s, errno=%d, error=%s", filename.c_str(), errno, strerror(errno));
+    return RC::IOERR_READ;
+  }
+
+  ControlFileHeader header;
+  int ret = readn(fd, &header, sizeof(header));
+  ::close(fd);
+  if (ret != 0) {
+    LOG_ERROR("failed to read control file. filename=%s, ret=%d", filename.c_str(), ret);
+    return RC::FILE_CORRUPTED;
+  }
+  if (header.magic != CONTROL_FILE_MAGIC || header.version != CONTROL_FILE_VERSION ||
+      header.check_sum != header.calc_check_sum()) {
+    LOG_ERROR("control file is corrupted. filename=%s, magic=%x, version=%u", filename.c_str(), header.magic, header.version);
+    return RC::FILE_CORRUPTED;
+  }
+
+  data_.checkpoint_lsn = header.checkpoint_lsn;
+  data_.redo_lsn       = header.redo_lsn;
+  LOG_INFO("load control file. filename=%s, checkpoint_lsn=%ld, redo_lsn=%ld",
+      filename.c_str(), data_.checkpoint_lsn, data_.redo_lsn);
+  return RC::SUCCESS;
+}
+
+RC ControlFile::write(const ControlFileData& data) {
+  ControlFileHeader header;
+  memset(&header, 0, sizeof(header));
+  header.magic          = CONTROL_FILE_MAGIC;
+  header.version        = CONTROL_FILE_VERSION;
+  header.checkpoint_lsn = data.checkpoint_lsn;
+  header.redo_lsn       = data.redo_lsn;
+  header.check_sum      = header.calc_check_sum();
+
+  const std::string tmp_file = filename_ + ".tmp";
+  int fd = ::open(tmp_file.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    LOG_ERROR("failed to create control file. filename=%s, errno=%d, error=%s", tmp_file.c_str(), errno, strerror(errno));
+    return RC::FILE_CREATE_ERR;
+  }
+  int ret = writen(fd, &header, sizeof(header));
+  if (ret == 0 && ::fdatasync(fd) != 0) {
+    ret = errno;
+  }
+  ::close(fd);
+  if (ret != 0 || ::rename(tmp_file.c_str(), filename_.c_str()) != 0) {
+    LOG_ERROR("failed to write control file. filename=%s, ret=%d, errno=%d, error=%s",
+        filename_.c_str(), ret, errno, strerror(errno));
+    ::unlink(tmp_file.c_str());
+    return RC::IOERR_WRITE;
+  }
+
+  // 改名也要落盘，否则回收了旧的日志之后，崩溃恢复时可能还是读到旧的控制文件
+  std::string dir = std::filesystem::path(filename_).parent_path().string();
+  if (dir.empty()) {
+    dir = ".";
+  }
+  fd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY);
+  if (fd < 0 || ::fsync(fd) != 0) {
+    LOG_ERROR("failed to sync control file directory. dir=%s, errno=%d, error=%s", dir.c_str(), errno, strerror(errno));
+    if (fd >= 0) {
+      ::close(fd);
+    }
+    return RC::IOERR_SYNC;
+  }
+  ::close(fd);
+
+  data_ = data;
+  return RC::SUCCESS;
+}
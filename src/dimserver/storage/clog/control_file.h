@@ -0,0 +1,45 @@
+#pragma once
+
+#include <string>
+
+#include "common/rc.h"
+#include "common/types.h"
+
+/**
+ * @brief 控制文件中记录的内容
+ */
+struct ControlFileData {
+  LSN checkpoint_lsn = 0;  /// 最近一次检查点日志的LSN，0表示还没有做过检查点
+  LSN redo_lsn       = 0;  /// 恢复时从这个LSN开始回放，它之前的修改都已经在数据文件中了
+};
+
+/**
+ * @brief 控制文件，记录最近一次检查点，恢复时从这里找到回放的起点
+ * @details 文件很小，每次检查点整个重写：先写临时文件并落盘，再改名覆盖，最后把目录落盘。
+ * 文件中带有 CRC32C 校验，要么读到完整的旧内容，要么读到完整的新内容。
+ * @ingroup CLog
+ */
+class ControlFile {
+public:
+  ControlFile()  = default;
+  ~ControlFile() = default;
+
+  /**
+   * @brief 读取控制文件
+   * @details 文件不存在时当作还没有做过检查点，data() 都是0。文件损坏时返回 FILE_CORRUPTED
+   * @param filename 控制文件名
+   */
+  RC open(const std::string& filename);
+
+  /**
+   * @brief 持久化新的内容，返回成功时已经落盘
+   */
+  RC write(const ControlFileData& data);
+
+  const ControlFileData& data() const { return data_; }
+  const std::string&     filename() const { return filename_; }
+
+private:
+  std::string     filename_;
+  ControlFileData data_;
+};
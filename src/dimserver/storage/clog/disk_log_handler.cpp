@@ -0,0 +1,289 @@
+#include <string.h>
+#include <unistd.h>
+#include <algorithm>
+
+#include "storage/clog/disk_log_handler.h"
+#include "storage/clog/log_entry.h"
+#include "storage/clog/log_replayer.h"
+#include "storage/clog/parallel_log_replayer.h"
+#include "common/log/log.h"
+
+DiskLogHandler::~DiskLogHandler() {
+  stop();
+  await_termination();
+}
+
+RC DiskLogHandler::init(const std::string& dir) {
+  return init(dir, DEFAULT_MAX_ENTRIES_PER_FILE);
+}
+
+RC DiskLogHandler::init(const std::string& dir, int max_entries_per_file,
+    int64_t segment_size /* = LogFileManager::DEFAULT_SEGMENT_SIZE */) {
+  RC rc = file_manager_.init(dir, max_entries_per_file, segment_size);
+  if (IS_FAIL(rc)) {
+    LOG_ERROR("Failed to init log file manager. dir=%s, rc=%s", dir.c_str(), strrc(rc));
+    return rc;
+  }
+
+  LSN last_lsn = 0;
+  rc = find_last_lsn(last_lsn);
+  if (IS_FAIL(rc)) {
+    LOG_ERROR("Failed to find the last lsn. dir=%s, rc=%s", dir.c_str(), strrc(rc));
+    return rc;
+  }
+
+  rc = log_buffer_.init(last_lsn);
+  if (IS_FAIL(rc)) {
+    LOG_ERROR("Failed to init log buffer. rc=%s", strrc(rc));
+    return rc;
+  }
+
+  io_engine_ = common::AsyncIoEngine::create(io_backend_, 1, 1);
+  writer_.set_io_engine(io_engine_.get());
+
+  // 继续写最后一个文件，它已经写满或者没有日志文件时创建新文件
+  rc = file_manager_.last_file(writer_);
+  if (IS_SUCC(rc) && last_lsn + 1 >= writer_.end_lsn()) {
+    rc = file_manager_.next_file(writer_);
+  } else if (rc == RC::FILE_NOT_FOUND) {
+    rc = file_manager_.next_file(writer_);
+  }
+  if (IS_FAIL(rc)) {
+    LOG_ERROR("Failed to open log file. dir=%s, rc=%s", dir.c_str(), strrc(rc));
+    return rc;
+  }
+
+  LOG_INFO("disk log handler initialized. dir=%s, last_lsn=%ld, file=%s",
+      dir.c_str(), last_lsn, writer_.to_string().c_str());
+  return RC::SUCCESS;
+}
+
+RC DiskLogHandler::find_last_lsn(LSN& last_lsn) {
+  last_lsn = 0;
+
+  std::vector<std::string> files;
+  RC rc = file_manager_.list_files(files, 0);
+  if (IS_FAIL(rc) || files.empty()) {
+    return rc;
+  }
+
+  // 最后一个文件可能是刚创建还没有写入的，继续往前找
+  for (auto iter = files.rbegin(); iter != files.rend() && last_lsn == 0; ++iter) {
+    LogFileReader reader;
+    rc = reader.open(*iter, LogFileReader::Mode::MMAP);
+    if (IS_FAIL(rc)) {
+      return rc;
+    }
+    rc = reader.iterate([&last_lsn](LogEntry& entry) {
+      last_lsn = std::max(last_lsn, entry.lsn());
+      return RC::SUCCESS;
+    });
+    reader.close();
+    if (IS_FAIL(rc)) {
+      return rc;
+    }
+  }
+  return RC::SUCCESS;
+}
+
+RC DiskLogHandler::start() {
+  if (running_.exchange(true)) {
+    LOG_WARN("disk log handler has already been started");
+    return RC::INTERNAL;
+  }
+
+  thread_ = std::make_unique<std::thread>(&DiskLogHandler::thread_func, this);
+  LOG_INFO("disk log handler started");
+  return RC::SUCCESS;
+}
+
+RC DiskLogHandler::stop() {
+  if (running_.exchange(false)) {
+    log_buffer_.request_flush();
+    LOG_INFO("disk log handler stopping");
+  }
+  return RC::SUCCESS;
+}
+
+RC DiskLogHandler::await_termination() {
+  if (thread_ != nullptr) {
+    thread_->join();
+    thread_.reset();
+  }
+
+  // 刷盘线程退出之后追加的日志也要落盘
+  RC rc = flush();
+  if (IS_FAIL(rc)) {
+    LOG_WARN("Failed to flush log buffer when terminating. rc=%s", strrc(rc));
+  }
+  return rc;
+}
+
+void DiskLogHandler::thread_func() {
+  LOG_INFO("log flush thread started");
+  while (running_.load()) {
+    log_buffer_.wait_flush_request(FLUSH_INTERVAL_MS);
+
+    const LSN flushed_lsn = log_buffer_.flushed_lsn();
+    RC rc = flush();
+    if (IS_FAIL(rc)) {
+      LOG_WARN("Failed to flush log buffer. rc=%s", strrc(rc));
+      // 在 wait_lsn 中等待的线程拿到这个错误返回，不会一直等下去
+      log_buffer_.report_flush_error(rc);
+    }
+
+    // 没有日志要写时准备空闲文件，不影响等待刷盘的线程
+    if (IS_SUCC(rc) && flushed_lsn == log_buffer_.flushed_lsn()) {
+      std::lock_guard<std::mutex> lock(writer_mutex_);
+      rc = file_manager_.prepare_file(PREPARE_BYTES_PER_ROUND);
+      if (IS_FAIL(rc)) {
+        LOG_WARN("Failed to prepare free log file. rc=%s", strrc(rc));
+      }
+    }
+  }
+
+  RC rc = flush();
+  if (IS_FAIL(rc)) {
+    LOG_WARN("Failed to flush log buffer. rc=%s", strrc(rc));
+  }
+  LOG_INFO("log flush thread stopped");
+}
+
+RC DiskLogHandler::flush() {
+  std::lock_guard<std::mutex> lock(writer_mutex_);
+  if (!writer_.is_open()) {
+    return RC::SUCCESS;
+  }
+
+  RC rc = log_buffer_.flush(writer_);
+  while (rc == RC::FILE_FULL) {
+    rc = file_manager_.next_file(writer_);
+    if (IS_FAIL(rc)) {
+      LOG_ERROR("Failed to open next log file. rc=%s", strrc(rc));
+      return rc;
+    }
+    LOG_INFO("switch to next log file. file=%s", writer_.to_string().c_str());
+    rc = log_buffer_.flush(writer_);
+  }
+  return rc;
+}
+
+RC DiskLogHandler::wait_lsn(LSN lsn) {
+  if (lsn > log_buffer_.current_lsn()) {
+    LOG_WARN("invalid lsn to wait. lsn=%ld, current_lsn=%ld", lsn, log_buffer_.current_lsn());
+    return RC::INVALID_ARGUMENT;
+  }
+
+  if (running_.load()) {
+    return log_buffer_.wait_flushed(lsn);
+  }
+
+  // 没有刷盘线程，自己组提交。lsn 之前有预留了还没有发布的日志时，在 group_commit 中等它发布，不会空转
+  std::lock_guard<std::mutex> lock(writer_mutex_);
+  if (!writer_.is_open()) {
+    return log_buffer_.flushed_lsn() >= lsn ? RC::SUCCESS : RC::FILE_NOT_OPEN;
+  }
+
+  RC rc = log_buffer_.group_commit(writer_, lsn);
+  while (rc == RC::FILE_FULL) {
+    rc = file_manager_.next_file(writer_);
+    if (IS_FAIL(rc)) {
+      LOG_ERROR("Failed to open next log file. rc=%s", strrc(rc));
+      return rc;
+    }
+    LOG_INFO("switch to next log file. file=%s", writer_.to_string().c_str());
+    rc = log_buffer_.group_commit(writer_, lsn);
+  }
+  return rc;
+}
+
+RC DiskLogHandler::recycle(LSN lsn) {
+  std::lock_guard<std::mutex> lock(writer_mutex_);
+  RC rc = file_manager_.recycle_files(lsn);
+  if (IS_FAIL(rc)) {
+    LOG_WARN("Failed to recycle log files. lsn=%ld, rc=%s", lsn, strrc(rc));
+  }
+  return rc;
+}
+
+RC DiskLogHandler::_append(LSN& lsn, LogModule module, std::vector<char>&& data) {
+  return log_buffer_.append(lsn, module, std::move(data));
+}
+
+RC DiskLogHandler::iterate(std::function<RC(LogEntry&)> consumer, LSN start_lsn) {
+  return iterate(std::move(consumer), start_lsn, nullptr);
+}
+
+RC DiskLogHandler::iterate(
+    std::function<RC(LogEntry&)> consumer, LSN start_lsn, const std::function<RC()>& before_close) {
+  std::vector<std::string> files;
+  RC rc = file_manager_.list_files(files, start_lsn);
+  if (IS_FAIL(rc)) {
+    LOG_ERROR("Failed to list log files. rc=%s", strrc(rc));
+    return rc;
+  }
+
+  for (size_t i = 0; i < files.size(); i++) {
+    const std::string& file = files[i];
+    LogFileReader      reader;
+    rc = reader.open(file, LogFileReader::Mode::MMAP);
+    if (IS_FAIL(rc)) {
+      LOG_ERROR("Failed to open log file. file=%s, rc=%s", file.c_str(), strrc(rc));
+      return rc;
+    }
+
+    rc = reader.iterate(consumer, start_lsn);
+    // 遍历失败也要调用，保证关闭文件时没有人还在使用它
+    if (before_close) {
+      RC close_rc = before_close();
+      rc = IS_SUCC(rc) ? close_rc : rc;
+    }
+    const bool torn = reader.torn();
+    reader.close();
+    if (IS_FAIL(rc)) {
+      LOG_ERROR("Failed to iterate log file. file=%s, rc=%s", file.c_str(), strrc(rc));
+      return rc;
+    }
+
+    // 只有最后一个文件的末尾可能是写了一半的日志，其它文件中出现损坏说明日志不完整了
+    if (torn) {
+      if (i + 1 < files.size()) {
+        LOG_ERROR("log file is corrupted before the last file. file=%s", file.c_str());
+        return RC::FILE_CORRUPTED;
+      }
+      break;
+    }
+  }
+  return RC::SUCCESS;
+}
+
+RC DiskLogHandler::replay(LogReplayer& replayer, LSN start_lsn) {
+  ParallelLogReplayer parallel_replayer(replayer, replay_threads_);
+  RC rc = parallel_replayer.start();
+  if (IS_FAIL(rc)) {
+    return rc;
+  }
+
+  // 日志是指向 mmap 文件的视图，关闭文件之前等它们回放完
+  rc = iterate(
+      [&parallel_replayer](LogEntry& entry) {
+        if (entry.module().id() == LogModule::Id::CHECKPOINT) {
+          return RC::SUCCESS;
+        }
+        return parallel_replayer.dispatch(std::move(entry));
+      },
+      start_lsn, [&parallel_replayer]() { return parallel_replayer.drain(); });
+  if (IS_FAIL(rc)) {
+    LOG_ERROR("Failed to replay log. start_lsn=%ld, rc=%s", start_lsn, strrc(rc));
+    return rc;
+  }
+
+  rc = parallel_replayer.on_done();
+  if (IS_FAIL(rc)) {
+    LOG_ERROR("Failed to finish replaying log. rc=%s", strrc(rc));
+    return rc;
+  }
+  LOG_INFO("replay log done. start_lsn=%ld, current_lsn=%ld, threads=%d, barriers=%lu",
+      start_lsn, current_lsn(), parallel_replayer.thread_num(), parallel_replayer.barrier_count());
+  return RC::SUCCESS;
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "common/io/async_io.h"
+#include "storage/clog/log_handler.h"
+#include "storage/clog/log_buffer.h"
+#include "storage/clog/log_file.h"
+
+/**
+ * @brief 磁盘日志处理器
+ * @details 日志先追加到 LogBuffer，由一个专门的刷盘线程写到 LogFileManager 管理的日志文件中：
+ * - 刷盘线程在 LogBuffer 的刷盘请求上等待，有线程在 wait_lsn 中等待、缓冲区达到刷盘阈值
+ *   或者超时(FLUSH_INTERVAL_MS)时，把缓冲区中已经发布的日志一次写入并落盘；
+ * - 当前文件写满(LSN达到文件的结束LSN)时通过 LogFileManager::next_file 切换到下一个文件；
+ * - wait_lsn 返回时 lsn 及之前的日志都已经落盘，并发等待的线程共用一次落盘。刷盘线程刷盘失败时，
+ *   等待的线程返回这个错误(参考 LogBuffer::report_flush_error)。
+ *
+ * 启动时从最后一个日志文件中找到最大的LSN，新的日志从它之后开始编号。崩溃时最后一个文件的末尾
+ * 可能有写了一半的日志，通过日志头中的 check_sum 识别出来，打开文件时在它的位置写上结束标记。
+ * 日志文件是预分配的(LogFileManager 的 segment_size)，使用 O_DSYNC 写入，写入通过 common::AsyncIoEngine 提交。刷盘线程空闲时
+ * 准备写过0的空闲文件，检查点之后通过 recycle 把不再需要的文件放回空闲文件池。
+ * 没有启动刷盘线程时 wait_lsn 通过 LogBuffer::group_commit 自己刷盘，会等待它之前还没有发布的日志。
+ * 读日志时使用 mmap 方式的 LogFileReader，日志不复制，通过稀疏索引定位起始LSN。
+ * 超过压缩阈值的日志追加时用 LZ4 压缩，读日志时自动解压。
+ * 回放时当前线程读日志，通过 ParallelLogReplayer 按 LogReplayer::partition 分发给多个线程回放，
+ * 每个文件回放完成之后再关闭它。检查点日志(LogModule::Id::CHECKPOINT)是给日志系统自己用的，不交给回放器。
+ *
+ * @ingroup CLog
+ */
+class DiskLogHandler : public LogHandler
+{
+public:
+  static constexpr int FLUSH_INTERVAL_MS              = 10;       /// 没有刷盘请求时的刷盘间隔
+  static constexpr int DEFAULT_MAX_ENTRIES_PER_FILE   = 1000000;  /// 每个日志文件最多多少条日志
+  static constexpr int64_t PREPARE_BYTES_PER_ROUND    = 1024 * 1024;  /// 刷盘线程空闲时每次准备空闲文件写多少字节
+
+public:
+  DiskLogHandler()          = default;
+  virtual ~DiskLogHandler();
+
+  RC init(const std::string& dir) override;
+
+  /**
+   * @brief 初始化
+   * @param dir 日志文件目录
+   * @param max_entries_per_file 每个日志文件最多多少条日志
+   * @param segment_size 日志文件预分配的大小，0表示不预分配
+   */
+  RC init(const std::string& dir, int max_entries_per_file,
+      int64_t segment_size = LogFileManager::DEFAULT_SEGMENT_SIZE);
+
+  RC start() override;
+  RC stop() override;
+  RC await_termination() override;
+
+  RC replay(LogReplayer& replayer, LSN start_lsn) override;
+  RC iterate(std::function<RC(LogEntry&)> consumer, LSN start_lsn) override;
+
+  RC wait_lsn(LSN lsn) override;
+
+  /**
+   * @brief 回收LSN全部小于 lsn 的日志文件，参考 LogFileManager::recycle_files
+   */
+  RC recycle(LSN lsn) override;
+
+  LSN current_lsn() const override { return log_buffer_.current_lsn(); }
+  LSN flushed_lsn() const override { return log_buffer_.flushed_lsn(); }
+
+  /**
+   * @brief 设置回放日志的线程数，不大于1时在调用 replay 的线程中串行回放
+   */
+  void set_replay_threads(int thread_num) { replay_threads_ = thread_num; }
+  int  replay_threads() const { return replay_threads_; }
+
+  /**
+   * @brief 设置压缩日志的阈值，参考 LogBuffer::set_compress_threshold
+   */
+  void set_compress_threshold(int32_t threshold) { log_buffer_.set_compress_threshold(threshold); }
+
+  /**
+   * @brief 设置写日志文件的异步IO实现方式，需要在 init 之前设置，参考 common::AsyncIoEngine::create
+   */
+  void set_io_backend(common::AsyncIoBackend backend) { io_backend_ = backend; }
+  common::AsyncIoBackend io_backend() const { return io_engine_ ? io_engine_->backend() : io_backend_; }
+
+  const LogBuffer& log_buffer() const { return log_buffer_; }
+
+private:
+  RC _append(LSN& lsn, LogModule module, std::vector<char>&& data) override;
+
+  void thread_func();
+
+  /**
+   * @brief 把缓冲区中已经发布的日志写入文件并落盘，文件写满时切换到下一个文件
+   * @details 持有 writer_mutex_，刷盘线程调用
+   */
+  RC flush();
+
+  /**
+   * @brief 从最后一个日志文件中找到最大的LSN
+   */
+  RC find_last_lsn(LSN& last_lsn);
+
+  /**
+   * @brief 遍历日志
+   * @param before_close 每个文件遍历完、关闭之前调用，可以为空
+   */
+  RC iterate(std::function<RC(LogEntry&)> consumer, LSN start_lsn, const std::function<RC()>& before_close);
+
+private:
+  LogFileManager file_manager_;
+  LogBuffer      log_buffer_;
+
+  /// writer_ 写文件使用，同样由 writer_mutex_ 保护。日志是顺序写的，同时只有一个请求。
+  /// 放在 writer_ 前面，writer_ 析构关闭文件时还会用到
+  common::AsyncIoBackend                 io_backend_ = common::AsyncIoBackend::AUTO;
+  std::unique_ptr<common::AsyncIoEngine> io_engine_;
+
+  std::mutex    writer_mutex_;  /// 保护 writer_ 和 file_manager_
+  LogFileWriter writer_;
+
+  std::unique_ptr<std::thread> thread_;
+  std::atomic<bool>            running_{false};
+
+  int replay_threads_ = static_cast<int>(std::thread::hardware_concurrency());
+};
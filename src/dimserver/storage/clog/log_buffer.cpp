@@ -1,6 +1,8 @@
 #include <string.h>
+#include <sys/uio.h>
+#include <algorithm>
 #include <chrono>
-#include <thread>
+#include <cstdint>
 #include <sstream>
 
 #include "storage/clog/log_buffer.h"
@@ -8,117 +10,389 @@
 #include "common/log/log.h"
 
 RC LogBuffer::init(LSN lsn, int32_t max_bytes /* = 0 */) {
-	current_lsn_.store(lsn);
-	flushed_lsn_.store(lsn);
-
 	if (max_bytes > 0) {
 		max_bytes_ = max_bytes;
 	}
+	if (max_bytes_ > MAX_BYTES) {
+		LOG_WARN("log buffer is too large, use the max size. max_bytes=%zu, limit=%zu", max_bytes_, MAX_BYTES);
+		max_bytes_ = MAX_BYTES;
+	}
+
+	capacity_ = 1;
+	while (capacity_ < max_bytes_) {
+		capacity_ <<= 1;
+	}
+	ring_.reset(new char[capacity_]);
+	done_.reset(new std::atomic<LSN>[DONE_NUM]);
+	for (size_t i = 0; i < DONE_NUM; i++) {
+		done_[i].store(0, std::memory_order_relaxed);
+	}
+
+	init_lsn_ = lsn;
+	reserve_.store(static_cast<uint64_t>(lsn) << POS_BITS);
+	released_pos_.store(0);
+	flushed_lsn_.store(lsn);
 	return RC::SUCCESS;
 }
 
 RC LogBuffer::append(LogEntry&& entry) {
-	while (current_bytes_.load() >= max_bytes_) {
-		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	LSN lsn = 0;
+	RC rc = append(lsn, entry.module(), entry.data(), entry.payload_size());
+	if (IS_SUCC(rc)) {
+		entry.set_lsn(lsn);
 	}
+	return rc;
+}
 
-	std::lock_guard<std::mutex> lock(mutex_);
-	// 更新LSN和统计信息
-	entry.set_lsn(++current_lsn_);
+RC LogBuffer::append(LSN& lsn, LogModule::Id module_id, std::vector<char>&& data) {
+	return append(lsn, LogModule(module_id), std::move(data));
+}
+
+RC LogBuffer::append(LSN& lsn, LogModule module, std::vector<char>&& data) {
+	if (data.size() > static_cast<size_t>(LogEntry::max_payload_size())) {
+		LOG_DEBUG("log entry data size(%zu) is too large", data.size());
+		return RC::MESSAGE_INVAID;
+	}
+	return append(lsn, module, data.data(), static_cast<int32_t>(data.size()));
+}
+
+RC LogBuffer::append(LSN& lsn, LogModule module, const char* data, int32_t size) {
+	if (size < 0 || size > LogEntry::max_payload_size()) {
+		LOG_DEBUG("log entry data size(%d) is invalid", size);
+		return RC::MESSAGE_INVAID;
+	}
+	if (ring_ == nullptr) {
+		LOG_ERROR("log buffer is not initialized");
+		return RC::INTERNAL;
+	}
+	if (RC error = io_error(); IS_FAIL(error)) {
+		return error;
+	}
+
+	// 大的日志先压缩，缓冲区中预留和写入文件的都是压缩之后的数据
+	thread_local std::vector<char> compressed;
+	uint8_t flags = 0;
+	if (compress_threshold_ > 0 && size >= compress_threshold_) {
+		const int32_t compressed_size = LogEntry::compress_payload(data, size, compressed);
+		if (compressed_size > 0) {
+			compressed_entries_.fetch_add(1, std::memory_order_relaxed);
+			compress_saved_bytes_.fetch_add(size - compressed_size, std::memory_order_relaxed);
+			data  = compressed.data();
+			size  = compressed_size;
+			flags = LogHeader::FLAG_COMPRESSED;
+		}
+	}
+
+	const uint64_t total_size = LogHeader::HEAD_SIZE + static_cast<uint64_t>(size);
+	if (total_size > max_bytes_) {
+		LOG_WARN("log entry is larger than log buffer. size=%lu, max_bytes=%zu", total_size, max_bytes_);
+		return RC::MESSAGE_INVAID;
+	}
+
+	// 预留：同时分配LSN和缓冲区中的位置
+	const uint64_t reserve = reserve_.fetch_add((1ULL << POS_BITS) + total_size, std::memory_order_acq_rel);
+	uint64_t start = 0;
+	LSN      last_lsn = 0;
+	// 自己的日志还没有发布，刷盘推进不到它之后，这时再读参考值也不会超过 reserve
+	decode_reserve(reserve, released_pos_.load(std::memory_order_acquire), flushed_lsn_.load(std::memory_order_acquire),
+		start, last_lsn);
+	lsn = last_lsn + 1;
+
+	const uint64_t end = start + total_size;
+	RC rc = wait_for_space(end, lsn);
+	if (IS_FAIL(rc)) {
+		// 不会再刷盘，预留的LSN也不需要发布
+		return rc;
+	}
+
+	// 拷贝：直接序列化到缓冲区中
+	LogHeader header;
+	header.lsn       = lsn;
+	header.data_size = size;
+	header.module_id = static_cast<int32_t>(module.index());
+	header.flags     = flags;
+	header.seal(data);
+	copy_in(start, &header, LogHeader::HEAD_SIZE);
+	copy_in(start + LogHeader::HEAD_SIZE, data, size);
 
-	// 添加日志条目
-	entries_.push_back(std::move(entry));
-	current_bytes_ += entries_.back().total_size();
-	total_appends_++;
+	// 发布：刷盘的线程看到完成标记时一定能看到拷贝的数据
+	done_[lsn & (DONE_NUM - 1)].store(lsn, std::memory_order_release);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (publish_waiters_.load(std::memory_order_relaxed) > 0) {
+		std::lock_guard<std::mutex> lock(mutex_);
+		flushed_cv_.notify_all();
+	}
 
-	// 检查是否需要触发刷盘
 	if (should_flush()) {
 		try_notify_flush();
 	}
-
 	return RC::SUCCESS;
 }
 
-RC LogBuffer::append(LSN& lsn, LogModule::Id module_id, std::vector<char>&& data) {
-	return append(lsn, LogModule(module_id), std::move(data));
+void LogBuffer::decode_reserve(uint64_t reserve, uint64_t released, LSN flushed, uint64_t& pos, LSN& lsn) {
+	// 参考值都不大于 reserve 中的值，并且差距远小于各自的位数能表示的范围
+	pos = released + ((reserve - released) & POS_MASK);
+	const uint64_t lsn_low = (reserve - pos) >> POS_BITS;
+	lsn = flushed + static_cast<LSN>((lsn_low - static_cast<uint64_t>(flushed)) & LSN_MASK);
 }
 
-RC LogBuffer::append(LSN& lsn, LogModule module, std::vector<char>&& data) {
-	while (current_bytes_.load() >= max_bytes_) {
-		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+size_t LogBuffer::bytes() const {
+	// 先读参考值再读 reserve_，两者都只增不减，参考值一定不超过后读到的 reserve_
+	const uint64_t released = released_pos_.load(std::memory_order_acquire);
+	const LSN      flushed  = flushed_lsn_.load(std::memory_order_acquire);
+	uint64_t pos = 0;
+	LSN      lsn = 0;
+	decode_reserve(reserve_.load(std::memory_order_acquire), released, flushed, pos, lsn);
+	// 两次读之间可能已经刷了很多日志，用最新的 released_pos_ 计算，否则会把已经释放的空间也算进来
+	const uint64_t latest = released_pos_.load(std::memory_order_acquire);
+	return pos > latest ? static_cast<size_t>(pos - latest) : 0;
+}
+
+LSN LogBuffer::current_lsn() const {
+	const uint64_t released = released_pos_.load(std::memory_order_acquire);
+	const LSN      flushed  = flushed_lsn_.load(std::memory_order_acquire);
+	uint64_t pos = 0;
+	LSN      lsn = 0;
+	decode_reserve(reserve_.load(std::memory_order_acquire), released, flushed, pos, lsn);
+	return lsn;
+}
+
+void LogBuffer::set_max_bytes(size_t max_bytes) {
+	std::lock_guard<std::mutex> lock(mutex_);
+	if (max_bytes > MAX_BYTES) {
+		LOG_WARN("log buffer is too large, use the max size. max_bytes=%zu, limit=%zu", max_bytes, MAX_BYTES);
+		max_bytes = MAX_BYTES;
 	}
 
-	LogEntry entry;
-	RC rc = entry.init(lsn, module, std::move(data));
-	if (IS_FAIL(rc)) {
-		LOG_WARN("failed to init log entry. rc=%s", strrc(rc));
-		return rc;
+	if (max_bytes > capacity_) {
+		if (ring_ != nullptr && bytes() > 0) {
+			LOG_WARN("log buffer is not empty, cannot grow. max_bytes=%zu, capacity=%zu", max_bytes, capacity_);
+			max_bytes = capacity_;
+		} else {
+			while (capacity_ < max_bytes) {
+				capacity_ = capacity_ == 0 ? 1 : capacity_ << 1;
+			}
+			ring_.reset(new char[capacity_]);
+		}
 	}
+	max_bytes_ = max_bytes;
+}
 
-	std::lock_guard<std::mutex> lock(mutex_);
-	lsn = ++current_lsn_;
-	entry.set_lsn(lsn);
+bool LogBuffer::has_space(uint64_t end_pos, LSN lsn) const {
+	return end_pos - released_pos_.load(std::memory_order_acquire) <= max_bytes_ &&
+		lsn - flushed_lsn_.load(std::memory_order_acquire) <= static_cast<LSN>(DONE_NUM);
+}
 
-	entries_.push_back(std::move(entry));
-	current_bytes_ += entries_.back().total_size();
-	total_appends_++;
+RC LogBuffer::wait_for_space(uint64_t end_pos, LSN lsn) {
+	if (has_space(end_pos, lsn)) {
+		return RC::SUCCESS;
+	}
 
-	return RC::SUCCESS;
+	std::unique_lock<std::mutex> lock(mutex_);
+	flush_requested_ = true;
+	try_notify_flush();
+	space_cv_.wait(lock, [this, end_pos, lsn]() { return has_space(end_pos, lsn) || IS_FAIL(io_error()); });
+	return has_space(end_pos, lsn) ? RC::SUCCESS : io_error();
+}
+
+void LogBuffer::copy_in(uint64_t pos, const void* src, size_t size) {
+	const size_t offset = static_cast<size_t>(pos & (capacity_ - 1));
+	const size_t first  = std::min(size, capacity_ - offset);
+	memcpy(ring_.get() + offset, src, first);
+	if (first < size) {
+		memcpy(ring_.get(), static_cast<const char*>(src) + first, size - first);
+	}
+}
+
+void LogBuffer::copy_out(uint64_t pos, void* dst, size_t size) const {
+	const size_t offset = static_cast<size_t>(pos & (capacity_ - 1));
+	const size_t first  = std::min(size, capacity_ - offset);
+	memcpy(dst, ring_.get() + offset, first);
+	if (first < size) {
+		memcpy(static_cast<char*>(dst) + first, ring_.get(), size - first);
+	}
+}
+
+int LogBuffer::to_iovec(uint64_t pos, size_t size, struct iovec* iov) const {
+	const size_t offset = static_cast<size_t>(pos & (capacity_ - 1));
+	const size_t first  = std::min(size, capacity_ - offset);
+	iov[0].iov_base = ring_.get() + offset;
+	iov[0].iov_len  = first;
+	if (first == size) {
+		return 1;
+	}
+	iov[1].iov_base = ring_.get();
+	iov[1].iov_len  = size - first;
+	return 2;
 }
 
 RC LogBuffer::flush_batch(LogFileWriter& writer, size_t batch_size) {
 	std::unique_lock<std::mutex> lock(mutex_);
-	
-	if (entries_.empty()) {
+	flushed_cv_.wait(lock, [this]() { return !flushing_; });
+
+	if (RC error = io_error(); IS_FAIL(error)) {
+		return error;
+	}
+	if (!is_done(flushed_lsn_ + 1)) {
 		return RC::SUCCESS;
 	}
 
-	// 确定实际批量大小
-	batch_size = std::min(batch_size, entries_.size());
-	
-	// 记录开始时间
-	auto start_time = std::chrono::steady_clock::now();
+	RC rc = lead_flush(lock, writer, batch_size);
+
+	// 如果还有未刷盘的数据，且达到阈值，继续通知
+	if (should_flush()) {
+		try_notify_flush();
+	}
+	return rc;
+}
+
+RC LogBuffer::flush(LogFileWriter& writer) {
+	return flush_batch(writer, SIZE_MAX);  // 刷入所有条目
+}
+
+RC LogBuffer::group_commit(LogFileWriter& writer, LSN lsn) {
+	std::unique_lock<std::mutex> lock(mutex_);
+	while (flushed_lsn_ < lsn) {
+		if (flushing_) {
+			// follower：等 leader 刷完再看自己的日志是否已经落盘
+			flushed_cv_.wait(lock);
+			continue;
+		}
+
+		if (RC error = io_error(); IS_FAIL(error)) {
+			return error;
+		}
+
+		if (!is_done(flushed_lsn_ + 1)) {
+			if (lsn > current_lsn()) {
+				LOG_WARN("invalid lsn to commit. lsn=%ld, current_lsn=%ld", lsn, current_lsn());
+				return RC::INVALID_ARGUMENT;
+			}
+			// 日志已经预留但是还没有发布，发布的线程看到 publish_waiters_ 之后唤醒
+			publish_waiters_.fetch_add(1);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			flushed_cv_.wait(lock, [this, lsn]() {
+				return flushed_lsn_ >= lsn || flushing_ || is_done(flushed_lsn_ + 1) || IS_FAIL(io_error());
+			});
+			publish_waiters_.fetch_sub(1);
+			continue;
+		}
 
-	// 批量写入日志条目
-	size_t written = 0;
-	while (written < batch_size && !entries_.empty()) {
-		// 先尝试写入
-		RC rc = writer.write(entries_.front());
+		RC rc = lead_flush(lock, writer, SIZE_MAX);
 		if (IS_FAIL(rc)) {
-			LOG_ERROR("Failed to write log entry in batch, lsn=%ld", entries_.front().lsn());
 			return rc;
 		}
-		
-		// 写入成功后才移动和删除条目
-		const auto& entry = std::move(entries_.front());
-		current_bytes_ -= entry.total_size();
-		flushed_lsn_ = entry.lsn();
-		entries_.pop_front();
-		written++;
+	}
+	return RC::SUCCESS;
+}
+
+RC LogBuffer::wait_flushed(LSN lsn) {
+	std::unique_lock<std::mutex> lock(mutex_);
+	const uint64_t error_count = flush_error_count_;
+	while (flushed_lsn_ < lsn) {
+		if (RC error = io_error(); IS_FAIL(error)) {
+			return error;
+		}
+		if (flush_error_count_ != error_count) {
+			return flush_error_;
+		}
+		flush_requested_ = true;
+		flush_cv_.notify_one();
+		flushed_cv_.wait(lock);
+	}
+	return RC::SUCCESS;
+}
+
+void LogBuffer::report_flush_error(RC rc) {
+	std::lock_guard<std::mutex> lock(mutex_);
+	flush_error_ = rc;
+	flush_error_count_++;
+	flushed_cv_.notify_all();
+}
+
+void LogBuffer::wait_flush_request(int timeout_ms) {
+	std::unique_lock<std::mutex> lock(mutex_);
+	flush_cv_.wait_for(lock, std::chrono::milliseconds(timeout_ms), [this]() {
+		return flush_requested_ || should_flush();
+	});
+	flush_requested_ = false;
+}
+
+void LogBuffer::request_flush() {
+	std::lock_guard<std::mutex> lock(mutex_);
+	flush_requested_ = true;
+	flush_cv_.notify_one();
+}
+
+RC LogBuffer::lead_flush(std::unique_lock<std::mutex>& lock, LogFileWriter& writer, size_t batch_size) {
+	flushing_ = true;
+
+	// 已经发布的日志写者不会再修改，写文件和落盘时不持有锁
+	const uint64_t start    = released_pos_.load(std::memory_order_relaxed);
+	LSN            last_lsn = flushed_lsn_;
+	const LSN      first_lsn = last_lsn + 1;
+	lock.unlock();
+
+	auto start_time = std::chrono::steady_clock::now();
+
+	// 确定这次刷到哪里：连续的已经发布的日志，最多 batch_size 条，并且不超过文件允许的最大LSN
+	const LSN end_lsn   = writer.end_lsn();
+	uint64_t  pos       = start;
+	size_t    count     = 0;
+	bool      file_full = false;
+	while (count < batch_size && is_done(last_lsn + 1)) {
+		LogHeader header;
+		copy_out(pos, &header, LogHeader::HEAD_SIZE);
+		if (header.lsn >= end_lsn) {
+			file_full = true;
+			break;
+		}
+		pos += LogHeader::HEAD_SIZE + header.data_size;
+		last_lsn = header.lsn;
+		count++;
+	}
+
+	RC rc = RC::SUCCESS;
+	if (pos > start) {
+		// 缓冲区中的数据和文件格式一样，直接写入
+		struct iovec iov[2];
+		const int iovcnt = to_iovec(start, static_cast<size_t>(pos - start), iov);
+		rc = writer.write_raw(iov, iovcnt, first_lsn, last_lsn);
+		if (IS_SUCC(rc)) {
+			rc = writer.sync();
+		}
+	}
+	if (IS_SUCC(rc) && file_full) {
+		rc = RC::FILE_FULL;
 	}
 
-	// 更新统计信息
-	total_flushes_++;
 	auto end_time = std::chrono::steady_clock::now();
-	total_wait_time_us_ += std::chrono::duration_cast<std::chrono::microseconds>(
-			end_time - start_time).count();
 
-	// 如果还有未刷盘的数据，且达到阈值，继续通知
-	if (!entries_.empty() && should_flush()) {
-		try_notify_flush();
+	lock.lock();
+	if (rc == RC::SUCCESS || rc == RC::FILE_FULL) {
+		released_pos_.store(pos, std::memory_order_release);
+		flushed_lsn_ = last_lsn;
+	} else if (rc == RC::IOERR_SYNC) {
+		// 数据已经写入文件，writer 的位置已经往后移了，重写会在文件中留下重复的LSN。
+		// 也不知道哪些数据真的落盘了，所有等待的和之后的提交都失败
+		LOG_ERROR("Failed to sync log entries, stop flushing. count=%zu, first_lsn=%ld, last_lsn=%ld",
+			count, first_lsn, last_lsn);
+		io_error_.store(rc, std::memory_order_release);
 	} else {
-		flush_cv_.notify_all();  // 通知所有等待的线程
+		// 写文件失败时 writer 的位置不变，日志留在缓冲区中，下一个 leader 在同一个位置重写
+		LOG_WARN("Failed to flush log entries. count=%zu, rc=%s", count, strrc(rc));
 	}
 
-	return RC::SUCCESS;
-}
-
-RC LogBuffer::flush(LogFileWriter& writer) {
-	return flush_batch(writer, entries_.size());  // 刷入所有条目
+	flushing_ = false;
+	total_flushes_++;
+	total_wait_time_us_ += std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time).count();
+	flushed_cv_.notify_all();
+	space_cv_.notify_all();
+	return rc;
 }
 
 bool LogBuffer::should_flush() const {
-	return current_bytes_ >= max_bytes_ * flush_threshold_;
+	return bytes() >= max_bytes_ * flush_threshold_;
 }
 
 void LogBuffer::try_notify_flush() {
@@ -126,17 +400,18 @@ void LogBuffer::try_notify_flush() {
 }
 
 std::string LogBuffer::to_string() const {
+	const size_t current_bytes = bytes();
 	std::stringstream ss;
 	ss << "LogBuffer("
-		<< "current_bytes=" << current_bytes_ << "/" << max_bytes_ << "(" 
-		<< (static_cast<double>(current_bytes_) / max_bytes_ * 100) << "%), "
-		<< "entries=" << entries_.size() << ", "
-		<< "current_lsn=" << current_lsn_ << ", "
+		<< "current_bytes=" << current_bytes << "/" << max_bytes_ << "("
+		<< (static_cast<double>(current_bytes) / max_bytes_ * 100) << "%), "
+		<< "entries=" << size() << ", "
+		<< "current_lsn=" << current_lsn() << ", "
 		<< "flushed_lsn=" << flushed_lsn_ << ", "
-		<< "total_appends=" << total_appends_ << ", "
+		<< "total_appends=" << current_lsn() - init_lsn_ << ", "
 		<< "total_flushes=" << total_flushes_ << ", "
-		<< "avg_flush_time=" << (total_flushes_ > 0 ? 
-			static_cast<double>(total_wait_time_us_) / total_flushes_ / 1000.0 : 0.0) 
+		<< "avg_flush_time=" << (total_flushes_ > 0 ?
+			static_cast<double>(total_wait_time_us_) / total_flushes_ / 1000.0 : 0.0)
 		<< "ms)";
 	return ss.str();
-} 
\ No newline at end of file
+}
@@ -1,12 +1,10 @@
 #pragma once
 
 #include <vector>
-#include <deque>
 #include <atomic>
 #include <mutex>
 #include <condition_variable>
 #include <memory>
-#include <map>
 #include <string>
 
 #include "common/types.h"
@@ -15,10 +13,35 @@
 
 
 class LogFileWriter;
+struct iovec;
 
 
+/**
+ * @brief 日志缓冲区
+ * @details 日志直接序列化(LogHeader 加数据，和文件中的格式一样)到一块连续的环形缓冲区中，
+ * 追加日志时没有内存分配，也不需要加锁：
+ * - 预留：一次 fetch_add 同时分配LSN和缓冲区中的位置，参考 reserve_；
+ * - 拷贝：各个线程并行地把日志拷贝到自己预留的位置；
+ * - 发布：把自己的LSN写到完成标记数组 done_ 中，不需要等前面的线程。
+ *   刷盘的线程从 flushed_lsn 开始按LSN检查完成标记，得到连续的一段已经完成的日志。
+ *
+ * 刷盘使用组提交(group commit)：同一时间只有一个 leader 在刷盘，它把已经发布的连续一段
+ * 数据直接用一次 writev 写入文件再 fdatasync，然后唤醒所有等待的线程。leader 刷盘期间
+ * 到达的提交请求在后面排队，由下一个 leader 一起刷盘，这样并发提交越多，每次 fdatasync
+ * 分摊的日志就越多。
+ * flushed_lsn 之前的日志都已经落盘。缓冲区满时追加日志会等待刷盘。
+ * 写文件失败时日志留在缓冲区中，下一个 leader 在同一个位置重写；落盘(fdatasync)失败之后
+ * 不知道哪些数据真的写到了磁盘上，也不能在别的位置重写(文件中会出现重复的LSN)，
+ * 所以落盘失败是永久的：之后的追加、提交和刷盘都返回这个错误，参考 io_error。
+ * 设置了 compress_threshold 时，数据不小于它的日志在预留之前用 LZ4 压缩(参考 LogEntry::compress_payload)，
+ * 读日志时 LogFileReader 透明地解压。默认不压缩，写页面镜像这类大日志的部署自己打开。
+ */
 class LogBuffer {
 public:
+  static constexpr size_t MAX_BYTES = 64 * 1024 * 1024;  /// 缓冲区的最大容量
+  static constexpr size_t DONE_NUM  = 64 * 1024;         /// 完成标记的个数，也是最多有多少条日志没有落盘
+  static constexpr int32_t DEFAULT_COMPRESS_THRESHOLD = 0;  /// 默认不压缩，参考 set_compress_threshold
+
   explicit LogBuffer() = default;
   ~LogBuffer() = default;
 
@@ -28,50 +51,157 @@ public:
   RC append(LSN& lsn, LogModule::Id module_id, std::vector<char>&& data);
   RC append(LSN& lsn, LogModule module, std::vector<char>&& data);
   RC append(LogEntry&& entry);
+
+  /**
+   * @brief 追加一条日志，数据直接拷贝到缓冲区中
+   * @param lsn 输出参数，分配的LSN
+   */
+  RC append(LSN& lsn, LogModule module, const char* data, int32_t size);
+
   RC flush(LogFileWriter& writer);
-  
+
+  /**
+   * @brief 组提交，保证 lsn 及之前的日志都已经落盘
+   * @details 没有线程在刷盘时当前线程成为 leader 刷盘，否则等待当前的 leader 完成。
+   * 多个线程可以使用同一个 writer，只有 leader 会访问它
+   * @return 文件写满时返回 FILE_FULL，调用者切换到下一个文件之后重试；落盘失败之后返回 IOERR_SYNC
+   */
+  RC group_commit(LogFileWriter& writer, LSN lsn);
+
+  /**
+   * @brief 等待 lsn 及之前的日志落盘，自己不刷盘
+   * @details 给有专门刷盘线程的 LogHandler::wait_lsn 使用，等待之前会唤醒刷盘线程
+   * @return 等待期间刷盘线程报告了错误(参考 report_flush_error)时返回这个错误，不再等待
+   */
+  RC wait_flushed(LSN lsn);
+
+  /**
+   * @brief 刷盘线程报告一次刷盘失败，唤醒 wait_flushed 中等待的线程
+   */
+  void report_flush_error(RC rc);
+
+  /**
+   * @brief 刷盘线程等待刷盘请求
+   * @details 有线程在 wait_flushed 中等待、缓冲区达到刷盘阈值、调用了 request_flush
+   * 或者超时时返回
+   */
+  void wait_flush_request(int timeout_ms);
+
+  /**
+   * @brief 唤醒刷盘线程
+   */
+  void request_flush();
+
   // 查询接口
-  bool is_full() const { return current_bytes_ >= max_bytes_; }
-  size_t size() const { return entries_.size(); }
-  size_t bytes() const { return current_bytes_; }
-  LSN current_lsn() const { return current_lsn_; }
+  bool is_full() const { return bytes() >= max_bytes_; }
+  size_t size() const {
+    // 先读 flushed_lsn，之后读到的 current_lsn 不会比它小
+    const LSN flushed = flushed_lsn();
+    return static_cast<size_t>(current_lsn() - flushed);
+  }
+  size_t bytes() const;
+  LSN current_lsn() const;
   LSN flushed_lsn() const { return flushed_lsn_; }
+  /// 落盘失败之后的错误，没有失败时是 SUCCESS
+  RC io_error() const { return io_error_.load(std::memory_order_acquire); }
 
   // 配置接口
-  void set_max_bytes(size_t max_bytes) { max_bytes_ = max_bytes; }
+  /**
+   * @brief 修改缓冲区大小，缓冲区中有日志时不能超过当前环形缓冲区的容量
+   */
+  void set_max_bytes(size_t max_bytes);
   void set_flush_threshold(float threshold) { flush_threshold_ = threshold; }
+  /**
+   * @brief 数据达到 threshold 字节的日志压缩之后再写入，0表示不压缩
+   * @details 大日志一般设置为1024左右，更小的日志压缩省不了多少空间
+   */
+  void set_compress_threshold(int32_t threshold) { compress_threshold_ = threshold; }
+  int32_t compress_threshold() const { return compress_threshold_; }
 
   // 刷盘接口
   RC flush_batch(LogFileWriter& writer, size_t batch_size);
 
+  uint64_t flush_count() const { return total_flushes_; }
+  uint64_t compressed_entries() const { return compressed_entries_.load(std::memory_order_relaxed); }
+  /// 压缩一共少写了多少字节
+  uint64_t compress_saved_bytes() const { return compress_saved_bytes_.load(std::memory_order_relaxed); }
+
   // 性能统计展示
   std::string to_string() const;
 
 private:
+  /**
+   * reserve_ 的低 POS_BITS 位是预留位置，高位是LSN，一次 fetch_add((1 << POS_BITS) + size)
+   * 同时分配两者。完整的值根据 released_pos_ 和 flushed_lsn_ 恢复：未刷盘的数据不超过
+   * 缓冲区容量加上每个线程的一条日志，远小于 2^POS_BITS 字节和 2^(64-POS_BITS) 条
+   */
+  static constexpr int      POS_BITS = 40;
+  static constexpr uint64_t POS_MASK = (1ULL << POS_BITS) - 1;
+  static constexpr uint64_t LSN_MASK = (1ULL << (64 - POS_BITS)) - 1;
+
   // 内部辅助方法
   void try_notify_flush();
   bool should_flush() const;
 
+  /**
+   * @brief 根据 reserve_ 的值恢复完整的预留位置和它之前的最后一个LSN
+   * @details released 和 flushed 必须不大于 reserve 对应的值：只读的调用者要先读它们再读 reserve_，
+   * 否则中间刷盘之后它们比 reserve 新，相减会回绕
+   */
+  static void decode_reserve(uint64_t reserve, uint64_t released, LSN flushed, uint64_t& pos, LSN& lsn);
+
+  /// 等待缓冲区中有 end_pos 之前的空间，并且 lsn 可以使用的完成标记已经空闲，落盘失败时返回错误
+  RC   wait_for_space(uint64_t end_pos, LSN lsn);
+  bool has_space(uint64_t end_pos, LSN lsn) const;
+
+  /// 下一条要刷盘的日志是否已经完成拷贝
+  bool is_done(LSN lsn) const { return done_[lsn & (DONE_NUM - 1)].load(std::memory_order_acquire) == lsn; }
+
+  void copy_in(uint64_t pos, const void* src, size_t size);
+  void copy_out(uint64_t pos, void* dst, size_t size) const;
+
+  /// 把 [pos, pos + size) 转成最多两段iovec，返回段数
+  int  to_iovec(uint64_t pos, size_t size, struct iovec* iov) const;
+
+  /**
+   * @brief 作为 leader 刷盘，最多刷 batch_size 条日志
+   * @details 调用时持有mutex_并且没有其它 leader。写文件和落盘时释放锁，
+   * 其它线程可以继续追加日志
+   */
+  RC lead_flush(std::unique_lock<std::mutex>& lock, LogFileWriter& writer, size_t batch_size);
+
 private:
   // 数据存储
-  std::deque<LogEntry> entries_;
-  
+  std::unique_ptr<char[]> ring_;
+  size_t                  capacity_{0};  // 环形缓冲区大小，2的幂
+  std::unique_ptr<std::atomic<LSN>[]> done_;  // 完成标记，LSN为lsn的日志拷贝完成之后 done_[lsn % DONE_NUM] = lsn
+
   // 并发控制
   mutable std::mutex mutex_;
-  std::condition_variable flush_cv_;
-  
+  std::condition_variable flush_cv_;    // 通知刷盘线程
+  std::condition_variable flushed_cv_;  // leader 刷盘结束
+  std::condition_variable space_cv_;    // 缓冲区有空间了
+  bool flushing_{false};                // 是否有 leader 正在刷盘
+  bool flush_requested_{false};         // 有线程在等待刷盘
+  std::atomic<int> publish_waiters_{0}; // 在 group_commit 中等待日志发布的线程数，发布时唤醒它们
+  std::atomic<RC>  io_error_{RC::SUCCESS};  // 落盘失败之后的错误
+  RC       flush_error_{RC::SUCCESS};  // 刷盘线程最近一次报告的错误
+  uint64_t flush_error_count_{0};      // 刷盘线程报告了多少次错误，wait_flushed 据此判断等待期间是否失败过
+
   // 状态追踪
-  std::atomic<size_t> current_bytes_{0};
-  std::atomic<LSN> current_lsn_{0};
+  alignas(64) std::atomic<uint64_t> reserve_{0};       // 预留位置和LSN
+  alignas(64) std::atomic<uint64_t> released_pos_{0};  // 这个位置之前的日志都已经落盘
   std::atomic<LSN> flushed_lsn_{0};
-  
+  LSN              init_lsn_{0};
+
   // 配置参数
   size_t max_bytes_{16 * 1024 * 1024};  // 默认16MB
   float flush_threshold_{0.75};          // 触发刷盘的阈值（默认75%）
-  size_t default_batch_size_{1024};      // 默认批量刷盘大小
-  
+  int32_t compress_threshold_{DEFAULT_COMPRESS_THRESHOLD};  // 压缩的阈值
+
   // 性能统计
-  std::atomic<uint64_t> total_appends_{0};
   std::atomic<uint64_t> total_flushes_{0};
   std::atomic<uint64_t> total_wait_time_us_{0};
+  std::atomic<uint64_t> compressed_entries_{0};
+  std::atomic<uint64_t> compress_saved_bytes_{0};
 };
@@ -1,17 +1,49 @@
 #include <cstdint>
+#include <cstring>
 #include <sstream>
 #include "storage/clog/log_entry.h"
 #include "common/log/log.h"
+#include "common/math/crc.h"
+#include "common/compress/lz4.h"
 
 
 const int32_t LogHeader::HEAD_SIZE = sizeof(LogHeader);
+static_assert(sizeof(LogHeader) == 24, "log header is part of the on-disk format");
+
+uint32_t LogHeader::calc_check_sum(const char* data) const {
+  LogHeader header = *this;
+  header.check_sum = 0;
+  const uint32_t crc = crc32c(&header, HEAD_SIZE);
+  return crc32c(data, data_size, crc);
+}
+
+void LogHeader::seal(const char* data) {
+  check_sum = calc_check_sum(data);
+}
+
+bool LogHeader::is_valid() const {
+  return magic == MAGIC && version == VERSION && (flags & ~FLAG_MASK) == 0 && data_size >= 0 &&
+         data_size <= LogEntry::max_payload_size();
+}
+
+bool LogHeader::is_zero() const {
+  static const char zero[sizeof(LogHeader)] = {};
+  return memcmp(this, zero, sizeof(zero)) == 0;
+}
+
+bool LogHeader::verify(const char* data) const {
+  return is_valid() && check_sum == calc_check_sum(data);
+}
 
 std::string LogHeader::to_string() const {
   std::ostringstream  oss;
   oss << "lsn=" << lsn
       << ",size=" << data_size
       << ",module_id=" << module_id
-      << ",module_name=" << LogModule(module_id).name();
+      << ",module_name=" << LogModule(module_id).name()
+      << ",version=" << static_cast<int>(version)
+      << ",flags=" << static_cast<int>(flags)
+      << ",check_sum=" << check_sum;
   return oss.str();
 }
 
@@ -20,16 +52,20 @@ LogEntry::LogEntry() = default;
 
 LogEntry::LogEntry(LogEntry&& other) noexcept 
   : m_header(other.m_header),
-    m_data(std::move(other.m_data)) {
+    m_data(std::move(other.m_data)),
+    m_view(other.m_view) {
   // 源对象的header会自动重置为默认值
   other.m_header = {};
+  other.m_view   = nullptr;
 }
 
 LogEntry& LogEntry::operator=(LogEntry&& other) noexcept {
   if (this != &other) {
     m_header = other.m_header;
     m_data = std::move(other.m_data);
+    m_view = other.m_view;
     other.m_header = {};
+    other.m_view   = nullptr;
   }
   return *this;
 }
@@ -47,10 +83,61 @@ RC LogEntry::init(LSN lsn, LogModule module, std::vector<char>&& data) {
   m_header.lsn = lsn;
   m_header.data_size = static_cast<int32_t>(data.size());
   m_header.module_id = static_cast<int32_t>(module.index());
+  m_header.flags = 0;
   m_data = std::move(data);
+  m_view = nullptr;
+  m_header.seal(m_data.data());
   return RC::SUCCESS;
 }
 
+void LogEntry::set_lsn(LSN lsn) {
+  m_header.lsn = lsn;
+  m_header.seal(data());
+}
+
+void LogEntry::init_view(const LogHeader& header, const char* data) {
+  m_header = header;
+  m_data.clear();
+  m_view = data;
+}
+
+RC LogEntry::init_decompress(const LogHeader& header, const char* data) {
+  int32_t raw_size = 0;
+  if (header.data_size < static_cast<int32_t>(sizeof(raw_size))) {
+    return RC::FILE_CORRUPTED;
+  }
+  memcpy(&raw_size, data, sizeof(raw_size));
+  if (raw_size < 0 || raw_size > max_payload_size()) {
+    LOG_WARN("invalid raw size of compressed log entry. header=%s, raw_size=%d", header.to_string().c_str(), raw_size);
+    return RC::FILE_CORRUPTED;
+  }
+
+  std::vector<char> raw(raw_size);
+  const int size = lz4_decompress(data + sizeof(raw_size), header.data_size - static_cast<int32_t>(sizeof(raw_size)),
+      raw.data(), raw_size);
+  if (size != raw_size) {
+    LOG_WARN("failed to decompress log entry. header=%s, raw_size=%d, ret=%d", header.to_string().c_str(), raw_size, size);
+    return RC::FILE_CORRUPTED;
+  }
+  return init(header.lsn, LogModule(header.module_id), std::move(raw));
+}
+
+int32_t LogEntry::compress_payload(const char* data, int32_t size, std::vector<char>& out) {
+  // 输出缓冲区只给到原始大小的 7/8，放不下就是不值得压缩
+  const int32_t limit = size - size / 8 - static_cast<int32_t>(sizeof(size));
+  if (limit <= 0) {
+    return 0;
+  }
+
+  out.resize(sizeof(size) + limit);
+  memcpy(out.data(), &size, sizeof(size));
+  const int compressed = lz4_compress(data, size, out.data() + sizeof(size), limit);
+  if (compressed <= 0) {
+    return 0;
+  }
+  return static_cast<int32_t>(sizeof(size)) + compressed;
+}
+
 std::string LogEntry::to_string() const {
   return header().to_string() + ",data=" + std::string(data(), payload_size());
 }
@@ -11,19 +11,60 @@
 /**
  * @brief 日志头结构体
  * 包含日志的基本元数据信息
+ * @details 文件中每条日志是日志头加日志数据。check_sum 是日志头(check_sum 为0)和日志数据的 CRC32C，
+ * 恢复时用 magic、version 和 check_sum 判断日志是否完整：写到一半的日志(torn write)或者损坏的日志
+ * 以及它后面的内容都会被丢弃。
+ * 带有 FLAG_COMPRESSED 的日志，文件中的数据是 int32_t 的原始大小加上 LZ4 压缩的原始数据，
+ * data_size 和 check_sum 都是针对压缩之后的数据，参考 LogEntry::compress_payload。
  */
 struct LogHeader final {
-  LSN         lsn{0};        // 日志序列号
-  int32_t     data_size{0};  // 日志数据大小（不包含header）
-  int32_t     module_id{0};  // 日志模块ID
+  static constexpr uint16_t MAGIC   = 0x4C47;  // "LG"
+  static constexpr uint8_t  VERSION = 1;       // 日志格式版本
+
+  static constexpr uint8_t  FLAG_COMPRESSED = 0x01;  // 日志数据是压缩过的
+  static constexpr uint8_t  FLAG_MASK       = FLAG_COMPRESSED;
+
+  LSN         lsn{0};             // 日志序列号
+  int32_t     data_size{0};       // 日志数据大小（不包含header）
+  int32_t     module_id{0};       // 日志模块ID
+  uint16_t    magic{MAGIC};       // 魔数
+  uint8_t     version{VERSION};   // 日志格式版本
+  uint8_t     flags{0};           // 日志标志，比如 FLAG_COMPRESSED
+  uint32_t    check_sum{0};       // 日志头和日志数据的 CRC32C
 
   static const int32_t HEAD_SIZE; // header的大小
 
+  /**
+   * @brief 计算并设置 check_sum
+   * @param data 日志数据，长度是 data_size
+   */
+  void seal(const char* data);
+
+  /**
+   * @brief 魔数、版本号、标志和数据大小是否有效，不检查 check_sum
+   */
+  bool is_valid() const;
+
+  bool is_compressed() const { return (flags & FLAG_COMPRESSED) != 0; }
+
+  /**
+   * @brief 是否全是0，预分配的日志文件中还没有写过的部分和日志的结束标记都是0
+   */
+  bool is_zero() const;
+
+  /**
+   * @brief 检查日志头和数据的 check_sum
+   */
+  bool verify(const char* data) const;
+
   /**
    * @brief 转换为字符串表示
    * @return 返回日志头的字符串表示
    */
   std::string to_string() const;
+
+private:
+  uint32_t calc_check_sum(const char* data) const;
 };
 
 /**
@@ -76,6 +117,37 @@ public:
    */
   RC init(LSN lsn, LogModule module, std::vector<char>&& data);
 
+  /**
+   * @brief 初始化为一个视图，数据指向外部的内存(比如 mmap 的日志文件)，不复制
+   * @details 视图只在外部内存有效时可以使用，需要长期保存时用 init 复制一份
+   * @param header 日志头
+   * @param data 日志数据，长度是 header.data_size
+   */
+  void init_view(const LogHeader& header, const char* data);
+
+  /**
+   * @brief 是否是指向外部内存的视图
+   */
+  bool is_view() const { return m_view != nullptr; }
+
+  /**
+   * @brief 从文件中压缩过的日志数据初始化，解压之后的日志不带 FLAG_COMPRESSED
+   * @param header 文件中的日志头，调用者已经用 LogHeader::verify 检查过
+   * @param data 文件中的日志数据，长度是 header.data_size
+   * @return 数据格式错误时返回 FILE_CORRUPTED
+   */
+  RC init_decompress(const LogHeader& header, const char* data);
+
+  /**
+   * @brief 压缩日志数据，格式参考 LogHeader
+   * @details 压缩之后至少小 1/8 才值得，否则不压缩
+   * @param data 原始数据
+   * @param size 原始数据大小
+   * @param[out] out 压缩之后的数据
+   * @return 压缩之后的大小，不压缩时返回0
+   */
+  static int32_t compress_payload(const char* data, int32_t size, std::vector<char>& out);
+
   // 数据访问接口
   /**
    * @brief 获取日志头
@@ -87,7 +159,7 @@ public:
    * @brief 获取日志数据
    * @return 返回日志数据指针
    */
-  const char* data() const { return m_data.data(); }
+  const char* data() const { return m_view != nullptr ? m_view : m_data.data(); }
   
   /**
    * @brief 获取数据大小
@@ -103,10 +175,10 @@ public:
 
   // LSN相关操作
   /**
-   * @brief 设置日志序列号
+   * @brief 设置日志序列号，重新计算 check_sum
    * @param lsn 新的日志序列号
    */
-  void set_lsn(LSN lsn) { m_header.lsn = lsn; }
+  void set_lsn(LSN lsn);
   
   /**
    * @brief 获取日志序列号
@@ -129,4 +201,5 @@ public:
 private:
   LogHeader m_header;        // 日志头
   std::vector<char> m_data;  // 日志数据
+  const char* m_view = nullptr;  // 视图指向的外部数据，不为空时不使用 m_data
 };
\ No newline at end of file
@@ -11,14 +11,30 @@
 #include "common/log/log.h"
 #include "storage/clog/log_entry.h"
 #include "common/io/io.h"
+#include "common/io/async_io.h"
 #include "common/utils/utils.h"
 
 
 /******************** LogFileReader ********************/
 
-RC LogFileReader::open(const std::string& filename) {
+static constexpr uint32_t LOG_INDEX_MAGIC = 0x584449ceU;  // 索引文件的魔数
+
+/**
+ * @brief 索引文件头，后面跟着 count 个 LogIndexEntry
+ */
+struct LogIndexFileHeader final {
+  uint32_t magic{LOG_INDEX_MAGIC};
+  uint32_t count{0};
+};
+
+LogFileReader::~LogFileReader() {
+  (void)this->close();
+}
+
+RC LogFileReader::open(const std::string& filename, Mode mode /* = Mode::BUFFERED */) {
 
   m_filename = filename;
+  m_mode     = mode;
   m_fd = ::open(filename.c_str(), O_RDONLY);
   if (m_fd < 0) {
     LOG_ERROR("open clog file failed. filename=%s, errno=%d, errmsg=%s", 
@@ -26,11 +42,47 @@ RC LogFileReader::open(const std::string& filename) {
     return RC::FILE_NOT_FOUND;
   }
 
-  LOG_INFO("open file success. filename=%s, fd=%d", filename.c_str(), m_fd);
+  struct stat st;
+  if (::fstat(m_fd, &st) != 0) {
+    LOG_ERROR("stat clog file failed. filename=%s, errno=%d, errmsg=%s", filename.c_str(), errno, strerror(errno));
+    close();
+    return RC::IOERR_READ;
+  }
+  m_size   = st.st_size;
+  m_offset = 0;
+  m_torn   = false;
+
+  if (mode == Mode::MMAP && m_size > 0) {
+    void* data = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, m_fd, 0);
+    if (data == MAP_FAILED) {
+      LOG_ERROR("mmap clog file failed. filename=%s, size=%ld, errno=%d, errmsg=%s",
+        filename.c_str(), m_size, errno, strerror(errno));
+      close();
+      return RC::IOERR_READ;
+    }
+    ::madvise(data, m_size, MADV_SEQUENTIAL);
+    m_data = static_cast<const char*>(data);
+  }
+
+  RC rc = load_index();
+  if (IS_FAIL(rc)) {
+    LOG_WARN("failed to load clog index, scan from the beginning. filename=%s, rc=%s", filename.c_str(), strrc(rc));
+    m_index.clear();
+  }
+
+  LOG_INFO("open file success. filename=%s, fd=%d, mmap=%d, index=%zu",
+    filename.c_str(), m_fd, mode == Mode::MMAP, m_index.size());
   return RC::SUCCESS;
 }
 
 RC LogFileReader::close() {
+  if (m_data != nullptr) {
+    ::munmap(const_cast<char*>(m_data), m_size);
+    m_data = nullptr;
+  }
+  m_size = 0;
+  m_index.clear();
+
   if (m_fd < 0) {
     return RC::FILE_NOT_FOUND;
   }
@@ -40,66 +92,90 @@ RC LogFileReader::close() {
   return RC::SUCCESS;
 }
 
-RC LogFileReader::go_to(LSN lsn) {
-  if (m_fd < 0) {
-    LOG_ERROR("clog file not opened.");
-    return RC::FILE_NOT_FOUND;
+RC LogFileReader::load_index() {
+  m_index.clear();
+
+  const std::string index_file = LogFileWriter::index_filename(m_filename);
+  int fd = ::open(index_file.c_str(), O_RDONLY);
+  if (fd < 0) {
+    // 当前正在写的文件还没有索引
+    return RC::SUCCESS;
   }
 
-  // 定位到文件开头
-  off_t pos = ::lseek(m_fd, 0, SEEK_SET);
-  if (pos == off_t(-1)) {
-    LOG_ERROR("seek file failed. seek to the beginning. filename=%s, error=%s", 
-      m_filename.c_str(), strerror(errno));
-    return RC::IOERR_SEEK;
+  struct stat st;
+  LogIndexFileHeader header;
+  int ret = ::fstat(fd, &st) == 0 ? readn(fd, &header, sizeof(header)) : errno;
+  if (ret == 0 && header.magic == LOG_INDEX_MAGIC &&
+      sizeof(header) + static_cast<int64_t>(header.count) * sizeof(LogIndexEntry) != static_cast<size_t>(st.st_size)) {
+    ret = -1;
+  }
+  if (ret == 0 && header.magic == LOG_INDEX_MAGIC) {
+    m_index.resize(header.count);
+    ret = readn(fd, m_index.data(), header.count * sizeof(LogIndexEntry));
   }
+  ::close(fd);
 
-  // 从文件开头开始查找
-  LogHeader header;
-  while (true) {
-    // 读取日志头
-    int rc = readn(m_fd, reinterpret_cast<char *>(&header), LogHeader::HEAD_SIZE);
-    if (rc != 0) {
-      if (rc == -1) {
-        // 文件结束
-        break;
-      }
-      LOG_ERROR("read file failed. filename=%s, ret=%d, error=%s", 
-        m_filename.c_str(), rc, strerror(errno));
-      return RC::IOERR_READ;
-    }
+  if (ret != 0 || header.magic != LOG_INDEX_MAGIC) {
+    LOG_WARN("invalid clog index file. filename=%s, ret=%d", index_file.c_str(), ret);
+    return RC::IOERR_READ;
+  }
+  return RC::SUCCESS;
+}
 
-    // 找到目标LSN
-    if (header.lsn >= lsn) {
-      // 回退到日志头开始位置
-      pos = ::lseek(m_fd, -LogHeader::HEAD_SIZE, SEEK_CUR);
-      if (pos == off_t(-1)) {
-        LOG_ERROR("seek file failed. skip back log header. filename=%s, error=%s", 
-          m_filename.c_str(), strerror(errno));
-        return RC::IOERR_SEEK;
-      }
-      break;
-    }
+bool LogFileReader::read_header(int64_t offset, LogHeader& header) const {
+  if (offset < 0 || offset + LogHeader::HEAD_SIZE > m_size) {
+    return false;
+  }
+  if (m_mode == Mode::MMAP) {
+    memcpy(&header, m_data + offset, LogHeader::HEAD_SIZE);
+    return true;
+  }
+  return preadn(m_fd, &header, LogHeader::HEAD_SIZE, offset) == 0;
+}
 
-    // 检查日志头数据区是否有效
-    if (header.data_size < 0 || header.data_size > LogEntry::max_payload_size()) {
-      LOG_ERROR("invalid log entry size. filename=%s, size=%d", 
-        m_filename.c_str(), header.data_size);
-      return RC::IOERR_READ;
-    }
+int64_t LogFileReader::index_lookup(LSN lsn) const {
+  // 第一个LSN大于 lsn 的索引项，它前面那一项就是要找的
+  auto iter = std::upper_bound(m_index.begin(), m_index.end(), lsn,
+    [](LSN value, const LogIndexEntry& entry) { return value < entry.lsn; });
+  if (iter == m_index.begin()) {
+    return 0;
+  }
+  --iter;
 
-    // 跳过日志体
-    pos = ::lseek(m_fd, LogHeader::HEAD_SIZE, SEEK_CUR);
-    if (pos == off_t(-1)) {
-      LOG_ERROR("seek file failed. skip log entry payload. filename=%s, error=%s", 
-        m_filename.c_str(), strerror(errno));
-      return RC::IOERR_SEEK;
-    }
+  // 索引和日志文件对不上时(比如日志文件被截断过)从头开始找
+  LogHeader header;
+  if (!read_header(iter->offset, header) || !header.is_valid() || header.lsn != iter->lsn) {
+    LOG_WARN("clog index does not match the log file. filename=%s, lsn=%ld, offset=%ld",
+      m_filename.c_str(), iter->lsn, iter->offset);
+    return 0;
   }
+  return iter->offset;
+}
 
+RC LogFileReader::go_to(LSN lsn) {
+  if (m_fd < 0) {
+    LOG_ERROR("clog file not opened.");
+    return RC::FILE_NOT_FOUND;
+  }
+
+  // 从索引项或者文件开头向后逐条跳过，只检查日志头。遇到无效的日志头时停下，由 iterate 处理
+  LogHeader header;
+  m_offset   = index_lookup(lsn);
+  m_torn     = false;
+  m_last_lsn = 0;
+  while (read_header(m_offset, header) && header.is_valid() && header.lsn < lsn && header.lsn > m_last_lsn) {
+    m_offset += LogHeader::HEAD_SIZE + header.data_size;
+    m_last_lsn = header.lsn;
+  }
   return RC::SUCCESS;
 }
 
+void LogFileReader::mark_torn(const char* reason) {
+  m_torn = true;
+  LOG_WARN("found torn or corrupted log entry, stop reading. filename=%s, offset=%ld, file_size=%ld, reason=%s",
+    m_filename.c_str(), m_offset, m_size, reason);
+}
+
 RC LogFileReader::iterate(std::function<RC(LogEntry&)> callback, LSN start_lsn) {
   if (m_fd < 0) {
     LOG_ERROR("log file not opened");
@@ -112,32 +188,66 @@ RC LogFileReader::iterate(std::function<RC(LogEntry&)> callback, LSN start_lsn)
   }
 
   LogHeader header;
-  while (true) {
-    int ret = readn(m_fd, reinterpret_cast<char*> (&header), LogHeader::HEAD_SIZE);
-    if (ret != 0) {
-      if (-1 == ret) {
-        break;
-      }
-      LOG_ERROR("read file faild. filename=%s, ret=%d, error=%s",
-        m_filename.c_str(), ret, strerror(errno));
-      return RC::IOERR_READ;
+  while (m_offset < m_size) {
+    if (!read_header(m_offset, header)) {
+      mark_torn("incomplete header");
+      break;
     }
-
-
-    // 读取日志体
-    std::vector<char> data(header.data_size);
-    ret = readn(m_fd, data.data(), header.data_size);
-    if (0 != ret) {
-      LOG_WARN("read file faild. filename=%s, size=%d, ret=%d, error=%s",
-        m_filename.c_str(), header.data_size, ret, strerror(errno));
-      return RC::IOERR_READ;
+    // 预分配空间中还没有写过的部分，或者写满切换文件时留下的结束标记
+    if (header.is_zero()) {
+      break;
+    }
+    if (!header.is_valid()) {
+      mark_torn("invalid header");
+      break;
+    }
+    if (m_offset + LogHeader::HEAD_SIZE + header.data_size > m_size) {
+      mark_torn("incomplete payload");
+      break;
     }
 
-    // 创建日志条目
     LogEntry entry;
-    entry.init(header.lsn, LogModule(header.module_id), std::move(data));
+    const int64_t data_offset = m_offset + LogHeader::HEAD_SIZE;
+    std::vector<char> data;
+    const char* payload = nullptr;
+    if (m_mode == Mode::MMAP) {
+      // 日志数据直接指向映射的内存
+      payload = m_data + data_offset;
+    } else {
+      // 读取日志体
+      data.resize(header.data_size);
+      int ret = preadn(m_fd, data.data(), header.data_size, data_offset);
+      if (0 != ret) {
+        LOG_WARN("read file faild. filename=%s, size=%d, ret=%d, error=%s",
+          m_filename.c_str(), header.data_size, ret, strerror(errno));
+        return RC::IOERR_READ;
+      }
+      payload = data.data();
+    }
+
+    if (!header.verify(payload)) {
+      mark_torn("check sum mismatch");
+      break;
+    }
+    if (header.is_compressed()) {
+      // 解压到日志自己的内存中，不再是视图
+      if (IS_FAIL(entry.init_decompress(header, payload))) {
+        mark_torn("decompress failed");
+        break;
+      }
+    } else if (m_mode == Mode::MMAP) {
+      entry.init_view(header, payload);
+    } else {
+      entry.init(header.lsn, LogModule(header.module_id), std::move(data));
+    }
+    // 回收的日志文件中上一次使用留下的日志，它们的LSN都比新写的小
+    if (header.lsn <= m_last_lsn) {
+      break;
+    }
+    m_offset   = data_offset + header.data_size;
+    m_last_lsn = header.lsn;
 
-    RC rc = callback(entry);
+    rc = callback(entry);
     if (IS_FAIL(rc)) {
       LOG_INFO("iterate log entry failed. entry=%s, rc=%s", entry.to_string().c_str(), strrc(rc));
       return rc;
@@ -155,20 +265,193 @@ LogFileWriter::~LogFileWriter() {
   (void)this->close();
 }
 
-RC LogFileWriter::open(const std::string& filename, LSN end_lsn) {
+RC LogFileWriter::open(const std::string& filename, LSN end_lsn, bool dsync /* = false */, int64_t extend_size /* = 0 */) {
   if (m_fd >= 0) {
     LOG_WARN("log file %s already opened", filename.c_str());
     return RC::FILE_OPEND;
   }
 
-  m_fd = ::open(filename.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+  // 找到最后一条完整日志的结束位置，从这里继续写。预分配的文件大小不代表写到了哪里
+  int64_t valid_size = 0;
+  bool    torn       = false;
+  m_last_lsn         = 0;
+  if (std::filesystem::exists(filename)) {
+    LogFileReader reader;
+    RC rc = reader.open(filename, LogFileReader::Mode::MMAP);
+    if (IS_SUCC(rc)) {
+      rc = reader.iterate([](LogEntry&) { return RC::SUCCESS; });
+    }
+    if (IS_FAIL(rc)) {
+      LOG_ERROR("failed to find the end of log file. filename=%s, rc=%s", filename.c_str(), strrc(rc));
+      return rc;
+    }
+    valid_size = reader.valid_size();
+    torn       = reader.torn();
+    m_last_lsn = reader.last_lsn();
+  }
+
+  m_fd = ::open(filename.c_str(), O_WRONLY | O_CREAT | (dsync ? O_DSYNC : 0), 0644);
   if (m_fd < 0) {
     LOG_ERROR("failed to open log file %s, errno=%d", filename.c_str(), errno);
     return RC::FILE_NOT_FOUND;
   }
 
-  m_filename = filename;
-  this->m_end_lsn = end_lsn;
+  struct stat st;
+  if (::fstat(m_fd, &st) != 0) {
+    LOG_ERROR("stat log file failed. filename=%s, errno=%d, error=%s", filename.c_str(), errno, strerror(errno));
+    close();
+    return RC::IOERR_READ;
+  }
+
+  if (m_io_engine != nullptr) {
+    m_io_engine->register_files(&m_fd, 1);
+  }
+
+  m_filename    = filename;
+  m_end_lsn     = end_lsn;
+  m_dsync       = dsync;
+  m_extend_size = extend_size;
+  m_offset      = valid_size;
+  m_file_size   = st.st_size;
+  m_index.clear();
+  m_next_index_lsn = 0;
+
+  // 崩溃时写了一半的日志：在它的位置写一个结束标记，后面新写的日志比它短时也不会再读到它
+  if (torn) {
+    LOG_WARN("clear torn log entry. filename=%s, offset=%ld, last_lsn=%ld", filename.c_str(), m_offset, m_last_lsn);
+    RC rc = mark_end();
+    if (IS_SUCC(rc)) {
+      rc = sync();
+    }
+    if (IS_FAIL(rc)) {
+      close();
+      return rc;
+    }
+  }
+  return RC::SUCCESS;
+}
+
+RC LogFileWriter::reserve(int64_t size) {
+  if (m_offset + size <= m_file_size || m_extend_size <= 0) {
+    return RC::SUCCESS;
+  }
+
+  // 写满了预分配的空间，再预分配一段，避免每次写入都扩展文件
+  const int64_t new_size = std::max(m_offset + size, m_file_size + m_extend_size);
+  int ret = ::posix_fallocate(m_fd, m_file_size, new_size - m_file_size);
+  if (ret != 0) {
+    // 文件系统不支持时写入会自己扩展文件
+    LOG_WARN("failed to preallocate log file. filename=%s, size=%ld, error=%s", m_filename.c_str(), new_size, strerror(ret));
+    m_extend_size = 0;
+    return RC::SUCCESS;
+  }
+  m_file_size = new_size;
+  return RC::SUCCESS;
+}
+
+RC LogFileWriter::pwrite(struct iovec* iov, int iovcnt, int64_t size) {
+  RC rc = reserve(size);
+  if (IS_FAIL(rc)) {
+    return rc;
+  }
+
+  // 写失败时 m_offset 不变，重试时覆盖写了一部分的数据
+  int ret = write_at(iov, iovcnt, m_offset);
+  if (0 != ret) {
+    LOG_WARN("write log file faild. filename=%s, offset=%ld, size=%ld, ret=%d, error=%s",
+      m_filename.c_str(), m_offset, size, ret, strerror(ret));
+    return RC::IOERR_WRITE;
+  }
+
+  m_offset += size;
+  m_file_size = std::max(m_file_size, m_offset);
+  return RC::SUCCESS;
+}
+
+RC LogFileWriter::mark_end() {
+  if (m_fd < 0) {
+    return RC::SUCCESS;
+  }
+  if (m_offset >= m_file_size) {
+    // 文件末尾就是日志的结尾
+    return RC::SUCCESS;
+  }
+
+  char zero[sizeof(LogHeader)] = {};
+  const int64_t size = std::min<int64_t>(LogHeader::HEAD_SIZE, m_file_size - m_offset);
+  struct iovec iov;
+  iov.iov_base = zero;
+  iov.iov_len  = size;
+  int ret = write_at(&iov, 1, m_offset);
+  if (0 != ret) {
+    LOG_WARN("write log end mark faild. filename=%s, offset=%ld, ret=%d, error=%s",
+      m_filename.c_str(), m_offset, ret, strerror(ret));
+    return RC::IOERR_WRITE;
+  }
+  return RC::SUCCESS;
+}
+
+int LogFileWriter::write_at(struct iovec* iov, int iovcnt, int64_t offset) {
+  if (m_io_engine == nullptr) {
+    return pwritevn(m_fd, iov, iovcnt, offset);
+  }
+
+  common::AsyncIoRequest request;
+  request.prep_writev(m_fd, iov, iovcnt, offset);
+  return m_io_engine->execute(&request, 1);
+}
+
+void LogFileWriter::add_index(LSN first_lsn) {
+  // 写入总是从一条日志的开头开始，这次写入的第一条日志可以作为索引项
+  if (first_lsn >= m_next_index_lsn) {
+    m_index.push_back(LogIndexEntry{first_lsn, m_offset});
+    m_next_index_lsn = first_lsn + INDEX_INTERVAL;
+  }
+}
+
+std::string LogFileWriter::index_filename(const std::string& filename) {
+  static constexpr std::string_view LOG_SUFFIX = ".log";
+  if (ends_with(filename, LOG_SUFFIX)) {
+    return filename.substr(0, filename.size() - LOG_SUFFIX.size()) + ".idx";
+  }
+  return filename + ".idx";
+}
+
+RC LogFileWriter::write_index() {
+  if (m_fd < 0 || m_index.empty()) {
+    return RC::SUCCESS;
+  }
+
+  const std::string index_file = index_filename(m_filename);
+  const std::string tmp_file   = index_file + ".tmp";
+  int fd = ::open(tmp_file.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    LOG_ERROR("failed to create log index file. filename=%s, errno=%d, error=%s",
+      tmp_file.c_str(), errno, strerror(errno));
+    return RC::FILE_CREATE_ERR;
+  }
+
+  LogIndexFileHeader header;
+  header.count = static_cast<uint32_t>(m_index.size());
+  struct iovec iov[2];
+  iov[0].iov_base = &header;
+  iov[0].iov_len  = sizeof(header);
+  iov[1].iov_base = m_index.data();
+  iov[1].iov_len  = m_index.size() * sizeof(LogIndexEntry);
+  int ret = writevn(fd, iov, 2);
+  if (ret == 0 && ::fdatasync(fd) != 0) {
+    ret = errno;
+  }
+  ::close(fd);
+
+  if (ret != 0 || ::rename(tmp_file.c_str(), index_file.c_str()) != 0) {
+    LOG_ERROR("failed to write log index file. filename=%s, ret=%d, errno=%d, error=%s",
+      index_file.c_str(), ret, errno, strerror(errno));
+    ::unlink(tmp_file.c_str());
+    return RC::IOERR_WRITE;
+  }
+
+  LOG_INFO("write log index file. filename=%s, count=%zu", index_file.c_str(), m_index.size());
   return RC::SUCCESS;
 }
 
@@ -177,6 +460,10 @@ RC LogFileWriter::close() {
     return RC::SUCCESS;
   }
 
+  // 引擎中注册的文件还引用着它
+  if (m_io_engine != nullptr) {
+    m_io_engine->register_files(nullptr, 0);
+  }
   ::close(m_fd);
 
   m_fd = -1;
@@ -195,22 +482,111 @@ RC LogFileWriter::write(const LogEntry& entry) {
     return RC::FILE_FULL;
   }
 
-  // 写入日志头
-  int ret = writen(m_fd, reinterpret_cast<const char *>(&entry.header()), LogHeader::HEAD_SIZE);
-  if (0 != ret) {
-    LOG_WARN("write log entry header faidl. filename=%s, ret=%d, error=%s, entry=%s",
-      m_filename.c_str(), ret, strerror(errno), entry.to_string().c_str());
-    return RC::IOERR_WRITE;
+  // 日志头和日志体一次写入
+  struct iovec iov[2];
+  iov[0].iov_base = const_cast<LogHeader*>(&entry.header());
+  iov[0].iov_len  = LogHeader::HEAD_SIZE;
+  iov[1].iov_base = const_cast<char*>(entry.data());
+  iov[1].iov_len  = entry.payload_size();
+  add_index(entry.lsn());
+  RC rc = pwrite(iov, 2, entry.total_size());
+  if (IS_FAIL(rc)) {
+    LOG_WARN("write log entry faild. filename=%s, entry=%s", m_filename.c_str(), entry.to_string().c_str());
+    return rc;
   }
 
-  ret = writen(m_fd, entry.data(), entry.payload_size());
-  if (0 != ret) {
-    LOG_WARN("write log entry data faild. filename=%s, ret=%d, error=%s, entry=%s",
-      m_filename.c_str(), ret, strerror(errno), entry.to_string().c_str());
-    return RC::IOERR_WRITE;
+  m_last_lsn = entry.lsn();
+  return RC::SUCCESS;
+}
+
+RC LogFileWriter::write_batch(const std::vector<LogEntry>& entries, size_t& written) {
+  written = 0;
+  if (m_fd < 0) {
+    LOG_ERROR("log file not open.");
+    return RC::FILE_NOT_OPEN;
   }
 
-  m_last_lsn = entry.lsn();
+  size_t count = 0;
+  while (count < entries.size() && entries[count].lsn() < m_end_lsn) {
+    count++;
+  }
+
+  if (count > 0) {
+    std::vector<struct iovec> iov(count * 2);
+    int64_t size = 0;
+    for (size_t i = 0; i < count; i++) {
+      const LogEntry& entry = entries[i];
+      iov[i * 2].iov_base     = const_cast<LogHeader*>(&entry.header());
+      iov[i * 2].iov_len      = LogHeader::HEAD_SIZE;
+      iov[i * 2 + 1].iov_base = const_cast<char*>(entry.data());
+      iov[i * 2 + 1].iov_len  = entry.payload_size();
+      size += entry.total_size();
+    }
+
+    add_index(entries[0].lsn());
+    RC rc = pwrite(iov.data(), static_cast<int>(iov.size()), size);
+    if (IS_FAIL(rc)) {
+      LOG_WARN("write log entries faild. filename=%s, count=%zu, rc=%s", m_filename.c_str(), count, strrc(rc));
+      return rc;
+    }
+
+    written    = count;
+    m_last_lsn = entries[count - 1].lsn();
+  }
+
+  if (count < entries.size()) {
+    LOG_INFO("log file is full, lsn=%ld, end_lsn=%ld", entries[count].lsn(), m_end_lsn);
+    return RC::FILE_FULL;
+  }
+  return RC::SUCCESS;
+}
+
+RC LogFileWriter::write_raw(struct iovec* iov, int iovcnt, LSN first_lsn, LSN last_lsn) {
+  if (m_fd < 0) {
+    LOG_ERROR("log file not open.");
+    return RC::FILE_NOT_OPEN;
+  }
+
+  // pwritevn 会修改 iov，先算好长度
+  int64_t size = 0;
+  for (int i = 0; i < iovcnt; i++) {
+    size += iov[i].iov_len;
+  }
+
+  add_index(first_lsn);
+  RC rc = pwrite(iov, iovcnt, size);
+  if (IS_FAIL(rc)) {
+    LOG_WARN("write log entries faild. filename=%s, last_lsn=%ld, rc=%s", m_filename.c_str(), last_lsn, strrc(rc));
+    return rc;
+  }
+
+  m_last_lsn = last_lsn;
+  return RC::SUCCESS;
+}
+
+RC LogFileWriter::sync() {
+  if (m_fd < 0) {
+    LOG_ERROR("log file not open.");
+    return RC::FILE_NOT_OPEN;
+  }
+
+  // O_DSYNC 打开时写入返回就已经落盘了
+  if (m_dsync) {
+    return RC::SUCCESS;
+  }
+
+  int ret = 0;
+  if (m_io_engine != nullptr) {
+    common::AsyncIoRequest request;
+    request.prep_fsync(m_fd);
+    ret = m_io_engine->execute(&request, 1);
+  } else if (::fdatasync(m_fd) != 0) {
+    ret = errno;
+  }
+  if (ret != 0) {
+    LOG_ERROR("sync log file failed. filename=%s, errno=%d, error=%s", m_filename.c_str(), ret, strerror(ret));
+    return RC::IOERR_SYNC;
+  }
   return RC::SUCCESS;
 }
 
@@ -251,9 +627,10 @@ RC LogFileManager::get_lsn_from_filename(const std::string& filename, LSN& lsn)
   }
 }
 
-RC LogFileManager::init(const std::string& dir, int max_file_count) {
+RC LogFileManager::init(const std::string& dir, int max_file_count, int64_t segment_size /* = DEFAULT_SEGMENT_SIZE */) {
   m_dir = dir;
   max_entry_number_per_file_ = max_file_count;
+  m_segment_size = segment_size;
 
   // 创建目录
   if (!std::filesystem::exists(m_dir)) {
@@ -263,13 +640,30 @@ RC LogFileManager::init(const std::string& dir, int max_file_count) {
     }
   }
 
-  // 扫描目录中的日志文件
+  // 上次没有准备完的文件不知道写到了哪里，重新准备
+  std::error_code ec;
+  std::filesystem::remove(m_dir / PREPARE_FILENAME, ec);
+
+  // 扫描目录中的日志文件和空闲文件
+  std::map<int64_t, std::filesystem::path> free_files;
   for (const auto& file : std::filesystem::directory_iterator(m_dir)) {
     if (!file.is_regular_file()) {
       continue;
     }
 
     std::string filename = file.path().filename().string();
+    if (starts_with(filename, CLOG_FILE_PREFIX) && ends_with(filename, FREE_FILE_SUFFIX)) {
+      std::string_view seq_str = filename;
+      seq_str.remove_prefix(CLOG_FILE_PREFIX.size());
+      seq_str.remove_suffix(FREE_FILE_SUFFIX.size());
+      try {
+        free_files[std::stol(std::string(seq_str))] = file.path();
+      } catch (const std::exception&) {
+        LOG_WARN("invalid free log file name %s", filename.c_str());
+      }
+      continue;
+    }
+
     if (!starts_with(filename, CLOG_FILE_PREFIX) || 
       !ends_with(filename, CLOG_FILE_SUFFIX)) {
       continue;
@@ -285,13 +679,20 @@ RC LogFileManager::init(const std::string& dir, int max_file_count) {
     m_log_files[lsn] = file.path();
   }
 
+  m_free_files.clear();
+  for (const auto& [seq, path] : free_files) {
+    m_free_files.push_back(path);
+    m_next_free_seq = seq + 1;
+  }
+  m_prepared_size = 0;
   return RC::SUCCESS;
 }
 
 RC LogFileManager::list_files(std::vector<std::string>& files, LSN start_lsn) {
   files.clear();
   for (const auto& [lsn, path] : m_log_files) {
-    if (lsn >= start_lsn) {
+    // 文件中日志的LSN范围是 [lsn, lsn + max_entry_number_per_file_)
+    if (lsn + max_entry_number_per_file_ > start_lsn) {
       files.push_back(path.string());
     }
   }
@@ -305,11 +706,23 @@ RC LogFileManager::last_file(LogFileWriter& writer) {
 
   auto it = m_log_files.rbegin();
   std::string filename = it->second.string();
-  return writer.open(filename, it->first + max_entry_number_per_file_);
+  return writer.open(filename, it->first + max_entry_number_per_file_, m_segment_size > 0, m_segment_size);
 }
 
 RC LogFileManager::next_file(LogFileWriter& writer) {
-  writer.close();
+  if (writer.is_open()) {
+    // 索引文件写失败不影响日志，读取时从头查找
+    (void)writer.write_index();
+    RC rc = writer.mark_end();
+    if (IS_SUCC(rc)) {
+      rc = writer.sync();
+    }
+    if (IS_FAIL(rc)) {
+      LOG_ERROR("failed to mark the end of log file. file=%s, rc=%s", writer.filename(), strrc(rc));
+      return rc;
+    }
+    writer.close();
+  }
 
   LSN next_lsn = 0;
   if (!m_log_files.empty()) {
@@ -321,5 +734,157 @@ RC LogFileManager::next_file(LogFileWriter& writer) {
     + std::string(LogFileManager::CLOG_FILE_PREFIX)
     + std::to_string(next_lsn)
     + std::string(LogFileManager::CLOG_FILE_SUFFIX);
-  return writer.open(filename, next_lsn + max_entry_number_per_file_);
-}
\ No newline at end of file
+  RC rc = m_free_files.empty() ? create_file(filename) : reuse_free_file(filename);
+  if (IS_FAIL(rc)) {
+    return rc;
+  }
+
+  rc = writer.open(filename, next_lsn + max_entry_number_per_file_, m_segment_size > 0, m_segment_size);
+  if (IS_SUCC(rc)) {
+    m_log_files[next_lsn] = filename;
+  }
+  return rc;
+}
+
+RC LogFileManager::create_file(const std::string& filename) {
+  if (m_segment_size <= 0) {
+    return RC::SUCCESS;
+  }
+
+  int fd = ::open(filename.c_str(), O_WRONLY | O_CREAT, 0644);
+  if (fd < 0) {
+    LOG_ERROR("failed to create log file. filename=%s, errno=%d, error=%s", filename.c_str(), errno, strerror(errno));
+    return RC::FILE_CREATE_ERR;
+  }
+  int ret = ::posix_fallocate(fd, 0, m_segment_size);
+  ::close(fd);
+  if (ret != 0) {
+    // 不支持预分配时写入会自己扩展文件
+    LOG_WARN("failed to preallocate log file. filename=%s, size=%ld, error=%s", filename.c_str(), m_segment_size, strerror(ret));
+  }
+  return RC::SUCCESS;
+}
+
+RC LogFileManager::reuse_free_file(const std::string& filename) {
+  const std::filesystem::path free_file = m_free_files.front();
+
+  // 清掉第一条日志头，文件改名之后还没有写入时它就是一个空的日志文件
+  int fd = ::open(free_file.c_str(), O_WRONLY);
+  if (fd < 0) {
+    LOG_ERROR("failed to open free log file. filename=%s, errno=%d, error=%s", free_file.c_str(), errno, strerror(errno));
+    return RC::FILE_NOT_FOUND;
+  }
+  char zero[LogHeader::HEAD_SIZE] = {0};
+  struct iovec iov;
+  iov.iov_base = zero;
+  iov.iov_len  = sizeof(zero);
+  int ret = pwritevn(fd, &iov, 1, 0);
+  if (ret == 0 && ::fdatasync(fd) != 0) {
+    ret = errno;
+  }
+  ::close(fd);
+  if (ret != 0) {
+    LOG_ERROR("failed to clear free log file. filename=%s, error=%s", free_file.c_str(), strerror(ret));
+    return RC::IOERR_WRITE;
+  }
+
+  if (::rename(free_file.c_str(), filename.c_str()) != 0) {
+    LOG_ERROR("failed to rename free log file. from=%s, to=%s, errno=%d, error=%s",
+      free_file.c_str(), filename.c_str(), errno, strerror(errno));
+    return RC::IOERR_WRITE;
+  }
+  m_free_files.pop_front();
+  LOG_INFO("reuse free log file. from=%s, to=%s, free_files=%zu", free_file.c_str(), filename.c_str(), m_free_files.size());
+  return RC::SUCCESS;
+}
+
+RC LogFileManager::add_free_file(const std::filesystem::path& path) {
+  const std::filesystem::path free_file = m_dir / (std::string(CLOG_FILE_PREFIX)
+    + std::to_string(m_next_free_seq)
+    + std::string(FREE_FILE_SUFFIX));
+  if (::rename(path.c_str(), free_file.c_str()) != 0) {
+    LOG_ERROR("failed to rename log file to free file. from=%s, to=%s, errno=%d, error=%s",
+      path.c_str(), free_file.c_str(), errno, strerror(errno));
+    return RC::IOERR_WRITE;
+  }
+  m_next_free_seq++;
+  m_free_files.push_back(free_file);
+  return RC::SUCCESS;
+}
+
+RC LogFileManager::recycle_files(LSN lsn) {
+  while (m_log_files.size() > 1) {
+    auto iter = m_log_files.begin();
+    if (iter->first + max_entry_number_per_file_ > lsn) {
+      break;
+    }
+
+    const std::filesystem::path path = iter->second;
+    std::error_code ec;
+    std::filesystem::remove(LogFileWriter::index_filename(path.string()), ec);
+
+    // 只有预分配的文件值得回收，随写入增长的文件大小不固定
+    RC rc = RC::SUCCESS;
+    if (m_segment_size > 0 && m_free_files.size() < MAX_FREE_FILES) {
+      rc = add_free_file(path);
+    } else if (::unlink(path.c_str()) != 0) {
+      LOG_ERROR("failed to remove log file. filename=%s, errno=%d, error=%s", path.c_str(), errno, strerror(errno));
+      rc = RC::IOERR_WRITE;
+    }
+    if (IS_FAIL(rc)) {
+      return rc;
+    }
+
+    LOG_INFO("recycle log file. filename=%s, lsn=%ld, free_files=%zu", path.c_str(), lsn, m_free_files.size());
+    m_log_files.erase(iter);
+  }
+  return RC::SUCCESS;
+}
+
+RC LogFileManager::prepare_file(int64_t max_bytes) {
+  if (m_segment_size <= 0 || max_bytes <= 0 || !m_free_files.empty()) {
+    return RC::SUCCESS;
+  }
+
+  const std::filesystem::path prepare_file = m_dir / PREPARE_FILENAME;
+  int fd = ::open(prepare_file.c_str(), O_WRONLY | O_CREAT, 0644);
+  if (fd < 0) {
+    LOG_ERROR("failed to create log file. filename=%s, errno=%d, error=%s", prepare_file.c_str(), errno, strerror(errno));
+    return RC::FILE_CREATE_ERR;
+  }
+  // 每次写一块并落盘，不要一次产生太多脏页
+  static constexpr int64_t CHUNK_SIZE = 1024 * 1024;
+  std::vector<char> zero(std::min({CHUNK_SIZE, max_bytes, m_segment_size}), 0);
+  int     ret     = 0;
+  int64_t written = 0;
+  while (ret == 0 && written < max_bytes && m_prepared_size < m_segment_size) {
+    struct iovec iov;
+    iov.iov_base = zero.data();
+    iov.iov_len  = std::min<int64_t>(zero.size(), m_segment_size - m_prepared_size);
+    const int64_t size = iov.iov_len;
+    ret = pwritevn(fd, &iov, 1, m_prepared_size);
+    if (ret == 0 && ::fdatasync(fd) != 0) {
+      ret = errno;
+    }
+    if (ret == 0) {
+      m_prepared_size += size;
+      written += size;
+    }
+  }
+  ::close(fd);
+  if (ret != 0) {
+    LOG_ERROR("failed to prepare log file. filename=%s, size=%ld, error=%s", prepare_file.c_str(), m_prepared_size, strerror(ret));
+    return RC::IOERR_WRITE;
+  }
+
+  if (m_prepared_size < m_segment_size) {
+    return RC::SUCCESS;
+  }
+
+  RC rc = add_free_file(prepare_file);
+  if (IS_SUCC(rc)) {
+    m_prepared_size = 0;
+    LOG_INFO("prepared a free log file. size=%ld", m_segment_size);
+  }
+  return rc;
+}
@@ -4,28 +4,63 @@
 #include <string_view>
 #include <functional>
 #include <filesystem>
+#include <deque>
 #include <map>
+#include <vector>
 #include "common/types.h"
 #include "common/rc.h"
 
 
 class LogEntry;
+struct LogHeader;
+struct iovec;
+
+namespace common {
+class AsyncIoEngine;
+}
+
+/**
+ * @brief 日志文件的稀疏索引项
+ * @details 文件写满切换到下一个文件时，每隔 LogFileWriter::INDEX_INTERVAL 个LSN记录一条日志在文件中的位置，
+ * 写到和日志文件同名、后缀是 .idx 的索引文件中。读取时二分查找，从不大于目标LSN的最近一项开始向后找
+ */
+struct LogIndexEntry final {
+  LSN     lsn{0};     // 日志序列号
+  int64_t offset{0};  // 日志头在文件中的偏移
+};
 
 /**
  * @brief 日志文件读取器类
  * 用于读取日志文件中的日志条目
+ * @details 有两种读取方式：
+ * - BUFFERED：用 read 读取，每条日志都复制一份数据；
+ * - MMAP：把整个文件映射到内存，回调拿到的 LogEntry 是指向映射内存的视图(LogEntry::is_view)，
+ *   只在 close 之前有效，需要保存的话自己复制。
+ * 两种方式都会使用索引文件(如果有的话)定位起始LSN。
+ *
+ * 遍历时检查每条日志的魔数、版本和 check_sum，遇到写了一半(torn write)或者损坏的日志时停下，
+ * 不再读后面的内容，iterate 仍然返回成功，通过 torn 和 valid_size 获取停下的位置。
+ * 日志文件是预分配的，遇到全0的日志头或者LSN没有递增的日志(回收的文件中以前的日志)时正常结束。
  */
 class LogFileReader {
+public:
+  enum class Mode
+  {
+    BUFFERED,
+    MMAP
+  };
+
 public:
   LogFileReader() = default;
-  ~LogFileReader() = default;
+  ~LogFileReader();
 
   /**
    * @brief 打开日志文件
    * @param filename 日志文件名
+   * @param mode 读取方式
    * @return 返回操作结果
    */
-  RC open(const std::string& filename);
+  RC open(const std::string& filename, Mode mode = Mode::BUFFERED);
   RC close();
   
   /**
@@ -36,6 +71,24 @@ public:
    */
   RC iterate(std::function<RC(LogEntry&)> callback, LSN start_lsn = 0);
 
+  /// 加载的索引项，没有索引文件时为空
+  const std::vector<LogIndexEntry>& index() const { return m_index; }
+
+  /**
+   * @brief 上一次 iterate 是否因为不完整或者损坏的日志停下
+   */
+  bool torn() const { return m_torn; }
+
+  /**
+   * @brief 上一次 iterate 读到的位置，torn 时是最后一条完整日志的结束位置，可以截断到这里
+   */
+  int64_t valid_size() const { return m_offset; }
+
+  /**
+   * @brief 上一次 iterate 读到的最后一条完整日志的LSN，没有读到日志时是0
+   */
+  LSN last_lsn() const { return m_last_lsn; }
+
 private:
   /**
    * @brief 跳转到指定LSN的日志条目
@@ -43,10 +96,26 @@ private:
    * @return RC::SUCCESS: 成功, 其他: 失败
    */
   RC go_to(LSN lsn); 
+
+  /// 根据索引找到不大于 lsn 的最近一条日志的位置，没有索引或者索引和文件对不上时返回0
+  int64_t index_lookup(LSN lsn) const;
+  bool    read_header(int64_t offset, LogHeader& header) const;
+
+  RC   load_index();
+  void mark_torn(const char* reason);
   
 private:
   std::string  m_filename; // 文件名
   int          m_fd = -1;  // 文件描述符
+  Mode         m_mode = Mode::BUFFERED;
+
+  const char*  m_data   = nullptr;  // MMAP 方式映射的文件内容
+  int64_t      m_size   = 0;        // 打开时的文件大小
+  int64_t      m_offset = 0;        // 下一条日志的位置
+  bool         m_torn   = false;    // 是否遇到了不完整或者损坏的日志
+  LSN          m_last_lsn = 0;      // 读到的最后一条日志的LSN
+
+  std::vector<LogIndexEntry> m_index;
 };
 
 
@@ -55,19 +124,32 @@ private:
  * 用于向日志文件写入日志条目
  */
 class LogFileWriter {
+public:
+  static constexpr LSN INDEX_INTERVAL = 1024;  /// 稀疏索引中相邻两项的LSN间隔
+
 public:
   LogFileWriter() = default;
   ~LogFileWriter();
 
   /**
    * @brief 打开日志文件
+   * @details 从最后一条完整日志之后继续写。文件可能是预分配或者回收来的，大小不代表日志的结尾，
+   * 所以打开时先扫描一遍文件。
    * @param filename 日志文件名
    * @param end_lsn 文件允许的最大LSN
+   * @param dsync 使用 O_DSYNC 打开，每次写入返回时就已经落盘，sync 不再需要 fdatasync
+   * @param extend_size 写到预分配空间的末尾时，每次再用 fallocate 预分配多少字节，0表示不预分配
    * @return 返回操作结果
    */
-  RC open(const std::string& filename, LSN end_lsn);
+  RC open(const std::string& filename, LSN end_lsn, bool dsync = false, int64_t extend_size = 0);
   RC close();
 
+  /**
+   * @brief 写日志和落盘通过异步IO引擎提交，为空时直接调用 pwritev 和 fdatasync
+   * @details 需要在 open 之前设置，打开的文件注册到引擎中。引擎不属于 writer，调用者保证同一时间只有一个线程使用
+   */
+  void set_io_engine(common::AsyncIoEngine* io_engine) { m_io_engine = io_engine; }
+
   /**
    * @brief 写入日志条目
    * @param entry 要写入的日志条目
@@ -75,12 +157,50 @@ public:
    */
   RC write(const LogEntry& entry);
 
+  /**
+   * @brief 批量写入日志条目，所有条目合并成一次 writev
+   * @details 只写入 LSN 小于 end_lsn 的那部分，写入之后不会落盘，需要再调用 sync
+   * @param entries 要写入的日志条目，按LSN递增
+   * @param written 输出参数，实际写入的条目数
+   * @return 有条目因为文件已满没有写入时返回 FILE_FULL
+   */
+  RC write_batch(const std::vector<LogEntry>& entries, size_t& written);
+
+  /**
+   * @brief 写入已经序列化好的日志，LogBuffer 用它直接写环形缓冲区中的数据
+   * @param iov 日志数据，格式和文件中的一样，部分写入时会被修改
+   * @param first_lsn 第一条日志的LSN
+   * @param last_lsn 最后一条日志的LSN，调用者保证小于 end_lsn
+   * @return 返回操作结果
+   */
+  RC write_raw(struct iovec* iov, int iovcnt, LSN first_lsn, LSN last_lsn);
+
+  /**
+   * @brief 把写入过程中记录的稀疏索引写到索引文件中，文件写满切换时调用
+   * @details 先写临时文件再改名，索引文件要么是完整的，要么不存在
+   */
+  RC write_index();
+
+  /**
+   * @brief 在最后一条日志后面写一个全0的日志头作为结束标记
+   * @details 预分配的空间已经是0，回收的文件后面是旧日志，关闭文件前调用，
+   * 读的时候不会把旧日志当作这个文件的日志
+   */
+  RC mark_end();
+
+  /**
+   * @brief 把已经写入的日志落盘(fdatasync)，O_DSYNC 打开时什么都不做
+   * @return 返回操作结果
+   */
+  RC sync();
+
   /**
    * @brief 检查文件是否已打开
    * @return true: 已打开, false: 未打开
    */
   bool is_open() const;
   bool is_full() const;
+  LSN  end_lsn() const { return m_end_lsn; }
   std::string to_string() const;
 
   /**
@@ -89,11 +209,34 @@ public:
    */
   const char* filename() const { return m_filename.c_str(); }
 
+  /**
+   * @brief 日志文件对应的索引文件名
+   */
+  static std::string index_filename(const std::string& filename);
+
+private:
+  /// 一次写入之前调用，first_lsn 是这次写入的第一条日志，需要的话记录一条索引
+  void add_index(LSN first_lsn);
+  /// 写入 size 字节之前确保预分配的空间足够
+  RC   reserve(int64_t size);
+  /// 在 m_offset 处写入，成功后移动 m_offset
+  RC   pwrite(struct iovec* iov, int iovcnt, int64_t size);
+  /// 在 offset 处写入全部数据，成功返回0，失败返回errno
+  int  write_at(struct iovec* iov, int iovcnt, int64_t offset);
+
 private:
   std::string  m_filename;       // 文件名
   int          m_fd = -1;        // 文件描述符
   LSN          m_last_lsn = 0;   // 写入的最后一个LSN
   LSN          m_end_lsn = 0;    // 文件允许的最大LSN
+  int64_t      m_offset = 0;     // 下一次写入的位置
+  int64_t      m_file_size = 0;  // 文件大小，包括预分配的空间
+  int64_t      m_extend_size = 0;  // 每次预分配的大小
+  bool         m_dsync = false;  // 是否使用 O_DSYNC 打开
+  common::AsyncIoEngine* m_io_engine = nullptr;  // 为空时同步写
+
+  std::vector<LogIndexEntry> m_index;     // 这次打开之后记录的索引
+  LSN                        m_next_index_lsn = 0;
 };
 
 
@@ -102,6 +245,10 @@ private:
  * 用于管理日志文件的创建、删除和查询
  */
 class LogFileManager {
+public:
+  static constexpr int64_t DEFAULT_SEGMENT_SIZE = 64 * 1024 * 1024;  /// 预分配日志文件的大小
+  static constexpr size_t  MAX_FREE_FILES       = 4;                 /// 最多保留多少个回收的日志文件
+
 public:
   LogFileManager() = default;
   ~LogFileManager() = default;
@@ -110,9 +257,11 @@ public:
    * @brief 初始化日志文件管理器
    * @param dir 日志文件目录
    * @param max_file_count 最大文件数量
+   * @param segment_size 新日志文件预分配的大小，写满之后每次再扩展这么多。0表示不预分配，
+   * 文件随写入增长，使用 fdatasync 落盘
    * @return 返回操作结果
    */
-  RC init(const std::string& dir, int max_file_count);
+  RC init(const std::string& dir, int max_file_count, int64_t segment_size = DEFAULT_SEGMENT_SIZE);
 
   /**
    * @brief 列出日志文件
@@ -128,7 +277,33 @@ public:
    * @return 返回操作结果
    */
   RC last_file(LogFileWriter& writer);
+  /**
+   * @brief 创建下一个日志文件，它的起始LSN是上一个文件的结束LSN
+   * @details writer 当前打开的文件写满了，关闭之前写索引文件和结束标记。
+   * 有回收的文件时改名使用它，否则创建新文件并预分配 segment_size 字节
+   */
   RC next_file(LogFileWriter& writer);
+
+  /**
+   * @brief 回收LSN全部小于 lsn 的日志文件，检查点之后调用
+   * @details 回收的文件改名放到空闲文件池中，下次切换文件时直接使用，不用再分配空间。
+   * 池满了就删除。最后一个文件正在写，不会回收
+   * @param lsn 这个LSN之前的日志已经不需要了
+   */
+  RC recycle_files(LSN lsn);
+
+  /**
+   * @brief 空闲文件池为空时，准备一个写过0的日志文件
+   * @details fallocate 分配的空间第一次写入时还要修改文件系统的元数据，O_DSYNC 写入会更慢。
+   * 每次调用最多写 max_bytes 字节，写完整个文件之后放入空闲文件池。
+   * 在空闲的时候调用，避免影响写日志
+   * @param max_bytes 这次最多写多少字节
+   */
+  RC prepare_file(int64_t max_bytes);
+
+  size_t  free_file_count() const { return m_free_files.size(); }
+  int64_t segment_size() const { return m_segment_size; }
+  int32_t max_entry_number_per_file() const { return max_entry_number_per_file_; }
 private:
   /**
    * @brief 从文件名中提取LSN
@@ -137,12 +312,26 @@ private:
    * @return 返回操作结果
    */
   static RC get_lsn_from_filename(const std::string& filename, LSN& lsn);
+
+  /// 把一个文件放入空闲文件池
+  RC add_free_file(const std::filesystem::path& path);
+  /// 用空闲文件池中的文件作为新的日志文件，它之前的内容通过结束标记和LSN区分
+  RC reuse_free_file(const std::string& filename);
+  /// 创建新的日志文件并预分配空间
+  RC create_file(const std::string& filename);
 private:
   static constexpr std::string_view CLOG_FILE_PREFIX = "clog_";
   static constexpr std::string_view CLOG_FILE_SUFFIX = ".log";
+  static constexpr std::string_view FREE_FILE_SUFFIX = ".free";
+  static constexpr std::string_view PREPARE_FILENAME = "clog_prepare.tmp";
 
   std::filesystem::path        m_dir;
-  int32_t                      max_entry_number_per_file_;
+  int32_t                      max_entry_number_per_file_ = 0;
 
   std::map<LSN, std::filesystem::path> m_log_files;
+
+  int64_t                            m_segment_size = 0;
+  std::deque<std::filesystem::path>  m_free_files;         // 空闲文件池
+  int64_t                            m_next_free_seq = 0;  // 下一个空闲文件的编号
+  int64_t                            m_prepared_size = 0;  // 正在准备的文件已经写了多少
 };
@@ -0,0 +1,29 @@
+#include "storage/clog/log_handler.h"
+#include "storage/clog/disk_log_handler.h"
+#include "storage/clog/vacuous_log_handler.h"
+#include "common/log/log.h"
+
+RC LogHandler::append(LSN& lsn, LogModule::Id module_id, std::string_view data) {
+  return append(lsn, LogModule(module_id), std::vector<char>(data.begin(), data.end()));
+}
+
+RC LogHandler::append(LSN& lsn, LogModule::Id module_id, std::vector<char>&& data) {
+  return append(lsn, LogModule(module_id), std::move(data));
+}
+
+RC LogHandler::append(LSN& lsn, LogModule module, std::vector<char>&& data) {
+  return _append(lsn, module, std::move(data));
+}
+
+RC LogHandler::create(const std::string& name, LogHandler*& handler) {
+  if (name.empty() || name == "vacuous") {
+    handler = new VacuousLogHandler();
+  } else if (name == "disk") {
+    handler = new DiskLogHandler();
+  } else {
+    LOG_ERROR("unknown log handler name: %s", name.c_str());
+    handler = nullptr;
+    return RC::INVALID_ARGUMENT;
+  }
+  return RC::SUCCESS;
+}
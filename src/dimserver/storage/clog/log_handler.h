@@ -60,7 +60,7 @@ public:
 
   /**
    * @brief 遍历日志
-   * @param consumer 日志消费者回调函数
+   * @param consumer 日志消费者回调函数，拿到的日志可能是视图(LogEntry::is_view)，只在回调中有效
    * @param start_lsn 起始日志序列号
    * @return 返回操作结果
    */
@@ -95,6 +95,8 @@ public:
 
   /**
    * @brief 等待指定LSN的日志被处理
+   * @details 返回成功时 lsn 及之前的日志都已经落盘。并发等待的线程由 LogBuffer 的组提交
+   * 合并成一次 fdatasync，参考 LogBuffer::group_commit
    * @param lsn 要等待的日志序列号
    * @return 返回操作结果
    */
@@ -106,6 +108,21 @@ public:
    */
   virtual LSN current_lsn() const = 0;
 
+  /**
+   * @brief 这个LSN之前的日志都已经落盘
+   * @details 默认和 current_lsn 相同，也就是追加就算落盘
+   */
+  virtual LSN flushed_lsn() const { return current_lsn(); }
+
+  /**
+   * @brief 回收不再需要的日志
+   * @details 检查点完成之后调用，lsn 之前的日志恢复时不会再回放，参考 Checkpointer。
+   * 默认什么都不做
+   * @param lsn 恢复的起点
+   * @return 返回操作结果
+   */
+  virtual RC recycle(LSN /*lsn*/) { return RC::SUCCESS; }
+
   /**
    * @brief 创建日志处理器实例
    * @param name 日志处理器名称
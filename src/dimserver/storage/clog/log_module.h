@@ -16,7 +16,8 @@ public:
     BUFFER_POOL,   // 缓存池模块
     BPLUS_TREE,    // B+树模块
     RECORD_MANAGER,// 记录管理模块
-    TRANSACTION    // 事务模块
+    TRANSACTION,   // 事务模块
+    CHECKPOINT     // 检查点，参考 Checkpointer
   };
 
 public:
@@ -43,6 +44,7 @@ public:
       xx(BPLUS_TREE);
       xx(RECORD_MANAGER);
       xx(TRANSACTION);
+      xx(CHECKPOINT);
 #undef xx
       default:
         return "UNKNOWN";
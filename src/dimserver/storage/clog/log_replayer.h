@@ -2,10 +2,15 @@
 
 #include <string>
 #include "common/rc.h"
+#include "common/types.h"
 
 class LogEntry;
 
 class LogReplayer {
+public:
+  /// 不能和其它日志并行回放的日志，参考 partition
+  static constexpr uint64_t BARRIER = UINT64_MAX;
+
 public:
   LogReplayer()          = default;
   virtual ~LogReplayer() = default;
@@ -15,4 +20,22 @@ public:
 
   virtual RC on_done() { return RC::SUCCESS; }
 
-};
\ No newline at end of file
+  /**
+   * @brief 并行回放时日志所属的分区
+   * @details 同一个分区的日志按照LSN顺序回放，不同分区的日志可能在不同的线程中同时回放，
+   * 参考 ParallelLogReplayer。页面级别的日志一般用 page_partition 按页面分区。
+   * 返回 BARRIER 的日志要等它之前的所有日志回放完成之后单独回放，它之后的日志也要等它回放完成，
+   * 比如修改整个 buffer pool 元数据的分配/释放页面日志。
+   * 默认所有日志都是 BARRIER，也就是串行回放。
+   */
+  virtual uint64_t partition(const LogEntry& /*entry*/) const { return BARRIER; }
+
+  /**
+   * @brief 按照 (buffer_pool_id, page_num) 分区
+   */
+  static uint64_t page_partition(int32_t buffer_pool_id, PageNum page_num)
+  {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(buffer_pool_id)) << 32) | static_cast<uint32_t>(page_num);
+  }
+
+};
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "storage/clog/log_entry.h"
+#include "storage/clog/log_replayer.h"
+
+/**
+ * @brief 并行回放日志
+ * @details 读日志的线程调用 dispatch/replay，按照 LogReplayer::partition 把日志分发到
+ * thread_num 个工作线程的队列中，同一个分区的日志总是进入同一个队列，所以按照LSN顺序回放。
+ * 日志先在读线程中按工作线程攒成一批再入队，减少加锁的次数；队列满时读线程等待，
+ * 避免把整个日志文件读到内存中。
+ *
+ * 遇到 BARRIER 日志时，先把所有攒着的日志入队并等待工作线程全部回放完成，
+ * 然后在读线程中回放这条日志，之后的日志再继续分发。
+ *
+ * 分发的日志可以是指向 mmap 日志文件的视图，工作线程直接使用，不复制数据。
+ *
+ * 任何一条日志回放失败之后，后面的日志不再回放，dispatch 和 on_done 返回第一个错误。
+ *
+ * @note 被包装的 replayer 要能在多个线程中同时回放不同分区的日志。
+ * thread_num 不大于1时不创建线程，直接在调用线程中回放。
+ * @ingroup CLog
+ */
+class ParallelLogReplayer : public LogReplayer
+{
+public:
+  static constexpr int BATCH_SIZE       = 64;  /// 每批日志的条数
+  static constexpr int MAX_QUEUED_BATCH = 16;  /// 每个工作线程最多排队的批数
+
+public:
+  ParallelLogReplayer(LogReplayer& replayer, int thread_num);
+  virtual ~ParallelLogReplayer();
+
+  RC start();
+
+  /**
+   * @brief 分发一条日志，日志会被移走
+   */
+  RC dispatch(LogEntry&& entry);
+
+  /// 复制一份日志再分发
+  RC replay(const LogEntry& entry) override;
+
+  /**
+   * @brief 等待已经分发的日志都回放完成
+   * @details 分发的日志是视图(LogEntry::is_view)时，要在视图指向的内存释放之前调用
+   * @return 回放过程中的第一个错误
+   */
+  RC drain();
+
+  /**
+   * @brief 等待所有日志回放完成，停止工作线程，然后调用被包装 replayer 的 on_done
+   */
+  RC on_done() override;
+
+  uint64_t partition(const LogEntry& entry) const override { return replayer_.partition(entry); }
+
+  int      thread_num() const { return thread_num_ > 1 ? thread_num_ : 1; }
+  uint64_t barrier_count() const { return barrier_count_; }
+
+private:
+  struct Worker
+  {
+    std::mutex                         mutex;
+    std::condition_variable            not_empty;
+    std::condition_variable            not_full;
+    std::deque<std::vector<LogEntry>>  batches;
+    std::vector<LogEntry>              pending;  /// 读线程正在攒的一批，只有读线程访问
+    std::thread                        thread;
+    bool                               stopping = false;
+  };
+
+  void worker_func(Worker& worker);
+
+  int  worker_index(uint64_t partition) const;
+  void submit(Worker& worker);
+
+  void stop_workers();
+
+  void set_error(RC rc);
+  RC   error() const { return error_.load(std::memory_order_acquire); }
+
+private:
+  LogReplayer& replayer_;
+  const int    thread_num_;
+  bool         running_ = false;
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+
+  std::atomic<int64_t>    queued_{0};  /// 已经入队还没有回放完成的日志条数
+  std::mutex              idle_mutex_;
+  std::condition_variable idle_cv_;
+
+  std::atomic<RC> error_{RC::SUCCESS};
+  uint64_t        barrier_count_ = 0;
+};
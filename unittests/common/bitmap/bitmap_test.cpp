@@ -1,4 +1,7 @@
 #include <gtest/gtest.h>
+#include <random>
+#include <vector>
+
 #include "common/bitmap/bitmap.h"
 
 class BitmapTest : public ::testing::Test {
@@ -156,4 +159,135 @@ TEST_F(BitmapTest, ToString) {
   
   std::string expected = "10101010";
   EXPECT_EQ(bitmap.to_string(), expected);
-} 
\ No newline at end of file
+} 
+
+// 测试超出 size 的位不影响查找，最后一个字节和最后一个字都不完整
+TEST_F(BitmapTest, TailBits) {
+  std::vector<char> data(16, static_cast<char>(0xFF));
+  Bitmap            bitmap(data.data(), 70);
+  EXPECT_EQ(bitmap.next_zero_bit(0), -1);
+  EXPECT_EQ(bitmap.count(), 70);
+  bitmap.clear(69);
+  EXPECT_EQ(bitmap.next_zero_bit(0), 69);
+
+  std::fill(data.begin(), data.end(), 0);
+  data[9] = static_cast<char>(0xC0);  // 第78、79位，超出 size
+  EXPECT_EQ(bitmap.next_one_bit(0), -1);
+  EXPECT_EQ(bitmap.count(), 0);
+  EXPECT_EQ(bitmap.next_one_bit(-5), -1);
+  EXPECT_EQ(bitmap.next_zero_bit(70), -1);
+}
+
+// 测试范围修改和计数，范围的两头不在字节边界上
+TEST_F(BitmapTest, Range) {
+  std::vector<char> data(64, 0);
+  Bitmap            bitmap(data.data(), 500);
+  bitmap.set_range(3, 203);
+  EXPECT_EQ(bitmap.count(), 200);
+  EXPECT_EQ(bitmap.next_one_bit(0), 3);
+  EXPECT_EQ(bitmap.next_zero_bit(3), 203);
+
+  bitmap.clear_range(10, 12);
+  EXPECT_EQ(bitmap.count(), 198);
+  EXPECT_EQ(bitmap.next_zero_bit(3), 10);
+  EXPECT_TRUE(bitmap.get(12));
+
+  bitmap.set_range(450, 1000);  // 超出 size 的部分忽略
+  EXPECT_EQ(bitmap.count(), 248);
+  EXPECT_EQ(data[63], 0);
+  bitmap.clear_range(5, 5);
+  EXPECT_EQ(bitmap.count(), 248);
+  bitmap.clear_range(0, 500);
+  EXPECT_EQ(bitmap.count(), 0);
+}
+
+// 测试查找的结果和逐位查找一样，包括 AVX2 和普通实现、有没有摘要
+TEST_F(BitmapTest, RandomSearch) {
+  std::mt19937 random(1);
+  for (bool avx2 : {false, true}) {
+    Bitmap::set_avx2_enabled(avx2);
+    for (bool summary : {false, true}) {
+      for (int size : {1, 63, 64, 65, 511, 4096, 5000, 70001}) {
+        // 不同的密度：大部分是1时找0，大部分是0时找1
+        for (int density : {0, 1, 50, 999, 1000}) {
+          std::vector<char> data((size + 7) / 8 + 3, 0);
+          Bitmap            bitmap(data.data(), size);
+          if (summary) {
+            bitmap.enable_summary();
+          }
+          std::vector<bool> expected(size);
+          for (int i = 0; i < size; i++) {
+            if (static_cast<int>(random() % 1000) < density) {
+              bitmap.set(i);
+              expected[i] = true;
+            }
+          }
+          // 开启摘要之后的修改也要反映到摘要中
+          const int start = static_cast<int>(random() % size);
+          const int end   = start + static_cast<int>(random() % 3000);
+          if (density >= 500) {
+            bitmap.set_range(start, end);
+          } else {
+            bitmap.clear_range(start, end);
+          }
+          for (int i = start; i < std::min(end, size); i++) {
+            expected[i] = density >= 500;
+          }
+
+          int count = 0;
+          for (int i = 0; i < size; i++) {
+            count += expected[i] ? 1 : 0;
+          }
+          ASSERT_EQ(bitmap.count(), count);
+
+          for (int probe = 0; probe < 50; probe++) {
+            const int from      = static_cast<int>(random() % size);
+            int       next_zero = -1;
+            int       next_one  = -1;
+            for (int i = from; i < size && (next_zero < 0 || next_one < 0); i++) {
+              if (!expected[i] && next_zero < 0) {
+                next_zero = i;
+              }
+              if (expected[i] && next_one < 0) {
+                next_one = i;
+              }
+            }
+            ASSERT_EQ(bitmap.next_zero_bit(from), next_zero)
+                << "size=" << size << ", density=" << density << ", from=" << from << ", avx2=" << avx2;
+            ASSERT_EQ(bitmap.next_one_bit(from), next_one)
+                << "size=" << size << ", density=" << density << ", from=" << from << ", avx2=" << avx2;
+          }
+        }
+      }
+    }
+  }
+  Bitmap::set_avx2_enabled(true);
+}
+
+// 测试摘要在逐位修改之后保持正确
+TEST_F(BitmapTest, Summary) {
+  const int         size = 4096 * 3 + 17;
+  std::vector<char> data((size + 7) / 8, 0);
+  Bitmap            bitmap(data.data(), size);
+  bitmap.set_range(0, size);
+  bitmap.enable_summary();
+  EXPECT_TRUE(bitmap.summary_enabled());
+  EXPECT_EQ(bitmap.next_zero_bit(0), -1);
+
+  bitmap.clear(size - 1);
+  EXPECT_EQ(bitmap.next_zero_bit(0), size - 1);
+  bitmap.clear(5000);
+  EXPECT_EQ(bitmap.next_zero_bit(0), 5000);
+  bitmap.set(5000);
+  EXPECT_EQ(bitmap.next_zero_bit(0), size - 1);
+  EXPECT_EQ(bitmap.next_zero_bit(size), -1);
+
+  bitmap.clear_range(0, size);
+  EXPECT_EQ(bitmap.next_one_bit(0), -1);
+  bitmap.set(4096 * 2);
+  EXPECT_EQ(bitmap.next_one_bit(1), 4096 * 2);
+
+  bitmap.init(data.data(), size);
+  EXPECT_FALSE(bitmap.summary_enabled());
+  EXPECT_EQ(bitmap.next_one_bit(1), 4096 * 2);
+}
@@ -0,0 +1,101 @@
+#include <gtest/gtest.h>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "common/compress/lz4.h"
+
+using namespace std;
+
+static string round_trip(const string& data, int* compressed_size = nullptr) {
+  vector<char> compressed(lz4_compress_bound(data.size()));
+  const int size = lz4_compress(data.data(), static_cast<int>(data.size()), compressed.data(),
+      static_cast<int>(compressed.size()));
+  EXPECT_GT(size, 0);
+  if (compressed_size != nullptr) {
+    *compressed_size = size;
+  }
+
+  string result(data.size(), '\0');
+  EXPECT_EQ(lz4_decompress(compressed.data(), size, result.data(), static_cast<int>(result.size())),
+      static_cast<int>(data.size()));
+  return result;
+}
+
+// 测试各种长度和内容的数据压缩之后能还原
+TEST(Lz4Test, RoundTrip) {
+  mt19937 rng(42);
+  for (size_t size : {0, 1, 4, 12, 13, 15, 16, 100, 255, 256, 4096, 8192, 70000, 1 << 20}) {
+    string random(size, '\0');
+    for (char& c : random) {
+      c = static_cast<char>(rng());
+    }
+    EXPECT_EQ(round_trip(random), random) << "size=" << size;
+
+    string repeated;
+    while (repeated.size() < size) {
+      repeated += "row " + to_string(repeated.size() % 97) + ";";
+    }
+    repeated.resize(size);
+    EXPECT_EQ(round_trip(repeated), repeated) << "size=" << size;
+
+    string zeros(size, '\0');
+    EXPECT_EQ(round_trip(zeros), zeros) << "size=" << size;
+  }
+}
+
+// 测试可压缩的数据确实变小了，随机数据最多膨胀到 lz4_compress_bound
+TEST(Lz4Test, Ratio) {
+  int size = 0;
+  round_trip(string(8192, '\0'), &size);
+  EXPECT_LT(size, 100);
+
+  string page;
+  for (int i = 0; page.size() < 8192; i++) {
+    page += "id=" + to_string(i) + ",name=user" + to_string(i % 10) + ",balance=1000;";
+  }
+  round_trip(page, &size);
+  EXPECT_LT(size, static_cast<int>(page.size()) / 2);
+
+  // 输出缓冲区太小时失败
+  vector<char> small(16);
+  EXPECT_EQ(lz4_compress(page.data(), static_cast<int>(page.size()), small.data(), static_cast<int>(small.size())), 0);
+}
+
+// 测试和 liblz4 格式兼容：手工构造的压缩数据
+TEST(Lz4Test, KnownBlock) {
+  // 字面量 "abcd"，然后偏移4、长度8的匹配，最后5个字节的字面量 "abcde"
+  const char block[] = {0x44, 'a', 'b', 'c', 'd', 0x04, 0x00, 0x50, 'a', 'b', 'c', 'd', 'e'};
+  char out[64];
+  ASSERT_EQ(lz4_decompress(block, sizeof(block), out, sizeof(out)), 17);
+  EXPECT_EQ(string(out, 17), "abcdabcdabcdabcde");
+}
+
+// 测试损坏的数据不会越界，返回错误
+TEST(Lz4Test, Corrupted) {
+  string data;
+  for (int i = 0; data.size() < 10000; i++) {
+    data += "value" + to_string(i % 50) + " ";
+  }
+  vector<char> compressed(lz4_compress_bound(data.size()));
+  const int size = lz4_compress(data.data(), static_cast<int>(data.size()), compressed.data(),
+      static_cast<int>(compressed.size()));
+  ASSERT_GT(size, 0);
+
+  string out(data.size(), '\0');
+  // 输出缓冲区不够
+  EXPECT_EQ(lz4_decompress(compressed.data(), size, out.data(), static_cast<int>(out.size()) - 1), -1);
+  // 数据被截断
+  EXPECT_EQ(lz4_decompress(compressed.data(), size / 2, out.data(), static_cast<int>(out.size())), -1);
+  // 偏移超出已经输出的数据
+  const char bad_offset[] = {0x10, 'a', 0x10, 0x00, 0x00};
+  EXPECT_EQ(lz4_decompress(bad_offset, sizeof(bad_offset), out.data(), static_cast<int>(out.size())), -1);
+
+  // 随机修改字节，只要求不崩溃
+  mt19937 rng(7);
+  for (int i = 0; i < 1000; i++) {
+    vector<char> broken(compressed.begin(), compressed.begin() + size);
+    broken[rng() % size] = static_cast<char>(rng());
+    (void)lz4_decompress(broken.data(), size, out.data(), static_cast<int>(out.size()));
+  }
+}
@@ -0,0 +1,177 @@
+#include <gtest/gtest.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <unistd.h>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "common/io/async_io.h"
+
+using namespace common;
+
+static const AsyncIoBackend BACKENDS[] = {AsyncIoBackend::AUTO, AsyncIoBackend::THREAD_POOL};
+
+class AsyncIoTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    std::filesystem::remove_all(test_dir);
+    std::filesystem::create_directories(test_dir);
+    fd = open((test_dir + "/data").c_str(), O_CREAT | O_RDWR | O_TRUNC, 0644);
+    ASSERT_GE(fd, 0);
+  }
+
+  void TearDown() override {
+    close(fd);
+    std::filesystem::remove_all(test_dir);
+  }
+
+  std::string test_dir = "test_async_io";
+  int         fd       = -1;
+};
+
+// 测试一批请求超过队列深度时分几次提交，写完落盘之后读回来
+TEST_F(AsyncIoTest, Execute) {
+  constexpr int BLOCK = 4096;
+  constexpr int COUNT = 50;
+  for (AsyncIoBackend backend : BACKENDS) {
+    auto engine = AsyncIoEngine::create(backend, 8, 3);
+    ASSERT_NE(engine, nullptr);
+    EXPECT_EQ(engine->queue_depth(), 8);
+
+    std::vector<char>           data(BLOCK * COUNT);
+    std::vector<AsyncIoRequest> requests(COUNT);
+    for (int i = 0; i < COUNT; i++) {
+      memset(data.data() + i * BLOCK, 'a' + (i + static_cast<int>(backend)) % 26, BLOCK);
+      requests[i].prep_write(fd, data.data() + i * BLOCK, BLOCK, static_cast<off_t>(i) * BLOCK);
+    }
+    ASSERT_EQ(engine->execute(requests.data(), COUNT), 0) << async_io_backend_name(engine->backend());
+    EXPECT_EQ(engine->inflight(), 0);
+
+    AsyncIoRequest sync;
+    sync.prep_fsync(fd);
+    ASSERT_EQ(engine->execute(&sync, 1), 0);
+
+    // 倒着读，每个请求分成两段
+    std::vector<char>         read_data(data.size());
+    std::vector<struct iovec> iov(COUNT * 2);
+    for (int i = 0; i < COUNT; i++) {
+      const int block = COUNT - 1 - i;
+      iov[i * 2]      = {read_data.data() + block * BLOCK, 100};
+      iov[i * 2 + 1]  = {read_data.data() + block * BLOCK + 100, BLOCK - 100};
+      requests[i].prep_readv(fd, &iov[i * 2], 2, static_cast<off_t>(block) * BLOCK);
+    }
+    ASSERT_EQ(engine->execute(requests.data(), COUNT), 0);
+    EXPECT_EQ(memcmp(data.data(), read_data.data(), data.size()), 0);
+  }
+}
+
+// 测试手动提交：队列满时 prepare 返回 EAGAIN，reap 之后可以继续
+TEST_F(AsyncIoTest, PrepareAndReap) {
+  for (AsyncIoBackend backend : BACKENDS) {
+    auto engine = AsyncIoEngine::create(backend, 4, 2);
+
+    char                        buf[4][512];
+    std::vector<AsyncIoRequest> requests(5);
+    for (int i = 0; i < 5; i++) {
+      memset(buf[i % 4], '0' + i, sizeof(buf[i % 4]));
+      requests[i].prep_write(fd, buf[i % 4], sizeof(buf[i % 4]), i * 512);
+      requests[i].user_data = &requests[i];
+    }
+    for (int i = 0; i < 4; i++) {
+      ASSERT_EQ(engine->prepare(&requests[i]), 0);
+    }
+    EXPECT_EQ(engine->prepare(&requests[4]), EAGAIN);
+    EXPECT_EQ(engine->inflight(), 4);
+    ASSERT_EQ(engine->submit(), 0);
+
+    AsyncIoRequest* completed[4];
+    int             done = 0;
+    while (done < 4) {
+      const int ret = engine->reap(1, completed, 4);
+      ASSERT_GT(ret, 0);
+      for (int i = 0; i < ret; i++) {
+        EXPECT_EQ(completed[i]->result, 0);
+        EXPECT_EQ(completed[i]->user_data, completed[i]);
+      }
+      done += ret;
+    }
+    EXPECT_EQ(engine->inflight(), 0);
+    EXPECT_EQ(engine->reap(1, completed, 4), 0);
+    ASSERT_EQ(engine->prepare(&requests[4]), 0);
+    ASSERT_EQ(engine->submit(), 0);
+    ASSERT_EQ(engine->reap(1, completed, 4), 1);
+  }
+}
+
+// 测试和 preadn/pwritevn 一样的结果：读到文件末尾返回-1，超过 IOV_MAX 的数据段也能写完，失败返回errno
+TEST_F(AsyncIoTest, Results) {
+  for (AsyncIoBackend backend : BACKENDS) {
+    auto engine = AsyncIoEngine::create(backend, 4, 2);
+    ASSERT_EQ(ftruncate(fd, 0), 0);
+
+    const int                 iovcnt = IOV_MAX * 2 + 10;
+    std::vector<long>         values(iovcnt);
+    std::vector<struct iovec> iov(iovcnt);
+    for (int i = 0; i < iovcnt; i++) {
+      values[i] = i;
+      iov[i]    = {&values[i], sizeof(long)};
+    }
+    AsyncIoRequest request;
+    request.prep_writev(fd, iov.data(), iovcnt, 0);
+    ASSERT_EQ(engine->execute(&request, 1), 0);
+    ASSERT_EQ(lseek(fd, 0, SEEK_END), static_cast<off_t>(iovcnt * sizeof(long)));
+
+    std::vector<long> read_values(iovcnt);
+    request.prep_read(fd, read_values.data(), iovcnt * sizeof(long), 0);
+    ASSERT_EQ(engine->execute(&request, 1), 0);
+    EXPECT_EQ(read_values, values);
+
+    // 只能读到一部分
+    request.prep_read(fd, read_values.data(), 4096, (iovcnt - 2) * sizeof(long));
+    EXPECT_EQ(engine->execute(&request, 1), -1);
+
+    AsyncIoRequest requests[2];
+    requests[0].prep_read(fd, read_values.data(), sizeof(long), 0);
+    requests[1].prep_fsync(-1);
+    EXPECT_EQ(engine->execute(requests, 2), EBADF);
+    EXPECT_EQ(requests[0].result, 0);
+    EXPECT_EQ(requests[1].result, EBADF);
+  }
+}
+
+// 测试注册的文件和内存，io_uring 使用 READ_FIXED/WRITE_FIXED
+TEST_F(AsyncIoTest, RegisteredFilesAndBuffers) {
+  for (AsyncIoBackend backend : BACKENDS) {
+    auto engine = AsyncIoEngine::create(backend, 8, 2);
+
+    std::vector<char> buffer(64 * 1024);
+    struct iovec      registered = {buffer.data(), buffer.size()};
+    EXPECT_EQ(engine->register_files(&fd, 1), 0);
+    EXPECT_EQ(engine->register_buffers(&registered, 1), 0);
+
+    AsyncIoRequest requests[16];
+    for (int i = 0; i < 16; i++) {
+      memset(buffer.data() + i * 4096, 'A' + i, 4096);
+      requests[i].prep_write(fd, buffer.data() + i * 4096, 4096, static_cast<off_t>(i) * 4096);
+    }
+    ASSERT_EQ(engine->execute(requests, 16), 0);
+
+    memset(buffer.data(), 0, buffer.size());
+    for (int i = 0; i < 16; i++) {
+      requests[i].prep_read(fd, buffer.data() + i * 4096, 4096, static_cast<off_t>(i) * 4096);
+    }
+    ASSERT_EQ(engine->execute(requests, 16), 0);
+    for (int i = 0; i < 16; i++) {
+      EXPECT_EQ(buffer[i * 4096 + 100], 'A' + i);
+    }
+
+    // 取消注册之后照常读写
+    EXPECT_EQ(engine->register_files(nullptr, 0), 0);
+    EXPECT_EQ(engine->register_buffers(nullptr, 0), 0);
+    requests[0].prep_read(fd, buffer.data(), 4096, 15 * 4096);
+    ASSERT_EQ(engine->execute(requests, 1), 0);
+    EXPECT_EQ(buffer[0], 'P');
+  }
+}
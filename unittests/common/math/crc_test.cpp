@@ -0,0 +1,67 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "common/math/crc.h"
+
+using namespace std;
+
+// 测试 CRC32C 的标准测试向量
+TEST(CrcTest, Crc32cKnownValues) {
+  EXPECT_EQ(crc32c("", 0), 0u);
+  EXPECT_EQ(crc32c("123456789", 9), 0xE3069283u);
+
+  // RFC 3720 B.4 中的例子：32个0字节和32个0xFF字节
+  vector<uint8_t> zeros(32, 0);
+  vector<uint8_t> ones(32, 0xFF);
+  EXPECT_EQ(crc32c(zeros.data(), zeros.size()), 0x8A9136AAu);
+  EXPECT_EQ(crc32c(ones.data(), ones.size()), 0x62A8AB43u);
+}
+
+// 测试分段计算和一次计算的结果相同，包括不对齐的起始位置
+TEST(CrcTest, Crc32cIncremental) {
+  string data;
+  for (int i = 0; i < 1000; i++) {
+    data.push_back(static_cast<char>(i * 31 + 7));
+  }
+
+  const uint32_t whole = crc32c(data.data(), data.size());
+  for (size_t split : {0, 1, 7, 8, 13, 500, 999, 1000}) {
+    uint32_t crc = crc32c(data.data(), split);
+    crc          = crc32c(data.data() + split, data.size() - split, crc);
+    EXPECT_EQ(crc, whole) << "split=" << split;
+  }
+}
+
+// 测试 CRC32 的标准测试向量
+TEST(CrcTest, Crc32KnownValues) {
+  EXPECT_EQ(crc32("", 0), 0u);
+  EXPECT_EQ(crc32("123456789", 9), 0xCBF43926u);
+  EXPECT_EQ(crc32("The quick brown fox jumps over the lazy dog", 43), 0x414FA339u);
+}
+
+// 测试每种实现在各种长度和起始位置上的结果都相同，包括三路交错的分段边界附近
+TEST(CrcTest, Crc32cKernels) {
+  vector<uint8_t> data(3 * 3 * 1024 + 3 * 128 + 64);
+  for (size_t i = 0; i < data.size(); i++) {
+    data[i] = static_cast<uint8_t>(i * 131 + (i >> 7));
+  }
+
+  for (Crc32cKernel kernel : {Crc32cKernel::SLICE8, Crc32cKernel::SSE42, Crc32cKernel::PCLMUL}) {
+    if (!crc32c_kernel_supported(kernel)) {
+      continue;
+    }
+    EXPECT_EQ(crc32c(kernel, "123456789", 9), 0xE3069283u) << crc32c_kernel_name(kernel);
+    for (size_t offset : {0, 1, 5}) {
+      for (size_t size : {0, 7, 8, 383, 384, 385, 3071, 3072, 3073, 3456, 8192, 9000}) {
+        size = std::min(size, data.size() - offset);
+        EXPECT_EQ(crc32c(kernel, data.data() + offset, size, 0x12345678u),
+            crc32c(Crc32cKernel::SLICE8, data.data() + offset, size, 0x12345678u))
+            << crc32c_kernel_name(kernel) << " offset=" << offset << " size=" << size;
+      }
+    }
+  }
+  EXPECT_TRUE(crc32c_kernel_supported(crc32c_kernel()));
+  EXPECT_EQ(crc32c(data.data(), data.size()), crc32c(crc32c_kernel(), data.data(), data.size()));
+}
@@ -0,0 +1,48 @@
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <cstring>
+
+#include "common/mem/huge_page_arena.h"
+
+using namespace common;
+
+// 测试大页不可用时也能正常退化，并且内存按大页大小对齐
+TEST(HugePageArenaTest, HugePageOrFallback) {
+  HugePageArena arena;
+  ASSERT_EQ(arena.init(3 << 20), 0);
+  EXPECT_NE(arena.backing(), HugePageArena::Backing::NONE);
+  EXPECT_EQ(arena.size() % HugePageArena::HUGE_PAGE_SIZE, 0u);
+  EXPECT_GE(arena.size(), 3u << 20);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(arena.data()) % HugePageArena::HUGE_PAGE_SIZE, 0u);
+
+  memset(arena.data(), 0x5A, arena.size());
+  EXPECT_EQ(arena.data()[arena.size() - 1], 0x5A);
+
+  arena.cleanup();
+  EXPECT_EQ(arena.data(), nullptr);
+  EXPECT_EQ(arena.backing(), HugePageArena::Backing::NONE);
+}
+
+// 测试不使用大页时只按系统页大小取整
+TEST(HugePageArenaTest, NormalPages) {
+  HugePageArena arena;
+  ASSERT_EQ(arena.init(10000, false), 0);
+  EXPECT_EQ(arena.backing(), HugePageArena::Backing::NORMAL);
+  EXPECT_EQ(arena.size() % 4096, 0u);
+  EXPECT_LT(arena.size(), HugePageArena::HUGE_PAGE_SIZE);
+  EXPECT_EQ(arena.numa_node_of(arena.data()), -1);
+}
+
+// 测试NUMA分段：节点数不会超过系统的节点数，单节点的机器上不做绑定
+TEST(HugePageArenaTest, NumaNodes) {
+  HugePageArena arena;
+  ASSERT_EQ(arena.init(8 << 20, true, 64), 0);
+  EXPECT_LE(arena.numa_node_num(), HugePageArena::system_numa_node_num());
+  if (arena.numa_node_num() > 1) {
+    EXPECT_EQ(arena.numa_node_of(arena.data()), 0);
+    EXPECT_EQ(arena.numa_node_of(arena.data() + arena.size() - 1), arena.numa_node_num() - 1);
+  } else {
+    EXPECT_EQ(arena.numa_node_of(arena.data()), -1);
+  }
+  memset(arena.data(), 0, arena.size());
+}
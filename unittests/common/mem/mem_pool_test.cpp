@@ -0,0 +1,258 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "common/mem/mem_pool.h"
+
+struct PoolItem {
+  int value = 0;
+  int reinit_count = 0;
+
+  void reinit() { reinit_count++; }
+  void reset() { value = 0; }
+};
+
+// 测试分配、释放和重复释放
+TEST(MemPoolTest, AllocFree) {
+  MemPoolSimple<PoolItem> pool("MemPoolTest");
+  ASSERT_EQ(pool.init(false, 1, 8), 0);
+
+  std::set<PoolItem*> items;
+  for (int i = 0; i < 8; i++) {
+    PoolItem* item = pool.alloc();
+    ASSERT_NE(item, nullptr);
+    item->value = i + 1;
+    items.insert(item);
+  }
+  EXPECT_EQ(items.size(), 8u);
+  EXPECT_EQ(pool.used_num(), 8);
+  EXPECT_EQ(pool.alloc(), nullptr);
+
+  PoolItem* item = *items.begin();
+  pool.free(item);
+  EXPECT_EQ(item->value, 0);
+  EXPECT_EQ(pool.used_num(), 7);
+
+  // 重复释放和不属于内存池的对象都会被忽略
+  pool.free(item);
+  PoolItem other;
+  pool.free(&other);
+  EXPECT_EQ(pool.used_num(), 7);
+
+  EXPECT_EQ(pool.alloc(), item);
+  EXPECT_EQ(pool.alloc(), nullptr);
+}
+
+// 测试动态扩展
+TEST(MemPoolTest, DynamicExtend) {
+  MemPoolSimple<PoolItem> pool("MemPoolTest");
+  ASSERT_EQ(pool.init(true, 1, 4), 0);
+
+  std::vector<PoolItem*> items;
+  for (int i = 0; i < 10; i++) {
+    items.push_back(pool.alloc());
+    ASSERT_NE(items.back(), nullptr);
+  }
+  EXPECT_EQ(pool.size(), 12);
+  for (PoolItem* item : items) {
+    pool.free(item);
+  }
+  EXPECT_EQ(pool.used_num(), 0);
+}
+
+// 测试 MemPoolItem
+TEST(MemPoolTest, MemPoolItem) {
+  MemPoolItem pool("MemPoolItemTest");
+  ASSERT_EQ(pool.init(32, true, 1, 2), 0);
+
+  void* a = pool.alloc();
+  void* b = pool.alloc();
+  void* c = pool.alloc();
+  ASSERT_NE(a, nullptr);
+  ASSERT_NE(b, nullptr);
+  ASSERT_NE(c, nullptr);
+  EXPECT_TRUE(pool.is_used(c));
+  EXPECT_EQ(pool.get_used_num(), 3);
+
+  pool.free(b);
+  EXPECT_FALSE(pool.is_used(b));
+  {
+    MemPoolItem::item_unique_ptr item = pool.alloc_unique_ptr();
+    EXPECT_EQ(item.get(), b);
+  }
+  EXPECT_FALSE(pool.is_used(b));
+  pool.free(a);
+  pool.free(c);
+  EXPECT_EQ(pool.get_used_num(), 0);
+}
+
+// 测试很多批次时按地址找到对象所在的批次，不是对象起始地址的指针不属于内存池
+TEST(MemPoolTest, ManyChunks) {
+  MemPoolItem pool("MemPoolItemTest");
+  ASSERT_EQ(pool.init(48, true, 1, 3), 0);
+
+  std::vector<char*> items;
+  for (int i = 0; i < 300; i++) {
+    items.push_back(static_cast<char*>(pool.alloc()));
+    ASSERT_NE(items.back(), nullptr);
+  }
+  EXPECT_EQ(pool.get_size(), 300);
+
+  for (char* item : items) {
+    EXPECT_TRUE(pool.is_used(item));
+    EXPECT_FALSE(pool.is_used(item + 8));
+  }
+  char other[48];
+  EXPECT_FALSE(pool.is_used(other));
+
+  for (size_t i = 0; i < items.size(); i += 2) {
+    pool.free(items[i]);
+  }
+  for (size_t i = 0; i < items.size(); i++) {
+    EXPECT_EQ(pool.is_used(items[i]), i % 2 == 1);
+  }
+  EXPECT_EQ(pool.get_used_num(), 150);
+  for (size_t i = 1; i < items.size(); i += 2) {
+    pool.free(items[i]);
+  }
+  EXPECT_EQ(pool.get_used_num(), 0);
+}
+
+// 测试多线程并发分配和释放，同一个对象不会同时分配给两个线程
+TEST(MemPoolTest, ConcurrentAllocFree) {
+  const int item_num = 64;
+  MemPoolSimple<PoolItem> pool("MemPoolTest");
+  ASSERT_EQ(pool.init(false, 1, item_num), 0);
+
+  std::atomic<int> conflicts{0};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 8; t++) {
+    threads.emplace_back([&, t]() {
+      std::vector<PoolItem*> items;
+      for (int i = 0; i < 20000; i++) {
+        PoolItem* item = pool.alloc();
+        if (item != nullptr) {
+          if (item->value != 0) {
+            conflicts++;
+          }
+          item->value = t + 1;
+          items.push_back(item);
+        }
+        if (items.size() >= 4 || (item == nullptr && !items.empty())) {
+          for (PoolItem* held : items) {
+            if (held->value != t + 1) {
+              conflicts++;
+            }
+            pool.free(held);
+          }
+          items.clear();
+        }
+      }
+      for (PoolItem* held : items) {
+        pool.free(held);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  EXPECT_EQ(conflicts.load(), 0);
+  EXPECT_EQ(pool.used_num(), 0);
+}
+
+// 测试 MemPoolItem 的线程缓存：释放的块先进入本线程的弹匣，弹匣满了之后经过仓库给其它线程使用
+TEST(MemPoolTest, MemPoolItemMagazine) {
+  const int item_num = MemPoolItem::MAGAZINE_SIZE * 4;
+  MemPoolItem pool("MemPoolItemTest");
+  ASSERT_EQ(pool.init(16, true, 1, item_num), 0);
+
+  std::vector<void*> items;
+  for (int i = 0; i < item_num; i++) {
+    items.push_back(pool.alloc());
+    ASSERT_NE(items.back(), nullptr);
+  }
+  EXPECT_EQ(pool.get_used_num(), item_num);
+
+  // 全部在另一个线程释放
+  std::thread([&]() {
+    for (void* item : items) {
+      pool.free(item);
+    }
+    // 弹匣中的块仍然能检查出重复释放
+    pool.free(items.front());
+  }).join();
+  EXPECT_EQ(pool.get_used_num(), 0);
+
+  // 释放线程的两个弹匣之外的块都在仓库中，当前线程不需要扩展就能拿到
+  std::set<void*> reused;
+  for (int i = 0; i < item_num - 2 * MemPoolItem::MAGAZINE_SIZE; i++) {
+    void* item = pool.alloc();
+    ASSERT_NE(item, nullptr);
+    EXPECT_TRUE(pool.is_used(item));
+    reused.insert(item);
+  }
+  EXPECT_EQ(pool.get_size(), item_num);
+  for (void* item : reused) {
+    EXPECT_NE(std::find(items.begin(), items.end(), item), items.end());
+    pool.free(item);
+  }
+  EXPECT_EQ(pool.get_used_num(), 0);
+}
+
+// 测试多线程在线程缓存上分配和跨线程释放
+TEST(MemPoolTest, MemPoolItemCrossThreadFree) {
+  MemPoolItem pool("MemPoolItemTest");
+  ASSERT_EQ(pool.init(sizeof(int), true, 1, 64), 0);
+
+  const int thread_num = 4;
+  std::vector<std::vector<void*>> handoff(thread_num);
+  std::vector<std::mutex>         handoff_mutex(thread_num);
+  std::atomic<int> conflicts{0};
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < thread_num; t++) {
+    threads.emplace_back([&, t]() {
+      for (int i = 0; i < 20000; i++) {
+        int* item = static_cast<int*>(pool.alloc());
+        ASSERT_NE(item, nullptr);
+        if (*item != 0) {
+          conflicts++;
+        }
+        *item = t + 1;
+
+        // 交给下一个线程释放，再释放上一个线程交过来的
+        {
+          std::lock_guard<std::mutex> lock(handoff_mutex[(t + 1) % thread_num]);
+          handoff[(t + 1) % thread_num].push_back(item);
+        }
+        std::vector<void*> received;
+        {
+          std::lock_guard<std::mutex> lock(handoff_mutex[t]);
+          received.swap(handoff[t]);
+        }
+        for (void* held : received) {
+          if (*static_cast<int*>(held) != (t + thread_num - 1) % thread_num + 1) {
+            conflicts++;
+          }
+          pool.free(held);
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (auto& items : handoff) {
+    for (void* item : items) {
+      pool.free(item);
+    }
+  }
+
+  EXPECT_EQ(conflicts.load(), 0);
+  EXPECT_EQ(pool.get_used_num(), 0);
+}
@@ -0,0 +1,66 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <thread>
+
+#include "common/thread/epoch.h"
+
+using namespace common;
+
+// 测试没有读者时retire的内存可以马上回收
+TEST(EpochTest, ReclaimWithoutReaders) {
+  EpochManager& manager = EpochManager::instance();
+  manager.reclaim();
+
+  int deleted = 0;
+  manager.retire([&deleted]() { deleted++; });
+  EXPECT_EQ(manager.reclaim(), 1u);
+  EXPECT_EQ(deleted, 1);
+  EXPECT_EQ(manager.pending(), 0u);
+}
+
+// 测试读者还在临界区时不会回收，读者退出之后才回收
+TEST(EpochTest, ReaderBlocksReclaim) {
+  EpochManager& manager = EpochManager::instance();
+  manager.reclaim();
+
+  std::atomic<bool> entered{false};
+  std::atomic<bool> leave{false};
+  std::thread reader([&]() {
+    EpochGuard guard;
+    EXPECT_TRUE(guard.active());
+    {
+      EpochGuard nested;  // 嵌套的guard不影响外层
+      EXPECT_TRUE(nested.active());
+    }
+    entered.store(true);
+    while (!leave.load()) {
+      std::this_thread::yield();
+    }
+  });
+  while (!entered.load()) {
+    std::this_thread::yield();
+  }
+
+  int deleted = 0;
+  manager.retire([&deleted]() { deleted++; });
+  EXPECT_EQ(manager.reclaim(), 0u);
+  EXPECT_EQ(deleted, 0);
+
+  leave.store(true);
+  reader.join();
+  EXPECT_EQ(manager.reclaim(), 1u);
+  EXPECT_EQ(deleted, 1);
+}
+
+// 测试retire之后才进入的读者不会阻止回收
+TEST(EpochTest, LaterReaderDoesNotBlock) {
+  EpochManager& manager = EpochManager::instance();
+  manager.reclaim();
+
+  int deleted = 0;
+  manager.retire([&deleted]() { deleted++; });
+
+  EpochGuard guard;
+  EXPECT_EQ(manager.reclaim(), 1u);
+  EXPECT_EQ(deleted, 1);
+}
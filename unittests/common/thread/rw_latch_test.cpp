@@ -0,0 +1,152 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "common/thread/rw_latch.h"
+
+using namespace common;
+
+// 测试读闩共享、写闩独占
+TEST(RwLatchTest, SharedAndExclusive) {
+  RwLatch latch;
+  EXPECT_EQ(sizeof(latch), 8u);
+
+  latch.read_latch();
+  EXPECT_TRUE(latch.try_read_latch());
+  EXPECT_EQ(latch.reader_count(), 2);
+  EXPECT_FALSE(latch.try_write_latch());
+  latch.read_unlatch();
+  latch.read_unlatch();
+
+  EXPECT_TRUE(latch.try_write_latch());
+  EXPECT_TRUE(latch.is_write_latched());
+  EXPECT_FALSE(latch.try_read_latch());
+  EXPECT_FALSE(latch.try_write_latch());
+  latch.write_unlatch();
+
+  EXPECT_FALSE(latch.is_write_latched());
+  EXPECT_TRUE(latch.try_read_latch());
+  latch.read_unlatch();
+}
+
+// 测试乐观读：期间有写者时验证失败
+TEST(RwLatchTest, OptimisticRead) {
+  RwLatch latch;
+
+  uint32_t version = latch.optimistic_read();
+  EXPECT_TRUE(latch.validate(version));
+
+  // 读闩不影响乐观读
+  latch.read_latch();
+  EXPECT_TRUE(latch.validate(version));
+  latch.read_unlatch();
+
+  latch.write_latch();
+  EXPECT_FALSE(latch.validate(version));
+  latch.write_unlatch();
+  EXPECT_FALSE(latch.validate(version));
+
+  version = latch.optimistic_read();
+  EXPECT_EQ(version % 2, 0u);
+  EXPECT_TRUE(latch.validate(version));
+}
+
+// 测试写者等待读者退出，并且写者等待时新的读者不能进入
+TEST(RwLatchTest, WriterWaitsForReaders) {
+  RwLatch latch;
+  latch.read_latch();
+
+  std::atomic<bool> written{false};
+  std::thread writer([&]() {
+    latch.write_latch();
+    written.store(true);
+    latch.write_unlatch();
+  });
+
+  while (!latch.is_write_latched()) {
+    std::this_thread::yield();
+  }
+  EXPECT_FALSE(latch.try_read_latch());
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  EXPECT_FALSE(written.load());
+
+  latch.read_unlatch();
+  writer.join();
+  EXPECT_TRUE(written.load());
+}
+
+// 测试闩耦合：guard 可以移动，覆盖时释放原来的闩
+TEST(RwLatchTest, LatchCoupling) {
+  RwLatch parent;
+  RwLatch child;
+
+  ReadLatchGuard guard(parent);
+  {
+    ReadLatchGuard child_guard(child);
+    EXPECT_EQ(parent.reader_count(), 1);
+    guard = std::move(child_guard);
+    EXPECT_FALSE(child_guard.owns_latch());
+  }
+  EXPECT_EQ(parent.reader_count(), 0);
+  EXPECT_EQ(child.reader_count(), 1);
+  guard.release();
+  EXPECT_EQ(child.reader_count(), 0);
+
+  WriteLatchGuard write_guard(parent);
+  EXPECT_TRUE(parent.is_write_latched());
+  WriteLatchGuard moved(std::move(write_guard));
+  EXPECT_TRUE(parent.is_write_latched());
+  moved.release();
+  EXPECT_FALSE(parent.is_write_latched());
+}
+
+// 测试多线程读写：写者保持两个计数相等，读者(包括乐观读者)不应该看到不相等的状态
+TEST(RwLatchTest, ConcurrentReadWrite) {
+  RwLatch latch;
+  std::atomic<long> first{0};
+  std::atomic<long> second{0};
+  std::atomic<bool> stop{false};
+  std::atomic<long> torn{0};
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; t++) {
+    threads.emplace_back([&, t]() {
+      while (!stop.load()) {
+        if (t % 2 == 0) {
+          ReadLatchGuard guard(latch);
+          if (first.load(std::memory_order_relaxed) != second.load(std::memory_order_relaxed)) {
+            torn++;
+          }
+        } else {
+          long a = 0;
+          long b = 0;
+          uint32_t version = 0;
+          do {
+            version = latch.optimistic_read();
+            a = first.load(std::memory_order_relaxed);
+            b = second.load(std::memory_order_relaxed);
+          } while (!latch.validate(version));
+          if (a != b) {
+            torn++;
+          }
+        }
+      }
+    });
+  }
+
+  for (int i = 0; i < 20000; i++) {
+    WriteLatchGuard guard(latch);
+    first.fetch_add(1, std::memory_order_relaxed);
+    second.fetch_add(1, std::memory_order_relaxed);
+  }
+  stop.store(true);
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  EXPECT_EQ(torn.load(), 0);
+  EXPECT_EQ(first.load(), 20000);
+  EXPECT_EQ(latch.reader_count(), 0);
+  EXPECT_FALSE(latch.is_write_latched());
+}
@@ -0,0 +1,241 @@
+#include <gtest/gtest.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+
+#include "storage/buffer/double_write_buffer.h"
+#include "common/io/io.h"
+
+using namespace storage;
+
+class DoubleWriteBufferTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    std::filesystem::remove_all(test_dir);
+    std::filesystem::create_directories(test_dir);
+    for (int32_t id : {1, 2}) {
+      fds[id] = open((test_dir + "/data_" + std::to_string(id)).c_str(), O_CREAT | O_RDWR, 0644);
+      ASSERT_GE(fds[id], 0);
+    }
+  }
+
+  void TearDown() override {
+    for (auto& pair : fds) {
+      close(pair.second);
+    }
+    std::filesystem::remove_all(test_dir);
+  }
+
+  DiskDoubleWriteBuffer::FileResolver resolver() {
+    return [this](int32_t buffer_pool_id) {
+      auto iter = fds.find(buffer_pool_id);
+      return iter == fds.end() ? -1 : iter->second;
+    };
+  }
+
+  static Page make_page(PageNum page_num, LSN lsn) {
+    Page page;
+    page.init();
+    page.header.page_num = page_num;
+    page.header.lsn      = lsn;
+    memset(page.data, 'a' + page_num % 26, sizeof(page.data));
+    return page;
+  }
+
+  /// 读数据文件中的页面，文件中没有时返回 false
+  bool read_data_page(int32_t buffer_pool_id, PageNum page_num, Page& page) {
+    return preadn(fds[buffer_pool_id], &page, sizeof(page), static_cast<off_t>(page_num) * BP_PAGE_SIZE) == 0;
+  }
+
+  std::string                      test_dir = "test_dblwr";
+  std::string                      dblwr_file = test_dir + "/dblwr.db";
+  std::unordered_map<int32_t, int> fds;
+};
+
+// 测试页面攒成一批之后写到数据文件：写盘之前可以读到，连续的页面合并成一次写，每个文件同步一次
+TEST_F(DoubleWriteBufferTest, FlushBatch) {
+  DiskDoubleWriteBuffer dblwr(resolver(), 8);
+  ASSERT_EQ(dblwr.open_file(dblwr_file), RC::SUCCESS);
+
+  // 文件1: 页面 3、1、2、6，文件2：页面 0
+  for (PageNum page_num : {3, 1, 2, 6}) {
+    ASSERT_EQ(dblwr.add_page(1, page_num, make_page(page_num, 1)), RC::SUCCESS);
+  }
+  ASSERT_EQ(dblwr.add_page(2, 0, make_page(0, 1)), RC::SUCCESS);
+  // 同一个页面再次加入时替换
+  ASSERT_EQ(dblwr.add_page(1, 3, make_page(3, 2)), RC::SUCCESS);
+  EXPECT_EQ(dblwr.pending_pages(), 5);
+
+  Page page;
+  ASSERT_EQ(dblwr.read_page(1, 3, page), RC::SUCCESS);
+  EXPECT_EQ(page.header.lsn, 2);
+  EXPECT_EQ(dblwr.read_page(2, 3, page), RC::BUFFERPOOL_INVALID_PAGE_NUM);
+  EXPECT_FALSE(read_data_page(1, 3, page));
+
+  ASSERT_EQ(dblwr.flush_page(), RC::SUCCESS);
+  EXPECT_EQ(dblwr.pending_pages(), 0);
+  EXPECT_EQ(dblwr.read_page(1, 3, page), RC::BUFFERPOOL_INVALID_PAGE_NUM);
+
+  for (PageNum page_num : {1, 2, 3, 6}) {
+    ASSERT_TRUE(read_data_page(1, page_num, page));
+    EXPECT_TRUE(page.verify_checksum());
+    EXPECT_EQ(page.header.page_num, page_num);
+    EXPECT_EQ(page.header.lsn, page_num == 3 ? 2 : 1);
+    EXPECT_EQ(page.data[100], 'a' + page_num);
+  }
+  ASSERT_TRUE(read_data_page(2, 0, page));
+  EXPECT_EQ(page.data[0], 'a');
+
+  DoubleWriteStats stats = dblwr.stats();
+  EXPECT_EQ(stats.batches, 1u);
+  EXPECT_EQ(stats.pages, 5u);
+  EXPECT_EQ(stats.data_writes, 3u);  // [1,3]、[6]、文件2的[0]
+  EXPECT_EQ(stats.data_syncs, 2u);
+
+  // 达到 max_pages 时自动写盘
+  for (PageNum page_num = 10; page_num < 18; page_num++) {
+    ASSERT_EQ(dblwr.add_page(page_num % 2 + 1, page_num, make_page(page_num, 3)), RC::SUCCESS);
+  }
+  EXPECT_EQ(dblwr.pending_pages(), 0);
+  EXPECT_EQ(dblwr.stats().batches, 2u);
+  ASSERT_TRUE(read_data_page(2, 17, page));
+  EXPECT_EQ(page.header.lsn, 3);
+}
+
+// 测试写数据文件之前崩溃：重启时从 double write buffer 文件中加载页面，恢复时写回数据文件，损坏的页面被跳过
+TEST_F(DoubleWriteBufferTest, Recover) {
+  const std::string crash_file = test_dir + "/dblwr.crash";
+  {
+    // 数据文件都找不到，相当于只写了 double write buffer 文件。页面不能当作已经写盘，留在内存中
+    bool opened = false;
+    auto files  = resolver();
+    DiskDoubleWriteBuffer dblwr([&opened, files](int32_t id) { return opened ? files(id) : -1; }, 8);
+    ASSERT_EQ(dblwr.open_file(dblwr_file), RC::SUCCESS);
+    for (PageNum page_num = 0; page_num < 4; page_num++) {
+      ASSERT_EQ(dblwr.add_page(1, page_num, make_page(page_num, 5)), RC::SUCCESS);
+    }
+    ASSERT_EQ(dblwr.add_page(2, 7, make_page(7, 5)), RC::SUCCESS);
+    ASSERT_EQ(dblwr.flush_page(), RC::FILE_NOT_OPEN);
+    EXPECT_EQ(dblwr.pending_pages(), 5);
+    EXPECT_EQ(dblwr.stats().batches, 0u);
+
+    // 正常关闭时会清空文件，复制一份当作崩溃时的文件
+    std::filesystem::copy_file(dblwr_file, crash_file);
+
+    // 数据文件打开之后可以写盘。清空数据文件，下面检查恢复时写回的页面
+    opened = true;
+    ASSERT_EQ(dblwr.clear_pages(), RC::SUCCESS);
+    EXPECT_EQ(dblwr.pending_pages(), 0);
+    for (auto& pair : fds) {
+      ASSERT_EQ(ftruncate(pair.second, 0), 0);
+    }
+  }
+
+  {
+    // 正常关闭之后没有要恢复的页面
+    DiskDoubleWriteBuffer dblwr(resolver());
+    ASSERT_EQ(dblwr.open_file(dblwr_file), RC::SUCCESS);
+    EXPECT_EQ(dblwr.pending_pages(), 0);
+  }
+
+  // 第二个页面写了一半
+  int fd = open(crash_file.c_str(), O_RDWR);
+  ASSERT_GE(fd, 0);
+  ASSERT_EQ(pwrite(fd, "torn", 4, 2 * BP_PAGE_SIZE + 100), 4);
+  close(fd);
+
+  DiskDoubleWriteBuffer dblwr(resolver());
+  ASSERT_EQ(dblwr.open_file(crash_file), RC::SUCCESS);
+  EXPECT_EQ(dblwr.pending_pages(), 4);
+
+  // 没有写坏的页面可以读到
+  Page page;
+  int  loaded = dblwr.read_page(2, 7, page) == RC::SUCCESS ? 1 : 0;
+  for (PageNum page_num = 0; page_num < 4; page_num++) {
+    loaded += dblwr.read_page(1, page_num, page) == RC::SUCCESS ? 1 : 0;
+  }
+  EXPECT_EQ(loaded, 4);
+
+  ASSERT_EQ(dblwr.recover(), RC::SUCCESS);
+  EXPECT_EQ(dblwr.pending_pages(), 0);
+  int recovered = 0;
+  for (auto [buffer_pool_id, page_num] : {std::pair{1, 0}, {1, 1}, {1, 2}, {1, 3}, {2, 7}}) {
+    if (read_data_page(buffer_pool_id, page_num, page) && page.header.lsn == 5) {
+      EXPECT_EQ(page.header.page_num, page_num);
+      EXPECT_TRUE(page.verify_checksum());
+      recovered++;
+    }
+  }
+  EXPECT_EQ(recovered, 4);
+
+  // 文件头损坏时忽略整个文件
+  ASSERT_EQ(dblwr.clear_pages(), RC::SUCCESS);
+  fd = open(crash_file.c_str(), O_RDWR);
+  ASSERT_GE(fd, 0);
+  ASSERT_EQ(pwrite(fd, "\xff", 1, 4), 1);
+  close(fd);
+  DiskDoubleWriteBuffer reopened(resolver());
+  ASSERT_EQ(reopened.open_file(crash_file), RC::SUCCESS);
+  EXPECT_EQ(reopened.pending_pages(), 0);
+}
+
+// 测试两种异步IO的实现写出来的数据文件相同，跨文件的写请求一起提交
+TEST_F(DoubleWriteBufferTest, IoBackends) {
+  for (common::AsyncIoBackend backend : {common::AsyncIoBackend::AUTO, common::AsyncIoBackend::THREAD_POOL}) {
+    DiskDoubleWriteBuffer dblwr(resolver(), 16, 2, backend);
+    ASSERT_EQ(dblwr.open_file(dblwr_file), RC::SUCCESS);
+    if (backend == common::AsyncIoBackend::THREAD_POOL) {
+      EXPECT_EQ(dblwr.io_backend(), common::AsyncIoBackend::THREAD_POOL);
+    }
+
+    const LSN lsn = static_cast<LSN>(backend) + 10;
+    for (PageNum page_num = 0; page_num < 12; page_num++) {
+      ASSERT_EQ(dblwr.add_page(page_num % 3 == 0 ? 2 : 1, page_num, make_page(page_num, lsn)), RC::SUCCESS);
+    }
+    ASSERT_EQ(dblwr.flush_page(), RC::SUCCESS);
+
+    Page page;
+    for (PageNum page_num = 0; page_num < 12; page_num++) {
+      ASSERT_TRUE(read_data_page(page_num % 3 == 0 ? 2 : 1, page_num, page));
+      EXPECT_EQ(page.header.lsn, lsn);
+      EXPECT_TRUE(page.verify_checksum());
+    }
+    // 文件1: [1,2] [4,5] [7,8] [10,11]，文件2: 0 3 6 9
+    EXPECT_EQ(dblwr.stats().data_writes, 8u);
+    EXPECT_EQ(dblwr.stats().data_syncs, 2u);
+  }
+}
+
+// 测试直接IO：数据文件和 double write buffer 文件都用 O_DIRECT 打开，写盘和恢复都使用对齐的缓冲区
+TEST_F(DoubleWriteBufferTest, DirectIo) {
+  for (auto& pair : fds) {
+    close(pair.second);
+    bool direct = true;
+    pair.second = open_file((test_dir + "/data_" + std::to_string(pair.first)).c_str(), O_RDWR, 0644, direct);
+    ASSERT_GE(pair.second, 0);
+  }
+
+  {
+    DiskDoubleWriteBuffer dblwr(resolver(), 4);
+    dblwr.set_direct_io(true);
+    ASSERT_EQ(dblwr.open_file(dblwr_file), RC::SUCCESS);
+    for (PageNum page_num = 0; page_num < 6; page_num++) {
+      ASSERT_EQ(dblwr.add_page(page_num % 2 + 1, page_num, make_page(page_num, 7)), RC::SUCCESS);
+    }
+    EXPECT_EQ(dblwr.pending_pages(), 2);
+    ASSERT_EQ(dblwr.flush_page(), RC::SUCCESS);
+  }
+
+  // 读的时候也要用对齐的内存
+  Page* page = static_cast<Page*>(aligned_alloc(DIRECT_IO_ALIGN, sizeof(Page)));
+  ASSERT_NE(page, nullptr);
+  for (PageNum page_num = 0; page_num < 6; page_num++) {
+    ASSERT_TRUE(read_data_page(page_num % 2 + 1, page_num, *page));
+    EXPECT_EQ(page->header.page_num, page_num);
+    EXPECT_EQ(page->header.lsn, 7);
+    EXPECT_TRUE(page->verify_checksum());
+  }
+  free(page);
+}
@@ -0,0 +1,188 @@
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+#include <set>
+
+#include "storage/buffer/frame_manager.h"
+
+using namespace storage;
+
+class FrameManagerTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    ASSERT_EQ(manager.init(frame_num, 4), RC::SUCCESS);
+  }
+
+  void TearDown() override {
+    // 释放所有还在使用的页帧，保证cleanup能够成功
+    std::list<Frame*> frames = manager.find_list(buffer_pool_id);
+    for (Frame* frame : frames) {
+      while (frame->pin_count() > 1) {
+        frame->unpin();
+      }
+      manager.free(frame->buffer_pool_id(), frame->page_num(), frame);
+    }
+    EXPECT_EQ(manager.cleanup(), RC::SUCCESS);
+  }
+
+  static constexpr int frame_num = 32;
+  static constexpr int buffer_pool_id = 1;
+  FrameManager manager{"FrameManagerTest"};
+};
+
+// 测试分配、查找和释放
+TEST_F(FrameManagerTest, AllocGetFree) {
+  EXPECT_EQ(manager.shard_num(), 4);
+  EXPECT_EQ(manager.total_frame_num(), static_cast<size_t>(frame_num));
+
+  Frame* frame = manager.alloc(buffer_pool_id, 10);
+  ASSERT_NE(frame, nullptr);
+  EXPECT_EQ(frame->pin_count(), 1);
+  EXPECT_EQ(frame->frame_id(), FrameId(buffer_pool_id, 10));
+  EXPECT_EQ(manager.frame_num(), 1u);
+
+  Frame* found = manager.get(buffer_pool_id, 10);
+  EXPECT_EQ(found, frame);
+  EXPECT_EQ(frame->pin_count(), 2);
+  found->unpin();
+
+  EXPECT_EQ(manager.get(buffer_pool_id, 11), nullptr);
+
+  EXPECT_EQ(manager.free(buffer_pool_id, 10, frame), RC::SUCCESS);
+  EXPECT_EQ(manager.frame_num(), 0u);
+  EXPECT_EQ(manager.get(buffer_pool_id, 10), nullptr);
+}
+
+// 测试所有分片共享全部页帧：单个分片的空闲帧用完后可以从其它分片借
+TEST_F(FrameManagerTest, AllocAllFramesAcrossShards) {
+  std::set<Frame*> frames;
+  for (int i = 0; i < frame_num; i++) {
+    Frame* frame = manager.alloc(buffer_pool_id, i);
+    ASSERT_NE(frame, nullptr) << "page " << i;
+    frames.insert(frame);
+  }
+  EXPECT_EQ(frames.size(), static_cast<size_t>(frame_num));
+  EXPECT_EQ(manager.frame_num(), static_cast<size_t>(frame_num));
+
+  // 没有空闲页帧了
+  EXPECT_EQ(manager.alloc(buffer_pool_id, frame_num), nullptr);
+
+  for (int i = 0; i < frame_num; i++) {
+    Frame* frame = manager.get(buffer_pool_id, i);
+    ASSERT_NE(frame, nullptr);
+    frame->unpin();
+    frame->unpin();
+  }
+}
+
+// 测试跨分片淘汰
+TEST_F(FrameManagerTest, PurgeFramesAcrossShards) {
+  for (int i = 0; i < frame_num; i++) {
+    Frame* frame = manager.alloc(buffer_pool_id, i);
+    ASSERT_NE(frame, nullptr);
+    frame->unpin();
+  }
+
+  // 前一半页面保持pin住，不能被淘汰
+  for (int i = 0; i < frame_num / 2; i++) {
+    ASSERT_NE(manager.get(buffer_pool_id, i), nullptr);
+  }
+
+  int purged_count = 0;
+  auto purger = [&purged_count](Frame* frame) {
+    EXPECT_GE(frame->page_num(), frame_num / 2);
+    purged_count++;
+    return RC::SUCCESS;
+  };
+
+  EXPECT_EQ(manager.purge_frames(frame_num, purger), frame_num / 2);
+  EXPECT_EQ(purged_count, frame_num / 2);
+  EXPECT_EQ(manager.frame_num(), static_cast<size_t>(frame_num / 2));
+
+  // 淘汰出来的页帧可以被任意分片重新使用
+  for (int i = frame_num; i < frame_num + frame_num / 2; i++) {
+    Frame* frame = manager.alloc(buffer_pool_id, i);
+    ASSERT_NE(frame, nullptr);
+    frame->unpin();
+  }
+
+  for (int i = 0; i < frame_num / 2; i++) {
+    Frame* frame = manager.get(buffer_pool_id, i);
+    frame->unpin();
+    frame->unpin();
+  }
+}
+
+// 测试purger失败时页帧不会被释放
+TEST_F(FrameManagerTest, PurgeFailed) {
+  Frame* frame = manager.alloc(buffer_pool_id, 1);
+  ASSERT_NE(frame, nullptr);
+  frame->unpin();
+
+  EXPECT_EQ(manager.purge_frames(1, [](Frame*) { return RC::IOERR_WRITE; }), 0);
+  EXPECT_EQ(frame->pin_count(), 0);
+  EXPECT_EQ(manager.get(buffer_pool_id, 1), frame);
+  frame->unpin();
+}
+
+// 测试多线程并发查找
+TEST_F(FrameManagerTest, ConcurrentGet) {
+  for (int i = 0; i < frame_num; i++) {
+    Frame* frame = manager.alloc(buffer_pool_id, i);
+    ASSERT_NE(frame, nullptr);
+    frame->unpin();
+  }
+
+  const int thread_num = 8;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < thread_num; t++) {
+    threads.emplace_back([this, t]() {
+      for (int i = 0; i < 10000; i++) {
+        PageNum page_num = (i + t) % frame_num;
+        Frame* frame = manager.get(buffer_pool_id, page_num);
+        ASSERT_NE(frame, nullptr);
+        EXPECT_EQ(frame->page_num(), page_num);
+        frame->unpin();
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  for (int i = 0; i < frame_num; i++) {
+    Frame* frame = manager.get(buffer_pool_id, i);
+    EXPECT_EQ(frame->pin_count(), 1);
+    frame->unpin();
+  }
+}
+
+// 测试所有分片中脏页帧最小的 recLSN
+TEST_F(FrameManagerTest, MinRecLsn) {
+  EXPECT_EQ(manager.min_rec_lsn(), 0);
+
+  for (int i = 0; i < 8; i++) {
+    Frame* frame = manager.alloc(buffer_pool_id, i);
+    ASSERT_NE(frame, nullptr);
+    if (i % 2 == 1) {
+      frame->mark_dirty(100 - i);
+    }
+    frame->unpin();
+  }
+  EXPECT_EQ(manager.min_rec_lsn(), 93);
+
+  Frame* frame = manager.get(buffer_pool_id, 7);
+  ASSERT_NE(frame, nullptr);
+  frame->clear_dirty();
+  frame->unpin();
+  EXPECT_EQ(manager.min_rec_lsn(), 95);
+
+  // 没有记录 recLSN 的脏页，不知道恢复要从哪里开始
+  frame = manager.get(buffer_pool_id, 0);
+  ASSERT_NE(frame, nullptr);
+  frame->mark_dirty();
+  EXPECT_EQ(manager.min_rec_lsn(), BP_UNKNOWN_REC_LSN);
+  frame->clear_dirty();
+  frame->unpin();
+  EXPECT_EQ(manager.min_rec_lsn(), 95);
+}
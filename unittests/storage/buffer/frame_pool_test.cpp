@@ -0,0 +1,61 @@
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <set>
+#include <vector>
+
+#include "storage/buffer/frame_pool.h"
+
+using namespace storage;
+
+// 测试页帧的页面放在arena上，按4KB对齐并且互不重叠
+TEST(FramePoolTest, PagesInArena) {
+  FramePool pool("FramePoolTest");
+  ASSERT_EQ(pool.init(false, 1, 64), 0);
+  EXPECT_NE(pool.backing(), common::HugePageArena::Backing::NONE);
+
+  std::vector<Frame*> frames;
+  std::set<const Page*> pages;
+  for (int i = 0; i < 64; i++) {
+    Frame* frame = pool.alloc();
+    ASSERT_NE(frame, nullptr);
+    const Page* page = &frame->page();
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(page) % 4096, 0u);
+    EXPECT_EQ(page->header.page_num, BP_INVALID_PAGE_NUM);
+    pages.insert(page);
+    frames.push_back(frame);
+  }
+  EXPECT_EQ(pages.size(), 64u);
+  EXPECT_EQ(pool.alloc(), nullptr);
+
+  // 页面内容可以正常读写
+  frames[0]->set_page_num(7);
+  frames[0]->data()[BP_PAGE_DATA_SIZE - 1] = 'x';
+  EXPECT_EQ(frames[0]->page_num(), 7);
+  EXPECT_EQ(frames[1]->page_num(), BP_INVALID_PAGE_NUM);
+
+  for (Frame* frame : frames) {
+    pool.free(frame);
+  }
+  EXPECT_EQ(pool.used_num(), 0);
+  pool.cleanup();
+}
+
+// 测试关闭大页时使用普通页面，动态扩展时每批页帧都有自己的arena
+TEST(FramePoolTest, NormalPagesAndExtend) {
+  FramePool pool("FramePoolTest");
+  pool.set_arena_options(false, 0);
+  ASSERT_EQ(pool.init(true, 1, 4), 0);
+  EXPECT_EQ(pool.backing(), common::HugePageArena::Backing::NORMAL);
+
+  std::vector<Frame*> frames;
+  for (int i = 0; i < 10; i++) {
+    Frame* frame = pool.alloc();
+    ASSERT_NE(frame, nullptr);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(&frame->page()) % 4096, 0u);
+    frames.push_back(frame);
+  }
+  EXPECT_EQ(pool.size(), 12);
+  for (Frame* frame : frames) {
+    pool.free(frame);
+  }
+}
@@ -69,6 +69,21 @@ TEST_F(FrameTest, DirtyFlagTest) {
   EXPECT_FALSE(frame->is_dirty());
 }
 
+// 测试 recLSN 只记录变脏之后的第一次修改
+TEST_F(FrameTest, RecLsnTest) {
+  EXPECT_EQ(frame->rec_lsn(), 0);
+
+  frame->mark_dirty(100);
+  frame->mark_dirty(120);
+  EXPECT_TRUE(frame->is_dirty());
+  EXPECT_EQ(frame->rec_lsn(), 100);
+
+  frame->clear_dirty();
+  EXPECT_EQ(frame->rec_lsn(), 0);
+  frame->mark_dirty(130);
+  EXPECT_EQ(frame->rec_lsn(), 130);
+}
+
 // 测试缓冲区ID操作
 TEST_F(FrameTest, BufferPoolIdTest) {
   EXPECT_EQ(frame->buffer_pool_id(), -1);
@@ -0,0 +1,202 @@
+#include <gtest/gtest.h>
+#include <map>
+#include <memory>
+#include <set>
+#include <vector>
+
+#include "storage/buffer/page_alloc_map.h"
+
+using namespace storage;
+
+static const int PAGES_PER_MAP = BPAllocMapPage::PAGES_PER_MAP;
+
+class PageAllocMapTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    header_page.init();
+    alloc_map = make_map();
+    ASSERT_EQ(alloc_map->create(header_page, 1), RC::SUCCESS);
+  }
+
+  /// 页面放在内存中，模拟 BufferPool 中 pin 住的页帧
+  std::unique_ptr<PageAllocMap> make_map() {
+    auto fetcher = [this](PageNum page_num, bool create, Page*& page) {
+      auto iter = pages.find(page_num);
+      if (create) {
+        EXPECT_EQ(iter, pages.end()) << page_num;
+        auto& slot = pages[page_num];
+        slot       = std::make_unique<Page>();
+        page       = slot.get();
+        return RC::SUCCESS;
+      }
+      if (iter == pages.end()) {
+        return RC::BUFFERPOOL_INVALID_PAGE_NUM;
+      }
+      page = iter->second.get();
+      return RC::SUCCESS;
+    };
+    auto marker = [this](PageNum page_num) { dirty_pages.insert(page_num); };
+    return std::make_unique<PageAllocMap>(fetcher, marker);
+  }
+
+  /// 用同样的页面重新打开
+  void reopen() {
+    alloc_map->close();
+    alloc_map = make_map();
+    ASSERT_EQ(alloc_map->open(header_page), RC::SUCCESS);
+  }
+
+  Page                                     header_page;
+  std::map<PageNum, std::unique_ptr<Page>> pages;
+  std::set<PageNum>                        dirty_pages;
+  std::unique_ptr<PageAllocMap>            alloc_map;
+};
+
+// 测试新文件：文件头和第一个分配图页面已经分配，从页号最小的空闲页面开始分配
+TEST_F(PageAllocMapTest, AllocateAndDeallocate) {
+  EXPECT_EQ(alloc_map->page_count(), 2);
+  EXPECT_EQ(alloc_map->allocated_pages(), 2);
+  EXPECT_EQ(alloc_map->map_page_count(), 1);
+  EXPECT_EQ(alloc_map->header()->buffer_pool_id, 1);
+  EXPECT_EQ(header_page.header.page_type, HEADER_PAGE);
+  EXPECT_EQ(pages.at(1)->header.page_type, ALLOC_MAP_PAGE);
+  EXPECT_EQ(dirty_pages, (std::set<PageNum>{0, 1}));
+
+  for (PageNum expected = 2; expected < 12; expected++) {
+    PageNum page_num = BP_INVALID_PAGE_NUM;
+    ASSERT_EQ(alloc_map->allocate(page_num), RC::SUCCESS);
+    EXPECT_EQ(page_num, expected);
+  }
+  EXPECT_EQ(alloc_map->page_count(), 12);
+  EXPECT_EQ(alloc_map->allocated_pages(), 12);
+
+  EXPECT_EQ(alloc_map->deallocate(7), RC::SUCCESS);
+  EXPECT_EQ(alloc_map->deallocate(4), RC::SUCCESS);
+  EXPECT_FALSE(alloc_map->is_allocated(4));
+  EXPECT_TRUE(alloc_map->is_allocated(5));
+  EXPECT_EQ(alloc_map->allocated_pages(), 10);
+  EXPECT_EQ(alloc_map->page_count(), 12);  // 释放页面不会缩小文件
+  EXPECT_EQ(alloc_map->next_allocated(4), 5);
+  EXPECT_EQ(alloc_map->next_allocated(12), BP_INVALID_PAGE_NUM);
+
+  // 不能释放的页面
+  EXPECT_EQ(alloc_map->deallocate(BP_HEADER_PAGE), RC::BUFFERPOOL_INVALID_PAGE_NUM);
+  EXPECT_EQ(alloc_map->deallocate(1), RC::BUFFERPOOL_INVALID_PAGE_NUM);
+  EXPECT_EQ(alloc_map->deallocate(4), RC::BUFFERPOOL_INVALID_PAGE_NUM);
+  EXPECT_EQ(alloc_map->deallocate(12), RC::BUFFERPOOL_INVALID_PAGE_NUM);
+  EXPECT_EQ(alloc_map->allocated_pages(), 10);
+
+  PageNum page_num = BP_INVALID_PAGE_NUM;
+  ASSERT_EQ(alloc_map->allocate(page_num), RC::SUCCESS);
+  EXPECT_EQ(page_num, 4);
+  ASSERT_EQ(alloc_map->allocate(page_num), RC::SUCCESS);
+  EXPECT_EQ(page_num, 7);
+  ASSERT_EQ(alloc_map->allocate(page_num), RC::SUCCESS);
+  EXPECT_EQ(page_num, 12);
+}
+
+// 测试文件超过一个分配图页面管理的范围：新的分配图页面放在范围的第一个页面上，分配时跳过
+TEST_F(PageAllocMapTest, GrowAcrossMaps) {
+  const int total = PAGES_PER_MAP * 2 + 100;
+  PageNum   page_num = BP_INVALID_PAGE_NUM;
+  PageNum   last     = 1;
+  while (alloc_map->allocated_pages() < total) {
+    ASSERT_EQ(alloc_map->allocate(page_num), RC::SUCCESS);
+    EXPECT_FALSE(PageAllocMap::is_map_page(page_num));
+    EXPECT_EQ(page_num, PageAllocMap::is_map_page(last + 1) ? last + 2 : last + 1);
+    last = page_num;
+  }
+  EXPECT_EQ(alloc_map->map_page_count(), 3);
+  EXPECT_EQ(alloc_map->page_count(), total);
+  EXPECT_EQ(alloc_map->header()->map_pages[1], PAGES_PER_MAP);
+  EXPECT_EQ(alloc_map->header()->map_pages[2], PAGES_PER_MAP * 2);
+  EXPECT_TRUE(alloc_map->is_allocated(PAGES_PER_MAP));
+  EXPECT_EQ(alloc_map->deallocate(PAGES_PER_MAP * 2), RC::BUFFERPOOL_INVALID_PAGE_NUM);
+
+  // 前面的分配图页面有了空闲页面，优先使用
+  ASSERT_EQ(alloc_map->deallocate(PAGES_PER_MAP + 10), RC::SUCCESS);
+  ASSERT_EQ(alloc_map->deallocate(100), RC::SUCCESS);
+  ASSERT_EQ(alloc_map->allocate(page_num), RC::SUCCESS);
+  EXPECT_EQ(page_num, 100);
+  ASSERT_EQ(alloc_map->allocate(page_num), RC::SUCCESS);
+  EXPECT_EQ(page_num, PAGES_PER_MAP + 10);
+  ASSERT_EQ(alloc_map->allocate(page_num), RC::SUCCESS);
+  EXPECT_EQ(page_num, total);
+
+  ASSERT_EQ(alloc_map->deallocate(PAGES_PER_MAP - 1), RC::SUCCESS);
+  EXPECT_EQ(alloc_map->next_allocated(PAGES_PER_MAP - 1), PAGES_PER_MAP);
+}
+
+// 测试重新打开之后状态不变，摘要和查找起点重新建立
+TEST_F(PageAllocMapTest, Reopen) {
+  PageNum page_num = BP_INVALID_PAGE_NUM;
+  for (int i = 0; i < PAGES_PER_MAP + 10; i++) {
+    ASSERT_EQ(alloc_map->allocate(page_num), RC::SUCCESS);
+  }
+  ASSERT_EQ(alloc_map->deallocate(50), RC::SUCCESS);
+  ASSERT_EQ(alloc_map->deallocate(PAGES_PER_MAP + 3), RC::SUCCESS);
+  const BPFileHeader header = *alloc_map->header();
+
+  reopen();
+  EXPECT_EQ(alloc_map->page_count(), header.page_count);
+  EXPECT_EQ(alloc_map->allocated_pages(), header.allocated_pages);
+  EXPECT_EQ(alloc_map->map_page_count(), 2);
+  EXPECT_FALSE(alloc_map->is_allocated(50));
+  EXPECT_TRUE(alloc_map->is_allocated(51));
+
+  ASSERT_EQ(alloc_map->allocate(page_num), RC::SUCCESS);
+  EXPECT_EQ(page_num, 50);
+  ASSERT_EQ(alloc_map->allocate(page_num), RC::SUCCESS);
+  EXPECT_EQ(page_num, PAGES_PER_MAP + 3);
+  ASSERT_EQ(alloc_map->allocate(page_num), RC::SUCCESS);
+  EXPECT_EQ(page_num, header.page_count);
+
+  // 分配图页面损坏
+  pages.at(PAGES_PER_MAP)->data[0] ^= 1;
+  alloc_map->close();
+  alloc_map = make_map();
+  EXPECT_EQ(alloc_map->open(header_page), RC::INTERNAL);
+}
+
+// 测试日志回放：重复回放不改变结果，分配图页面还不存在时创建出来
+TEST_F(PageAllocMapTest, Redo) {
+  const PageNum far_page = PAGES_PER_MAP * 2 + 5;
+  ASSERT_EQ(alloc_map->redo_allocate(far_page), RC::SUCCESS);
+  EXPECT_EQ(alloc_map->map_page_count(), 3);
+  EXPECT_EQ(alloc_map->page_count(), far_page + 1);
+  EXPECT_EQ(alloc_map->allocated_pages(), 5);  // 文件头、3个分配图页面和 far_page
+  ASSERT_EQ(alloc_map->redo_allocate(far_page), RC::SUCCESS);
+  EXPECT_EQ(alloc_map->allocated_pages(), 5);
+
+  ASSERT_EQ(alloc_map->redo_allocate(3), RC::SUCCESS);
+  ASSERT_EQ(alloc_map->redo_deallocate(3), RC::SUCCESS);
+  ASSERT_EQ(alloc_map->redo_deallocate(3), RC::SUCCESS);
+  ASSERT_EQ(alloc_map->redo_deallocate(far_page + 100), RC::SUCCESS);
+  EXPECT_EQ(alloc_map->allocated_pages(), 5);
+  EXPECT_FALSE(alloc_map->is_allocated(3));
+
+  EXPECT_EQ(alloc_map->redo_deallocate(1), RC::BUFFERPOOL_INVALID_PAGE_NUM);
+  EXPECT_EQ(alloc_map->redo_allocate(BPFileHeader::MAX_PAGE_NUM), RC::BUFFERPOOL_INVALID_PAGE_NUM);
+
+  // 回放之后正常分配，中间的空闲页面都可以使用
+  PageNum page_num = BP_INVALID_PAGE_NUM;
+  ASSERT_EQ(alloc_map->allocate(page_num), RC::SUCCESS);
+  EXPECT_EQ(page_num, 2);
+}
+
+// 测试修改过的文件头和分配图页面都通知了调用者
+TEST_F(PageAllocMapTest, DirtyPages) {
+  PageNum page_num = BP_INVALID_PAGE_NUM;
+  for (int i = 0; i < PAGES_PER_MAP; i++) {
+    ASSERT_EQ(alloc_map->allocate(page_num), RC::SUCCESS);
+  }
+  EXPECT_EQ(dirty_pages, (std::set<PageNum>{0, 1, PAGES_PER_MAP}));
+
+  dirty_pages.clear();
+  ASSERT_EQ(alloc_map->deallocate(PAGES_PER_MAP + 1), RC::SUCCESS);
+  EXPECT_EQ(dirty_pages, (std::set<PageNum>{0, PAGES_PER_MAP}));
+
+  dirty_pages.clear();
+  EXPECT_EQ(alloc_map->deallocate(PAGES_PER_MAP + 1), RC::BUFFERPOOL_INVALID_PAGE_NUM);
+  EXPECT_TRUE(dirty_pages.empty());
+}
@@ -0,0 +1,185 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "storage/buffer/page_cleaner.h"
+
+using namespace storage;
+
+class PageCleanerTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    ASSERT_EQ(manager.init(frame_num, 4), RC::SUCCESS);
+  }
+
+  void TearDown() override {
+    manager.purge_frames(frame_num, [](Frame*) { return RC::SUCCESS; });
+    EXPECT_EQ(manager.frame_num(), 0u);
+    EXPECT_EQ(manager.cleanup(), RC::SUCCESS);
+  }
+
+  /// 加载count个页面，其中前dirty个是脏页
+  void load_pages(int count, int dirty) {
+    for (PageNum i = 0; i < count; i++) {
+      Frame* frame = manager.alloc(buffer_pool_id, i);
+      ASSERT_NE(frame, nullptr);
+      if (i < dirty) {
+        frame->mark_dirty();
+      }
+      frame->unpin();
+    }
+  }
+
+  PageCleaner::FlushBatch flush_recorder() {
+    return [this](const std::vector<Frame*>& frames) {
+      for (Frame* frame : frames) {
+        EXPECT_TRUE(frame->is_dirty());
+        EXPECT_GT(frame->pin_count(), 0);
+        // 刷盘时持有读闩，写者不能修改页面
+        EXPECT_FALSE(frame->try_write_latch());
+        flushed.insert(frame->page_num());
+      }
+      return fail ? RC::IOERR_WRITE : RC::SUCCESS;
+    };
+  }
+
+  static constexpr int frame_num = 100;
+  static constexpr int buffer_pool_id = 1;
+  FrameManager manager{"PageCleanerTest"};
+  std::set<PageNum> flushed;
+  bool fail = false;
+};
+
+// 测试根据脏页比例计算每轮刷的页面数
+TEST_F(PageCleanerTest, FlushTarget) {
+  PageCleanerOptions options;
+  options.max_io_pages   = 100;
+  options.low_dirty_pct  = 10;
+  options.high_dirty_pct = 50;
+  options.lsn_high_rate  = 1000;
+  PageCleaner cleaner(manager, flush_recorder(), nullptr, options);
+
+  EXPECT_EQ(cleaner.flush_target(0.05, 0), 0);
+  EXPECT_EQ(cleaner.flush_target(0.30, 0), 50);
+  EXPECT_EQ(cleaner.flush_target(0.60, 0), 100);
+
+  // 日志增长很快时，即使脏页不多也要刷
+  EXPECT_EQ(cleaner.flush_target(0.05, 500), 50);
+  EXPECT_EQ(cleaner.flush_target(0.30, 2000), 100);
+}
+
+// 测试脏页比例低于下限时不刷
+TEST_F(PageCleanerTest, IdleWhenFewDirtyPages) {
+  load_pages(50, 5);
+  PageCleaner cleaner(manager, flush_recorder());
+
+  EXPECT_EQ(cleaner.run_once(), 0);
+  EXPECT_TRUE(flushed.empty());
+  PageCleanerStats stats = cleaner.stats();
+  EXPECT_EQ(stats.dirty_pages, 5u);
+  EXPECT_DOUBLE_EQ(stats.dirty_ratio, 0.05);
+}
+
+// 测试刷盘之后页面变干净，pin都被释放
+TEST_F(PageCleanerTest, FlushDirtyPages) {
+  load_pages(80, 60);
+  PageCleanerOptions options;
+  options.max_io_pages = 1000;
+  PageCleaner cleaner(manager, flush_recorder(), nullptr, options);
+
+  EXPECT_EQ(cleaner.run_once(), 60);
+  EXPECT_EQ(flushed.size(), 60u);
+  EXPECT_EQ(manager.dirty_frame_num(), 0u);
+  EXPECT_EQ(cleaner.stats().flushed_pages, 60u);
+
+  for (PageNum i = 0; i < 80; i++) {
+    Frame* frame = manager.get(buffer_pool_id, i);
+    ASSERT_NE(frame, nullptr);
+    EXPECT_EQ(frame->pin_count(), 1);
+    frame->unpin();
+  }
+}
+
+// 测试刷盘失败时保留脏页标记
+TEST_F(PageCleanerTest, FlushFailed) {
+  load_pages(80, 60);
+  fail = true;
+  PageCleaner cleaner(manager, flush_recorder());
+
+  EXPECT_EQ(cleaner.run_once(), 0);
+  EXPECT_EQ(manager.dirty_frame_num(), 60u);
+  EXPECT_EQ(cleaner.stats().failed_batches, 1u);
+}
+
+// 测试正在被修改的页面这一轮跳过，修改之后仍然是脏页
+TEST_F(PageCleanerTest, SkipLatchedPages) {
+  load_pages(80, 60);
+  PageCleanerOptions options;
+  options.max_io_pages = 1000;
+  PageCleaner cleaner(manager, flush_recorder(), nullptr, options);
+
+  Frame* writing = manager.get(buffer_pool_id, 0);
+  ASSERT_NE(writing, nullptr);
+  writing->write_latch();
+
+  EXPECT_EQ(cleaner.run_once(), 59);
+  EXPECT_EQ(flushed.count(0), 0u);
+  EXPECT_EQ(manager.dirty_frame_num(), 1u);
+
+  writing->mark_dirty();
+  writing->write_unlatch();
+  EXPECT_TRUE(writing->is_dirty());
+  writing->unpin();
+}
+
+// 测试日志增长速度推动刷脏页
+TEST_F(PageCleanerTest, LsnGrowth) {
+  load_pages(50, 5);
+  std::atomic<LSN> lsn{0};
+  PageCleanerOptions options;
+  options.lsn_high_rate = 1;
+  PageCleaner cleaner(manager, flush_recorder(), [&lsn]() { return lsn.load(); }, options);
+
+  EXPECT_EQ(cleaner.run_once(), 0);
+  lsn = 1000000;
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  EXPECT_EQ(cleaner.run_once(), 5);
+  EXPECT_GT(cleaner.stats().lsn_rate, 0);
+}
+
+// 测试淘汰时优先选择干净的页帧
+TEST_F(PageCleanerTest, PurgePrefersCleanFrames) {
+  load_pages(frame_num, frame_num / 2);
+
+  std::vector<PageNum> purged;
+  int count = manager.purge_frames(10, [&purged](Frame* frame) {
+    purged.push_back(frame->page_num());
+    return RC::SUCCESS;
+  });
+  EXPECT_EQ(count, 10);
+  for (PageNum page_num : purged) {
+    EXPECT_GE(page_num, frame_num / 2);
+  }
+  EXPECT_EQ(manager.dirty_purge_count(), 0u);
+}
+
+// 测试后台线程
+TEST_F(PageCleanerTest, BackgroundThread) {
+  load_pages(80, 60);
+  PageCleanerOptions options;
+  options.interval_ms = 10;
+  PageCleaner cleaner(manager, flush_recorder(), nullptr, options);
+  ASSERT_EQ(cleaner.start(), RC::SUCCESS);
+
+  for (int i = 0; i < 200 && manager.dirty_frame_num() > static_cast<size_t>(frame_num * options.low_dirty_pct / 100);
+       i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  cleaner.stop();
+
+  EXPECT_LE(manager.dirty_frame_num(), static_cast<size_t>(frame_num * options.low_dirty_pct / 100));
+  EXPECT_GT(cleaner.stats().rounds, 0u);
+}
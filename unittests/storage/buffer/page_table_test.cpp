@@ -0,0 +1,197 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "common/thread/epoch.h"
+#include "storage/buffer/page_table.h"
+#include "storage/buffer/frame_manager.h"
+
+using namespace storage;
+
+// 测试插入、查找、覆盖和删除
+TEST(PageTableTest, InsertFindErase) {
+  PageTable table;
+  Frame frames[3];
+
+  EXPECT_TRUE(table.empty());
+  EXPECT_EQ(table.find(FrameId(1, 1)), nullptr);
+
+  EXPECT_EQ(table.insert(FrameId(1, 1), &frames[0]), nullptr);
+  EXPECT_EQ(table.insert(FrameId(2, 1), &frames[1]), nullptr);
+  EXPECT_EQ(table.size(), 2u);
+  EXPECT_EQ(table.find(FrameId(1, 1)), &frames[0]);
+  EXPECT_EQ(table.find(FrameId(2, 1)), &frames[1]);
+
+  // 覆盖时返回原来的页帧
+  EXPECT_EQ(table.insert(FrameId(1, 1), &frames[2]), &frames[0]);
+  EXPECT_EQ(table.size(), 2u);
+  EXPECT_EQ(table.find(FrameId(1, 1)), &frames[2]);
+
+  EXPECT_TRUE(table.erase(FrameId(1, 1)));
+  EXPECT_FALSE(table.erase(FrameId(1, 1)));
+  EXPECT_EQ(table.find(FrameId(1, 1)), nullptr);
+  EXPECT_EQ(table.find(FrameId(2, 1)), &frames[1]);
+  EXPECT_EQ(table.size(), 1u);
+}
+
+// 测试扩容和墓碑清理之后所有元素仍然能找到
+TEST(PageTableTest, Rebuild) {
+  PageTable table(16);
+  const int count = 1000;
+  std::vector<Frame> frames(count);
+
+  for (int i = 0; i < count; i++) {
+    ASSERT_EQ(table.insert(FrameId(1, i), &frames[i]), nullptr);
+  }
+  EXPECT_EQ(table.size(), static_cast<size_t>(count));
+  EXPECT_GE(table.capacity(), static_cast<size_t>(count));
+
+  for (int i = 0; i < count; i += 2) {
+    ASSERT_TRUE(table.erase(FrameId(1, i)));
+  }
+  const size_t capacity = table.capacity();
+
+  // 反复插入删除只会产生墓碑，不应该一直扩容
+  for (int round = 0; round < 10; round++) {
+    for (int i = 0; i < count; i += 2) {
+      ASSERT_EQ(table.insert(FrameId(2, i), &frames[i]), nullptr);
+    }
+    for (int i = 0; i < count; i += 2) {
+      ASSERT_TRUE(table.erase(FrameId(2, i)));
+    }
+  }
+  EXPECT_EQ(table.capacity(), capacity);
+
+  for (int i = 0; i < count; i++) {
+    EXPECT_EQ(table.find(FrameId(1, i)), i % 2 == 0 ? nullptr : &frames[i]);
+  }
+
+  int visited = 0;
+  table.foreach([&visited, &frames](const FrameId& frame_id, Frame* frame) {
+    EXPECT_EQ(frame_id.buffer_pool_id, 1);
+    EXPECT_EQ(frame, &frames[frame_id.page_num]);
+    visited++;
+    return true;
+  });
+  EXPECT_EQ(visited, count / 2);
+}
+
+// 测试扩容时并发查找：写者不停地插入，读者查找已经插入的元素
+TEST(PageTableTest, ConcurrentFindDuringRebuild) {
+  PageTable table(16);
+  const int count = 20000;
+  std::vector<Frame> frames(count);
+  std::atomic<int> inserted{0};
+  std::atomic<bool> stop{false};
+
+  std::vector<std::thread> readers;
+  for (int t = 0; t < 4; t++) {
+    readers.emplace_back([&, t]() {
+      std::mt19937 random(t);
+      while (!stop.load(std::memory_order_acquire)) {
+        const int limit = inserted.load(std::memory_order_acquire);
+        if (limit == 0) {
+          continue;
+        }
+        const int i = static_cast<int>(random() % limit);
+        common::EpochGuard guard;
+        ASSERT_TRUE(guard.active());
+        ASSERT_EQ(table.find(FrameId(1, i)), &frames[i]);
+      }
+    });
+  }
+
+  for (int i = 0; i < count; i++) {
+    table.insert(FrameId(1, i), &frames[i]);
+    inserted.store(i + 1, std::memory_order_release);
+  }
+  stop.store(true, std::memory_order_release);
+  for (auto& reader : readers) {
+    reader.join();
+  }
+
+  // 所有读者都退出之后，旧的数组都可以释放了
+  common::EpochManager::instance().reclaim();
+  EXPECT_EQ(common::EpochManager::instance().pending(), 0u);
+}
+
+/**
+ * 无锁命中和淘汰并发的压力测试，可以用 -DENABLE_TSAN=ON 编译后运行
+ * 页帧比页面少得多，加载线程不停地淘汰和加载页面，读者检查拿到的页帧确实是自己要找的页面
+ */
+TEST(PageTableTest, ConcurrentLookupAndEviction) {
+  const int frame_num  = 16;
+  const int page_count = 64;
+  const int buffer_pool_id = 1;
+
+  FrameManager manager("PageTableStress");
+  ASSERT_EQ(manager.init(frame_num, 4), RC::SUCCESS);
+
+  std::atomic<bool> stop{false};
+  std::atomic<long> hits{0};
+
+  auto loader = [&](int seed) {
+    std::mt19937 random(seed);
+    while (!stop.load(std::memory_order_acquire)) {
+      const PageNum page_num = static_cast<PageNum>(random() % page_count);
+      Frame* frame = nullptr;
+      RC rc = manager.alloc_for_read(buffer_pool_id, page_num, false, frame);
+      if (rc == RC::BUFFER_POOL_FULL) {
+        manager.purge_frames(4, [](Frame*) { return RC::SUCCESS; });
+        continue;
+      }
+      ASSERT_EQ(rc, RC::SUCCESS);
+      if (frame == nullptr) {
+        continue;
+      }
+      memcpy(frame->page().data, &page_num, sizeof(page_num));
+      frame->set_io_state(Frame::IoState::NONE);
+      frame->unpin();
+    }
+  };
+
+  auto reader = [&](int seed) {
+    std::mt19937 random(seed);
+    for (int i = 0; i < 50000; i++) {
+      const PageNum page_num = static_cast<PageNum>(random() % page_count);
+      Frame* frame = manager.get(buffer_pool_id, page_num);
+      if (frame == nullptr) {
+        continue;
+      }
+      ASSERT_EQ(frame->buffer_pool_id(), buffer_pool_id);
+      ASSERT_EQ(frame->page_num(), page_num);
+      while (frame->io_state() == Frame::IoState::READING) {
+        std::this_thread::yield();
+      }
+      PageNum data = -1;
+      memcpy(&data, frame->page().data, sizeof(data));
+      ASSERT_EQ(data, page_num);
+      frame->unpin();
+      hits.fetch_add(1, std::memory_order_relaxed);
+    }
+  };
+
+  std::vector<std::thread> loaders;
+  for (int t = 0; t < 2; t++) {
+    loaders.emplace_back(loader, t + 1);
+  }
+  std::vector<std::thread> readers;
+  for (int t = 0; t < 4; t++) {
+    readers.emplace_back(reader, t + 100);
+  }
+  for (auto& thread : readers) {
+    thread.join();
+  }
+  stop.store(true, std::memory_order_release);
+  for (auto& thread : loaders) {
+    thread.join();
+  }
+  EXPECT_GT(hits.load(), 0);
+
+  manager.purge_frames(frame_num, [](Frame*) { return RC::SUCCESS; });
+  EXPECT_EQ(manager.frame_num(), 0u);
+  EXPECT_EQ(manager.cleanup(), RC::SUCCESS);
+}
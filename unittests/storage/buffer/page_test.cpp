@@ -38,6 +38,16 @@ TEST_F(PageTest, ChecksumTest) {
 	// 修改数据后校验和应该不匹配
 	page->data[0] = 'h';
 	EXPECT_FALSE(page->verify_checksum());
+
+	// 校验不修改页面，只覆盖页面数据
+	page->calc_checksum();
+	const Page& const_page = *page;
+	EXPECT_TRUE(const_page.verify_checksum());
+	EXPECT_EQ(page->header.check_sum, crc32c(page->data, BP_PAGE_DATA_SIZE));
+	page->header.lsn = 100;
+	EXPECT_TRUE(const_page.verify_checksum());
+	page->data[BP_PAGE_DATA_SIZE - 1] ^= 1;
+	EXPECT_FALSE(const_page.verify_checksum());
 }
 
 // 测试页面标志位操作
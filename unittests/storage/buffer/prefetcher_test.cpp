@@ -0,0 +1,230 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "storage/buffer/prefetcher.h"
+
+using namespace storage;
+
+class PrefetcherTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    ASSERT_EQ(manager.init(frame_num, 4), RC::SUCCESS);
+    memset(bitmap_data, 0, sizeof(bitmap_data));
+    allocated.init(bitmap_data, page_count);
+  }
+
+  void TearDown() override {
+    prefetcher.cleanup();
+    manager.purge_frames(frame_num, [](Frame*) { return RC::SUCCESS; });
+    EXPECT_EQ(manager.frame_num(), 0u);
+    EXPECT_EQ(manager.cleanup(), RC::SUCCESS);
+  }
+
+  /// 模拟 BufferPool::load_page：页面数据中写入页号
+  RC read_page(PageNum page_num, Frame* frame) {
+    std::this_thread::sleep_for(read_latency);
+    {
+      std::lock_guard lock(mutex);
+      read_pages.push_back(page_num);
+      if (fail_pages.erase(page_num) > 0) {
+        return RC::IOERR_READ;
+      }
+    }
+    frame->page().header.page_num = page_num;
+    memcpy(frame->page().data, &page_num, sizeof(page_num));
+    return RC::SUCCESS;
+  }
+
+  PrefetchStream make_stream(int window = 8) {
+    return PrefetchStream(buffer_pool_id,
+      [this](PageNum page_num, Frame* frame) { return read_page(page_num, frame); }, nullptr, window);
+  }
+
+  /// 按页号顺序访问所有已分配的页面
+  void scan(PrefetchStream& stream) {
+    for (int page_num = allocated.next_one_bit(0); page_num >= 0; page_num = allocated.next_one_bit(page_num + 1)) {
+      Frame* frame = nullptr;
+      ASSERT_EQ(prefetcher.get_page(stream, page_num, allocated, frame), RC::SUCCESS);
+      ASSERT_NE(frame, nullptr);
+      PageNum data = BP_INVALID_PAGE_NUM;
+      memcpy(&data, frame->page().data, sizeof(data));
+      EXPECT_EQ(data, page_num);
+      EXPECT_EQ(frame->io_state(), Frame::IoState::NONE);
+      frame->unpin();
+    }
+  }
+
+  static constexpr int frame_num      = 256;
+  static constexpr int page_count     = 128;
+  static constexpr int buffer_pool_id = 1;
+
+  FrameManager manager{"PrefetcherTest"};
+  Prefetcher   prefetcher{manager};
+  char         bitmap_data[page_count / 8];
+  Bitmap       allocated;
+
+  std::mutex           mutex;
+  std::vector<PageNum> read_pages;
+  std::set<PageNum>    fail_pages;
+  std::chrono::microseconds read_latency{0};  /// 模拟磁盘读取延迟
+};
+
+// 测试顺序扫描时后面的页面由后台线程读取
+TEST_F(PrefetcherTest, SequentialScan) {
+  ASSERT_EQ(prefetcher.init(2), RC::SUCCESS);
+  for (int i = 0; i < page_count; i++) {
+    allocated.set(i);
+  }
+
+  read_latency = std::chrono::microseconds(200);
+
+  PrefetchStream stream = make_stream();
+  scan(stream);
+  prefetcher.wait_idle();
+
+  // 命中的个数取决于线程调度，这里只检查预读生效了
+  PrefetchStats stats = prefetcher.stats();
+  EXPECT_GT(stats.issued, 0u);
+  EXPECT_GT(stats.hits, 0u);
+  EXPECT_EQ(stats.hits + stats.misses + 1,  // 第一个页面还不是顺序访问
+            static_cast<uint64_t>(page_count));
+  EXPECT_EQ(stats.failed, 0u);
+
+  // 每个页面只读取一次
+  std::set<PageNum> unique_pages(read_pages.begin(), read_pages.end());
+  EXPECT_EQ(unique_pages.size(), read_pages.size());
+}
+
+// 测试预读按照分配位图跳过没有分配的页面
+TEST_F(PrefetcherTest, SkipHoles) {
+  ASSERT_EQ(prefetcher.init(2), RC::SUCCESS);
+  for (int i = 0; i < page_count; i++) {
+    if (i % 3 != 1) {
+      allocated.set(i);
+    }
+  }
+  read_latency = std::chrono::microseconds(200);
+
+  PrefetchStream stream = make_stream();
+  scan(stream);
+  prefetcher.wait_idle();
+
+  EXPECT_TRUE(stream.sequential());
+  EXPECT_GT(prefetcher.stats().hits, 0u);
+  for (PageNum page_num : read_pages) {
+    EXPECT_TRUE(allocated.get(page_num)) << "read unallocated page " << page_num;
+  }
+}
+
+// 测试随机访问不会触发预读
+TEST_F(PrefetcherTest, RandomAccess) {
+  ASSERT_EQ(prefetcher.init(2), RC::SUCCESS);
+  for (int i = 0; i < page_count; i++) {
+    allocated.set(i);
+  }
+
+  PrefetchStream stream = make_stream();
+  for (PageNum page_num : {50, 3, 77, 20, 100, 9}) {
+    Frame* frame = nullptr;
+    ASSERT_EQ(prefetcher.get_page(stream, page_num, allocated, frame), RC::SUCCESS);
+    frame->unpin();
+  }
+  prefetcher.wait_idle();
+
+  EXPECT_FALSE(stream.sequential());
+  EXPECT_EQ(prefetcher.stats().issued, 0u);
+  EXPECT_EQ(read_pages.size(), 6u);
+}
+
+// 测试预读失败的页面由访问者重新读取
+TEST_F(PrefetcherTest, PrefetchFailed) {
+  ASSERT_EQ(prefetcher.init(1), RC::SUCCESS);
+  for (int i = 0; i < 16; i++) {
+    allocated.set(i);
+  }
+  fail_pages.insert(5);
+
+  PrefetchStream stream = make_stream();
+  Frame* frame = nullptr;
+  for (PageNum page_num = 0; page_num < 2; page_num++) {
+    ASSERT_EQ(prefetcher.get_page(stream, page_num, allocated, frame), RC::SUCCESS);
+    frame->unpin();
+  }
+  prefetcher.wait_idle();
+  EXPECT_EQ(prefetcher.stats().failed, 1u);
+
+  stream.reset();
+  ASSERT_EQ(prefetcher.get_page(stream, 5, allocated, frame), RC::SUCCESS);
+  PageNum data = BP_INVALID_PAGE_NUM;
+  memcpy(&data, frame->page().data, sizeof(data));
+  EXPECT_EQ(data, 5);
+  EXPECT_EQ(frame->io_state(), Frame::IoState::NONE);
+  frame->unpin();
+}
+
+// 测试没有预读线程时退化为同步读取
+TEST_F(PrefetcherTest, Disabled) {
+  ASSERT_EQ(prefetcher.init(0), RC::SUCCESS);
+  for (int i = 0; i < 32; i++) {
+    allocated.set(i);
+  }
+
+  PrefetchStream stream = make_stream();
+  scan(stream);
+  PrefetchStats stats = prefetcher.stats();
+  EXPECT_EQ(stats.issued, 0u);
+  EXPECT_EQ(stats.hits, 0u);
+  EXPECT_EQ(stats.misses, 0u);
+  EXPECT_EQ(read_pages.size(), 32u);
+}
+
+// 测试带着 ScanRing 扫描时，没有命中的页面分配的页帧记录到环中并被复用
+TEST_F(PrefetcherTest, ScanWithRing) {
+  ASSERT_EQ(prefetcher.init(0), RC::SUCCESS);
+  for (int i = 0; i < 32; i++) {
+    allocated.set(i);
+  }
+
+  PrefetchStream stream(buffer_pool_id, [this](PageNum page_num, Frame* frame) { return read_page(page_num, frame); },
+    [](Frame*) { return RC::SUCCESS; });
+  ScanRing ring(4);
+  for (int page_num = allocated.next_one_bit(0); page_num >= 0; page_num = allocated.next_one_bit(page_num + 1)) {
+    Frame* frame = nullptr;
+    ASSERT_EQ(prefetcher.get_page(stream, page_num, allocated, frame, &ring), RC::SUCCESS);
+    ASSERT_NE(frame, nullptr);
+    EXPECT_TRUE(frame->scan_only());
+    frame->unpin();
+  }
+
+  EXPECT_EQ(read_pages.size(), 32u);
+  EXPECT_EQ(ring.reused_count(), 28u);
+  EXPECT_EQ(manager.frame_num(), 4u);
+}
+
+// 测试多个线程同时访问正在预读的页面
+TEST_F(PrefetcherTest, ConcurrentScan) {
+  ASSERT_EQ(prefetcher.init(2), RC::SUCCESS);
+  for (int i = 0; i < page_count; i++) {
+    allocated.set(i);
+  }
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; t++) {
+    threads.emplace_back([this]() {
+      PrefetchStream stream = make_stream();
+      scan(stream);
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  prefetcher.wait_idle();
+
+  std::set<PageNum> unique_pages(read_pages.begin(), read_pages.end());
+  EXPECT_EQ(unique_pages.size(), read_pages.size());
+  EXPECT_EQ(unique_pages.size(), static_cast<size_t>(page_count));
+}
@@ -0,0 +1,145 @@
+#include <gtest/gtest.h>
+#include <memory>
+#include <vector>
+
+#include "storage/buffer/replacer.h"
+
+using namespace storage;
+
+class ReplacerTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    frames.resize(frame_num);
+    for (int i = 0; i < frame_num; i++) {
+      frames[i] = std::make_unique<Frame>();
+      frames[i]->set_buffer_pool_id(1);
+      frames[i]->set_page_num(i);
+    }
+  }
+
+  std::unique_ptr<Replacer> create(const std::string& name) {
+    Replacer* replacer = nullptr;
+    EXPECT_EQ(Replacer::create(name, replacer), RC::SUCCESS);
+    return std::unique_ptr<Replacer>(replacer);
+  }
+
+  /// 按照淘汰顺序返回前count个页号
+  static std::vector<PageNum> victims(Replacer& replacer, size_t count) {
+    std::vector<PageNum> result;
+    replacer.foreach_victim([&result, count](Frame* frame) {
+      result.push_back(frame->page_num());
+      return result.size() < count;
+    });
+    return result;
+  }
+
+  static constexpr int frame_num = 16;
+  std::vector<std::unique_ptr<Frame>> frames;
+};
+
+// 测试按名字创建
+TEST_F(ReplacerTest, Create) {
+  EXPECT_STREQ(create("lru")->name(), "lru");
+  EXPECT_STREQ(create("clock")->name(), "clock");
+  EXPECT_STREQ(create("2q")->name(), "2q");
+
+  Replacer* replacer = nullptr;
+  EXPECT_EQ(Replacer::create("unknown", replacer), RC::INVALID_ARGUMENT);
+  EXPECT_EQ(replacer, nullptr);
+}
+
+// 测试LRU淘汰顺序
+TEST_F(ReplacerTest, LruOrder) {
+  auto replacer = create("lru");
+  for (int i = 0; i < 4; i++) {
+    replacer->insert(frames[i].get());
+  }
+  replacer->access(frames[0].get());
+
+  EXPECT_EQ(victims(*replacer, 4), (std::vector<PageNum>{1, 2, 3, 0}));
+
+  replacer->remove(frames[1].get());
+  EXPECT_EQ(replacer->size(), 3u);
+  EXPECT_EQ(victims(*replacer, 1), (std::vector<PageNum>{2}));
+}
+
+// 测试CLOCK给访问过的页帧第二次机会，并且每个页帧只给出一次
+TEST_F(ReplacerTest, ClockSecondChance) {
+  auto replacer = create("clock");
+  for (int i = 0; i < 4; i++) {
+    replacer->insert(frames[i].get());
+  }
+  replacer->access(frames[0].get());
+  replacer->access(frames[2].get());
+
+  EXPECT_EQ(victims(*replacer, 10), (std::vector<PageNum>{1, 3, 0, 2}));
+
+  // 访问位已经被清除，空出来的位置可以复用
+  replacer->remove(frames[1].get());
+  EXPECT_EQ(frames[1]->replacer_slot(), -1);
+  replacer->insert(frames[4].get());
+  EXPECT_EQ(replacer->size(), 4u);
+  EXPECT_EQ(victims(*replacer, 10).size(), 4u);
+}
+
+// 测试2Q：只访问一次的页面先被淘汰，反复访问的页面留在Am中
+TEST_F(ReplacerTest, TwoQueueScanResistant) {
+  auto replacer = create("2q");
+
+  // 热点页面：插入后被访问过，第一次淘汰扫描时会晋升到Am
+  for (int i = 0; i < 4; i++) {
+    replacer->insert(frames[i].get());
+    replacer->access(frames[i].get());
+  }
+  // 扫描页面：只访问一次
+  for (int i = 4; i < 12; i++) {
+    replacer->insert(frames[i].get());
+  }
+
+  std::vector<PageNum> result = victims(*replacer, 8);
+  EXPECT_EQ(result, (std::vector<PageNum>{4, 5, 6, 7, 8, 9, 10, 11}));
+}
+
+// 测试2Q：从A1in淘汰过的页面再次加载时直接进入Am
+TEST_F(ReplacerTest, TwoQueueGhost) {
+  auto replacer = create("2q");
+  for (int i = 0; i < 8; i++) {
+    replacer->insert(frames[i].get());
+  }
+
+  // 淘汰页面0，它会被记录在A1out中
+  EXPECT_EQ(victims(*replacer, 1), (std::vector<PageNum>{0}));
+  replacer->remove(frames[0].get());
+
+  // 页面0重新加载，进入Am；后续淘汰时A1in中的页面优先
+  replacer->insert(frames[0].get());
+  std::vector<PageNum> result = victims(*replacer, 8);
+  ASSERT_EQ(result.size(), 8u);
+  EXPECT_EQ(result.back(), 0);
+}
+
+// 测试foreach_cold跳过访问过的页帧，并且不修改替换策略的状态
+TEST_F(ReplacerTest, ForeachCold) {
+  for (const char* name : {"clock", "2q"}) {
+    auto replacer = create(name);
+    for (int i = 0; i < 4; i++) {
+      replacer->insert(frames[i].get());
+    }
+    replacer->access(frames[1].get());
+
+    std::vector<PageNum> cold;
+    replacer->foreach_cold([&cold](Frame* frame) {
+      cold.push_back(frame->page_num());
+      return true;
+    });
+    EXPECT_EQ(cold, (std::vector<PageNum>{0, 2, 3})) << name;
+
+    // 访问位没有被清除，页帧1仍然最后被淘汰
+    std::vector<PageNum> result = victims(*replacer, 4);
+    ASSERT_EQ(result.size(), 4u) << name;
+    EXPECT_EQ(result.back(), 1) << name;
+    for (int i = 0; i < 4; i++) {
+      replacer->remove(frames[i].get());
+    }
+  }
+}
@@ -0,0 +1,158 @@
+#include <gtest/gtest.h>
+#include <set>
+#include <vector>
+
+#include "storage/buffer/frame_manager.h"
+#include "storage/buffer/scan_ring.h"
+
+using namespace storage;
+
+class ScanRingTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    ASSERT_EQ(manager.init(frame_num, 4), RC::SUCCESS);
+  }
+
+  void TearDown() override {
+    std::list<Frame*> frames = manager.find_list(buffer_pool_id);
+    for (Frame* frame : frames) {
+      while (frame->pin_count() > 1) {
+        frame->unpin();
+      }
+      manager.free(frame->buffer_pool_id(), frame->page_num(), frame);
+    }
+    EXPECT_EQ(manager.cleanup(), RC::SUCCESS);
+  }
+
+  /// 模拟 BufferPool::get_this_page：先查找，没有命中再分配
+  Frame* scan_page(PageNum page_num, ScanRing& ring) {
+    Frame* frame = manager.get(buffer_pool_id, page_num, &ring);
+    if (frame == nullptr) {
+      frame = manager.alloc(buffer_pool_id, page_num, ring, purger);
+    }
+    return frame;
+  }
+
+  static constexpr int frame_num = 64;
+  static constexpr int buffer_pool_id = 1;
+  FrameManager manager{"ScanRingTest"};
+  int purged = 0;
+  std::function<RC(Frame*)> purger = [this](Frame*) { purged++; return RC::SUCCESS; };
+};
+
+// 测试扫描最多只占用环大小个页帧
+TEST_F(ScanRingTest, ReuseRingFrames) {
+  ScanRing ring(4);
+  std::set<Frame*> used;
+  for (PageNum i = 0; i < 20; i++) {
+    Frame* frame = scan_page(i, ring);
+    ASSERT_NE(frame, nullptr);
+    EXPECT_TRUE(frame->scan_only());
+    EXPECT_EQ(frame->frame_id(), FrameId(buffer_pool_id, i));
+    used.insert(frame);
+    frame->unpin();
+  }
+
+  EXPECT_EQ(used.size(), 4u);
+  EXPECT_EQ(manager.frame_num(), 4u);
+  EXPECT_EQ(ring.reused_count(), 16u);
+  EXPECT_EQ(purged, 16);
+
+  // 被复用的页面已经不在缓冲池中
+  EXPECT_EQ(manager.get(buffer_pool_id, 0), nullptr);
+  Frame* frame = manager.get(buffer_pool_id, 19, &ring);
+  ASSERT_NE(frame, nullptr);
+  frame->unpin();
+}
+
+// 测试被其它访问命中或者pin住的页帧不会被扫描复用
+TEST_F(ScanRingTest, SharedFramesNotReused) {
+  ScanRing ring(2);
+  Frame* frame0 = scan_page(0, ring);
+  Frame* frame1 = scan_page(1, ring);
+  ASSERT_NE(frame0, nullptr);
+  ASSERT_NE(frame1, nullptr);
+  frame0->unpin();
+
+  // 页面0被普通访问命中，变成共享的页面；页面1仍然被pin住
+  Frame* hot = manager.get(buffer_pool_id, 0);
+  ASSERT_EQ(hot, frame0);
+  EXPECT_FALSE(hot->scan_only());
+  hot->unpin();
+
+  Frame* frame2 = scan_page(2, ring);
+  Frame* frame3 = scan_page(3, ring);
+  ASSERT_NE(frame2, nullptr);
+  ASSERT_NE(frame3, nullptr);
+  EXPECT_NE(frame2, frame0);
+  EXPECT_NE(frame3, frame1);
+  EXPECT_EQ(ring.reused_count(), 0u);
+  EXPECT_EQ(manager.frame_num(), 4u);
+
+  frame1->unpin();
+  frame2->unpin();
+  frame3->unpin();
+}
+
+// 测试环中的页帧被淘汰并且被别的页面使用之后，不会被误复用
+TEST_F(ScanRingTest, StaleRingEntry) {
+  ScanRing ring(1);
+  Frame* frame = scan_page(0, ring);
+  ASSERT_NE(frame, nullptr);
+  frame->unpin();
+
+  ASSERT_EQ(manager.purge_frames(frame_num, purger), 1);
+  Frame* other = manager.alloc(buffer_pool_id, 100);
+  ASSERT_NE(other, nullptr);
+  other->unpin();
+
+  Frame* frame1 = scan_page(1, ring);
+  ASSERT_NE(frame1, nullptr);
+  EXPECT_EQ(ring.reused_count(), 0u);
+  EXPECT_NE(manager.get(buffer_pool_id, 100), nullptr);
+  frame1->unpin();
+}
+
+// 测试扫描命中不会在替换策略中提升页面
+TEST(ScanRingPromoteTest, HitDoesNotPromote) {
+  // 只用一个分片，才能比较页面的淘汰顺序
+  FrameManager manager("ScanRingPromoteTest");
+  ASSERT_EQ(manager.init(8, 1), RC::SUCCESS);
+
+  ScanRing ring;
+  for (PageNum i = 0; i < 2; i++) {
+    Frame* frame = manager.alloc(1, i);
+    ASSERT_NE(frame, nullptr);
+    frame->unpin();
+  }
+
+  // 扫描命中页面0，页面0仍然是最先被淘汰的
+  Frame* hit = manager.get(1, 0, &ring);
+  ASSERT_NE(hit, nullptr);
+  hit->unpin();
+
+  std::vector<PageNum> purged_pages;
+  auto recorder = [&purged_pages](Frame* frame) {
+    purged_pages.push_back(frame->page_num());
+    return RC::SUCCESS;
+  };
+  ASSERT_EQ(manager.purge_frames(1, recorder), 1);
+  EXPECT_EQ(purged_pages, (std::vector<PageNum>{0}));
+
+  // 对照：普通命中会提升页面，页面1不再是最先被淘汰的
+  for (PageNum i = 2; i < 4; i++) {
+    Frame* frame = manager.alloc(1, i);
+    ASSERT_NE(frame, nullptr);
+    frame->unpin();
+  }
+  hit = manager.get(1, 1);
+  ASSERT_NE(hit, nullptr);
+  hit->unpin();
+
+  purged_pages.clear();
+  ASSERT_EQ(manager.purge_frames(1, recorder), 1);
+  EXPECT_EQ(purged_pages, (std::vector<PageNum>{2}));
+
+  manager.purge_frames(8, recorder);
+  EXPECT_EQ(manager.cleanup(), RC::SUCCESS);
+}
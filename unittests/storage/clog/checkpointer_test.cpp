@@ -0,0 +1,287 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "storage/clog/checkpointer.h"
+#include "storage/clog/control_file.h"
+#include "storage/clog/disk_log_handler.h"
+#include "storage/clog/log_entry.h"
+#include "storage/clog/log_replayer.h"
+
+using namespace std;
+
+/**
+ * @brief 记录回放的日志
+ */
+class CollectReplayer : public LogReplayer {
+public:
+  RC replay(const LogEntry& entry) override {
+    lsns.push_back(entry.lsn());
+    return RC::SUCCESS;
+  }
+
+  vector<LSN> lsns;
+};
+
+class CheckpointerTest : public testing::Test {
+protected:
+  void SetUp() override {
+    test_dir = "test_checkpoint_logs";
+    filesystem::remove_all(test_dir);
+  }
+
+  void TearDown() override { filesystem::remove_all(test_dir); }
+
+  string control_file() const { return test_dir + "/dimdb.ctl"; }
+
+  int count_files(const string& ext) const {
+    int count = 0;
+    for (const auto& file : filesystem::directory_iterator(test_dir)) {
+      count += file.path().extension() == ext ? 1 : 0;
+    }
+    return count;
+  }
+
+  static void append(DiskLogHandler& handler, int count) {
+    LSN lsn = 0;
+    for (int i = 0; i < count; i++) {
+      ASSERT_EQ(handler.append(lsn, LogModule::Id::BUFFER_POOL, "entry"), RC::SUCCESS);
+    }
+    ASSERT_EQ(handler.wait_lsn(lsn), RC::SUCCESS);
+  }
+
+  string test_dir;
+};
+
+// 测试控制文件不存在、写入之后重新读取，以及损坏时报错
+TEST_F(CheckpointerTest, ControlFile) {
+  filesystem::create_directories(test_dir);
+
+  ControlFile file;
+  ASSERT_EQ(file.open(control_file()), RC::SUCCESS);
+  EXPECT_EQ(file.data().checkpoint_lsn, 0);
+  EXPECT_EQ(file.data().redo_lsn, 0);
+
+  ControlFileData data;
+  data.checkpoint_lsn = 100;
+  data.redo_lsn       = 42;
+  ASSERT_EQ(file.write(data), RC::SUCCESS);
+  EXPECT_FALSE(filesystem::exists(control_file() + ".tmp"));
+
+  ControlFile other;
+  ASSERT_EQ(other.open(control_file()), RC::SUCCESS);
+  EXPECT_EQ(other.data().checkpoint_lsn, 100);
+  EXPECT_EQ(other.data().redo_lsn, 42);
+
+  {
+    FILE* fp = fopen(control_file().c_str(), "r+b");
+    ASSERT_NE(fp, nullptr);
+    fseek(fp, 10, SEEK_SET);
+    fputc(0x5a, fp);
+    fclose(fp);
+  }
+  EXPECT_EQ(other.open(control_file()), RC::FILE_CORRUPTED);
+}
+
+// 测试恢复起点取脏页最小的 recLSN，回收它之前的日志文件，回放时跳过检查点日志
+TEST_F(CheckpointerTest, CheckpointAndRecycle) {
+  const int entries_per_file = 16;
+  LSN       min_rec_lsn      = 0;
+  {
+    DiskLogHandler handler;
+    ASSERT_EQ(handler.init(test_dir, entries_per_file, 4096), RC::SUCCESS);
+
+    Checkpointer checkpointer(handler, [&min_rec_lsn]() { return min_rec_lsn; });
+    ASSERT_EQ(checkpointer.init(control_file()), RC::SUCCESS);
+    EXPECT_EQ(checkpointer.redo_lsn(), 0);
+
+    // 有一个从 LSN 40 开始变脏的页面
+    append(handler, 100);
+    min_rec_lsn = 40;
+    ASSERT_EQ(checkpointer.checkpoint(), RC::SUCCESS);
+    EXPECT_EQ(checkpointer.redo_lsn(), 40);
+    EXPECT_EQ(checkpointer.stats().checkpoint_lsn, 101);
+    EXPECT_FALSE(filesystem::exists(test_dir + "/clog_16.log"));
+    EXPECT_TRUE(filesystem::exists(test_dir + "/clog_32.log"));
+
+    // 恢复起点没有变化时不再写检查点日志
+    ASSERT_EQ(checkpointer.checkpoint(), RC::SUCCESS);
+    EXPECT_EQ(checkpointer.stats().checkpoints, 1u);
+
+    // 页面都刷盘之后恢复起点是当前LSN之后
+    append(handler, 10);
+    min_rec_lsn = 0;
+    ASSERT_EQ(checkpointer.checkpoint(), RC::SUCCESS);
+    EXPECT_EQ(checkpointer.redo_lsn(), 112);
+    EXPECT_EQ(checkpointer.stats().checkpoints, 2u);
+    EXPECT_EQ(count_files(".log"), 1);
+  }
+
+  // 重启之后从控制文件记录的恢复起点开始回放
+  DiskLogHandler handler;
+  ASSERT_EQ(handler.init(test_dir, entries_per_file, 4096), RC::SUCCESS);
+  Checkpointer checkpointer(handler, nullptr);
+  ASSERT_EQ(checkpointer.init(control_file()), RC::SUCCESS);
+  EXPECT_EQ(checkpointer.redo_lsn(), 112);
+  append(handler, 5);
+
+  CollectReplayer replayer;
+  ASSERT_EQ(handler.replay(replayer, checkpointer.redo_lsn()), RC::SUCCESS);
+  EXPECT_EQ(replayer.lsns, vector<LSN>({113, 114, 115, 116, 117}));
+}
+
+// 测试追加了还没有落盘的日志时，恢复起点停在已经落盘的日志之后
+TEST_F(CheckpointerTest, RedoLsnNotBeyondFlushed) {
+  DiskLogHandler handler;
+  ASSERT_EQ(handler.init(test_dir, 16, 0), RC::SUCCESS);
+  Checkpointer checkpointer(handler, []() { return LSN(0); });
+  ASSERT_EQ(checkpointer.init(control_file()), RC::SUCCESS);
+
+  append(handler, 20);
+  LSN lsn = 0;
+  for (int i = 0; i < 10; i++) {
+    ASSERT_EQ(handler.append(lsn, LogModule::Id::BUFFER_POOL, "entry"), RC::SUCCESS);
+  }
+  ASSERT_EQ(handler.flushed_lsn(), 20);
+  ASSERT_EQ(handler.current_lsn(), 30);
+
+  ASSERT_EQ(checkpointer.checkpoint(), RC::SUCCESS);
+  EXPECT_EQ(checkpointer.redo_lsn(), 21);
+  EXPECT_EQ(checkpointer.stats().checkpoint_lsn, 31);
+
+  vector<LSN> lsns;
+  ASSERT_EQ(handler.iterate(
+                [&lsns](LogEntry& entry) {
+                  lsns.push_back(entry.lsn());
+                  return RC::SUCCESS;
+                },
+                checkpointer.redo_lsn()),
+      RC::SUCCESS);
+  ASSERT_FALSE(lsns.empty());
+  EXPECT_LE(lsns.front(), 21);
+  EXPECT_EQ(lsns.back(), 31);
+}
+
+// 测试追加和刷盘的同时做检查点：恢复起点不会越过已经落盘的日志，回收之后仍然保留恢复起点之后的所有日志
+TEST_F(CheckpointerTest, CheckpointWhileAppending) {
+  const int num_appenders = 2;
+  const int num_entries   = 2000;
+  LSN       last_lsn      = 0;
+  LSN       redo_lsn      = 0;
+  {
+    DiskLogHandler handler;
+    ASSERT_EQ(handler.init(test_dir, 64, 0), RC::SUCCESS);
+    ASSERT_EQ(handler.start(), RC::SUCCESS);
+    Checkpointer checkpointer(handler, []() { return LSN(0); });
+    ASSERT_EQ(checkpointer.init(control_file()), RC::SUCCESS);
+
+    atomic<int>    running{num_appenders};
+    vector<thread> appenders;
+    for (int i = 0; i < num_appenders; i++) {
+      appenders.emplace_back([&handler, &running, num_entries]() {
+        LSN lsn = 0;
+        for (int j = 0; j < num_entries; j++) {
+          EXPECT_EQ(handler.append(lsn, LogModule::Id::BUFFER_POOL, "entry"), RC::SUCCESS);
+          if (j % 100 == 0) {
+            this_thread::yield();
+          }
+        }
+        running--;
+      });
+    }
+
+    int checkpoints = 0;
+    while (running.load() > 0 || checkpoints == 0) {
+      ASSERT_EQ(checkpointer.checkpoint(), RC::SUCCESS);
+      EXPECT_LE(checkpointer.redo_lsn(), handler.flushed_lsn() + 1);
+      checkpoints++;
+    }
+    for (thread& appender : appenders) {
+      appender.join();
+    }
+
+    last_lsn = handler.current_lsn();
+    ASSERT_EQ(handler.wait_lsn(last_lsn), RC::SUCCESS);
+    redo_lsn = checkpointer.redo_lsn();
+    EXPECT_GT(redo_lsn, 0);
+    ASSERT_EQ(handler.stop(), RC::SUCCESS);
+    ASSERT_EQ(handler.await_termination(), RC::SUCCESS);
+  }
+
+  // 检查点日志回放时会跳过，这里遍历所有日志，恢复起点之后的LSN必须连续
+  DiskLogHandler handler;
+  ASSERT_EQ(handler.init(test_dir, 64, 0), RC::SUCCESS);
+  EXPECT_EQ(handler.current_lsn(), last_lsn);
+  vector<LSN> lsns;
+  ASSERT_EQ(handler.iterate(
+                [&lsns, redo_lsn](LogEntry& entry) {
+                  if (entry.lsn() >= redo_lsn) {
+                    lsns.push_back(entry.lsn());
+                  }
+                  return RC::SUCCESS;
+                },
+                redo_lsn),
+      RC::SUCCESS);
+  if (redo_lsn > last_lsn) {
+    EXPECT_TRUE(lsns.empty());
+  } else {
+    ASSERT_EQ(lsns.size(), static_cast<size_t>(last_lsn - redo_lsn + 1));
+    for (size_t i = 0; i < lsns.size(); i++) {
+      EXPECT_EQ(lsns[i], redo_lsn + i);
+    }
+  }
+}
+
+// 测试后台线程按照目标恢复时间做检查点，脏页太旧时请求刷脏页
+TEST_F(CheckpointerTest, TargetRecoveryTime) {
+  DiskLogHandler handler;
+  ASSERT_EQ(handler.init(test_dir, 1000, 0), RC::SUCCESS);
+
+  // 目标恢复时间对应100条日志，日志增长50条就做检查点
+  CheckpointOptions options;
+  options.target_recovery_ms = 100;
+  options.replay_lsn_per_sec = 1000;
+  options.check_interval_ms  = 10;
+
+  LSN         min_rec_lsn = 0;
+  atomic<int> flush_requests{0};
+  Checkpointer checkpointer(handler, [&min_rec_lsn]() { return min_rec_lsn; }, [&flush_requests]() { flush_requests++; },
+      options);
+  ASSERT_EQ(checkpointer.init(control_file()), RC::SUCCESS);
+  EXPECT_EQ(checkpointer.target_lsn_distance(), 100);
+
+  append(handler, 49);
+  EXPECT_FALSE(checkpointer.need_checkpoint());
+  append(handler, 1);
+  EXPECT_TRUE(checkpointer.need_checkpoint());
+
+  ASSERT_EQ(checkpointer.start(), RC::SUCCESS);
+  for (int i = 0; i < 500 && checkpointer.stats().checkpoints == 0; i++) {
+    this_thread::sleep_for(chrono::milliseconds(10));
+  }
+  EXPECT_EQ(checkpointer.stats().checkpoints, 1u);
+  EXPECT_EQ(checkpointer.redo_lsn(), 51);
+  EXPECT_FALSE(checkpointer.need_checkpoint());
+  checkpointer.stop();
+
+  // 有一个很旧的脏页，检查点推进不了恢复起点
+  min_rec_lsn = 60;
+  append(handler, 150);
+  ASSERT_EQ(checkpointer.checkpoint(), RC::SUCCESS);
+  EXPECT_EQ(checkpointer.redo_lsn(), 60);
+  EXPECT_EQ(flush_requests.load(), 1);
+  EXPECT_EQ(checkpointer.stats().flush_requests, 1u);
+
+  // 有不知道 recLSN 的脏页，恢复起点和日志都保持不动
+  const uint64_t checkpoints = checkpointer.stats().checkpoints;
+  min_rec_lsn = -1;
+  append(handler, 10);
+  ASSERT_EQ(checkpointer.checkpoint(), RC::SUCCESS);
+  EXPECT_EQ(checkpointer.redo_lsn(), 60);
+  EXPECT_EQ(checkpointer.stats().checkpoints, checkpoints);
+  EXPECT_EQ(flush_requests.load(), 2);
+}
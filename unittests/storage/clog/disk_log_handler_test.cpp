@@ -0,0 +1,379 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "storage/clog/disk_log_handler.h"
+#include "storage/clog/log_entry.h"
+#include "storage/clog/log_replayer.h"
+#include "common/log/log.h"
+
+using namespace std;
+
+/**
+ * @brief 记录回放的日志
+ */
+class CollectReplayer : public LogReplayer {
+public:
+  RC replay(const LogEntry& entry) override {
+    lsns.push_back(entry.lsn());
+    payloads.emplace_back(entry.data(), entry.payload_size());
+    return RC::SUCCESS;
+  }
+
+  RC on_done() override {
+    done = true;
+    return RC::SUCCESS;
+  }
+
+  vector<LSN>    lsns;
+  vector<string> payloads;
+  bool           done = false;
+};
+
+class DiskLogHandlerTest : public testing::Test {
+protected:
+  void SetUp() override {
+    test_dir = "test_disk_logs";
+    filesystem::remove_all(test_dir);
+  }
+
+  void TearDown() override { filesystem::remove_all(test_dir); }
+
+  string test_dir;
+};
+
+// 测试通过 LogHandler::create 创建，追加日志之后 wait_lsn 返回时日志已经落盘
+TEST_F(DiskLogHandlerTest, AppendAndWait) {
+  LogHandler* handler = nullptr;
+  ASSERT_EQ(LogHandler::create("disk", handler), RC::SUCCESS);
+  ASSERT_NE(handler, nullptr);
+  ASSERT_EQ(handler->init(test_dir), RC::SUCCESS);
+  ASSERT_EQ(handler->start(), RC::SUCCESS);
+
+  LSN lsn = 0;
+  for (int i = 0; i < 10; i++) {
+    ASSERT_EQ(handler->append(lsn, LogModule::Id::BUFFER_POOL, "entry" + to_string(i)), RC::SUCCESS);
+    EXPECT_EQ(lsn, i + 1);
+  }
+  EXPECT_EQ(handler->wait_lsn(lsn), RC::SUCCESS);
+  EXPECT_GE(static_cast<DiskLogHandler*>(handler)->flushed_lsn(), lsn);
+  EXPECT_EQ(handler->wait_lsn(lsn + 1), RC::INVALID_ARGUMENT);
+
+  ASSERT_EQ(handler->stop(), RC::SUCCESS);
+  ASSERT_EQ(handler->await_termination(), RC::SUCCESS);
+  delete handler;
+
+  EXPECT_EQ(LogHandler::create("unknown", handler), RC::INVALID_ARGUMENT);
+}
+
+// 测试文件切换，重新打开之后从最后的LSN继续，并且可以从任意LSN开始回放
+TEST_F(DiskLogHandlerTest, RolloverAndReplay) {
+  const int entries_per_file = 16;
+  const int total            = 100;
+  {
+    DiskLogHandler handler;
+    ASSERT_EQ(handler.init(test_dir, entries_per_file, 4096), RC::SUCCESS);
+    ASSERT_EQ(handler.start(), RC::SUCCESS);
+
+    // 多个线程并发追加，每个线程等待自己的日志落盘
+    vector<thread> threads;
+    for (int t = 0; t < 4; t++) {
+      threads.emplace_back([&handler, t]() {
+        for (int i = 0; i < total / 4; i++) {
+          LSN lsn = 0;
+          ASSERT_EQ(handler.append(lsn, LogModule::Id::BUFFER_POOL, "t" + to_string(t)), RC::SUCCESS);
+          ASSERT_EQ(handler.wait_lsn(lsn), RC::SUCCESS);
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    EXPECT_EQ(handler.flushed_lsn(), total);
+    handler.stop();
+    handler.await_termination();
+  }
+
+  // 除了最后一个正在写的文件，每个日志文件切换时都写了索引文件
+  int file_count  = 0;
+  int index_count = 0;
+  for (const auto& file : filesystem::directory_iterator(test_dir)) {
+    const string ext = file.path().extension().string();
+    file_count += ext == ".log" ? 1 : 0;
+    index_count += ext == ".idx" ? 1 : 0;
+  }
+  EXPECT_EQ(file_count, (total + 1 + entries_per_file - 1) / entries_per_file);
+  EXPECT_EQ(index_count, file_count - 1);
+
+  DiskLogHandler handler;
+  ASSERT_EQ(handler.init(test_dir, entries_per_file, 4096), RC::SUCCESS);
+  EXPECT_EQ(handler.current_lsn(), total);
+
+  CollectReplayer all;
+  ASSERT_EQ(handler.replay(all, 0), RC::SUCCESS);
+  EXPECT_TRUE(all.done);
+  ASSERT_EQ(all.lsns.size(), static_cast<size_t>(total));
+  for (int i = 0; i < total; i++) {
+    EXPECT_EQ(all.lsns[i], i + 1);
+  }
+
+  // 从文件中间开始回放
+  CollectReplayer part;
+  ASSERT_EQ(handler.replay(part, 40), RC::SUCCESS);
+  ASSERT_EQ(part.lsns.size(), static_cast<size_t>(total - 39));
+  EXPECT_EQ(part.lsns.front(), 40);
+
+  // 没有启动刷盘线程时 wait_lsn 自己刷盘
+  LSN lsn = 0;
+  ASSERT_EQ(handler.append(lsn, LogModule::Id::BUFFER_POOL, "after restart"), RC::SUCCESS);
+  EXPECT_EQ(lsn, total + 1);
+  ASSERT_EQ(handler.wait_lsn(lsn), RC::SUCCESS);
+
+  CollectReplayer tail;
+  ASSERT_EQ(handler.replay(tail, lsn), RC::SUCCESS);
+  ASSERT_EQ(tail.lsns.size(), 1u);
+  EXPECT_EQ(tail.payloads.front(), "after restart");
+}
+
+// 测试没有启动刷盘线程时多个线程并发追加和等待：wait_lsn 通过组提交刷盘，等待前面还没有发布的日志，跨文件切换
+TEST_F(DiskLogHandlerTest, WaitWithoutFlushThread) {
+  const int entries_per_file = 16;
+  const int total            = 400;
+  {
+    DiskLogHandler handler;
+    ASSERT_EQ(handler.init(test_dir, entries_per_file, 4096), RC::SUCCESS);
+
+    vector<thread> threads;
+    for (int t = 0; t < 4; t++) {
+      threads.emplace_back([&handler, t]() {
+        for (int i = 0; i < total / 4; i++) {
+          LSN lsn = 0;
+          ASSERT_EQ(handler.append(lsn, LogModule::Id::BUFFER_POOL, "t" + to_string(t)), RC::SUCCESS);
+          ASSERT_EQ(handler.wait_lsn(lsn), RC::SUCCESS);
+          EXPECT_GE(handler.flushed_lsn(), lsn);
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    EXPECT_EQ(handler.flushed_lsn(), total);
+  }
+
+  DiskLogHandler handler;
+  ASSERT_EQ(handler.init(test_dir, entries_per_file, 4096), RC::SUCCESS);
+  EXPECT_EQ(handler.current_lsn(), total);
+  CollectReplayer all;
+  ASSERT_EQ(handler.replay(all, 0), RC::SUCCESS);
+  ASSERT_EQ(all.lsns.size(), static_cast<size_t>(total));
+  for (int i = 0; i < total; i++) {
+    EXPECT_EQ(all.lsns[i], i + 1);
+  }
+}
+
+// 测试崩溃时写了一半的日志：重启时在它的位置写上结束标记，回放停在最后一条完整的日志，之后可以继续写
+TEST_F(DiskLogHandlerTest, TornTail) {
+  const int total = 20;
+  {
+    DiskLogHandler handler;
+    ASSERT_EQ(handler.init(test_dir), RC::SUCCESS);
+    LSN lsn = 0;
+    for (int i = 0; i < total; i++) {
+      ASSERT_EQ(handler.append(lsn, LogModule::Id::BUFFER_POOL, "entry" + to_string(i)), RC::SUCCESS);
+    }
+    ASSERT_EQ(handler.wait_lsn(lsn), RC::SUCCESS);
+  }
+
+  string log_file;
+  for (const auto& file : filesystem::directory_iterator(test_dir)) {
+    if (file.path().extension() == ".log") {
+      log_file = file.path().string();
+    }
+  }
+
+  // 文件是预分配的，日志的结尾不是文件大小
+  int64_t valid_size = 0;
+  {
+    LogFileReader reader;
+    ASSERT_EQ(reader.open(log_file, LogFileReader::Mode::MMAP), RC::SUCCESS);
+    ASSERT_EQ(reader.iterate([](LogEntry&) { return RC::SUCCESS; }), RC::SUCCESS);
+    EXPECT_FALSE(reader.torn());
+    EXPECT_EQ(reader.last_lsn(), total);
+    valid_size = reader.valid_size();
+  }
+  EXPECT_GT(static_cast<int64_t>(filesystem::file_size(log_file)), valid_size);
+
+  // 模拟最后一条日志只写了一部分，并且倒数第二条日志的数据损坏
+  {
+    FILE* file = fopen(log_file.c_str(), "r+b");
+    ASSERT_NE(file, nullptr);
+    LogHeader header;
+    header.lsn       = total + 1;
+    header.data_size = 100;
+    fseek(file, static_cast<long>(valid_size), SEEK_SET);
+    fwrite(&header, LogHeader::HEAD_SIZE, 1, file);
+    fwrite("half", 4, 1, file);
+    fseek(file, static_cast<long>(valid_size) - 1, SEEK_SET);
+    fputc('X', file);
+    fclose(file);
+  }
+
+  DiskLogHandler handler;
+  ASSERT_EQ(handler.init(test_dir), RC::SUCCESS);
+  EXPECT_EQ(handler.current_lsn(), total - 1);
+
+  LSN lsn = 0;
+  ASSERT_EQ(handler.append(lsn, LogModule::Id::BUFFER_POOL, "after crash"), RC::SUCCESS);
+  EXPECT_EQ(lsn, total);
+  ASSERT_EQ(handler.wait_lsn(lsn), RC::SUCCESS);
+
+  CollectReplayer replayer;
+  ASSERT_EQ(handler.replay(replayer, 0), RC::SUCCESS);
+  ASSERT_EQ(replayer.lsns.size(), static_cast<size_t>(total));
+  EXPECT_EQ(replayer.lsns.back(), total);
+  EXPECT_EQ(replayer.payloads.back(), "after crash");
+}
+
+// 测试检查点之后回收日志文件，切换文件时重用它们，旧的日志不会被当作新文件中的日志
+TEST_F(DiskLogHandlerTest, RecycleFiles) {
+  const int entries_per_file = 16;
+  const int total            = 100;
+  auto count_files = [this](const string& ext) {
+    int count = 0;
+    for (const auto& file : filesystem::directory_iterator(test_dir)) {
+      count += file.path().extension() == ext ? 1 : 0;
+    }
+    return count;
+  };
+
+  {
+    // 旧日志比新日志长，新日志写不满重用的文件
+    DiskLogHandler handler;
+    ASSERT_EQ(handler.init(test_dir, entries_per_file, 4096), RC::SUCCESS);
+    LSN lsn = 0;
+    for (int i = 0; i < total; i++) {
+      ASSERT_EQ(handler.append(lsn, LogModule::Id::BUFFER_POOL, string(40, 'o')), RC::SUCCESS);
+    }
+    ASSERT_EQ(handler.wait_lsn(lsn), RC::SUCCESS);
+
+    // [0, 48) 的三个文件不再需要了
+    ASSERT_EQ(handler.recycle(50), RC::SUCCESS);
+    EXPECT_EQ(count_files(".free"), 3);
+    EXPECT_EQ(count_files(".log"), 4);
+    EXPECT_FALSE(filesystem::exists(test_dir + "/clog_0.log"));
+    EXPECT_FALSE(filesystem::exists(test_dir + "/clog_0.idx"));
+
+    for (int i = 0; i < 2 * entries_per_file + 1; i++) {
+      ASSERT_EQ(handler.append(lsn, LogModule::Id::BUFFER_POOL, "new" + to_string(i)), RC::SUCCESS);
+      ASSERT_EQ(handler.wait_lsn(lsn), RC::SUCCESS);
+    }
+    EXPECT_EQ(count_files(".free"), 1);
+  }
+
+  const LSN last_lsn = total + 2 * entries_per_file + 1;
+  DiskLogHandler handler;
+  ASSERT_EQ(handler.init(test_dir, entries_per_file, 4096), RC::SUCCESS);
+  EXPECT_EQ(handler.current_lsn(), last_lsn);
+
+  CollectReplayer replayer;
+  ASSERT_EQ(handler.replay(replayer, 48), RC::SUCCESS);
+  ASSERT_EQ(replayer.lsns.size(), static_cast<size_t>(last_lsn - 47));
+  for (size_t i = 0; i < replayer.lsns.size(); i++) {
+    const LSN lsn = 48 + static_cast<LSN>(i);
+    EXPECT_EQ(replayer.lsns[i], lsn);
+    EXPECT_EQ(replayer.payloads[i], lsn <= total ? string(40, 'o') : "new" + to_string(lsn - total - 1));
+  }
+}
+
+// 测试压缩日志：超过阈值的日志压缩之后写入，两种读取方式和回放都能还原
+TEST_F(DiskLogHandlerTest, CompressLargeEntries) {
+  // 类似页面镜像，大部分是重复的记录
+  auto page_image = [](int i) {
+    string page;
+    while (page.size() < 8192) {
+      page += "key" + to_string(i) + "_" + to_string(page.size() % 64) + ";";
+    }
+    page.resize(8192);
+    return page;
+  };
+
+  const int total = 20;
+  {
+    DiskLogHandler handler;
+    ASSERT_EQ(handler.init(test_dir), RC::SUCCESS);
+    // 默认不压缩
+    EXPECT_EQ(handler.log_buffer().compress_threshold(), 0);
+    handler.set_compress_threshold(1024);
+    LSN lsn = 0;
+    for (int i = 0; i < total; i++) {
+      // 小日志不压缩
+      const string data = i % 2 == 0 ? page_image(i) : "small" + to_string(i);
+      ASSERT_EQ(handler.append(lsn, LogModule::Id::BUFFER_POOL, data), RC::SUCCESS);
+    }
+    ASSERT_EQ(handler.wait_lsn(lsn), RC::SUCCESS);
+    EXPECT_EQ(handler.log_buffer().compressed_entries(), static_cast<uint64_t>(total / 2));
+    EXPECT_GT(handler.log_buffer().compress_saved_bytes(), static_cast<uint64_t>(total / 2 * 4096));
+  }
+
+  for (auto mode : {LogFileReader::Mode::MMAP, LogFileReader::Mode::BUFFERED}) {
+    LogFileReader reader;
+    ASSERT_EQ(reader.open(test_dir + "/clog_0.log", mode), RC::SUCCESS);
+    int count = 0;
+    ASSERT_EQ(reader.iterate([&count, &page_image](LogEntry& entry) {
+      const int i = count++;
+      EXPECT_FALSE(entry.header().is_compressed());
+      EXPECT_EQ(string(entry.data(), entry.payload_size()), i % 2 == 0 ? page_image(i) : "small" + to_string(i));
+      return RC::SUCCESS;
+    }), RC::SUCCESS);
+    EXPECT_EQ(count, total);
+    EXPECT_FALSE(reader.torn());
+  }
+
+  DiskLogHandler handler;
+  ASSERT_EQ(handler.init(test_dir), RC::SUCCESS);
+  EXPECT_EQ(handler.current_lsn(), total);
+  CollectReplayer replayer;
+  ASSERT_EQ(handler.replay(replayer, 0), RC::SUCCESS);
+  ASSERT_EQ(replayer.payloads.size(), static_cast<size_t>(total));
+  EXPECT_EQ(replayer.payloads[0], page_image(0));
+  EXPECT_EQ(replayer.payloads[1], "small1");
+}
+
+// 测试两种异步IO的实现写出来的日志可以互相读：线程池写，重新打开之后默认方式继续写并回放
+TEST_F(DiskLogHandlerTest, IoBackends) {
+  LSN lsn = 0;
+  {
+    DiskLogHandler handler;
+    handler.set_io_backend(common::AsyncIoBackend::THREAD_POOL);
+    ASSERT_EQ(handler.init(test_dir, 50, 0), RC::SUCCESS);
+    EXPECT_EQ(handler.io_backend(), common::AsyncIoBackend::THREAD_POOL);
+    ASSERT_EQ(handler.start(), RC::SUCCESS);
+    for (int i = 0; i < 120; i++) {
+      ASSERT_EQ(handler.append(lsn, LogModule::Id::BUFFER_POOL, "entry" + to_string(i)), RC::SUCCESS);
+    }
+    ASSERT_EQ(handler.wait_lsn(lsn), RC::SUCCESS);
+    ASSERT_EQ(handler.stop(), RC::SUCCESS);
+    ASSERT_EQ(handler.await_termination(), RC::SUCCESS);
+  }
+
+  DiskLogHandler handler;
+  ASSERT_EQ(handler.init(test_dir, 50, 0), RC::SUCCESS);
+  ASSERT_EQ(handler.start(), RC::SUCCESS);
+  for (int i = 120; i < 150; i++) {
+    ASSERT_EQ(handler.append(lsn, LogModule::Id::BUFFER_POOL, "entry" + to_string(i)), RC::SUCCESS);
+  }
+  ASSERT_EQ(handler.wait_lsn(lsn), RC::SUCCESS);
+  EXPECT_EQ(lsn, 150);
+
+  CollectReplayer replayer;
+  ASSERT_EQ(handler.replay(replayer, 0), RC::SUCCESS);
+  ASSERT_EQ(replayer.payloads.size(), 150u);
+  for (int i = 0; i < 150; i++) {
+    EXPECT_EQ(replayer.lsns[i], i + 1);
+    EXPECT_EQ(replayer.payloads[i], "entry" + to_string(i));
+  }
+  ASSERT_EQ(handler.stop(), RC::SUCCESS);
+  ASSERT_EQ(handler.await_termination(), RC::SUCCESS);
+}
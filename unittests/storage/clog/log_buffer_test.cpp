@@ -1,15 +1,66 @@
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
 #include <thread>
 #include <vector>
 #include <random>
 #include <chrono>
 #include <filesystem>
 
+#include "common/io/async_io.h"
 #include "storage/clog/log_buffer.h"
 #include "storage/clog/log_file.h"
 #include "common/rc.h"
 #include "common/log/log.h"
 
+/**
+ * @brief 可以让落盘失败的IO引擎，读写直接执行
+ */
+class FaultyIoEngine : public common::AsyncIoEngine {
+public:
+  FaultyIoEngine() : AsyncIoEngine(4) {}
+
+  common::AsyncIoBackend backend() const override { return common::AsyncIoBackend::THREAD_POOL; }
+
+  int prepare(common::AsyncIoRequest* request) override {
+    if (inflight_ >= queue_depth_) {
+      return EAGAIN;
+    }
+    inflight_++;
+    prepared_.push_back(request);
+    return 0;
+  }
+
+  int submit() override {
+    for (common::AsyncIoRequest* request : prepared_) {
+      if ((request->op == common::AsyncIoOp::FSYNC && fail_sync.load()) ||
+          (request->op == common::AsyncIoOp::WRITE && fail_write.load())) {
+        request->result = EIO;
+      } else {
+        execute_sync(*request);
+      }
+      completed_.push_back(request);
+    }
+    prepared_.clear();
+    return 0;
+  }
+
+  int reap(int /*min_complete*/, common::AsyncIoRequest** completed, int max) override {
+    const int count = std::min(max, static_cast<int>(completed_.size()));
+    std::copy(completed_.begin(), completed_.begin() + count, completed);
+    completed_.erase(completed_.begin(), completed_.begin() + count);
+    inflight_ -= count;
+    return count;
+  }
+
+  std::atomic<bool> fail_sync{false};
+  std::atomic<bool> fail_write{false};
+
+private:
+  std::vector<common::AsyncIoRequest*> prepared_;
+  std::vector<common::AsyncIoRequest*> completed_;
+};
+
 /**
  * @brief LogBuffer测试类
  * 用于测试LogBuffer的各种功能和边界条件
@@ -166,6 +217,7 @@ TEST_F(LogBufferTest, Configuration) {
 
   // 测试设置刷盘阈值
   buffer.set_flush_threshold(0.5f);
+  // 默认不压缩，按原始大小占用缓冲区
   std::vector<char> data(1024 * 1024, 'a');  // 1MB
   LSN lsn = 0;
   RC rc = buffer.append(lsn, LogModule(1), std::move(data));
@@ -213,6 +265,402 @@ TEST_F(LogBufferTest, ErrorHandling) {
   EXPECT_EQ(rc, RC::SUCCESS);  // 空数据应该是允许的
 }
 
+/**
+ * @brief 测试组提交
+ * 多个线程并发提交，每个线程返回时自己的日志都已经落盘，并且可以从文件中读出来
+ */
+TEST_F(LogBufferTest, GroupCommit) {
+  const int num_threads = 8;
+  const int commits_per_thread = 50;
+
+  LogFileWriter writer;
+  ASSERT_EQ(writer.open(test_dir + "/test.log", 100000), RC::SUCCESS);
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < num_threads; ++i) {
+    threads.emplace_back([this, &writer, i]() {
+      for (int j = 0; j < commits_per_thread; ++j) {
+        std::vector<char> data(16, static_cast<char>('a' + i));
+        LSN lsn = 0;
+        ASSERT_EQ(buffer.append(lsn, LogModule(1), std::move(data)), RC::SUCCESS);
+        ASSERT_EQ(buffer.group_commit(writer, lsn), RC::SUCCESS);
+        EXPECT_GE(buffer.flushed_lsn(), lsn);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  const LSN total = num_threads * commits_per_thread;
+  EXPECT_EQ(buffer.flushed_lsn(), total);
+  EXPECT_EQ(buffer.size(), 0);
+  EXPECT_EQ(buffer.bytes(), 0);
+  EXPECT_LE(buffer.flush_count(), static_cast<uint64_t>(total));
+  ASSERT_EQ(writer.close(), RC::SUCCESS);
+
+  // 文件中的日志按LSN连续
+  LogFileReader reader;
+  ASSERT_EQ(reader.open(test_dir + "/test.log"), RC::SUCCESS);
+  LSN expected = 1;
+  ASSERT_EQ(reader.iterate([&expected](LogEntry& entry) {
+    EXPECT_EQ(entry.lsn(), expected++);
+    EXPECT_EQ(entry.payload_size(), 16);
+    return RC::SUCCESS;
+  }), RC::SUCCESS);
+  EXPECT_EQ(expected, total + 1);
+  reader.close();
+
+  // 已经落盘的LSN直接返回，没有分配过的LSN返回错误
+  EXPECT_EQ(buffer.group_commit(writer, total), RC::SUCCESS);
+  EXPECT_EQ(buffer.group_commit(writer, total + 1), RC::INVALID_ARGUMENT);
+}
+
+/**
+ * @brief 测试追加和刷盘的同时读 current_lsn/bytes/size
+ * 读到的值不能比之前读到的 flushed_lsn 小，也不能超过已经开始追加的日志，bytes 不能超过缓冲区大小加上正在追加的日志
+ */
+TEST_F(LogBufferTest, ConcurrentReads) {
+  const int  num_appenders = 2;
+  const int  num_readers   = 4;
+  const LSN  total         = 100000;
+
+  LogFileWriter writer;
+  ASSERT_EQ(writer.open(test_dir + "/test.log", total + 1), RC::SUCCESS);
+
+  std::atomic<LSN>  issued{0};  // 开始追加的日志条数，在 append 之前增加
+  std::atomic<bool> done{false};
+  std::atomic<int>  errors{0};
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < num_appenders; ++i) {
+    threads.emplace_back([this, &issued]() {
+      while (issued.fetch_add(1) < total) {
+        LSN lsn = 0;
+        ASSERT_EQ(buffer.append(lsn, LogModule(1), std::vector<char>(32, 'x')), RC::SUCCESS);
+      }
+    });
+  }
+  threads.emplace_back([this, &writer, &done]() {
+    while (!done.load()) {
+      ASSERT_EQ(buffer.flush(writer), RC::SUCCESS);
+    }
+  });
+  for (int i = 0; i < num_readers; ++i) {
+    threads.emplace_back([this, &issued, &done, &errors]() {
+      while (!done.load()) {
+        const LSN    flushed     = buffer.flushed_lsn();
+        const LSN    current_lsn = buffer.current_lsn();
+        const size_t bytes       = buffer.bytes();
+        const size_t size        = buffer.size();
+        const LSN    limit       = issued.load();
+        if (current_lsn < flushed || current_lsn > limit || bytes > 1024 * 1024 + num_appenders * 1024 ||
+            size > static_cast<size_t>(limit)) {
+          errors++;
+        }
+      }
+    });
+  }
+
+  for (int i = 0; i < num_appenders; ++i) {
+    threads[i].join();
+  }
+  while (buffer.flushed_lsn() < total) {
+    std::this_thread::yield();
+  }
+  done = true;
+  for (size_t i = num_appenders; i < threads.size(); ++i) {
+    threads[i].join();
+  }
+
+  EXPECT_EQ(errors.load(), 0);
+  EXPECT_EQ(buffer.current_lsn(), total);
+  EXPECT_EQ(buffer.bytes(), 0u);
+  ASSERT_EQ(writer.close(), RC::SUCCESS);
+}
+
+/**
+ * @brief 测试 wait_flushed 等待其它线程刷盘，以及文件写满时剩下的日志留在缓冲区中
+ */
+TEST_F(LogBufferTest, WaitFlushedAndFileFull) {
+  LogFileWriter writer;
+  ASSERT_EQ(writer.open(test_dir + "/test.log", 3), RC::SUCCESS);  // 只能写入LSN 1、2
+
+  LSN lsn = 0;
+  for (int i = 0; i < 3; ++i) {
+    std::vector<char> data = {'t', 'e', 's', 't'};
+    ASSERT_EQ(buffer.append(lsn, LogModule(1), std::move(data)), RC::SUCCESS);
+  }
+
+  std::thread waiter([this]() { EXPECT_EQ(buffer.wait_flushed(2), RC::SUCCESS); });
+  EXPECT_EQ(buffer.group_commit(writer, 3), RC::FILE_FULL);
+  waiter.join();
+  EXPECT_EQ(buffer.flushed_lsn(), 2);
+  EXPECT_EQ(buffer.size(), 1);
+
+  // 切换到新文件之后继续提交
+  LogFileWriter next_writer;
+  ASSERT_EQ(next_writer.open(test_dir + "/test_next.log", 100), RC::SUCCESS);
+  EXPECT_EQ(buffer.group_commit(next_writer, 3), RC::SUCCESS);
+  EXPECT_EQ(buffer.flushed_lsn(), 3);
+  EXPECT_EQ(buffer.size(), 0);
+}
+
+/**
+ * @brief 测试落盘失败
+ * 数据已经写进文件但是没有落盘，不能在后面重写一遍。之后的提交、刷盘和追加都返回同一个错误，
+ * 文件中每条日志只出现一次
+ */
+TEST_F(LogBufferTest, SyncFailure) {
+  FaultyIoEngine engine;
+  LogFileWriter  writer;
+  ASSERT_EQ(writer.open(test_dir + "/test.log", 100), RC::SUCCESS);
+  writer.set_io_engine(&engine);
+
+  LSN lsn = 0;
+  ASSERT_EQ(buffer.append(lsn, LogModule(1), "test", 4), RC::SUCCESS);
+  ASSERT_EQ(buffer.group_commit(writer, lsn), RC::SUCCESS);
+  for (int i = 0; i < 2; ++i) {
+    ASSERT_EQ(buffer.append(lsn, LogModule(1), "test", 4), RC::SUCCESS);
+  }
+
+  engine.fail_sync.store(true);
+  EXPECT_EQ(buffer.group_commit(writer, 3), RC::IOERR_SYNC);
+  EXPECT_EQ(buffer.io_error(), RC::IOERR_SYNC);
+  EXPECT_EQ(buffer.flushed_lsn(), 1);
+
+  // 磁盘恢复之后也不再写入
+  engine.fail_sync.store(false);
+  EXPECT_EQ(buffer.group_commit(writer, 3), RC::IOERR_SYNC);
+  EXPECT_EQ(buffer.flush(writer), RC::IOERR_SYNC);
+  EXPECT_EQ(buffer.append(lsn, LogModule(1), "test", 4), RC::IOERR_SYNC);
+  EXPECT_EQ(buffer.flushed_lsn(), 1);
+  // 已经落盘的LSN不受影响
+  EXPECT_EQ(buffer.group_commit(writer, 1), RC::SUCCESS);
+  writer.set_io_engine(nullptr);
+  ASSERT_EQ(writer.close(), RC::SUCCESS);
+
+  LogFileReader reader;
+  ASSERT_EQ(reader.open(test_dir + "/test.log"), RC::SUCCESS);
+  std::vector<LSN> lsns;
+  ASSERT_EQ(reader.iterate([&lsns](LogEntry& entry) {
+    lsns.push_back(entry.lsn());
+    return RC::SUCCESS;
+  }), RC::SUCCESS);
+  EXPECT_EQ(lsns, (std::vector<LSN>{1, 2, 3}));
+  reader.close();
+}
+
+/**
+ * @brief 测试落盘失败之后重启，回放不会丢日志
+ * LogFileReader 遇到不大于上一条的LSN时认为是回收文件中留下的旧日志，停止读取。
+ * 落盘失败之后如果把同一批日志重写一遍，重启之后重复的日志后面的所有日志都读不到
+ */
+TEST_F(LogBufferTest, ReplayAfterSyncFailure) {
+  const std::string filename = test_dir + "/test.log";
+  std::vector<LSN>  committed;  // group_commit 返回成功的日志，重启之后都要能读到
+  {
+    FaultyIoEngine engine;
+    LogFileWriter  writer;
+    ASSERT_EQ(writer.open(filename, 100), RC::SUCCESS);
+    writer.set_io_engine(&engine);
+
+    auto commit = [&](bool fail_sync) {
+      engine.fail_sync.store(fail_sync);
+      LSN lsn = 0;
+      if (IS_SUCC(buffer.append(lsn, LogModule(1), "x", 1)) && IS_SUCC(buffer.group_commit(writer, lsn))) {
+        committed.push_back(lsn);
+      }
+    };
+    commit(false);
+    commit(true);
+    // 磁盘恢复之后继续提交
+    commit(false);
+    commit(false);
+    writer.set_io_engine(nullptr);
+    ASSERT_EQ(writer.close(), RC::SUCCESS);
+  }
+  EXPECT_EQ(committed, (std::vector<LSN>{1}));
+
+  LogFileReader reader;
+  ASSERT_EQ(reader.open(filename), RC::SUCCESS);
+  std::vector<LSN> lsns;
+  ASSERT_EQ(reader.iterate([&lsns](LogEntry& entry) {
+    lsns.push_back(entry.lsn());
+    return RC::SUCCESS;
+  }), RC::SUCCESS);
+  reader.close();
+  for (LSN lsn : committed) {
+    EXPECT_NE(std::find(lsns.begin(), lsns.end(), lsn), lsns.end()) << "lost committed lsn " << lsn;
+  }
+  // 文件中的LSN严格递增，没有重复
+  for (size_t i = 1; i < lsns.size(); i++) {
+    EXPECT_GT(lsns[i], lsns[i - 1]);
+  }
+
+  // 重启：从文件中最后一条日志之后继续，之后的日志都能读到
+  const LSN last_lsn = lsns.empty() ? 0 : lsns.back();
+  LogBuffer restarted;
+  ASSERT_EQ(restarted.init(last_lsn, 1024 * 1024), RC::SUCCESS);
+  LogFileWriter writer;
+  ASSERT_EQ(writer.open(filename, 100), RC::SUCCESS);
+  LSN lsn = 0;
+  for (int i = 0; i < 3; ++i) {
+    ASSERT_EQ(restarted.append(lsn, LogModule(1), "y", 1), RC::SUCCESS);
+  }
+  ASSERT_EQ(restarted.group_commit(writer, lsn), RC::SUCCESS);
+  ASSERT_EQ(writer.close(), RC::SUCCESS);
+
+  ASSERT_EQ(reader.open(filename), RC::SUCCESS);
+  LSN expected = 1;
+  ASSERT_EQ(reader.iterate([&expected](LogEntry& entry) {
+    EXPECT_EQ(entry.lsn(), expected++);
+    return RC::SUCCESS;
+  }), RC::SUCCESS);
+  EXPECT_EQ(expected, last_lsn + 4);
+  reader.close();
+}
+
+/**
+ * @brief 测试有刷盘线程时 wait_flushed 拿到刷盘线程的错误
+ * 写文件失败可以重试，等待的线程返回这次的错误；落盘失败之后所有的等待都返回错误
+ */
+TEST_F(LogBufferTest, WaitFlushedError) {
+  FaultyIoEngine engine;
+  LogFileWriter  writer;
+  ASSERT_EQ(writer.open(test_dir + "/test.log", 100), RC::SUCCESS);
+  writer.set_io_engine(&engine);
+
+  // 和 DiskLogHandler 的刷盘线程一样
+  std::atomic<bool> stop{false};
+  std::thread flusher([&]() {
+    while (!stop.load()) {
+      buffer.wait_flush_request(10);
+      RC rc = buffer.flush(writer);
+      if (IS_FAIL(rc)) {
+        buffer.report_flush_error(rc);
+      }
+    }
+  });
+
+  LSN lsn = 0;
+  engine.fail_write.store(true);
+  ASSERT_EQ(buffer.append(lsn, LogModule(1), "test", 4), RC::SUCCESS);
+  EXPECT_EQ(buffer.wait_flushed(lsn), RC::IOERR_WRITE);
+
+  // 刷盘线程可能在恢复之前又失败了一次
+  engine.fail_write.store(false);
+  RC rc = RC::SUCCESS;
+  do {
+    rc = buffer.wait_flushed(lsn);
+  } while (rc == RC::IOERR_WRITE);
+  EXPECT_EQ(rc, RC::SUCCESS);
+
+  engine.fail_sync.store(true);
+  ASSERT_EQ(buffer.append(lsn, LogModule(1), "test", 4), RC::SUCCESS);
+  EXPECT_EQ(buffer.wait_flushed(lsn), RC::IOERR_SYNC);
+  engine.fail_sync.store(false);
+  EXPECT_EQ(buffer.wait_flushed(lsn), RC::IOERR_SYNC);
+
+  stop.store(true);
+  flusher.join();
+  writer.set_io_engine(nullptr);
+  ASSERT_EQ(writer.close(), RC::SUCCESS);
+}
+
+/**
+ * @brief 测试等待日志发布
+ * 提交的日志已经预留但是还没有拷贝完时，提交的线程等待发布之后再刷盘
+ */
+TEST_F(LogBufferTest, GroupCommitWaitsForPublish) {
+  LogFileWriter writer;
+  ASSERT_EQ(writer.open(test_dir + "/test.log", 100000), RC::SUCCESS);
+
+  LogBuffer small;
+  ASSERT_EQ(small.init(0, 4096), RC::SUCCESS);
+
+  // 大的日志拷贝时间长，提交的线程经常看到已经预留但是还没有发布的日志
+  const int                num_threads = 4;
+  std::vector<std::thread> threads;
+  for (int i = 0; i < num_threads; ++i) {
+    threads.emplace_back([&, i]() {
+      std::vector<char> data(1000, static_cast<char>('a' + i));
+      for (int j = 0; j < 200; ++j) {
+        LSN lsn = 0;
+        ASSERT_EQ(small.append(lsn, LogModule(1), data.data(), static_cast<int32_t>(data.size())), RC::SUCCESS);
+        const LSN current = std::max(lsn, small.current_lsn());
+        ASSERT_EQ(small.group_commit(writer, current), RC::SUCCESS);
+        EXPECT_GE(small.flushed_lsn(), current);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(small.flushed_lsn(), num_threads * 200);
+  ASSERT_EQ(writer.close(), RC::SUCCESS);
+}
+
+/**
+ * @brief 测试环形缓冲区回绕
+ * 缓冲区很小，多个线程追加长度不同的日志，同时有线程不停地刷盘，
+ * 文件中的日志应该按LSN连续并且内容完整
+ */
+TEST_F(LogBufferTest, RingWrapAround) {
+  LogBuffer small;
+  ASSERT_EQ(small.init(0, 4096), RC::SUCCESS);
+
+  LogFileWriter writer;
+  ASSERT_EQ(writer.open(test_dir + "/test.log", 1000000), RC::SUCCESS);
+
+  const int num_threads = 4;
+  const int entries_per_thread = 2000;
+  std::atomic<bool> stop{false};
+  std::thread flusher([&]() {
+    while (!stop.load()) {
+      EXPECT_EQ(small.flush(writer), RC::SUCCESS);
+      std::this_thread::yield();
+    }
+  });
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < num_threads; ++i) {
+    threads.emplace_back([&small, i]() {
+      for (int j = 0; j < entries_per_thread; ++j) {
+        std::vector<char> data(1 + (i * 131 + j * 17) % 700, static_cast<char>('a' + i));
+        LSN lsn = 0;
+        EXPECT_EQ(small.append(lsn, LogModule(i), std::move(data)), RC::SUCCESS);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  stop.store(true);
+  flusher.join();
+  ASSERT_EQ(small.flush(writer), RC::SUCCESS);
+  EXPECT_EQ(small.flushed_lsn(), num_threads * entries_per_thread);
+  EXPECT_EQ(small.bytes(), 0);
+  ASSERT_EQ(writer.close(), RC::SUCCESS);
+
+  LogFileReader reader;
+  ASSERT_EQ(reader.open(test_dir + "/test.log"), RC::SUCCESS);
+  LSN expected = 1;
+  ASSERT_EQ(reader.iterate([&expected](LogEntry& entry) {
+    EXPECT_EQ(entry.lsn(), expected++);
+    const char fill = static_cast<char>('a' + entry.header().module_id);
+    for (int k = 0; k < entry.payload_size(); k++) {
+      if (entry.data()[k] != fill) {
+        ADD_FAILURE() << "corrupted entry " << entry.lsn();
+        break;
+      }
+    }
+    return RC::SUCCESS;
+  }), RC::SUCCESS);
+  EXPECT_EQ(expected, num_threads * entries_per_thread + 1);
+  reader.close();
+}
+
 /**
  * @brief 主函数
  * 运行所有测试用例
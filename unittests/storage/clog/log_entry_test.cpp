@@ -29,8 +29,8 @@ TEST_F(LogEntryTest, Init) {
   EXPECT_EQ(entry2.lsn(), 2);
   EXPECT_EQ(entry2.module().index(), 2);
   EXPECT_EQ(entry2.payload_size(), 4);
-  EXPECT_EQ(sizeof(entry2.header()), 16);
-  EXPECT_EQ(entry2.total_size(), 20);
+  EXPECT_EQ(sizeof(entry2.header()), 24);
+  EXPECT_EQ(entry2.total_size(), 28);
 }
 
 // 测试 LogEntry 的数据访问
@@ -94,4 +94,68 @@ TEST_F(LogEntryTest, ToString) {
   EXPECT_TRUE(str.find("lsn=1") != string::npos);
   EXPECT_TRUE(str.find("module_id=1") != string::npos);
   EXPECT_TRUE(str.find("data=test") != string::npos);
-} 
\ No newline at end of file
+}
+
+// 测试 check_sum：修改日志头或者数据都能发现，set_lsn 之后重新计算
+TEST_F(LogEntryTest, CheckSum) {
+  LogEntry entry;
+  EXPECT_EQ(entry.init(1, LogModule(1), vector<char>{'t', 'e', 's', 't'}), RC::SUCCESS);
+  EXPECT_TRUE(entry.header().is_valid());
+  EXPECT_TRUE(entry.header().verify(entry.data()));
+  EXPECT_FALSE(entry.header().verify("tesT"));
+
+  LogHeader header = entry.header();
+  header.lsn = 2;
+  EXPECT_FALSE(header.verify(entry.data()));
+  header.lsn     = 1;
+  header.version = LogHeader::VERSION + 1;
+  EXPECT_FALSE(header.is_valid());
+
+  entry.set_lsn(2);
+  EXPECT_TRUE(entry.header().verify(entry.data()));
+}
+
+// 测试压缩日志：压缩之后通过 init_decompress 还原，不值得压缩的数据不压缩，损坏的数据能发现
+TEST_F(LogEntryTest, Compress) {
+  string raw;
+  for (int i = 0; i < 512; i++) {
+    raw += "row" + to_string(i % 16) + ",";
+  }
+
+  vector<char> compressed;
+  const int32_t size = LogEntry::compress_payload(raw.data(), static_cast<int32_t>(raw.size()), compressed);
+  ASSERT_GT(size, 0);
+  EXPECT_LT(size, static_cast<int32_t>(raw.size() - raw.size() / 8));
+
+  LogEntry stored;
+  compressed.resize(size);
+  ASSERT_EQ(stored.init(1, LogModule(1), std::move(compressed)), RC::SUCCESS);
+  LogHeader header = stored.header();
+  header.flags |= LogHeader::FLAG_COMPRESSED;
+  EXPECT_TRUE(header.is_valid());
+  EXPECT_TRUE(header.is_compressed());
+
+  LogEntry entry;
+  ASSERT_EQ(entry.init_decompress(header, stored.data()), RC::SUCCESS);
+  EXPECT_EQ(entry.lsn(), 1);
+  EXPECT_FALSE(entry.header().is_compressed());
+  EXPECT_EQ(string(entry.data(), entry.payload_size()), raw);
+
+  // 原始大小被改坏
+  vector<char> corrupted(stored.data(), stored.data() + stored.payload_size());
+  corrupted[0] ^= 0x01;
+  EXPECT_EQ(entry.init_decompress(header, corrupted.data()), RC::FILE_CORRUPTED);
+
+  // 随机数据压缩不到 7/8
+  string random(4096, 0);
+  unsigned int seed = 1;
+  for (char& c : random) {
+    seed = seed * 1103515245 + 12345;
+    c    = static_cast<char>(seed >> 16);
+  }
+  EXPECT_EQ(LogEntry::compress_payload(random.data(), static_cast<int32_t>(random.size()), compressed), 0);
+
+  // 未知的标记
+  header.flags = 0x80;
+  EXPECT_FALSE(header.is_valid());
+}
@@ -125,4 +125,124 @@ TEST_F(LogFileTest, LogFileManager) {
   EXPECT_EQ(manager.next_file(writer), RC::SUCCESS);
   EXPECT_TRUE(writer.is_open());
   writer.close();
-} 
\ No newline at end of file
+}
+
+// 测试 mmap 方式读取和稀疏索引定位
+TEST_F(LogFileTest, MmapReaderWithIndex) {
+  const int total = 5000;
+  string filename = test_dir + "/clog_0.log";
+  LogFileWriter writer;
+  ASSERT_EQ(writer.open(filename, total + 1), RC::SUCCESS);
+  for (int i = 1; i <= total; i++) {
+    LogEntry entry;
+    string   payload = "entry" + to_string(i);
+    ASSERT_EQ(entry.init(i, LogModule(1), vector<char>(payload.begin(), payload.end())), RC::SUCCESS);
+    ASSERT_EQ(writer.write(entry), RC::SUCCESS);
+  }
+  ASSERT_EQ(writer.write_index(), RC::SUCCESS);
+  writer.close();
+  EXPECT_TRUE(filesystem::exists(LogFileWriter::index_filename(filename)));
+
+  for (auto mode : {LogFileReader::Mode::MMAP, LogFileReader::Mode::BUFFERED}) {
+    LogFileReader reader;
+    ASSERT_EQ(reader.open(filename, mode), RC::SUCCESS);
+    EXPECT_EQ(reader.index().size(), static_cast<size_t>((total + LogFileWriter::INDEX_INTERVAL - 1) / LogFileWriter::INDEX_INTERVAL));
+
+    LSN  expect = 3000;
+    bool views  = true;
+    ASSERT_EQ(reader.iterate([&](LogEntry& entry) {
+      EXPECT_EQ(entry.lsn(), expect);
+      EXPECT_EQ(string(entry.data(), entry.payload_size()), "entry" + to_string(expect));
+      views = views && entry.is_view();
+      expect++;
+      return RC::SUCCESS;
+    }, 3000), RC::SUCCESS);
+    EXPECT_EQ(expect, total + 1);
+    EXPECT_EQ(views, mode == LogFileReader::Mode::MMAP);
+    reader.close();
+  }
+}
+
+// 测试索引和日志文件对不上时从头查找
+TEST_F(LogFileTest, MismatchedIndex) {
+  const int total = 3000;
+  auto write_file = [total](const string& filename, int payload_mod) {
+    LogFileWriter writer;
+    ASSERT_EQ(writer.open(filename, total + 1), RC::SUCCESS);
+    for (int i = 1; i <= total; i++) {
+      LogEntry entry;
+      ASSERT_EQ(entry.init(i, LogModule(1), vector<char>(i % payload_mod, 'a')), RC::SUCCESS);
+      ASSERT_EQ(writer.write(entry), RC::SUCCESS);
+    }
+    ASSERT_EQ(writer.write_index(), RC::SUCCESS);
+    writer.close();
+  };
+
+  // 用另一个文件的索引覆盖，索引项指向的位置不是对应的日志
+  string filename   = test_dir + "/clog_0.log";
+  string other_file = test_dir + "/clog_other.log";
+  write_file(filename, 100);
+  write_file(other_file, 7);
+  filesystem::rename(LogFileWriter::index_filename(other_file), LogFileWriter::index_filename(filename));
+
+  LogFileReader reader;
+  ASSERT_EQ(reader.open(filename, LogFileReader::Mode::MMAP), RC::SUCCESS);
+  EXPECT_FALSE(reader.index().empty());
+  int count = 0;
+  ASSERT_EQ(reader.iterate([&](LogEntry& entry) {
+    EXPECT_EQ(entry.lsn(), 2500 + count);
+    EXPECT_EQ(entry.payload_size(), (2500 + count) % 100);
+    count++;
+    return RC::SUCCESS;
+  }, 2500), RC::SUCCESS);
+  EXPECT_EQ(count, total - 2499);
+}
+
+// 测试准备空闲文件，切换文件时使用它
+TEST_F(LogFileTest, PrepareFreeFile) {
+  const int64_t segment_size = 64 * 1024;
+  LogFileManager manager;
+  ASSERT_EQ(manager.init(test_dir, 10000, segment_size), RC::SUCCESS);
+
+  // 每次最多写 16KB，写满整个文件之后才放入空闲文件池
+  for (int i = 0; i < 3; i++) {
+    ASSERT_EQ(manager.prepare_file(16 * 1024), RC::SUCCESS);
+    EXPECT_EQ(manager.free_file_count(), 0u);
+  }
+  ASSERT_EQ(manager.prepare_file(16 * 1024), RC::SUCCESS);
+  EXPECT_EQ(manager.free_file_count(), 1u);
+  ASSERT_EQ(manager.prepare_file(16 * 1024), RC::SUCCESS);
+  EXPECT_EQ(manager.free_file_count(), 1u);
+
+  // 重新初始化时能找到空闲文件
+  LogFileManager other;
+  ASSERT_EQ(other.init(test_dir, 10000, segment_size), RC::SUCCESS);
+  EXPECT_EQ(other.free_file_count(), 1u);
+
+  LogFileWriter writer;
+  ASSERT_EQ(manager.next_file(writer), RC::SUCCESS);
+  EXPECT_EQ(manager.free_file_count(), 0u);
+  const string filename = writer.filename();
+  EXPECT_EQ(static_cast<int64_t>(filesystem::file_size(filename)), segment_size);
+
+  // 写超过预分配的大小时继续扩展
+  const int total = 1000;
+  for (int i = 0; i < total; i++) {
+    LogEntry entry;
+    ASSERT_EQ(entry.init(i + 1, LogModule(1), vector<char>(100, 'a')), RC::SUCCESS);
+    ASSERT_EQ(writer.write(entry), RC::SUCCESS);
+  }
+  ASSERT_EQ(writer.sync(), RC::SUCCESS);
+  writer.close();
+  EXPECT_EQ(static_cast<int64_t>(filesystem::file_size(filename)) % segment_size, 0);
+
+  LogFileReader reader;
+  ASSERT_EQ(reader.open(filename, LogFileReader::Mode::MMAP), RC::SUCCESS);
+  int count = 0;
+  ASSERT_EQ(reader.iterate([&count](LogEntry& entry) {
+    EXPECT_EQ(entry.lsn(), ++count);
+    return RC::SUCCESS;
+  }), RC::SUCCESS);
+  EXPECT_EQ(count, total);
+  EXPECT_FALSE(reader.torn());
+}
@@ -0,0 +1,156 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <vector>
+
+#include "storage/clog/disk_log_handler.h"
+#include "storage/clog/log_entry.h"
+#include "storage/clog/parallel_log_replayer.h"
+
+using namespace std;
+
+/**
+ * @brief 测试用的页面日志，page_num 小于0的是屏障日志
+ */
+struct TestPageLog {
+  int32_t buffer_pool_id;
+  PageNum page_num;
+};
+
+static vector<char> make_payload(int32_t buffer_pool_id, PageNum page_num) {
+  TestPageLog log{buffer_pool_id, page_num};
+  vector<char> data(sizeof(log));
+  memcpy(data.data(), &log, sizeof(log));
+  return data;
+}
+
+/**
+ * @brief 检查同一个页面的日志按LSN顺序回放，屏障日志回放时它之前的日志都已经回放
+ */
+class CheckOrderReplayer : public LogReplayer {
+public:
+  RC replay(const LogEntry& entry) override {
+    TestPageLog log;
+    memcpy(&log, entry.data(), sizeof(log));
+    if (entry.lsn() == fail_lsn) {
+      return RC::INTERNAL;
+    }
+
+    if (log.page_num < 0) {
+      if (replayed.load() != entry.lsn() - 1) {
+        errors++;
+      }
+      barriers++;
+    } else {
+      lock_guard<mutex> lock(mutex_);
+      LSN& last = last_lsn[partition(entry)];
+      if (last >= entry.lsn()) {
+        errors++;
+      }
+      last = entry.lsn();
+    }
+    replayed++;
+    return RC::SUCCESS;
+  }
+
+  RC on_done() override {
+    done = true;
+    return RC::SUCCESS;
+  }
+
+  uint64_t partition(const LogEntry& entry) const override {
+    TestPageLog log;
+    memcpy(&log, entry.data(), sizeof(log));
+    return log.page_num < 0 ? BARRIER : page_partition(log.buffer_pool_id, log.page_num);
+  }
+
+  atomic<int64_t> replayed{0};
+  atomic<int>     barriers{0};
+  atomic<int>     errors{0};
+  LSN             fail_lsn = 0;
+  bool            done     = false;
+
+private:
+  mutex              mutex_;
+  map<uint64_t, LSN> last_lsn;
+};
+
+// 每隔一段插入一条屏障日志，其它日志分散在多个页面上
+static LogEntry make_entry(LSN lsn) {
+  LogEntry entry;
+  const bool barrier = lsn % 500 == 0;
+  entry.init(lsn, LogModule::Id::BUFFER_POOL,
+      barrier ? make_payload(0, -1) : make_payload(static_cast<int32_t>(lsn % 3), static_cast<PageNum>(lsn % 37)));
+  return entry;
+}
+
+// 测试同一页面内的顺序和屏障
+TEST(ParallelLogReplayerTest, PageOrderAndBarrier) {
+  const int total = 20000;
+  for (int thread_num : {1, 4}) {
+    CheckOrderReplayer replayer;
+    ParallelLogReplayer parallel(replayer, thread_num);
+    ASSERT_EQ(parallel.start(), RC::SUCCESS);
+    for (LSN lsn = 1; lsn <= total; lsn++) {
+      ASSERT_EQ(parallel.dispatch(make_entry(lsn)), RC::SUCCESS);
+    }
+    ASSERT_EQ(parallel.on_done(), RC::SUCCESS);
+
+    EXPECT_TRUE(replayer.done);
+    EXPECT_EQ(replayer.replayed.load(), total);
+    EXPECT_EQ(replayer.barriers.load(), total / 500);
+    EXPECT_EQ(replayer.errors.load(), 0);
+  }
+}
+
+// 测试回放失败之后返回第一个错误，不再调用 on_done
+TEST(ParallelLogReplayerTest, StopOnError) {
+  CheckOrderReplayer replayer;
+  replayer.fail_lsn = 1234;
+  ParallelLogReplayer parallel(replayer, 4);
+  ASSERT_EQ(parallel.start(), RC::SUCCESS);
+
+  RC rc = RC::SUCCESS;
+  for (LSN lsn = 1; lsn <= 5000 && IS_SUCC(rc); lsn++) {
+    rc = parallel.dispatch(make_entry(lsn));
+  }
+  EXPECT_EQ(rc, RC::INTERNAL);  // 1500 是屏障，最晚在这里发现错误
+  EXPECT_EQ(parallel.on_done(), RC::INTERNAL);
+  EXPECT_FALSE(replayer.done);
+  EXPECT_LT(replayer.replayed.load(), 1500);
+}
+
+// 测试 DiskLogHandler 使用多个线程回放
+TEST(ParallelLogReplayerTest, DiskLogHandlerReplay) {
+  const string test_dir = "test_parallel_replay_logs";
+  filesystem::remove_all(test_dir);
+
+  const int total = 3000;
+  {
+    DiskLogHandler handler;
+    ASSERT_EQ(handler.init(test_dir, 1000), RC::SUCCESS);
+    LSN lsn = 0;
+    for (LSN i = 1; i <= total; i++) {
+      LogEntry entry = make_entry(i);
+      ASSERT_EQ(handler.append(lsn, entry.module(), vector<char>(entry.data(), entry.data() + entry.payload_size())),
+          RC::SUCCESS);
+    }
+    ASSERT_EQ(handler.wait_lsn(lsn), RC::SUCCESS);
+  }
+
+  DiskLogHandler handler;
+  ASSERT_EQ(handler.init(test_dir, 1000), RC::SUCCESS);
+  handler.set_replay_threads(4);
+
+  CheckOrderReplayer replayer;
+  ASSERT_EQ(handler.replay(replayer, 0), RC::SUCCESS);
+  EXPECT_TRUE(replayer.done);
+  EXPECT_EQ(replayer.replayed.load(), total);
+  EXPECT_EQ(replayer.barriers.load(), total / 500);
+  EXPECT_EQ(replayer.errors.load(), 0);
+
+  filesystem::remove_all(test_dir);
+}